@@ -67,7 +67,8 @@ uint16_t apduCoreParseIncomingAPDU(uint8_t* apdu, uint32_t apduLength, APDU_CORE
         parsedAPDU->lePresent = APDU_TRUE;
         parsedAPDU->data = &apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_DATA];
     }
-    else if ((apduLength == (0x07 + APDU_MAKEWORD(apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_LC_OR_LE3],
+    else if ((apduLength > 0x07) &&
+             (apduLength == (0x07 + APDU_MAKEWORD(apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_LC_OR_LE3],
                                                   apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_LC_OR_LE2]))) &&
              (apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_LC_OR_LE1] == 0x00))
     {
@@ -78,7 +79,8 @@ uint16_t apduCoreParseIncomingAPDU(uint8_t* apdu, uint32_t apduLength, APDU_CORE
         parsedAPDU->lePresent = APDU_FALSE;
         parsedAPDU->data = &apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_DATA];
     }
-    else if ((apduLength == (0x09 + APDU_MAKEWORD(apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_LC_OR_LE3],
+    else if ((apduLength > 0x07) &&
+             (apduLength == (0x09 + APDU_MAKEWORD(apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_LC_OR_LE3],
                                                   apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_LC_OR_LE2]))) &&
              (apdu[APDU_CORE_OFFSET_EXTENDED_LENGTH_LC_OR_LE1] == 0x00))
     {
@@ -472,11 +472,142 @@ END:
     return retVal;
 }
 
+/*
+ * A page that already holds its data is left as it is. A page whose differing longwords are all erased is programmed
+ * without an erase, mk82SystemFlashProgram skips the longwords that already match. Programming a longword that is
+ * not erased is not allowed, so any other change needs the page erased first.
+ *
+ * A page that is kept without an erase must also read back at the user margin level. A weakly erased or programmed
+ * longword reads correctly at the normal level but may not keep its value, such a page is erased and rewritten.
+ *
+ * The flash can only check a whole section against erased. Each run of erased section units takes one Verify Section
+ * command, the units that hold data take one Program Check per longword. A page with more of those than
+ * BLDR_HAL_MAX_PROGRAM_CHECKS_PER_PAGE is cheaper to erase and rewrite than to check.
+ */
+static uint16_t bldrHalIsSectionUnitErased(uint32_t unitAddress)
+{
+    uint32_t* flashWords = (uint32_t*)unitAddress;
+    uint32_t i;
+
+    for (i = 0; i < (BLDR_HAL_SECTION_UNIT_SIZE / sizeof(uint32_t)); i++)
+    {
+        if (flashWords[i] != BLDR_HAL_ERASED_FLASH_WORD)
+        {
+            return BLDR_FALSE;
+        }
+    }
+
+    return BLDR_TRUE;
+}
+
+static uint32_t bldrHalCountProgramChecks(uint32_t pageAddress)
+{
+    uint32_t programChecks = 0;
+    uint32_t unitAddress;
+
+    for (unitAddress = pageAddress; unitAddress < (pageAddress + MK82_FLASH_PAGE_SIZE);
+         unitAddress += BLDR_HAL_SECTION_UNIT_SIZE)
+    {
+        if (bldrHalIsSectionUnitErased(unitAddress) != BLDR_TRUE)
+        {
+            programChecks += BLDR_HAL_SECTION_UNIT_SIZE / sizeof(uint32_t);
+        }
+    }
+
+    return programChecks;
+}
+
+static uint16_t bldrHalIsPageWithinMargin(uint32_t pageAddress)
+{
+    status_t calleeRetVal = kStatus_FLASH_Success;
+    uint32_t pageEnd = pageAddress + MK82_FLASH_PAGE_SIZE;
+    uint32_t runStart = pageAddress;
+    uint16_t runErased;
+    uint32_t unitAddress;
+    uint32_t failedAddress;
+    uint32_t failedData;
+
+    runErased = bldrHalIsSectionUnitErased(pageAddress);
+
+    mk82SystemFlashBeginOperation();
+
+    for (unitAddress = pageAddress + BLDR_HAL_SECTION_UNIT_SIZE; unitAddress <= pageEnd;
+         unitAddress += BLDR_HAL_SECTION_UNIT_SIZE)
+    {
+        if ((unitAddress < pageEnd) && (bldrHalIsSectionUnitErased(unitAddress) == runErased))
+        {
+            continue;
+        }
+
+        if (runErased == BLDR_TRUE)
+        {
+            calleeRetVal =
+                FLASH_VerifyErase(&mk82FlashDriver, runStart, unitAddress - runStart, kFLASH_marginValueUser);
+        }
+        else
+        {
+            calleeRetVal = FLASH_VerifyProgram(&mk82FlashDriver, runStart, unitAddress - runStart, (uint32_t*)runStart,
+                                               kFLASH_marginValueUser, &failedAddress, &failedData);
+        }
+
+        if (calleeRetVal != kStatus_FLASH_Success)
+        {
+            break;
+        }
+
+        runStart = unitAddress;
+        runErased = (runErased == BLDR_TRUE) ? BLDR_FALSE : BLDR_TRUE;
+    }
+
+    mk82SystemFlashEndOperation();
+
+    if (calleeRetVal != kStatus_FLASH_Success)
+    {
+        return BLDR_FALSE;
+    }
+
+    return BLDR_TRUE;
+}
+
+static void bldrHalComparePage(uint32_t pageAddress, uint8_t* pageData, uint16_t* pageChanged, uint16_t* eraseNeeded)
+{
+    uint32_t* flashWords = (uint32_t*)pageAddress;
+    uint32_t* dataWords = (uint32_t*)pageData;
+    uint32_t i;
+
+    *pageChanged = BLDR_FALSE;
+    *eraseNeeded = BLDR_FALSE;
+
+    for (i = 0; i < (MK82_FLASH_PAGE_SIZE / sizeof(uint32_t)); i++)
+    {
+        if (flashWords[i] != dataWords[i])
+        {
+            *pageChanged = BLDR_TRUE;
+
+            if (flashWords[i] != BLDR_HAL_ERASED_FLASH_WORD)
+            {
+                *eraseNeeded = BLDR_TRUE;
+                return;
+            }
+        }
+    }
+
+    if ((bldrHalCountProgramChecks(pageAddress) > BLDR_HAL_MAX_PROGRAM_CHECKS_PER_PAGE) ||
+        (bldrHalIsPageWithinMargin(pageAddress) != BLDR_TRUE))
+    {
+        *pageChanged = BLDR_TRUE;
+        *eraseNeeded = BLDR_TRUE;
+    }
+}
+
 void bldrHalWriteImageData(uint32_t imageLength)
 {
     status_t caleeRetVal;
-    uint32_t primask;
     uint32_t startAddress;
+    uint32_t pageAddress;
+    uint8_t* pageData;
+    uint16_t pageChanged;
+    uint16_t eraseNeeded;
     uint32_t i;
     uint32_t numberOfSteps;
 
@@ -501,35 +632,34 @@ void bldrHalWriteImageData(uint32_t imageLength)
 
     for (i = 0; i < numberOfSteps; i++)
     {
-        primask = DisableGlobalIRQ();
+        pageAddress = startAddress + (i * MK82_FLASH_PAGE_SIZE);
+        pageData = dataBuffer + (i * MK82_FLASH_PAGE_SIZE);
 
-        caleeRetVal = FLASH_Erase(&mk82FlashDriver, startAddress + (i * MK82_FLASH_PAGE_SIZE), MK82_FLASH_PAGE_SIZE,
-                                  kFLASH_apiEraseKey);
+        bldrHalComparePage(pageAddress, pageData, &pageChanged, &eraseNeeded);
 
-        if (caleeRetVal != kStatus_FLASH_Success)
+        if (pageChanged == BLDR_FALSE)
         {
-            mk82SystemFatalError();
+            continue;
         }
 
-        EnableGlobalIRQ(primask);
+        if (eraseNeeded == BLDR_TRUE)
+        {
+            mk82SystemFlashBeginOperation();
 
-        __ISB();
-        __DSB();
-    }
+            caleeRetVal = FLASH_Erase(&mk82FlashDriver, pageAddress, MK82_FLASH_PAGE_SIZE, kFLASH_apiEraseKey);
 
-    for (i = 0; i < numberOfSteps; i++)
-    {
-        primask = DisableGlobalIRQ();
+            if (caleeRetVal != kStatus_FLASH_Success)
+            {
+                mk82SystemFatalError();
+            }
 
-        caleeRetVal = FLASH_Program(&mk82FlashDriver, startAddress + (i * MK82_FLASH_PAGE_SIZE),
-                                    (uint32_t*)(dataBuffer + (i * MK82_FLASH_PAGE_SIZE)), MK82_FLASH_PAGE_SIZE);
+            mk82SystemFlashEndOperation();
 
-        if (caleeRetVal != kStatus_FLASH_Success)
-        {
-            mk82SystemFatalError();
+            __ISB();
+            __DSB();
         }
 
-        EnableGlobalIRQ(primask);
+        mk82SystemFlashProgram(pageAddress, pageData, MK82_FLASH_PAGE_SIZE);
 
         __ISB();
         __DSB();
@@ -585,7 +715,6 @@ void bldrHalEnableManufacturerBootloader(void)
 {
     uint8_t pageContents[MK82_FLASH_PAGE_SIZE];
     uint8_t bootloaderEnabled[] = BLDR_HAL_MK82_BOOTLOADER_ENABLED;
-    uint32_t primask;
     status_t calleeRetVal;
     uint32_t i;
 
@@ -597,7 +726,7 @@ void bldrHalEnableManufacturerBootloader(void)
     mk82SystemMemCpy(&pageContents[BLDR_HAL_MK82_BOOTLOADER_SETTINGS_PAGE_OFFSET], bootloaderEnabled,
                      sizeof(bootloaderEnabled));
 
-    primask = DisableGlobalIRQ();
+    mk82SystemFlashBeginOperation();
 
     calleeRetVal = FLASH_Erase(&mk82FlashDriver, BLDR_HAL_MK82_BOOTLOADER_SETTINGS_PAGE_ADDRESS, MK82_FLASH_PAGE_SIZE,
                                kFLASH_apiEraseKey);
@@ -615,7 +744,7 @@ void bldrHalEnableManufacturerBootloader(void)
         mk82SystemFatalError();
     }
 
-    EnableGlobalIRQ(primask);
+    mk82SystemFlashEndOperation();
 }
 
 #endif /* FIRMWARE */
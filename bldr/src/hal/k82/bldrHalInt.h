@@ -13,6 +13,16 @@
 #define BLDR_HAL_SHA256_LENGTH (32)
 #define BLDR_HAL_R_AND_S_LENGTH (32)
 
+#define BLDR_HAL_ERASED_FLASH_WORD (0xFFFFFFFF)
+
+/* Verify Section checks aligned runs of this many bytes */
+#define BLDR_HAL_SECTION_UNIT_SIZE (FSL_FEATURE_FLASH_PFLASH_SECTION_CMD_ADDRESS_ALIGMENT)
+/*
+ * A Program Check takes up to 95 us, programming a longword about 7.5 us and a sector erase about 14 ms. Past this
+ * many Program Checks, erasing the page and writing it again is quicker than checking it.
+ */
+#define BLDR_HAL_MAX_PROGRAM_CHECKS_PER_PAGE (160)
+
 #define BLDR_HAL_MK82_BOOTLOADER_ENABLED                                                               \
     {                                                                                                  \
         0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFE, 0xFF, 0xFF, 0xFF \
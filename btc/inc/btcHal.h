@@ -69,6 +69,8 @@ extern "C"
     void btcHalWriteSetupInfoAndFinalizeSetup(uint8_t regularCoinVersion, uint8_t p2shCoinVersion, uint8_t* pinHash);
     void btcHalSetMasterKey(uint8_t* seed, uint32_t seedLength);
     void btcHalSetRandomTrustedInputKey(void);
+    void btcHalBeginSetupTransaction(void);
+    void btcHalCommitSetupTransaction(void);
     uint16_t btcHalGetWalletState(void);
     uint16_t btcHalIsWipeoutInProgress(void);
 
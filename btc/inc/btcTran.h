@@ -44,6 +44,7 @@ extern "C"
     uint16_t btcTranSigningSign(uint32_t* derivationIndexes, uint32_t numberOfKeyDerivations, uint32_t lockTime,
                                 uint32_t signHashType, uint8_t* signature, uint32_t* signatureLength);
     void btcTranIsFirstSignatureGenerated(uint16_t* firstSignatureGenerated);
+    void btcTranIsReadyToSign(uint16_t* readyToSign);
     void btcTranMessageSigningClearState(void);
     void btcTranMessageSigningInit(void);
     uint16_t btcTranMessageSigningProcessData(uint32_t* derivationIndexes, uint32_t numberOfKeyDerivations,
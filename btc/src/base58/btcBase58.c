@@ -34,25 +34,30 @@ void btcBase58EncodeBitcoinAddress(uint8_t* data, uint32_t dataLength, uint8_t*
                                    uint32_t* encodedDataLength, uint8_t version)
 {
     bool calleeRetVal = false;
+    size_t encodedLength;
 
     if ((data == NULL) || (encodedData == NULL) || (encodedDataLength == NULL))
     {
         btcHalFatalError();
     }
 
-    calleeRetVal = b58check_enc((char*)encodedData, (size_t*)encodedDataLength, version, data, dataLength);
+    encodedLength = *encodedDataLength;
+
+    calleeRetVal = b58check_enc((char*)encodedData, &encodedLength, version, data, dataLength);
 
     if (calleeRetVal != true)
     {
         btcHalFatalError();
     }
+
+    *encodedDataLength = (uint32_t)encodedLength;
 }
 
 uint16_t btcBase58DecodeAndCheckBitcoinAddress(uint8_t* data, uint32_t dataLength, uint8_t* decodedData,
                                                uint8_t version)
 {
     uint8_t addressWithTypeAndChecksum[BTC_BASE58_CHECK_ADDRESS_LENGTH];
-    uint32_t addressWithTypeAndChecksumLength;
+    size_t addressWithTypeAndChecksumLength;
     bool boolCalleeRetVal = false;
     bool intCalleeRetVal = -1;
     uint16_t retVal = BTC_GENERAL_ERROR;
@@ -65,7 +70,7 @@ uint16_t btcBase58DecodeAndCheckBitcoinAddress(uint8_t* data, uint32_t dataLengt
     addressWithTypeAndChecksumLength = sizeof(addressWithTypeAndChecksum);
 
     boolCalleeRetVal =
-        b58tobin(addressWithTypeAndChecksum, (size_t*)&addressWithTypeAndChecksumLength, (const char*)data, dataLength);
+        b58tobin(addressWithTypeAndChecksum, &addressWithTypeAndChecksumLength, (const char*)data, dataLength);
 
     if (boolCalleeRetVal != true)
     {
@@ -153,7 +153,14 @@ static void btcCoreProcessSetup(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_R
     if (createNewSeed == BTC_TRUE)
     {
         btcHalGenerateNewSeed(newSeed, sizeof(newSeed));
+    }
+
+    btcPinCheckNewPinAndGetPinHash(&commandAPDU->data[pinOffset], pinLength, pinHash);
 
+    btcHalBeginSetupTransaction();
+
+    if (createNewSeed == BTC_TRUE)
+    {
         btcHalSetMasterKey(newSeed, sizeof(newSeed));
     }
     else
@@ -163,10 +170,10 @@ static void btcCoreProcessSetup(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_R
 
     btcHalSetRandomTrustedInputKey();
 
-    btcPinCheckNewPinAndGetPinHash(&commandAPDU->data[pinOffset], pinLength, pinHash);
-
     btcHalWriteSetupInfoAndFinalizeSetup(regularCoinVersion, p2shCoinVersion, pinHash);
 
+    btcHalCommitSetupTransaction();
+
     responseAPDU->data[0] = BTC_CORE_SEED_NOT_TYPED_TO_THE_USER;
     responseAPDU->dataLength = 1;
 
@@ -228,7 +235,8 @@ static void btcCoreProcessVerifyPin(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CO
     }
     else
     {
-        btcHalFatalError();
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
     }
 
     sw = APDU_CORE_SW_NO_ERROR;
@@ -569,6 +577,7 @@ static void btcCoreProcessUntrustedHashSign(APDU_CORE_COMMAND_APDU* commandAPDU,
     uint32_t signatureLength;
     uint16_t confirmed = BTC_FALSE;
     uint16_t firstSignatureGenerated;
+    uint16_t readyToSign;
 
     if (commandAPDU->lcPresent != APDU_TRUE)
     {
@@ -625,6 +634,14 @@ static void btcCoreProcessUntrustedHashSign(APDU_CORE_COMMAND_APDU* commandAPDU,
         goto END;
     }
 
+    btcTranIsReadyToSign(&readyToSign);
+
+    if (readyToSign != BTC_TRUE)
+    {
+        sw = APDU_CORE_SW_WRONG_DATA;
+        goto END;
+    }
+
     btcTranIsFirstSignatureGenerated(&firstSignatureGenerated);
 
     if (firstSignatureGenerated != BTC_TRUE)
@@ -674,9 +691,7 @@ END:
 static void btcCoreProcessReadTransaction(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU)
 {
     uint16_t sw;
-    uint32_t dataLength;
     uint16_t offset = 0;
-    uint16_t i;
     uint64_t remainingTime;
     BTC_TRAN_TRANSACTION_TO_DISPLAY* transactionToDisplay;
     int64_t* inputAmounts;
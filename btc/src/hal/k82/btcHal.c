@@ -280,6 +280,10 @@ void btcHalWriteSetupInfoAndFinalizeSetup(uint8_t regularCoinVersion, uint8_t p2
     mk82FsCommitWrite(MK82_FS_FILE_ID_BTC_DATA);
 }
 
+void btcHalBeginSetupTransaction(void) { mk82FsBeginTransaction(); }
+
+void btcHalCommitSetupTransaction(void) { mk82FsCommitTransaction(); }
+
 uint16_t btcHalGetWalletState(void)
 {
     uint16_t walletState = BTC_GLOBAL_WALLET_STATE_INITIALIZATION;
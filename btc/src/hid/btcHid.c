@@ -77,7 +77,9 @@ void btcHidProcessIncomingFrame(BTC_HID_HANDLE* hidHandle, uint8_t incomingFrame
 
         if (apduLength > BTC_HID_MAX_DATA_SIZE)
         {
-            btcHalFatalError();
+            *requiredPostFrameProcessingAction = BTC_HID_ACTION_DO_NOTHING;
+            btcHidClearState(hidHandle);
+            goto END;
         }
 
         if (apduLength > sizeof(incomingHidFrame->initialAPDUFrame.payload))
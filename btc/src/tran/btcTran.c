@@ -881,7 +881,7 @@ static uint16_t btcTranSigningProcessHeaderAndInputsElement(uint8_t** data, uint
 
             if (firstSignatureGenerated == BTC_FALSE)
             {
-                if (btcTranSigningContext.currentInputNumber > BTC_TRANS_MAX_NUMBER_OF_INPUTS)
+                if (btcTranSigningContext.currentInputNumber >= BTC_TRANS_MAX_NUMBER_OF_INPUTS)
                 {
                     retVal = BTC_TRANSACTION_PARSING_FAILED_ERROR;
                     goto END;
@@ -1096,7 +1096,6 @@ static uint16_t btcTranSigningProcessHeaderAndInputsElementSegWit(uint8_t** data
 
         case BTC_TRAN_HEADER_AND_INPUTS_PROCESSING_STATE_PARSING_TI_OR_SEGWIT_PREVOUT:
         {
-            uint16_t calleeRetVal = BTC_GENERAL_ERROR;
             int64_t amount;
 
             btcTranParseArray(data, dataLength, BTC_GLOBAL_SHA256_SIZE, &parsingSuccessful);
@@ -1128,7 +1127,7 @@ static uint16_t btcTranSigningProcessHeaderAndInputsElementSegWit(uint8_t** data
 
             if (initialProcessing == BTC_TRUE)
             {
-                if (btcTranSigningContext.currentInputNumber > BTC_TRANS_MAX_NUMBER_OF_INPUTS)
+                if (btcTranSigningContext.currentInputNumber >= BTC_TRANS_MAX_NUMBER_OF_INPUTS)
                 {
                     retVal = BTC_TRANSACTION_PARSING_FAILED_ERROR;
                     goto END;
@@ -1144,7 +1143,7 @@ static uint16_t btcTranSigningProcessHeaderAndInputsElementSegWit(uint8_t** data
             }
             else
             {
-                if (btcTranSigningContext.segwitSignatureNumber > BTC_TRANS_MAX_NUMBER_OF_INPUTS)
+                if (btcTranSigningContext.segwitSignatureNumber >= BTC_TRANS_MAX_NUMBER_OF_INPUTS)
                 {
                     retVal = BTC_TRANSACTION_PARSING_FAILED_ERROR;
                     goto END;
@@ -1694,6 +1693,23 @@ void btcTranIsFirstSignatureGenerated(uint16_t* firstSignatureGenerated)
     *firstSignatureGenerated = btcTranSigningContext.firstSignatureGenerated;
 }
 
+void btcTranIsReadyToSign(uint16_t* readyToSign)
+{
+    if (readyToSign == NULL)
+    {
+        btcHalFatalError();
+    }
+
+    if (btcTranSigningContext.state == BTC_TRAN_SIGNING_STATE_COMPUTING_SIGNATURE)
+    {
+        *readyToSign = BTC_TRUE;
+    }
+    else
+    {
+        *readyToSign = BTC_FALSE;
+    }
+}
+
 void btcTranMessageSigningClearState(void)
 {
     btcTranMessageSigningContext.state = BTC_TRAN_MESSAGE_SIGNING_STATE_WAITING_FOR_RESET;
@@ -16,7 +16,7 @@
 #define CCID_DEVICE_CLASS_DESCRIPTOR_TYPE (0x21)
 #define CCID_BCD_VERSION (0x0110)
 
-#define CCID_MAX_SLOT_INDEX (0x00)                 // One slot
+#define CCID_MAX_SLOT_INDEX (CCID_NUMBER_OF_SLOTS - 1)
 #define CCID_SUPPORTED_VOLTAGE (0x01)              // Supports 5.0 Volts only
 #define CCID_SUPPORTED_PROTOCOLS (0x00000002)      // Supports T=1 only
 #define CCID_DEFAULT_CLOCK (0x00000DFC)            // 3.58 MHz
@@ -46,7 +46,7 @@ Support for the following:
 #define CCID_ENVELOPE_CLA (0xFF)        // Irrelivant, as onlt T=1 is supported
 #define CCID_LCD_LAYOUT (0x0000)        // No LCD
 #define CCID_PIN_SUPPORT (0x00)         // No Pin operations supported
-#define CCID_MAXIMUM_BUSY_SLOTS (0x01)  // One slot is supported
+#define CCID_MAXIMUM_BUSY_SLOTS (0x01)  // One command at a time across all slots
 
 #define CCID_DEVICE_CLASS_DESCRIPTOR                                                      \
     CCID_DEVICE_CLASS_DESCRIPTOR_LENGTH,                    /* bLength */                 \
@@ -43,6 +43,8 @@ extern "C"
 
     void ccidCoreGetAPDU(CCID_CORE_HANDLE* ccidHandle, uint8_t** apdu, uint32_t* apduLength);
 
+    void ccidCoreGetSlot(CCID_CORE_HANDLE* ccidHandle, uint8_t* slot);
+
     void ccidCoreGetResponse(CCID_CORE_HANDLE* ccidHandle, uint8_t** response, uint32_t* resposneLength);
 
     void ccidCoreGetWTXRequest(CCID_CORE_HANDLE* ccidHandle, uint8_t** request, uint32_t* requestLength);
@@ -33,6 +33,13 @@ extern "C"
 /* Change this if you are using a different USB endpoint packet size. */
 #define CCID_MAX_PACKET_SIZE (64)
 
+/* Every slot shows up as a separate reader on the host. The bootloader serves a single application and keeps one. */
+#ifdef FIRMWARE
+#define CCID_NUMBER_OF_SLOTS (3)
+#else
+#define CCID_NUMBER_OF_SLOTS (1)
+#endif /* FIRMWARE */
+
 #ifdef __cplusplus
 }
 #endif
@@ -25,6 +25,9 @@ extern "C"
 
     void ccidHalMemSet(uint8_t* dst, uint8_t value, uint16_t length);
 
+    /* Called on every ICC power on and off, the card in the slot starts over */
+    void ccidHalResetSlot(uint8_t slot);
+
     void ccidHalFatalError(void);
 
 #ifdef __cplusplus
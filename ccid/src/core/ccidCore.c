@@ -132,9 +132,9 @@ void ccidCoreProcessIncomingPacket(CCID_CORE_HANDLE* ccidHandle, uint8_t* incomi
             }
             else
             {
-                if (message->slot != CCID_CORE_SLOT_NUMBER)
+                if (message->slot > CCID_MAX_SLOT_INDEX)
                 {
-                    ccidCoreConstructErrorMessageAndSetState(ccidHandle, CCID_CORE_ERROR_INVALID_LENGTH);
+                    ccidCoreConstructErrorMessageAndSetState(ccidHandle, CCID_CORE_ERROR_INVALID_SLOT);
 
                     *requiredPostProcessingAction = CCID_CORE_ACTION_SEND_RESPOSE;
 
@@ -148,6 +148,8 @@ void ccidCoreProcessIncomingPacket(CCID_CORE_HANDLE* ccidHandle, uint8_t* incomi
                         // Do not check the length
                         // Do not check bPowerSelect
 
+                        ccidHalResetSlot(message->slot);
+
                         ccidHalMemCpy(&ccidHandle->dataBuffer[CCID_MESSAGE_HEADER_SIZE], ccidHandle->atr,
                                       ccidHandle->atrLength);
 
@@ -162,6 +164,8 @@ void ccidCoreProcessIncomingPacket(CCID_CORE_HANDLE* ccidHandle, uint8_t* incomi
                     break;
                     case CCID_CORE_COMMAND_ICC_POWER_OFF:
                     {
+                        ccidHalResetSlot(message->slot);
+
                         ccidCoreConstructHeaderAndSetState(ccidHandle, CCID_CORE_RESPONSE_SLOTSTATUS, 0x00,
                                                            CCID_CORE_CLOCK_STATUS_CLOCK_RUNNING);
 
@@ -211,6 +215,10 @@ void ccidCoreProcessIncomingPacket(CCID_CORE_HANDLE* ccidHandle, uint8_t* incomi
                         if (levelParameter != CCID_CORE_LEVEL_APDU_BEGINS_AND_ENDS_HERE)
                         {
                             ccidCoreConstructErrorMessageAndSetState(ccidHandle, CCID_CORE_ERROR_BAD_LEVEL_PARAMETER);
+
+                            *requiredPostProcessingAction = CCID_CORE_ACTION_SEND_RESPOSE;
+
+                            goto END;
                         }
 
                         ccidHandle->state = CCID_CORE_STATE_PROCESSING_RECEIVED_APDU;
@@ -263,6 +271,23 @@ void ccidCoreGetAPDU(CCID_CORE_HANDLE* ccidHandle, uint8_t** apdu, uint32_t* apd
     *apduLength = ccidHandle->totalBytesReceived - CCID_MESSAGE_HEADER_SIZE;
 }
 
+void ccidCoreGetSlot(CCID_CORE_HANDLE* ccidHandle, uint8_t* slot)
+{
+    CCID_CORE_MESSAGE* message = (CCID_CORE_MESSAGE*)ccidHandle->dataBuffer;
+
+    if ((ccidHandle == NULL) || (slot == NULL))
+    {
+        ccidHalFatalError();
+    }
+
+    if (ccidHandle->state != CCID_CORE_STATE_PROCESSING_RECEIVED_APDU)
+    {
+        ccidHalFatalError();
+    }
+
+    *slot = message->slot;
+}
+
 void ccidCoreGetResponse(CCID_CORE_HANDLE* ccidHandle, uint8_t** response, uint32_t* resposneLength)
 {
     if ((ccidHandle == NULL) || (response == NULL) || (resposneLength == NULL))
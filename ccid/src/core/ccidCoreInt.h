@@ -44,8 +44,6 @@ CCID_CORE_MESSAGE;
 
 #define CCID_CORE_ATR_MAX_HISTCHAR_LENGTH (15)
 
-#define CCID_CORE_SLOT_NUMBER (0)
-
 #define CCID_CORE_LEVEL_APDU_BEGINS_AND_ENDS_HERE (0x0000)
 
 #define CCID_CORE_STATUS_ICC_PRESENT_AND_ACTIVE (0x00)
@@ -15,6 +15,10 @@
 
 #include "mk82System.h"
 
+#ifdef FIRMWARE
+#include "mk82As.h"
+#endif /* FIRMWARE */
+
 void ccidhalInit() {}
 
 void ccidHalDeinit() {}
@@ -23,4 +27,13 @@ void ccidHalMemCpy(uint8_t* dst, uint8_t* src, uint16_t length) { mk82SystemMemC
 
 void ccidHalMemSet(uint8_t* dst, uint8_t value, uint16_t length) { mk82SystemMemSet(dst, value, length); }
 
+void ccidHalResetSlot(uint8_t slot)
+{
+#ifdef FIRMWARE
+    mk82AsResetSlot(slot);
+#else
+    (void)slot;
+#endif /* FIRMWARE */
+}
+
 void ccidHalFatalError(void) { mk82SystemFatalError(); }
@@ -50,11 +50,43 @@
 #include "bldrCore.h"
 #include "bldrHal.h"
 
+typedef void (*INIT_STAGE)(void);
+
+/* Common stages first, then the applets in the order their interfaces are usually hit after plug-in. */
+static const INIT_STAGE initStages[] = {
+	mk82AsInit,
+	mk82FsInit,
+	mk82KeysafeInit,
+	mk82SslInit,
+	mk82SecApduInit,
+	sfCoreInit,
+	btcCoreInit,
+	otpCoreInit,
+	opgpCoreInit,
+	ethCoreInit,
+	xrpCoreInit,
+	bldrCoreInit
+};
+
+/* The stages from mk82FsInit on read the file system, which fatal-errors when it is corrupt. They wait for the first
+ * command, so that the bootloader activation command still gets through on such a device. */
+#define INIT_STAGES_BEFORE_FIRST_COMMAND (1)
+#define INIT_STAGES_FOR_U2F (6)
+#define INIT_STAGES_FOR_BTC (7)
+#define INIT_STAGES_FOR_OTP (8)
+#define INIT_STAGES_FOR_ALL (sizeof(initStages) / sizeof(initStages[0]))
+
+static uint32_t initStagesCompleted = 0;
+
 static uint16_t computeOTP = MK82_FALSE;
 
 static void otpButtonPressed(void)
 {
-	computeOTP = MK82_TRUE;
+	/* A code computed while the previous one is still being typed would be dropped, and with HOTP waste a counter value. */
+	if(mk82UsbKeyboardIsBusy() != MK82_TRUE)
+	{
+		computeOTP = MK82_TRUE;
+	}
 }
 
 static void checkForSpecialBootloaderActivation(uint8_t* data, uint32_t dataLength)
@@ -76,6 +108,42 @@ static void checkForSpecialBootloaderActivation(uint8_t* data, uint32_t dataLeng
 	}
 }
 
+static void runNextInitStage(void)
+{
+	uint64_t startTime;
+	uint64_t endTime;
+
+	if(initStagesCompleted >= INIT_STAGES_FOR_ALL)
+	{
+		mk82SystemFatalError();
+	}
+
+	mk82SystemTickerGetUsPassed(&startTime);
+
+	initStages[initStagesCompleted]();
+
+	mk82SystemTickerGetUsPassed(&endTime);
+
+	mk82SystemInitStageCompleted(initStagesCompleted, startTime, endTime);
+
+	initStagesCompleted++;
+}
+
+static void completeInitStages(uint32_t stagesRequired)
+{
+	if(initStagesCompleted >= stagesRequired)
+	{
+		return;
+	}
+
+	mk82SystemInitCommandDelayed();
+
+	while(initStagesCompleted < stagesRequired)
+	{
+		runNextInitStage();
+	}
+}
+
 int main(void) {
 	
 	uint16_t firstCommandReceived = MK82_FALSE;
@@ -121,27 +189,29 @@ int main(void) {
 
 			if(firstCommandReceived == MK82_FALSE)
 			{
+				if(newUsbCommandReceived == MK82_USB_COMMAND_RECEIVED)
+				{
 					checkForSpecialBootloaderActivation(data, dataLength);
-				
-					mk82AsInit();
-					mk82FsInit();
-					mk82KeysafeInit();
-					mk82SslInit();
-					mk82SecApduInit();
-				
-					opgpCoreInit();
-					sfCoreInit();
-					otpCoreInit();
-					btcCoreInit();
-					ethCoreInit();
-					xrpCoreInit();
-					bldrCoreInit();
-				
-					firstCommandReceived = MK82_TRUE;
+				}
+
+				firstCommandReceived = MK82_TRUE;
 			}
 
 			if(newUsbCommandReceived == MK82_USB_COMMAND_RECEIVED)
 			{
+				if(dataType == MK82_GLOBAL_DATATYPE_U2F_MESSAGE)
+				{
+					completeInitStages(INIT_STAGES_FOR_U2F);
+				}
+				else if(dataType == MK82_GLOBAL_DATATYPE_BTC_MESSAGE)
+				{
+					completeInitStages(INIT_STAGES_FOR_BTC);
+				}
+				else
+				{
+					completeInitStages(INIT_STAGES_FOR_ALL);
+				}
+
 				mk82SecApduSetPrimaryDataType(dataType);
 
 				if(dataType == MK82_GLOBAL_DATATYPE_CCID_APDU)
@@ -152,7 +222,7 @@ int main(void) {
 
 					if( (sslStatus == MK82_SSL_STATUS_UNWRAPPED) || (sslStatus == MK82_SSL_STATUS_NOT_SSL) )
 					{
-						mk82AsProcessAPDU(data, &dataLength, MK82_AS_ALLOW_ALL_COMMANDS);
+						mk82AsProcessAPDU(data, &dataLength, MK82_AS_ALLOW_ALL_COMMANDS, mk82UsbGetCcidSlot());
 					}
 					else
 					{
@@ -190,6 +260,8 @@ int main(void) {
 
 				computeOTP = MK82_FALSE;
 
+				completeInitStages(INIT_STAGES_FOR_OTP);
+
 				calleeRetVal = otpCoreComputeOtp(otp, &otpLength);
 
 				if(calleeRetVal != OTP_NO_ERROR)
@@ -209,5 +281,28 @@ int main(void) {
 			mk82TouchEnable();
 #endif
 		}
+		else if(initStagesCompleted < INIT_STAGES_FOR_ALL)
+		{
+			/* One stage per pass, so that USB keeps being serviced while the rest initialize. */
+			if(mk82UsbIsConfigured() == MK82_TRUE)
+			{
+				if( (firstCommandReceived == MK82_TRUE) || (initStagesCompleted < INIT_STAGES_BEFORE_FIRST_COMMAND) )
+				{
+#ifdef USE_TOUCH
+					mk82TouchDisable();
+#endif
+					runNextInitStage();
+#ifdef USE_TOUCH
+					mk82TouchEnable();
+#endif
+				}
+			}
+		}
+		else
+		{
+			mk82FsIdleTask();
+			sfCoreIdleTask();
+			opgpCoreIdleTask();
+		}
 	}
 }
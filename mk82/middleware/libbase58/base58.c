@@ -16,6 +16,12 @@ typedef int32_t ssize_t;
 
 bool (*b58_sha256_impl)(void *, const void *, size_t) = NULL;
 
+// 58^5 is the largest power of 58 that fits in 32 bits
+#define b58_batch_digits 5
+// 58^4 is the largest power of 58 that still leaves 8 spare bits
+#define b58_limb_digits 4
+#define b58_limb_base 11316496
+
 static const int8_t b58digits_map[] = {
 	-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
 	-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
@@ -35,8 +41,8 @@ bool b58tobin(void *bin, size_t *binszp, const char *b58, size_t b58sz)
 	size_t outisz = (binsz + 3) / 4;
 	uint32_t outi[outisz];
 	uint64_t t;
-	uint32_t c;
-	size_t i, j;
+	uint32_t c, mul;
+	size_t i, j, k;
 	uint8_t bytesleft = binsz % 4;
 	uint32_t zeromask = bytesleft ? (0xffffffff << (bytesleft * 8)) : 0;
 	unsigned zerocount = 0;
@@ -50,19 +56,27 @@ bool b58tobin(void *bin, size_t *binszp, const char *b58, size_t b58sz)
 	for (i = 0; i < b58sz && b58u[i] == '1'; ++i)
 		++zerocount;
 	
-	for ( ; i < b58sz; ++i)
+	while (i < b58sz)
 	{
-		if (b58u[i] & 0x80)
-			// High-bit set on invalid digit
-			return false;
-		if (b58digits_map[b58u[i]] == -1)
-			// Invalid base58 digit
-			return false;
-		c = (unsigned)b58digits_map[b58u[i]];
+		// Gather up to b58_batch_digits digits, so that the limbs are
+		// multiplied once per batch instead of once per digit
+		c = 0;
+		mul = 1;
+		for (k = 0; k < b58_batch_digits && i < b58sz; ++k, ++i)
+		{
+			if (b58u[i] & 0x80)
+				// High-bit set on invalid digit
+				return false;
+			if (b58digits_map[b58u[i]] == -1)
+				// Invalid base58 digit
+				return false;
+			c = c * 58 + (unsigned)b58digits_map[b58u[i]];
+			mul *= 58;
+		}
 		for (j = outisz; j--; )
 		{
-			t = ((uint64_t)outi[j]) * 58 + c;
-			c = (t & 0x3f00000000) >> 32;
+			t = ((uint64_t)outi[j]) * mul + c;
+			c = t >> 32;
 			outi[j] = t & 0xffffffff;
 		}
 		if (c)
@@ -140,41 +154,55 @@ static const char b58digits_ordered[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdef
 bool b58enc(char *b58, size_t *b58sz, const void *data, size_t binsz)
 {
 	const uint8_t *bin = data;
-	int carry;
-	ssize_t i, j, high, zcount = 0;
-	size_t size;
+	uint32_t carry;
+	ssize_t i, j, k, d, high, zcount = 0;
+	size_t size, limbs, digits;
 	
 	while (zcount < binsz && !bin[zcount])
 		++zcount;
 	
+	// Work in base 58^4 limbs: limb * 256 + carry always fits in 32 bits
 	size = (binsz - zcount) * 138 / 100 + 1;
-	uint8_t buf[size];
-	memset(buf, 0, size);
+	limbs = (size + b58_limb_digits - 1) / b58_limb_digits;
+	uint32_t buf[limbs];
+	memset(buf, 0, limbs * sizeof(*buf));
 	
-	for (i = zcount, high = size - 1; i < binsz; ++i, high = j)
+	for (i = zcount, high = limbs - 1; i < binsz; ++i, high = j)
 	{
-		for (carry = bin[i], j = size - 1; (j > high) || carry; --j)
+		for (carry = bin[i], j = limbs - 1; (j > high) || carry; --j)
 		{
-			carry += 256 * buf[j];
-			buf[j] = carry % 58;
-			carry /= 58;
+			carry += buf[j] << 8;
+			buf[j] = carry % b58_limb_base;
+			carry /= b58_limb_base;
 		}
 	}
 	
-	for (j = 0; j < size && !buf[j]; ++j);
+	for (j = 0; j < limbs && !buf[j]; ++j);
 	
-	if (*b58sz <= zcount + size - j)
+	digits = 0;
+	if (j < limbs)
 	{
-		*b58sz = zcount + size - j + 1;
+		for (carry = buf[j]; carry; carry /= 58)
+			++digits;
+		digits += (limbs - j - 1) * b58_limb_digits;
+	}
+	
+	if (*b58sz <= zcount + digits)
+	{
+		*b58sz = zcount + digits + 1;
 		return false;
 	}
 	
 	if (zcount)
 		memset(b58, '1', zcount);
-	for (i = zcount; j < size; ++i, ++j)
-		b58[i] = b58digits_ordered[buf[j]];
+	i = zcount + digits;
 	b58[i] = '\0';
 	*b58sz = i + 1;
+	for (k = limbs - 1; k >= j; --k)
+	{
+		for (carry = buf[k], d = 0; d < b58_limb_digits && i > zcount; ++d, carry /= 58)
+			b58[--i] = b58digits_ordered[carry % 58];
+	}
 	
 	return true;
 }
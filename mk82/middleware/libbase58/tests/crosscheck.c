@@ -0,0 +1,283 @@
+/*
+ * Copyright 2012-2014 Luke Dashjr
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the standard MIT license.  See COPYING for more details.
+ */
+
+// Cross-checks b58enc/b58tobin against the original digit-by-digit
+// implementation and reports how long both take for the input sizes the
+// firmware uses most: 25-byte addresses and 82-byte extended keys.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libbase58.h"
+
+static const int8_t ref_digits_map[] = {
+	-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,
+	-1, 0, 1, 2, 3, 4, 5, 6,  7, 8,-1,-1,-1,-1,-1,-1,
+	-1, 9,10,11,12,13,14,15, 16,-1,17,18,19,20,21,-1,
+	22,23,24,25,26,27,28,29, 30,31,32,-1,-1,-1,-1,-1,
+	-1,33,34,35,36,37,38,39, 40,41,42,43,-1,44,45,46,
+	47,48,49,50,51,52,53,54, 55,56,57,-1,-1,-1,-1,-1,
+};
+
+static const char ref_digits_ordered[] = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+
+static
+bool ref_b58tobin(void *bin, size_t *binszp, const char *b58, size_t b58sz)
+{
+	size_t binsz = *binszp;
+	const unsigned char *b58u = (void*)b58;
+	unsigned char *binu = bin;
+	size_t outisz = (binsz + 3) / 4;
+	uint32_t outi[outisz];
+	uint64_t t;
+	uint32_t c;
+	size_t i, j;
+	uint8_t bytesleft = binsz % 4;
+	uint32_t zeromask = bytesleft ? (0xffffffff << (bytesleft * 8)) : 0;
+	unsigned zerocount = 0;
+	
+	if (!b58sz)
+		b58sz = strlen(b58);
+	
+	memset(outi, 0, outisz * sizeof(*outi));
+	
+	for (i = 0; i < b58sz && b58u[i] == '1'; ++i)
+		++zerocount;
+	
+	for ( ; i < b58sz; ++i)
+	{
+		if (b58u[i] & 0x80)
+			return false;
+		if (ref_digits_map[b58u[i]] == -1)
+			return false;
+		c = (unsigned)ref_digits_map[b58u[i]];
+		for (j = outisz; j--; )
+		{
+			t = ((uint64_t)outi[j]) * 58 + c;
+			c = (t & 0x3f00000000) >> 32;
+			outi[j] = t & 0xffffffff;
+		}
+		if (c)
+			return false;
+		if (outi[0] & zeromask)
+			return false;
+	}
+	
+	j = 0;
+	switch (bytesleft) {
+		case 3:
+			*(binu++) = (outi[0] &   0xff0000) >> 16;
+		case 2:
+			*(binu++) = (outi[0] &     0xff00) >>  8;
+		case 1:
+			*(binu++) = (outi[0] &       0xff);
+			++j;
+		default:
+			break;
+	}
+	
+	for (; j < outisz; ++j)
+	{
+		*(binu++) = (outi[j] >> 0x18) & 0xff;
+		*(binu++) = (outi[j] >> 0x10) & 0xff;
+		*(binu++) = (outi[j] >>    8) & 0xff;
+		*(binu++) = (outi[j] >>    0) & 0xff;
+	}
+	
+	binu = bin;
+	for (i = 0; i < binsz; ++i)
+	{
+		if (binu[i])
+			break;
+		--*binszp;
+	}
+	*binszp += zerocount;
+	
+	return true;
+}
+
+static
+bool ref_b58enc(char *b58, size_t *b58sz, const void *data, size_t binsz)
+{
+	const uint8_t *bin = data;
+	int carry;
+	ptrdiff_t i, j, high, zcount = 0;
+	size_t size;
+	
+	while (zcount < binsz && !bin[zcount])
+		++zcount;
+	
+	size = (binsz - zcount) * 138 / 100 + 1;
+	uint8_t buf[size];
+	memset(buf, 0, size);
+	
+	for (i = zcount, high = size - 1; i < binsz; ++i, high = j)
+	{
+		for (carry = bin[i], j = size - 1; (j > high) || carry; --j)
+		{
+			carry += 256 * buf[j];
+			buf[j] = carry % 58;
+			carry /= 58;
+		}
+	}
+	
+	for (j = 0; j < size && !buf[j]; ++j);
+	
+	if (*b58sz <= zcount + size - j)
+	{
+		*b58sz = zcount + size - j + 1;
+		return false;
+	}
+	
+	if (zcount)
+		memset(b58, '1', zcount);
+	for (i = zcount; j < size; ++i, ++j)
+		b58[i] = ref_digits_ordered[buf[j]];
+	b58[i] = '\0';
+	*b58sz = i + 1;
+	
+	return true;
+}
+
+static
+void random_bytes(uint8_t *buf, size_t sz)
+{
+	size_t i, zeros = (rand() % 4 == 0) ? (size_t)(rand() % 4) : 0;
+	for (i = 0; i < sz; ++i)
+		buf[i] = (i < zeros) ? 0 : (uint8_t)rand();
+}
+
+static
+int crosscheck(size_t binsz)
+{
+	uint8_t bin[0x80], out[0x80], refout[0x80];
+	char b58[0x100], refb58[0x100];
+	size_t b58sz = sizeof(b58), refb58sz = sizeof(refb58);
+	size_t outsz = binsz, refoutsz = binsz;
+	bool ok, refok, corrupt = false;
+	
+	random_bytes(bin, binsz);
+	
+	ok = b58enc(b58, &b58sz, bin, binsz);
+	refok = ref_b58enc(refb58, &refb58sz, bin, binsz);
+	if (ok != refok || b58sz != refb58sz || strcmp(b58, refb58))
+	{
+		fprintf(stderr, "encode mismatch for %u bytes: %s != %s\n", (unsigned)binsz, b58, refb58);
+		return 1;
+	}
+	
+	// Too small an output buffer must report the same required size
+	b58sz = refb58sz = refb58sz - 1;
+	ok = b58enc(b58, &b58sz, bin, binsz);
+	refok = ref_b58enc(refb58, &refb58sz, bin, binsz);
+	if (ok || refok || b58sz != refb58sz)
+	{
+		fprintf(stderr, "short buffer mismatch for %u bytes\n", (unsigned)binsz);
+		return 1;
+	}
+	
+	// Occasionally corrupt a digit or grow the number past binsz
+	if (rand() % 8 == 0)
+	{
+		b58[rand() % strlen(b58)] = "0OIl9z"[rand() % 6];
+		corrupt = true;
+	}
+	if (rand() % 8 == 0)
+	{
+		strcat(b58, "z");
+		corrupt = true;
+	}
+	
+	ok = b58tobin(out, &outsz, b58, 0);
+	refok = ref_b58tobin(refout, &refoutsz, b58, 0);
+	if (ok != refok || (ok && (outsz != refoutsz || memcmp(out, refout, binsz))))
+	{
+		fprintf(stderr, "decode mismatch for %s\n", b58);
+		return 1;
+	}
+	if (!corrupt && (!ok || outsz != binsz || memcmp(out, bin, binsz)))
+	{
+		fprintf(stderr, "round trip mismatch for %s\n", b58);
+		return 1;
+	}
+	
+	return 0;
+}
+
+static
+void benchmark(size_t binsz, unsigned rounds)
+{
+	uint8_t bin[0x80], out[0x80];
+	char b58[0x100];
+	size_t b58sz, outsz;
+	clock_t start;
+	double enc, refenc, dec, refdec;
+	unsigned i;
+	
+	random_bytes(bin, binsz);
+	bin[0] |= 1;
+	
+	start = clock();
+	for (i = 0; i < rounds; ++i)
+	{
+		b58sz = sizeof(b58);
+		b58enc(b58, &b58sz, bin, binsz);
+	}
+	enc = (double)(clock() - start) / CLOCKS_PER_SEC;
+	
+	start = clock();
+	for (i = 0; i < rounds; ++i)
+	{
+		b58sz = sizeof(b58);
+		ref_b58enc(b58, &b58sz, bin, binsz);
+	}
+	refenc = (double)(clock() - start) / CLOCKS_PER_SEC;
+	
+	start = clock();
+	for (i = 0; i < rounds; ++i)
+	{
+		outsz = binsz;
+		b58tobin(out, &outsz, b58, 0);
+	}
+	dec = (double)(clock() - start) / CLOCKS_PER_SEC;
+	
+	start = clock();
+	for (i = 0; i < rounds; ++i)
+	{
+		outsz = binsz;
+		ref_b58tobin(out, &outsz, b58, 0);
+	}
+	refdec = (double)(clock() - start) / CLOCKS_PER_SEC;
+	
+	printf("%3u bytes: encode %6.0f ns (was %6.0f ns), decode %6.0f ns (was %6.0f ns)\n",
+	       (unsigned)binsz, enc * 1e9 / rounds, refenc * 1e9 / rounds, dec * 1e9 / rounds, refdec * 1e9 / rounds);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned i;
+	size_t binsz;
+	
+	srand(58);
+	
+	for (i = 0; i < 2000; ++i)
+		for (binsz = 1; binsz <= 100; ++binsz)
+			if (crosscheck(binsz))
+				return 1;
+	
+	benchmark(25, 100000);
+	benchmark(82, 20000);
+	
+	return 0;
+}
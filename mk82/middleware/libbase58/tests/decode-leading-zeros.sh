@@ -0,0 +1,3 @@
+#!/bin/sh
+hex=$(base58 -d 20 11111111111111117YXq9G | xxd -p)
+test x$hex = x00000000000000000000000000000000ffffffff
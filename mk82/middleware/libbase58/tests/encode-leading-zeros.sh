@@ -0,0 +1,3 @@
+#!/bin/sh
+b58=$(echo '00000000000000000000000000000000ffffffff' | xxd -r -p | base58)
+test x$b58 = x11111111111111117YXq9G
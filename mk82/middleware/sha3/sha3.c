@@ -1,6 +1,6 @@
 /* -------------------------------------------------------------------------
  * Works when compiled for either 32-bit or 64-bit targets, optimized for
- * 64 bit.
+ * 32 bit.
  *
  * Canonical implementation of Init/Update/Finalize for SHA-3 byte input.
  *
@@ -14,6 +14,13 @@
  * write or test * your code.
  *
  * Aug 2015. Andrey Jivsov. crypto@brainhub.org
+ *
+ * The permutation keeps the state in the bit-interleaved representation
+ * (even bits of a lane in one 32-bit word, odd bits in the other), so that
+ * every 64-bit lane rotation becomes two 32-bit rotations and no 64-bit
+ * arithmetic is emulated on a 32-bit core. The round body is unrolled, the
+ * 24 rounds are not, to keep the code size reasonable for the firmware.
+ * Lanes are converted on absorb and on squeeze only.
  * ---------------------------------------------------------------------- */
 
 #include <stdio.h>
@@ -32,86 +39,229 @@
  * SHA3_USE_KECCAK only changes one line of code in Finalize.
  */
 
-#if defined(_MSC_VER)
-#define SHA3_CONST(x) x
-#else
-#define SHA3_CONST(x) x##L
+#ifndef SHA3_ROTL32
+#define SHA3_ROTL32(x, y) \
+	(((x) << (y)) | ((x) >> ((sizeof(uint32_t)*8) - (y))))
 #endif
 
-#ifndef SHA3_ROTL64
-#define SHA3_ROTL64(x, y) \
-	(((x) << (y)) | ((x) >> ((sizeof(uint64_t)*8) - (y))))
-#endif
-
-static const uint64_t keccakf_rndc[24] = {
-    SHA3_CONST(0x0000000000000001UL), SHA3_CONST(0x0000000000008082UL),
-    SHA3_CONST(0x800000000000808aUL), SHA3_CONST(0x8000000080008000UL),
-    SHA3_CONST(0x000000000000808bUL), SHA3_CONST(0x0000000080000001UL),
-    SHA3_CONST(0x8000000080008081UL), SHA3_CONST(0x8000000000008009UL),
-    SHA3_CONST(0x000000000000008aUL), SHA3_CONST(0x0000000000000088UL),
-    SHA3_CONST(0x0000000080008009UL), SHA3_CONST(0x000000008000000aUL),
-    SHA3_CONST(0x000000008000808bUL), SHA3_CONST(0x800000000000008bUL),
-    SHA3_CONST(0x8000000000008089UL), SHA3_CONST(0x8000000000008003UL),
-    SHA3_CONST(0x8000000000008002UL), SHA3_CONST(0x8000000000000080UL),
-    SHA3_CONST(0x000000000000800aUL), SHA3_CONST(0x800000008000000aUL),
-    SHA3_CONST(0x8000000080008081UL), SHA3_CONST(0x8000000000008080UL),
-    SHA3_CONST(0x0000000080000001UL), SHA3_CONST(0x8000000080008008UL)
-};
-
-static const unsigned keccakf_rotc[24] = {
-    1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62,
-    18, 39, 61, 20, 44
-};
-
-static const unsigned keccakf_piln[24] = {
-    10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20,
-    14, 22, 9, 6, 1
+/* Round constants, already split into even and odd bits. */
+static const uint32_t keccakf_rndc[48] = {
+    0x00000001UL, 0x00000000UL, 0x00000000UL, 0x00000089UL,
+    0x00000000UL, 0x8000008BUL, 0x00000000UL, 0x80008080UL,
+    0x00000001UL, 0x0000008BUL, 0x00000001UL, 0x00008000UL,
+    0x00000001UL, 0x80008088UL, 0x00000001UL, 0x80000082UL,
+    0x00000000UL, 0x0000000BUL, 0x00000000UL, 0x0000000AUL,
+    0x00000001UL, 0x00008082UL, 0x00000000UL, 0x00008003UL,
+    0x00000001UL, 0x0000808BUL, 0x00000001UL, 0x8000000BUL,
+    0x00000001UL, 0x8000008AUL, 0x00000001UL, 0x80000081UL,
+    0x00000000UL, 0x80000081UL, 0x00000000UL, 0x80000008UL,
+    0x00000000UL, 0x00000083UL, 0x00000000UL, 0x80008003UL,
+    0x00000001UL, 0x80008088UL, 0x00000000UL, 0x80000088UL,
+    0x00000001UL, 0x00008000UL, 0x00000000UL, 0x80008082UL
 };
 
 /* generally called after SHA3_KECCAK_SPONGE_WORDS-ctx->capacityWords words
- * are XORed into the state s
+ * are XORed into the state s; lane i lives in s[2 * i] (even bits) and
+ * s[2 * i + 1] (odd bits)
  */
 static void
-keccakf(uint64_t s[25])
+keccakf(uint32_t s[50])
 {
-    int i, j, round;
-    uint64_t t, bc[5];
+    int round;
+    uint32_t b[50];
+    uint32_t c0e, c0o, c1e, c1o, c2e, c2o, c3e, c3o, c4e, c4o;
+    uint32_t d0e, d0o, d1e, d1o, d2e, d2o, d3e, d3o, d4e, d4o;
 #define KECCAK_ROUNDS 24
 
     for(round = 0; round < KECCAK_ROUNDS; round++) {
 
         /* Theta */
-        for(i = 0; i < 5; i++)
-            bc[i] = s[i] ^ s[i + 5] ^ s[i + 10] ^ s[i + 15] ^ s[i + 20];
-
-        for(i = 0; i < 5; i++) {
-            t = bc[(i + 4) % 5] ^ SHA3_ROTL64(bc[(i + 1) % 5], 1);
-            for(j = 0; j < 25; j += 5)
-                s[j + i] ^= t;
-        }
-
-        /* Rho Pi */
-        t = s[1];
-        for(i = 0; i < 24; i++) {
-            j = keccakf_piln[i];
-            bc[0] = s[j];
-            s[j] = SHA3_ROTL64(t, keccakf_rotc[i]);
-            t = bc[0];
-        }
+        c0e = s[0] ^ s[10] ^ s[20] ^ s[30] ^ s[40];
+        c0o = s[1] ^ s[11] ^ s[21] ^ s[31] ^ s[41];
+        c1e = s[2] ^ s[12] ^ s[22] ^ s[32] ^ s[42];
+        c1o = s[3] ^ s[13] ^ s[23] ^ s[33] ^ s[43];
+        c2e = s[4] ^ s[14] ^ s[24] ^ s[34] ^ s[44];
+        c2o = s[5] ^ s[15] ^ s[25] ^ s[35] ^ s[45];
+        c3e = s[6] ^ s[16] ^ s[26] ^ s[36] ^ s[46];
+        c3o = s[7] ^ s[17] ^ s[27] ^ s[37] ^ s[47];
+        c4e = s[8] ^ s[18] ^ s[28] ^ s[38] ^ s[48];
+        c4o = s[9] ^ s[19] ^ s[29] ^ s[39] ^ s[49];
+        d0e = c4e ^ SHA3_ROTL32(c1o, 1);
+        d0o = c4o ^ c1e;
+        d1e = c0e ^ SHA3_ROTL32(c2o, 1);
+        d1o = c0o ^ c2e;
+        d2e = c1e ^ SHA3_ROTL32(c3o, 1);
+        d2o = c1o ^ c3e;
+        d3e = c2e ^ SHA3_ROTL32(c4o, 1);
+        d3o = c2o ^ c4e;
+        d4e = c3e ^ SHA3_ROTL32(c0o, 1);
+        d4o = c3o ^ c0e;
+
+        /* Theta (applied), Rho, Pi */
+        b[0] = (s[0] ^ d0e);
+        b[1] = (s[1] ^ d0o);
+        b[20] = SHA3_ROTL32((s[3] ^ d1o), 1);
+        b[21] = (s[2] ^ d1e);
+        b[40] = SHA3_ROTL32((s[4] ^ d2e), 31);
+        b[41] = SHA3_ROTL32((s[5] ^ d2o), 31);
+        b[10] = SHA3_ROTL32((s[6] ^ d3e), 14);
+        b[11] = SHA3_ROTL32((s[7] ^ d3o), 14);
+        b[30] = SHA3_ROTL32((s[9] ^ d4o), 14);
+        b[31] = SHA3_ROTL32((s[8] ^ d4e), 13);
+        b[32] = SHA3_ROTL32((s[10] ^ d0e), 18);
+        b[33] = SHA3_ROTL32((s[11] ^ d0o), 18);
+        b[2] = SHA3_ROTL32((s[12] ^ d1e), 22);
+        b[3] = SHA3_ROTL32((s[13] ^ d1o), 22);
+        b[22] = SHA3_ROTL32((s[14] ^ d2e), 3);
+        b[23] = SHA3_ROTL32((s[15] ^ d2o), 3);
+        b[42] = SHA3_ROTL32((s[17] ^ d3o), 28);
+        b[43] = SHA3_ROTL32((s[16] ^ d3e), 27);
+        b[12] = SHA3_ROTL32((s[18] ^ d4e), 10);
+        b[13] = SHA3_ROTL32((s[19] ^ d4o), 10);
+        b[14] = SHA3_ROTL32((s[21] ^ d0o), 2);
+        b[15] = SHA3_ROTL32((s[20] ^ d0e), 1);
+        b[34] = SHA3_ROTL32((s[22] ^ d1e), 5);
+        b[35] = SHA3_ROTL32((s[23] ^ d1o), 5);
+        b[4] = SHA3_ROTL32((s[25] ^ d2o), 22);
+        b[5] = SHA3_ROTL32((s[24] ^ d2e), 21);
+        b[24] = SHA3_ROTL32((s[27] ^ d3o), 13);
+        b[25] = SHA3_ROTL32((s[26] ^ d3e), 12);
+        b[44] = SHA3_ROTL32((s[29] ^ d4o), 20);
+        b[45] = SHA3_ROTL32((s[28] ^ d4e), 19);
+        b[46] = SHA3_ROTL32((s[31] ^ d0o), 21);
+        b[47] = SHA3_ROTL32((s[30] ^ d0e), 20);
+        b[16] = SHA3_ROTL32((s[33] ^ d1o), 23);
+        b[17] = SHA3_ROTL32((s[32] ^ d1e), 22);
+        b[36] = SHA3_ROTL32((s[35] ^ d2o), 8);
+        b[37] = SHA3_ROTL32((s[34] ^ d2e), 7);
+        b[6] = SHA3_ROTL32((s[37] ^ d3o), 11);
+        b[7] = SHA3_ROTL32((s[36] ^ d3e), 10);
+        b[26] = SHA3_ROTL32((s[38] ^ d4e), 4);
+        b[27] = SHA3_ROTL32((s[39] ^ d4o), 4);
+        b[28] = SHA3_ROTL32((s[40] ^ d0e), 9);
+        b[29] = SHA3_ROTL32((s[41] ^ d0o), 9);
+        b[48] = SHA3_ROTL32((s[42] ^ d1e), 1);
+        b[49] = SHA3_ROTL32((s[43] ^ d1o), 1);
+        b[18] = SHA3_ROTL32((s[45] ^ d2o), 31);
+        b[19] = SHA3_ROTL32((s[44] ^ d2e), 30);
+        b[38] = SHA3_ROTL32((s[46] ^ d3e), 28);
+        b[39] = SHA3_ROTL32((s[47] ^ d3o), 28);
+        b[8] = SHA3_ROTL32((s[48] ^ d4e), 7);
+        b[9] = SHA3_ROTL32((s[49] ^ d4o), 7);
 
         /* Chi */
-        for(j = 0; j < 25; j += 5) {
-            for(i = 0; i < 5; i++)
-                bc[i] = s[j + i];
-            for(i = 0; i < 5; i++)
-                s[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
-        }
+        s[0] = b[0] ^ (~b[2] & b[4]);
+        s[1] = b[1] ^ (~b[3] & b[5]);
+        s[2] = b[2] ^ (~b[4] & b[6]);
+        s[3] = b[3] ^ (~b[5] & b[7]);
+        s[4] = b[4] ^ (~b[6] & b[8]);
+        s[5] = b[5] ^ (~b[7] & b[9]);
+        s[6] = b[6] ^ (~b[8] & b[0]);
+        s[7] = b[7] ^ (~b[9] & b[1]);
+        s[8] = b[8] ^ (~b[0] & b[2]);
+        s[9] = b[9] ^ (~b[1] & b[3]);
+        s[10] = b[10] ^ (~b[12] & b[14]);
+        s[11] = b[11] ^ (~b[13] & b[15]);
+        s[12] = b[12] ^ (~b[14] & b[16]);
+        s[13] = b[13] ^ (~b[15] & b[17]);
+        s[14] = b[14] ^ (~b[16] & b[18]);
+        s[15] = b[15] ^ (~b[17] & b[19]);
+        s[16] = b[16] ^ (~b[18] & b[10]);
+        s[17] = b[17] ^ (~b[19] & b[11]);
+        s[18] = b[18] ^ (~b[10] & b[12]);
+        s[19] = b[19] ^ (~b[11] & b[13]);
+        s[20] = b[20] ^ (~b[22] & b[24]);
+        s[21] = b[21] ^ (~b[23] & b[25]);
+        s[22] = b[22] ^ (~b[24] & b[26]);
+        s[23] = b[23] ^ (~b[25] & b[27]);
+        s[24] = b[24] ^ (~b[26] & b[28]);
+        s[25] = b[25] ^ (~b[27] & b[29]);
+        s[26] = b[26] ^ (~b[28] & b[20]);
+        s[27] = b[27] ^ (~b[29] & b[21]);
+        s[28] = b[28] ^ (~b[20] & b[22]);
+        s[29] = b[29] ^ (~b[21] & b[23]);
+        s[30] = b[30] ^ (~b[32] & b[34]);
+        s[31] = b[31] ^ (~b[33] & b[35]);
+        s[32] = b[32] ^ (~b[34] & b[36]);
+        s[33] = b[33] ^ (~b[35] & b[37]);
+        s[34] = b[34] ^ (~b[36] & b[38]);
+        s[35] = b[35] ^ (~b[37] & b[39]);
+        s[36] = b[36] ^ (~b[38] & b[30]);
+        s[37] = b[37] ^ (~b[39] & b[31]);
+        s[38] = b[38] ^ (~b[30] & b[32]);
+        s[39] = b[39] ^ (~b[31] & b[33]);
+        s[40] = b[40] ^ (~b[42] & b[44]);
+        s[41] = b[41] ^ (~b[43] & b[45]);
+        s[42] = b[42] ^ (~b[44] & b[46]);
+        s[43] = b[43] ^ (~b[45] & b[47]);
+        s[44] = b[44] ^ (~b[46] & b[48]);
+        s[45] = b[45] ^ (~b[47] & b[49]);
+        s[46] = b[46] ^ (~b[48] & b[40]);
+        s[47] = b[47] ^ (~b[49] & b[41]);
+        s[48] = b[48] ^ (~b[40] & b[42]);
+        s[49] = b[49] ^ (~b[41] & b[43]);
 
         /* Iota */
-        s[0] ^= keccakf_rndc[round];
+        s[0] ^= keccakf_rndc[round * 2];
+        s[1] ^= keccakf_rndc[round * 2 + 1];
     }
 }
 
+/* Splits a lane given as two little-endian 32-bit halves into its even and
+ * odd bits. */
+static void
+sha3_Interleave(uint32_t lo, uint32_t hi, uint32_t *even, uint32_t *odd)
+{
+    uint32_t t;
+
+    t = (lo ^ (lo >> 1)) & 0x22222222UL; lo ^= t ^ (t << 1);
+    t = (lo ^ (lo >> 2)) & 0x0C0C0C0CUL; lo ^= t ^ (t << 2);
+    t = (lo ^ (lo >> 4)) & 0x00F000F0UL; lo ^= t ^ (t << 4);
+    t = (lo ^ (lo >> 8)) & 0x0000FF00UL; lo ^= t ^ (t << 8);
+
+    t = (hi ^ (hi >> 1)) & 0x22222222UL; hi ^= t ^ (t << 1);
+    t = (hi ^ (hi >> 2)) & 0x0C0C0C0CUL; hi ^= t ^ (t << 2);
+    t = (hi ^ (hi >> 4)) & 0x00F000F0UL; hi ^= t ^ (t << 4);
+    t = (hi ^ (hi >> 8)) & 0x0000FF00UL; hi ^= t ^ (t << 8);
+
+    *even = (lo & 0x0000FFFFUL) | (hi << 16);
+    *odd = (lo >> 16) | (hi & 0xFFFF0000UL);
+}
+
+/* Inverse of sha3_Interleave. */
+static void
+sha3_Deinterleave(uint32_t even, uint32_t odd, uint32_t *lo, uint32_t *hi)
+{
+    uint32_t t, l, h;
+
+    l = (even & 0x0000FFFFUL) | (odd << 16);
+    h = (even >> 16) | (odd & 0xFFFF0000UL);
+
+    t = (l ^ (l >> 8)) & 0x0000FF00UL; l ^= t ^ (t << 8);
+    t = (l ^ (l >> 4)) & 0x00F000F0UL; l ^= t ^ (t << 4);
+    t = (l ^ (l >> 2)) & 0x0C0C0C0CUL; l ^= t ^ (t << 2);
+    t = (l ^ (l >> 1)) & 0x22222222UL; l ^= t ^ (t << 1);
+
+    t = (h ^ (h >> 8)) & 0x0000FF00UL; h ^= t ^ (t << 8);
+    t = (h ^ (h >> 4)) & 0x00F000F0UL; h ^= t ^ (t << 4);
+    t = (h ^ (h >> 2)) & 0x0C0C0C0CUL; h ^= t ^ (t << 2);
+    t = (h ^ (h >> 1)) & 0x22222222UL; h ^= t ^ (t << 1);
+
+    *lo = l;
+    *hi = h;
+}
+
+static void
+sha3_AbsorbLane(sha3_context *ctx, unsigned lane, uint32_t lo, uint32_t hi)
+{
+    uint32_t even, odd;
+
+    sha3_Interleave(lo, hi, &even, &odd);
+
+    ctx->si[lane * 2] ^= even;
+    ctx->si[lane * 2 + 1] ^= odd;
+}
+
 /* *************************** Public Inteface ************************ */
 
 /* For Init or Reset call these: */
@@ -169,12 +319,13 @@ sha3_Update(void *priv, void const *bufIn, size_t len)
             ctx->saved |= (uint64_t) (*(buf++)) << ((ctx->byteIndex++) * 8);
 
         /* now ready to add saved to the sponge */
-        ctx->s[ctx->wordIndex] ^= ctx->saved;
+        sha3_AbsorbLane(ctx, ctx->wordIndex, (uint32_t) ctx->saved,
+                (uint32_t) (ctx->saved >> 32));
         ctx->byteIndex = 0;
         ctx->saved = 0;
         if(++ctx->wordIndex ==
                 (SHA3_KECCAK_SPONGE_WORDS - ctx->capacityWords)) {
-            keccakf(ctx->s);
+            keccakf(ctx->si);
             ctx->wordIndex = 0;
         }
     }
@@ -184,19 +335,19 @@ sha3_Update(void *priv, void const *bufIn, size_t len)
     tail = len - words * sizeof(uint64_t);
 
     for(i = 0; i < words; i++, buf += sizeof(uint64_t)) {
-        const uint64_t t = (uint64_t) (buf[0]) |
-                ((uint64_t) (buf[1]) << 8 * 1) |
-                ((uint64_t) (buf[2]) << 8 * 2) |
-                ((uint64_t) (buf[3]) << 8 * 3) |
-                ((uint64_t) (buf[4]) << 8 * 4) |
-                ((uint64_t) (buf[5]) << 8 * 5) |
-                ((uint64_t) (buf[6]) << 8 * 6) |
-                ((uint64_t) (buf[7]) << 8 * 7);
-
-        ctx->s[ctx->wordIndex] ^= t;
+        const uint32_t lo = (uint32_t) (buf[0]) |
+                ((uint32_t) (buf[1]) << 8 * 1) |
+                ((uint32_t) (buf[2]) << 8 * 2) |
+                ((uint32_t) (buf[3]) << 8 * 3);
+        const uint32_t hi = (uint32_t) (buf[4]) |
+                ((uint32_t) (buf[5]) << 8 * 1) |
+                ((uint32_t) (buf[6]) << 8 * 2) |
+                ((uint32_t) (buf[7]) << 8 * 3);
+
+        sha3_AbsorbLane(ctx, ctx->wordIndex, lo, hi);
         if(++ctx->wordIndex ==
                 (SHA3_KECCAK_SPONGE_WORDS - ctx->capacityWords)) {
-            keccakf(ctx->s);
+            keccakf(ctx->si);
             ctx->wordIndex = 0;
         }
     }
@@ -215,6 +366,7 @@ void const *
 sha3_Finalize(void *priv)
 {
     sha3_context *ctx = (sha3_context *) priv;
+    uint64_t padding;
 
     /* Append 2-bit suffix 01, per SHA-3 spec. Instead of 1 for padding we
      * use 1<<2 below. The 0x02 below corresponds to the suffix 01.
@@ -223,30 +375,27 @@ sha3_Finalize(void *priv)
 
 #ifndef SHA3_USE_KECCAK
     /* SHA3 version */
-    ctx->s[ctx->wordIndex] ^=
-            (ctx->saved ^ ((uint64_t) ((uint64_t) (0x02 | (1 << 2)) <<
+    padding = (ctx->saved ^ ((uint64_t) ((uint64_t) (0x02 | (1 << 2)) <<
                             ((ctx->byteIndex) * 8))));
 #else
     /* For testing the "pure" Keccak version */
-    ctx->s[ctx->wordIndex] ^=
-            (ctx->saved ^ ((uint64_t) ((uint64_t) 1 << (ctx->byteIndex *
+    padding = (ctx->saved ^ ((uint64_t) ((uint64_t) 1 << (ctx->byteIndex *
                                     8))));
 #endif
 
-    ctx->s[SHA3_KECCAK_SPONGE_WORDS - ctx->capacityWords - 1] ^=
-            SHA3_CONST(0x8000000000000000UL);
-    keccakf(ctx->s);
+    sha3_AbsorbLane(ctx, ctx->wordIndex, (uint32_t) padding,
+            (uint32_t) (padding >> 32));
+    sha3_AbsorbLane(ctx, SHA3_KECCAK_SPONGE_WORDS - ctx->capacityWords - 1,
+            0, 0x80000000UL);
+    keccakf(ctx->si);
 
-    /* Return first bytes of the ctx->s. This conversion is not needed for
-     * little-endian platforms e.g. wrap with #if !defined(__BYTE_ORDER__)
-     * || !defined(__ORDER_LITTLE_ENDIAN__) || \
-     * __BYTE_ORDER__!=__ORDER_LITTLE_ENDIAN__ ... the conversion below ...
-     * #endif */
+    /* Return first bytes of the ctx->s, converted back from the
+     * bit-interleaved representation. */
     {
         unsigned i;
         for(i = 0; i < SHA3_KECCAK_SPONGE_WORDS; i++) {
-            const unsigned t1 = (uint32_t) ctx->s[i];
-            const unsigned t2 = (uint32_t) ((ctx->s[i] >> 16) >> 16);
+            uint32_t t1, t2;
+            sha3_Deinterleave(ctx->si[i * 2], ctx->si[i * 2 + 1], &t1, &t2);
             ctx->sb[i * 8 + 0] = (uint8_t) (t1);
             ctx->sb[i * 8 + 1] = (uint8_t) (t1 >> 8);
             ctx->sb[i * 8 + 2] = (uint8_t) (t1 >> 16);
@@ -260,7 +409,3 @@ sha3_Finalize(void *priv)
 
     return (ctx->sb);
 }
-
-
-
-
@@ -14,6 +14,7 @@ typedef struct sha3_context_ {
                                  * didn't consume yet */
     union {                     /* Keccak's state */
         uint64_t s[SHA3_KECCAK_SPONGE_WORDS];
+        uint32_t si[SHA3_KECCAK_SPONGE_WORDS * 2]; /* bit-interleaved lanes */
         uint8_t sb[SHA3_KECCAK_SPONGE_WORDS * 8];
     };
     unsigned byteIndex;         /* 0..7--the next byte after the set one
@@ -43,4 +43,10 @@
 u16 uffs_crc16update(const void *data, int length, u16 crc);
 u16 uffs_crc16sum(const void *data, int length);
 
+/* table driven CRC16, what uffs_crc16update() computes without CONFIG_PLATFORM_CRC16 */
+u16 uffs_crc16update_table(const void *data, int length, u16 crc);
+
+/* provided by the platform with CONFIG_PLATFORM_CRC16, must match uffs_crc16update_table() */
+u16 uffs_PlatformCrc16Update(const void *data, int length, u16 crc);
+
 #endif
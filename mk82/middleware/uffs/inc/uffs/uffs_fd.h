@@ -107,6 +107,7 @@ struct uffs_stat {
 int uffs_open(const char *name, int oflag, ...);
 int uffs_close(int fd);
 int uffs_read(int fd, void *data, int len);
+int uffs_locate(int fd, struct uffs_BufSt **buf, u16 *block, u16 *page, u32 *ofs);
 int uffs_write(int fd, const void *data, int len);
 long uffs_seek(int fd, long offset, int origin);
 long uffs_tell(int fd);
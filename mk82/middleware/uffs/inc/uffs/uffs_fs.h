@@ -118,6 +118,7 @@ URET uffs_CreateObject(uffs_Object *obj, const char *fullname, int oflag);
 URET uffs_CloseObject(uffs_Object *obj);
 int uffs_WriteObject(uffs_Object *obj, const void *data, int len);
 int uffs_ReadObject(uffs_Object *obj, void *data, int len);
+int uffs_LocateObjectData(uffs_Object *obj, uffs_Buf **buf, u16 *block, u16 *page, u32 *ofs);
 long uffs_SeekObject(uffs_Object *obj, long offset, int origin);
 int uffs_GetCurOffset(uffs_Object *obj);
 int uffs_EndOfFile(uffs_Object *obj);
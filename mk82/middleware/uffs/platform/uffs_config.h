@@ -169,7 +169,7 @@
  * \def MAX_OBJECT_HANDLE
  * maximum number of object handle 
  */
-#define MAX_OBJECT_HANDLE	4
+#define MAX_OBJECT_HANDLE	5
 #define FD_SIGNATURE_SHIFT	6
 
 
@@ -247,6 +247,16 @@
 #define CONFIG_ENABLE_PAGE_DATA_CRC
 
 
+/**
+ * \def CONFIG_PLATFORM_CRC16
+ * \note If this is enabled, uffs_crc16update() hands the CRC16 to
+ *       uffs_PlatformCrc16Update() in the platform layer, which may use a
+ *       CRC engine. The platform must return what the table in uffs_crc.c
+ *       returns for the same data and seed.
+ */
+#define CONFIG_PLATFORM_CRC16
+
+
 /** micros for calculating buffer sizes */
 
 /**
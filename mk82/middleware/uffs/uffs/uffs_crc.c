@@ -36,6 +36,7 @@
  * \note Created in 23 Nov, 2011
  */
 
+#include "uffs_config.h"
 #include "uffs/uffs_crc.h"
 
 /* CRC16 Table */
@@ -76,7 +77,7 @@ static const u16 CRC16_TBL[256] = {
 
 #define CRC16(v, x) v = ((v) >> 8) ^ CRC16_TBL[((v) ^ (x)) & 0x00ff]
 
-u16 uffs_crc16update(const void *data, int length, u16 crc)
+u16 uffs_crc16update_table(const void *data, int length, u16 crc)
 {
 	int i;
 	const u8 *p = (const u8 *)data;
@@ -87,6 +88,15 @@ u16 uffs_crc16update(const void *data, int length, u16 crc)
 	return crc;
 }
 
+u16 uffs_crc16update(const void *data, int length, u16 crc)
+{
+#ifdef CONFIG_PLATFORM_CRC16
+	return uffs_PlatformCrc16Update(data, length, crc);
+#else
+	return uffs_crc16update_table(data, length, crc);
+#endif
+}
+
 u16 uffs_crc16sum(const void *data, int length)
 {
 	return uffs_crc16update(data, length, 0xFFFF);
@@ -298,6 +298,21 @@ int uffs_read(int fd, void *data, int len)
 	return ret;
 }
 
+int uffs_locate(int fd, struct uffs_BufSt **buf, u16 *block, u16 *page, u32 *ofs)
+{
+	int ret;
+	uffs_Object *obj;
+
+	CHK_OBJ_LOCK(fd, obj, -1);
+	uffs_ClearObjectErr(obj);
+	ret = uffs_LocateObjectData(obj, buf, block, page, ofs);
+	uffs_set_error(-uffs_GetObjectErr(obj));
+
+	uffs_GlobalFsLockUnlock();
+
+	return ret;
+}
+
 int uffs_write(int fd, const void *data, int len)
 {
 	int ret;
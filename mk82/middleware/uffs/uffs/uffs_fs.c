@@ -1207,6 +1207,125 @@ int uffs_ReadObject(uffs_Object *obj, void *data, int len)
 	return len - remain;
 }
 
+/**
+ * locate the object data at the file pointer and move the file pointer
+ * past it, without copying the data.
+ *
+ * \param[in] obj uffs object
+ * \param[out] buf the page buffer that holds the data if the page is
+ *			cached, NULL if the data is only on flash
+ * \param[out] block block of the page, set if \a buf is NULL
+ * \param[out] page physical page in the block, set if \a buf is NULL
+ * \param[out] ofs offset of the data in the page data
+ *
+ * \return number of bytes of the object in this page from the file
+ *			pointer on, 0 at the end of the object or on error.
+ *
+ * \note no reference is taken on \a buf. The location is only good until
+ *			the next operation on the device.
+ */
+int uffs_LocateObjectData(uffs_Object *obj, uffs_Buf **buf, u16 *block, u16 *page, u32 *ofs)
+{
+	uffs_Device *dev = obj->dev;
+	TreeNode *fnode = NULL;
+	TreeNode *dnode;
+	uffs_BlockInfo *bc;
+	u16 fdn;
+	u16 parent, serial, blk, pg;
+	u16 page_id;
+	u32 blockOfs;
+	u32 pageOfs;
+	u32 data_len;
+	u32 size = 0;
+
+	if (obj == NULL)
+		return 0;
+
+	fnode = obj->node;
+
+	if (obj->dev == NULL || obj->open_succ == U_FALSE || obj->type == UFFS_TYPE_DIR) {
+		obj->err = UEBADF;
+		return 0;
+	}
+
+	if (obj->pos >= fnode->u.file.len) {
+		return 0;
+	}
+
+	uffs_ObjectDevLock(obj);
+
+	fdn = GetFdnByOfs(obj, obj->pos);
+	if (fdn == 0) {
+		parent = fnode->u.file.parent;
+		serial = fnode->u.file.serial;
+		blk = fnode->u.file.block;
+	}
+	else {
+		dnode = uffs_TreeFindDataNode(dev, fnode->u.file.serial, fdn);
+		if (dnode == NULL) {
+			uffs_Perror(UFFS_MSG_SERIOUS, "can't get data node in entry!");
+			obj->err = UEUNKNOWN_ERR;
+			goto ext;
+		}
+		parent = dnode->u.data.parent;
+		serial = dnode->u.data.serial;
+		blk = dnode->u.data.block;
+	}
+
+	blockOfs = GetStartOfDataBlock(obj, fdn);
+	page_id = (obj->pos - blockOfs) / dev->com.pg_data_size;
+
+	if (fdn == 0) {
+		// page 0 of the first block is for file attr
+		page_id++;
+	}
+
+	*buf = uffs_BufFind(dev, parent, serial, page_id);
+	if (*buf) {
+		data_len = (*buf)->data_len;
+	}
+	else {
+		bc = uffs_BlockInfoGet(dev, blk);
+		if (bc == NULL) {
+			uffs_Perror(UFFS_MSG_SERIOUS, "Can't get block info!");
+			obj->err = UEIOERR;
+			goto ext;
+		}
+
+		pg = uffs_FindPageInBlockWithPageId(dev, bc, page_id);
+		if (pg != UFFS_INVALID_PAGE)
+			pg = uffs_FindBestPageInBlock(dev, bc, pg);
+
+		if (pg == UFFS_INVALID_PAGE) {
+			uffs_BlockInfoPut(dev, bc);
+			uffs_Perror(UFFS_MSG_SERIOUS, "can't find right page ? block %d page_id %d", blk, page_id);
+			obj->err = UEIOERR;
+			goto ext;
+		}
+
+		data_len = TAG_DATA_LEN(GET_TAG(bc, pg));
+		uffs_BlockInfoPut(dev, bc);
+
+		*block = blk;
+		*page = pg;
+	}
+
+	pageOfs = obj->pos % dev->com.pg_data_size;
+	if (pageOfs < data_len) {
+		size = data_len - pageOfs;
+		if (size > fnode->u.file.len - obj->pos)
+			size = fnode->u.file.len - obj->pos;
+
+		*ofs = pageOfs;
+		obj->pos += size;
+	}
+
+ext:
+	uffs_ObjectDevUnLock(obj);
+
+	return size;
+}
+
 /**
  * move the file pointer
  *
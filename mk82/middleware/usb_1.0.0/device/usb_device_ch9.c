@@ -87,6 +87,10 @@ extern usb_status_t USB_DeviceProcessClassRequest(usb_device_handle handle,
                                                   usb_setup_struct_t *setup,
                                                   uint32_t *length,
                                                   uint8_t **buffer);
+extern usb_status_t USB_DeviceProcessVendorRequest(usb_device_handle handle,
+                                                   usb_setup_struct_t *setup,
+                                                   uint32_t *length,
+                                                   uint8_t **buffer);
 
 /*!
  * @brief Get the buffer to save the class specific data sent from host.
@@ -858,6 +862,11 @@ usb_status_t USB_DeviceControlCallback(usb_device_handle handle,
                     /* Get data buffer to response the host. */
                     error = USB_DeviceProcessClassRequest(handle, deviceSetup, &length, &buffer);
                 }
+                else if ((deviceSetup->bmRequestType & USB_REQUEST_TYPE_TYPE_MASK) == USB_REQUEST_TYPE_TYPE_VENDOR)
+                {
+                    /* Get data buffer to response the host. */
+                    error = USB_DeviceProcessVendorRequest(handle, deviceSetup, &length, &buffer);
+                }
                 else
                 {
                 }
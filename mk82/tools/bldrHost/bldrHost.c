@@ -0,0 +1,593 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Runs the firmware update of the bootloader on a Linux host. The program flash from the bootloader up to the end of
+ * the file system is a raw image file mapped at its real address, which needs root or vm.mmap_min_addr at most
+ * 0x2000. The flash driver below gives it the program and erase behaviour of the K82, refuses to program a longword
+ * that is not erased and stops the update if the firmware region is touched while the firmware is marked valid.
+ *
+ * A longword can be marked weak: it reads back its value but fails every check above the normal margin level, like a
+ * cell that is losing its charge. Erasing its page or programming it again makes it whole.
+ *
+ * An update goes through bldrHal the way bldrCore drives it. Images are signed with a key made up for the run, which
+ * replaces the public key of the bootloader.
+ *
+ * Built by bldrUpdateReport.py.
+ *
+ * Usage:
+ *   bldrHost init <flash> <image>     erase the flash, write a valid boot info and the firmware as is
+ *   bldrHost update <flash> <image> [<address>]
+ *                                     update to the firmware, or firmware and file system, and print the erases,
+ *                                     programmed longwords, Verify Section and Program Check commands, with the
+ *                                     longword at address marked weak first
+ *   bldrHost reject <flash> <image>   change one byte of the signed image and check that nothing is written
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <bldrGlobal.h>
+#include <bldrGlobalInt.h>
+#include <bldrHal.h>
+
+#include "mk82Global.h"
+#include "mk82System.h"
+#include "mk82BootInfo.h"
+
+#include "fsl_device_registers.h"
+#include "fsl_crc.h"
+
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/sha256.h"
+
+#define BLDR_HOST_FLASH_START (MK82_FLASH_BOOTLOADER_START)
+#define BLDR_HOST_FLASH_SIZE (MK82_FLASH_FILE_SYSTEM_START + MK82_FLASH_FILE_SYSTEM_SIZE - BLDR_HOST_FLASH_START)
+#define BLDR_HOST_WRITE_UNIT_SIZE (FSL_FEATURE_FLASH_PFLASH_BLOCK_WRITE_UNIT_SIZE)
+#define BLDR_HOST_SECTION_UNIT_SIZE (FSL_FEATURE_FLASH_PFLASH_SECTION_CMD_ADDRESS_ALIGMENT)
+#define BLDR_HOST_ERASED_WORD (0xFFFFFFFF)
+#define BLDR_HOST_CRC32_POLYNOMIAL (0xEDB88320)
+/* Image data arrives in APDUs of at most 255 bytes */
+#define BLDR_HOST_CHUNK_SIZE (255)
+#define BLDR_HOST_KEY_LENGTH (32)
+#define BLDR_HOST_DEVICE_ID (1)
+#define BLDR_HOST_FIRMWARE_VERSION (0x00000002)
+#define BLDR_HOST_FILE_SYSTEM_VERSION (0x00000002)
+
+flash_config_t mk82FlashDriver;
+CRC_Type bldrHostCRC;
+
+extern uint8_t mk82BldrHalPublicKeyX[BLDR_HOST_KEY_LENGTH];
+extern uint8_t mk82BldrHalPublicKeyY[BLDR_HOST_KEY_LENGTH];
+
+static uint8_t *bldrHostFlash;
+static uint8_t bldrHostWeakLongwords[BLDR_HOST_FLASH_SIZE / BLDR_HOST_WRITE_UNIT_SIZE];
+static uint32_t bldrHostFirmwareErases;
+static uint32_t bldrHostFirmwareLongwords;
+static uint32_t bldrHostFirmwareVerifySections;
+static uint32_t bldrHostFirmwareProgramChecks;
+
+static uint8_t bldrHostImage[MK82_FLASH_FIRMWARE_SIZE + MK82_FLASH_FILE_SYSTEM_SIZE];
+static uint32_t bldrHostImageLength;
+
+static void bldrHostDie(const char *message)
+{
+    fprintf(stderr, "bldrHost: %s\n", message);
+    exit(1);
+}
+
+static int bldrHostInFlash(uint32_t start, uint32_t length)
+{
+    return (start >= BLDR_HOST_FLASH_START) && ((start + length) <= (BLDR_HOST_FLASH_START + BLDR_HOST_FLASH_SIZE));
+}
+
+/* The firmware region may only change while the boot info says the firmware is not valid */
+static void bldrHostCheckFirmwareRegionWrite(uint32_t start)
+{
+    MK82_BOOT_INFO bootInfo;
+
+    if (start < MK82_FLASH_FIRMWARE_START)
+    {
+        return;
+    }
+
+    mk82BootInfoGetData(&bootInfo);
+
+    if (bootInfo.firmwareValid != MK82_FALSE)
+    {
+        bldrHostDie("the firmware region is written while the firmware is valid");
+    }
+}
+
+status_t FLASH_Program(flash_config_t *config, uint32_t start, uint32_t *src, uint32_t lengthInBytes)
+{
+    uint32_t i;
+
+    (void)config;
+
+    if (!bldrHostInFlash(start, lengthInBytes) || (start % BLDR_HOST_WRITE_UNIT_SIZE) ||
+        (lengthInBytes % BLDR_HOST_WRITE_UNIT_SIZE))
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    bldrHostCheckFirmwareRegionWrite(start);
+
+    for (i = 0; i < lengthInBytes / BLDR_HOST_WRITE_UNIT_SIZE; i++)
+    {
+        uint32_t *word = (uint32_t *)&bldrHostFlash[start - BLDR_HOST_FLASH_START + (i * BLDR_HOST_WRITE_UNIT_SIZE)];
+
+        if (*word != BLDR_HOST_ERASED_WORD)
+        {
+            bldrHostDie("a longword is programmed without an erase");
+        }
+
+        *word = src[i];
+        bldrHostWeakLongwords[(start - BLDR_HOST_FLASH_START) / BLDR_HOST_WRITE_UNIT_SIZE + i] = 0;
+    }
+
+    if (start >= MK82_FLASH_FIRMWARE_START)
+    {
+        bldrHostFirmwareLongwords += lengthInBytes / BLDR_HOST_WRITE_UNIT_SIZE;
+    }
+
+    return kStatus_FLASH_Success;
+}
+
+status_t FLASH_Erase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, uint32_t key)
+{
+    (void)config;
+
+    if (!bldrHostInFlash(start, lengthInBytes) || (start % MK82_FLASH_PAGE_SIZE) ||
+        (lengthInBytes % MK82_FLASH_PAGE_SIZE) || (key != kFLASH_apiEraseKey))
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    bldrHostCheckFirmwareRegionWrite(start);
+
+    memset(&bldrHostFlash[start - BLDR_HOST_FLASH_START], 0xFF, lengthInBytes);
+    memset(&bldrHostWeakLongwords[(start - BLDR_HOST_FLASH_START) / BLDR_HOST_WRITE_UNIT_SIZE], 0,
+           lengthInBytes / BLDR_HOST_WRITE_UNIT_SIZE);
+
+    if (start >= MK82_FLASH_FIRMWARE_START)
+    {
+        bldrHostFirmwareErases += lengthInBytes / MK82_FLASH_PAGE_SIZE;
+    }
+
+    return kStatus_FLASH_Success;
+}
+
+/* Returns the offset of the first longword in the range that fails the margin level, or lengthInBytes if none does */
+static uint32_t bldrHostCheckMargin(uint32_t start, uint32_t lengthInBytes, uint32_t margin)
+{
+    uint32_t offset;
+
+    if (margin > kFLASH_marginValueFactory)
+    {
+        bldrHostDie("an unknown margin level is checked");
+    }
+
+    if (margin == kFLASH_marginValueNormal)
+    {
+        return lengthInBytes;
+    }
+
+    for (offset = 0; offset < lengthInBytes; offset += BLDR_HOST_WRITE_UNIT_SIZE)
+    {
+        if (bldrHostWeakLongwords[(start - BLDR_HOST_FLASH_START + offset) / BLDR_HOST_WRITE_UNIT_SIZE])
+        {
+            break;
+        }
+    }
+
+    return offset;
+}
+
+status_t FLASH_VerifyErase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, uint32_t margin)
+{
+    uint32_t i;
+
+    (void)config;
+
+    if (!bldrHostInFlash(start, lengthInBytes) || (start % BLDR_HOST_SECTION_UNIT_SIZE) ||
+        (lengthInBytes % BLDR_HOST_SECTION_UNIT_SIZE))
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    /* One Verify Section command */
+    if (start >= MK82_FLASH_FIRMWARE_START)
+    {
+        bldrHostFirmwareVerifySections++;
+    }
+
+    for (i = 0; i < lengthInBytes; i++)
+    {
+        if (bldrHostFlash[start - BLDR_HOST_FLASH_START + i] != 0xFF)
+        {
+            return kStatus_FLASH_Failure;
+        }
+    }
+
+    if (bldrHostCheckMargin(start, lengthInBytes, margin) != lengthInBytes)
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    return kStatus_FLASH_Success;
+}
+
+status_t FLASH_VerifyProgram(flash_config_t *config, uint32_t start, uint32_t lengthInBytes,
+                             const uint32_t *expectedData, uint32_t margin, uint32_t *failedAddress,
+                             uint32_t *failedData)
+{
+    uint32_t offset;
+
+    (void)config;
+
+    if (!bldrHostInFlash(start, lengthInBytes) || (start % BLDR_HOST_WRITE_UNIT_SIZE) ||
+        (lengthInBytes % BLDR_HOST_WRITE_UNIT_SIZE))
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    /* The driver issues one Program Check command per longword */
+    if (start >= MK82_FLASH_FIRMWARE_START)
+    {
+        bldrHostFirmwareProgramChecks += lengthInBytes / BLDR_HOST_WRITE_UNIT_SIZE;
+    }
+
+    for (offset = 0; offset < lengthInBytes; offset += BLDR_HOST_WRITE_UNIT_SIZE)
+    {
+        if (memcmp(&bldrHostFlash[start - BLDR_HOST_FLASH_START + offset], &expectedData[offset / sizeof(uint32_t)],
+                   BLDR_HOST_WRITE_UNIT_SIZE))
+        {
+            break;
+        }
+    }
+
+    if (offset == lengthInBytes)
+    {
+        offset = bldrHostCheckMargin(start, lengthInBytes, margin);
+    }
+
+    if (offset != lengthInBytes)
+    {
+        *failedAddress = start + offset;
+        memcpy(failedData, &bldrHostFlash[start - BLDR_HOST_FLASH_START + offset], sizeof(uint32_t));
+        return kStatus_FLASH_Failure;
+    }
+
+    return kStatus_FLASH_Success;
+}
+
+void CRC_GetDefaultConfig(crc_config_t *config) { memset(config, 0, sizeof(crc_config_t)); }
+
+void CRC_Init(CRC_Type *base, const crc_config_t *config)
+{
+    (void)config;
+
+    base->value = BLDR_HOST_ERASED_WORD;
+}
+
+void CRC_Deinit(CRC_Type *base) { (void)base; }
+
+void CRC_WriteData(CRC_Type *base, const uint8_t *data, size_t dataSize)
+{
+    uint32_t i;
+
+    while (dataSize--)
+    {
+        base->value ^= *data++;
+
+        for (i = 0; i < 8; i++)
+        {
+            base->value = (base->value & 1) ? ((base->value >> 1) ^ BLDR_HOST_CRC32_POLYNOMIAL) : (base->value >> 1);
+        }
+    }
+}
+
+uint32_t CRC_Get32bitResult(CRC_Type *base) { return ~base->value; }
+
+void mk82SystemMemCpy(uint8_t *dst, uint8_t *src, uint16_t length) { memmove(dst, src, length); }
+
+void mk82SystemMemSet(uint8_t *dst, uint8_t value, uint16_t length) { memset(dst, value, length); }
+
+uint16_t mk82SystemMemCmp(uint8_t *array1, uint8_t *array2, uint16_t length)
+{
+    return memcmp(array1, array2, length) ? MK82_CMP_NOT_EQUAL : MK82_CMP_EQUAL;
+}
+
+void mk82SystemFatalError(void) { bldrHostDie("fatal error in the bootloader"); }
+
+void mk82SystemGetSerialNumber(uint32_t *serialNumber) { *serialNumber = 0; }
+
+static int bldrHostRandom(void *param, unsigned char *buffer, size_t bufferLength)
+{
+    (void)param;
+
+    while (bufferLength--)
+    {
+        *buffer++ = (unsigned char)rand();
+    }
+
+    return 0;
+}
+
+static void bldrHostMapImage(const char *path)
+{
+    FILE *file;
+
+    bldrHostFlash = mmap((void *)BLDR_HOST_FLASH_START, BLDR_HOST_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+
+    if (bldrHostFlash != (uint8_t *)BLDR_HOST_FLASH_START)
+    {
+        bldrHostDie("can not map the flash, build with -no-pie and run as root");
+    }
+
+    memset(bldrHostFlash, 0xFF, BLDR_HOST_FLASH_SIZE);
+
+    if (path == NULL)
+    {
+        return;
+    }
+
+    file = fopen(path, "rb");
+
+    if ((file == NULL) || (fread(bldrHostFlash, 1, BLDR_HOST_FLASH_SIZE, file) != BLDR_HOST_FLASH_SIZE))
+    {
+        bldrHostDie("can not read the flash image");
+    }
+
+    fclose(file);
+}
+
+static void bldrHostSaveImage(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+
+    if ((file == NULL) || (fwrite(bldrHostFlash, 1, BLDR_HOST_FLASH_SIZE, file) != BLDR_HOST_FLASH_SIZE))
+    {
+        bldrHostDie("can not write the flash image");
+    }
+
+    fclose(file);
+}
+
+static void bldrHostLoadFirmware(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+
+    if (file == NULL)
+    {
+        bldrHostDie("can not read the firmware");
+    }
+
+    bldrHostImageLength = (uint32_t)fread(bldrHostImage, 1, sizeof(bldrHostImage), file);
+
+    fclose(file);
+
+    if ((bldrHostImageLength != MK82_FLASH_FIRMWARE_SIZE) && (bldrHostImageLength != sizeof(bldrHostImage)))
+    {
+        bldrHostDie("the firmware is neither the firmware region nor the firmware and file system regions");
+    }
+}
+
+/* Same layout as the header bldrHalVerifyImageSignature hashes in the bootloader */
+static void bldrHostSignImage(BLDR_GLOBAL_IMAGE_HEADER *imageHeader)
+{
+    mbedtls_ecdsa_context ecdsaContext;
+    mbedtls_sha256_context shaContext;
+    mbedtls_mpi r;
+    mbedtls_mpi s;
+    uint32_t headerWords[5];
+    uint8_t header[sizeof(headerWords)];
+    uint8_t imageHash[32];
+    int rYSign;
+    uint32_t i;
+
+    mbedtls_ecdsa_init(&ecdsaContext);
+    mbedtls_sha256_init(&shaContext);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+
+    if (mbedtls_ecdsa_genkey(&ecdsaContext, MBEDTLS_ECP_DP_SECP256R1, bldrHostRandom, NULL) ||
+        mbedtls_mpi_write_binary(&ecdsaContext.Q.X, mk82BldrHalPublicKeyX, BLDR_HOST_KEY_LENGTH) ||
+        mbedtls_mpi_write_binary(&ecdsaContext.Q.Y, mk82BldrHalPublicKeyY, BLDR_HOST_KEY_LENGTH))
+    {
+        bldrHostDie("can not make a signing key");
+    }
+
+    headerWords[0] = BLDR_GLOBAL_IMAGE_TYPE_FIRMWARE;
+    headerWords[1] = imageHeader->deviceID;
+    headerWords[2] = imageHeader->firmwareVersion;
+    headerWords[3] = imageHeader->fileSystemVersion;
+    headerWords[4] = imageHeader->bootloaderVersion;
+
+    for (i = 0; i < sizeof(header); i++)
+    {
+        header[i] = (uint8_t)(headerWords[i / 4] >> (24 - (8 * (i % 4))));
+    }
+
+    mbedtls_sha256_starts(&shaContext, 0);
+    mbedtls_sha256_update(&shaContext, header, sizeof(header));
+    mbedtls_sha256_update(&shaContext, bldrHostImage, bldrHostImageLength);
+    mbedtls_sha256_finish(&shaContext, imageHash);
+
+    if (mbedtls_ecdsa_sign(&ecdsaContext.grp, &r, &s, &ecdsaContext.d, imageHash, sizeof(imageHash), &rYSign,
+                           bldrHostRandom, NULL) ||
+        mbedtls_mpi_write_binary(&r, imageHeader->signature, BLDR_HOST_KEY_LENGTH) ||
+        mbedtls_mpi_write_binary(&s, imageHeader->signature + BLDR_HOST_KEY_LENGTH, BLDR_HOST_KEY_LENGTH))
+    {
+        bldrHostDie("can not sign the image");
+    }
+
+    mbedtls_ecdsa_free(&ecdsaContext);
+    mbedtls_sha256_free(&shaContext);
+    mbedtls_mpi_free(&r);
+    mbedtls_mpi_free(&s);
+}
+
+static void bldrHostInit(const char *flashPath)
+{
+    MK82_BOOT_INFO bootInfo;
+
+    bootInfo.firmwareVersion = MK82_BOOT_INFO_FIRMWARE_VERSION;
+    bootInfo.fileSystemVersion = MK82_BOOT_INFO_FILE_SYSTEM_VERSION;
+    bootInfo.bootloaderVersion = MK82_BOOT_INFO_BOOTLOADER_VERSION;
+    bootInfo.bootTarget = MK82_BOOT_INFO_START_BOOTLOADER;
+    bootInfo.firmwareValid = MK82_TRUE;
+    bootInfo.bootloaderValid = MK82_TRUE;
+    bootInfo.fileSystemUpdateInterrupted = MK82_FALSE;
+
+    CRC_Init(CRC0, NULL);
+    CRC_WriteData(CRC0, (uint8_t *)&bootInfo, sizeof(MK82_BOOT_INFO) - sizeof(uint32_t));
+    bootInfo.crc = CRC_Get32bitResult(CRC0);
+
+    memcpy(&bldrHostFlash[MK82_BOOT_INFO_1_FLASH_AREA_START - BLDR_HOST_FLASH_START], &bootInfo, sizeof(bootInfo));
+    memcpy(&bldrHostFlash[MK82_FLASH_FIRMWARE_START - BLDR_HOST_FLASH_START], bldrHostImage, bldrHostImageLength);
+
+    bldrHostSaveImage(flashPath);
+}
+
+/* Loads, verifies and writes the image in the order bldrCore does */
+static void bldrHostMarkWeak(const char *addressText)
+{
+    char *end;
+    uint32_t address;
+
+    address = (uint32_t)strtoul(addressText, &end, 0);
+
+    if ((*end != '\0') || !bldrHostInFlash(address, BLDR_HOST_WRITE_UNIT_SIZE) ||
+        (address % BLDR_HOST_WRITE_UNIT_SIZE))
+    {
+        bldrHostDie("the weak longword is not a longword of the flash");
+    }
+
+    bldrHostWeakLongwords[(address - BLDR_HOST_FLASH_START) / BLDR_HOST_WRITE_UNIT_SIZE] = 1;
+}
+
+static void bldrHostUpdate(const char *flashPath, int tamper)
+{
+    BLDR_GLOBAL_IMAGE_HEADER imageHeader;
+    uint32_t ramCRC32;
+    uint32_t flashCRC32;
+    uint16_t firmwareValid;
+    uint32_t offset;
+
+    imageHeader.deviceID = BLDR_HOST_DEVICE_ID;
+    imageHeader.firmwareVersion = BLDR_HOST_FIRMWARE_VERSION;
+    imageHeader.fileSystemVersion = BLDR_HOST_FILE_SYSTEM_VERSION;
+    imageHeader.bootloaderVersion = MK82_BOOT_INFO_BOOTLOADER_VERSION;
+
+    bldrHostSignImage(&imageHeader);
+
+    if (tamper)
+    {
+        bldrHostImage[bldrHostImageLength / 2] ^= 0x01;
+    }
+
+    for (offset = 0; offset < bldrHostImageLength; offset += BLDR_HOST_CHUNK_SIZE)
+    {
+        uint32_t length = bldrHostImageLength - offset;
+
+        bldrHalLoadImageData(&bldrHostImage[offset], (length < BLDR_HOST_CHUNK_SIZE) ? length : BLDR_HOST_CHUNK_SIZE,
+                             offset);
+    }
+
+    if (bldrHalVerifyImageSignature(&imageHeader, bldrHostImageLength) != BLDR_NO_ERROR)
+    {
+        if (bldrHostFirmwareErases || bldrHostFirmwareLongwords)
+        {
+            bldrHostDie("flash was written for an image that failed its signature check");
+        }
+
+        printf("rejected\n");
+        return;
+    }
+
+    if (tamper)
+    {
+        bldrHostDie("a changed image passed its signature check");
+    }
+
+    if (bldrHostImageLength != MK82_FLASH_FIRMWARE_SIZE)
+    {
+        bldrHalSetFileSystemUpdateInterruptedFlag(BLDR_TRUE);
+    }
+
+    bldrHalCalulateImageCRC32(bldrHostImageLength, &ramCRC32);
+
+    bldrHalSetFirmwareValidityFlag(BLDR_FALSE);
+    bldrHalWriteImageData(bldrHostImageLength);
+
+    bldrHalCalulateFlashContentsCRC32(bldrHostImageLength, &flashCRC32);
+
+    if (ramCRC32 != flashCRC32)
+    {
+        bldrHostDie("the flash contents differ from the image");
+    }
+
+    bldrHalClearUpdateInterruptedFlagSetVersionsAndValidateFirmware(imageHeader.firmwareVersion,
+                                                                    imageHeader.fileSystemVersion);
+
+    bldrHalIsFirmwareValid(&firmwareValid);
+
+    if ((firmwareValid != BLDR_TRUE) ||
+        memcmp(&bldrHostFlash[MK82_FLASH_FIRMWARE_START - BLDR_HOST_FLASH_START], bldrHostImage, bldrHostImageLength))
+    {
+        bldrHostDie("the update did not leave a valid copy of the image");
+    }
+
+    printf("update %u %u %u %u\n", bldrHostFirmwareErases, bldrHostFirmwareLongwords, bldrHostFirmwareVerifySections,
+           bldrHostFirmwareProgramChecks);
+
+    bldrHostSaveImage(flashPath);
+}
+
+int main(int argc, char **argv)
+{
+    if ((argc != 4) && ((argc != 5) || strcmp(argv[1], "update")))
+    {
+        bldrHostDie("usage: bldrHost init|update|reject <flash> <image>, bldrHost update <flash> <image> <address>");
+    }
+
+    bldrHostMapImage(strcmp(argv[1], "init") ? argv[2] : NULL);
+    bldrHostLoadFirmware(argv[3]);
+
+    if (!strcmp(argv[1], "init"))
+    {
+        bldrHostInit(argv[2]);
+    }
+    else if (!strcmp(argv[1], "update"))
+    {
+        if (argc == 5)
+        {
+            bldrHostMarkWeak(argv[4]);
+        }
+
+        bldrHostUpdate(argv[2], 0);
+    }
+    else if (!strcmp(argv[1], "reject"))
+    {
+        bldrHostUpdate(argv[2], 1);
+    }
+    else
+    {
+        bldrHostDie("unknown command");
+    }
+
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Host replacement of the KSDK CRC driver, implemented by bldrHost.c. The configuration is ignored and a CRC-32 is
+ * computed instead, the bootloader only compares the checksums it computes with each other.
+ */
+
+#ifndef __BLDR_HOST_FSL_CRC_H__
+#define __BLDR_HOST_FSL_CRC_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum
+{
+    kCrcBits16 = 0,
+    kCrcBits32 = 1
+} crc_bits_t;
+
+typedef enum
+{
+    kCrcFinalChecksum = 0,
+    kCrcIntermediateChecksum = 1
+} crc_result_t;
+
+typedef struct
+{
+    uint32_t polynomial;
+    uint32_t seed;
+    bool reflectIn;
+    bool reflectOut;
+    bool complementChecksum;
+    crc_bits_t crcBits;
+    crc_result_t crcResult;
+} crc_config_t;
+
+typedef struct
+{
+    uint32_t value;
+} CRC_Type;
+
+extern CRC_Type bldrHostCRC;
+
+#define CRC0 (&bldrHostCRC)
+
+void CRC_GetDefaultConfig(crc_config_t *config);
+void CRC_Init(CRC_Type *base, const crc_config_t *config);
+void CRC_Deinit(CRC_Type *base);
+void CRC_WriteData(CRC_Type *base, const uint8_t *data, size_t dataSize);
+uint32_t CRC_Get32bitResult(CRC_Type *base);
+
+#endif /* __BLDR_HOST_FSL_CRC_H__ */
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Shows how much flash work a firmware update costs in the bootloader for
+# typical point release changes.
+#
+# The bootloader HAL is built for Linux in bldrHost/ and updates a file
+# backed flash image. Each case starts from a flash holding the old firmware
+# and a valid boot info, then goes through signature check, write, CRC check
+# and validation. The erases and programmed longwords are turned into flash
+# time with the K82 timings from fsRecordStore.py and printed next to what
+# erasing the whole region first costs. The time of the changed pages
+# approach includes the margin checks of the pages it keeps: the Verify
+# Section commands over erased runs and the Program Check commands, one per
+# longword, over data.
+#
+# The firmware images are made up: CODE_SIZE bytes of random data with
+# erased flash behind them, changed the way a point release changes them. A
+# tampered image is checked to be rejected before anything is written.
+#
+# The weak cases mark one longword of the old flash as weak: it reads back
+# fine but fails the user margin check, so the page holding it has to be
+# erased and written again even where the image does not change it.
+#
+# Usage:
+#   bldrUpdateReport.py
+#
+
+import os
+import random
+import shutil
+import sys
+import tempfile
+
+from fsRecordStore import REPO_DIR, TOOLS_DIR, compile_and_link, flash_ms, run
+
+FIRMWARE_START = 0xC000
+FIRMWARE_SIZE = 0x2C000
+PAGE_SIZE = 0x1000
+LONGWORD_SIZE = 4
+CODE_SIZE = 0x24000
+
+# Maximum K82 times of the margin check commands, the datasheet gives no
+# typical ones: one Verify Section of up to a 4 KB sector, one Program Check.
+VERIFY_SECTION_US = 100.0
+PROGRAM_CHECK_US = 95.0
+
+MBEDTLS_DIR = os.path.join(REPO_DIR, 'mk82', 'middleware', 'mbedtls_2.1.2')
+MBEDTLS_SOURCES = ['sha256.c', 'ecdsa.c', 'ecp.c', 'ecp_curves.c', 'bignum.c', 'asn1parse.c', 'asn1write.c']
+
+INCLUDE_DIRS = ['mk82/tools/bldrHost/inc', 'mk82/tools/fsHost/inc', 'platform/mk82/inc', 'platform/mk82/src',
+                'platform/mk82/src/system', 'bldr/inc', 'bldr/src', 'mk82/middleware/mbedtls_2.1.2/include']
+
+USAGE = 'usage: bldrUpdateReport.py'
+
+
+def build(work_dir):
+    binary = os.path.join(work_dir, 'bldrHost')
+    flags = ['-O2', '-std=gnu99', '-no-pie', '-fno-pie', '-DBOOTLOADER',
+             '-DMBEDTLS_CONFIG_FILE=<../port/ksdk/ksdk_mbedtls_config_bldr.h>']
+    flags += ['-I' + os.path.join(REPO_DIR, path) for path in INCLUDE_DIRS]
+    files = [os.path.join(TOOLS_DIR, 'bldrHost', 'bldrHost.c'),
+             os.path.join(REPO_DIR, 'bldr', 'src', 'hal', 'k82', 'bldrHal.c'),
+             os.path.join(REPO_DIR, 'platform', 'mk82', 'src', 'system', 'mk82SystemFlash.c'),
+             os.path.join(REPO_DIR, 'platform', 'mk82', 'src', 'bootInfo', 'mk82BootInfo.c')]
+    files += [os.path.join(MBEDTLS_DIR, 'library', name) for name in MBEDTLS_SOURCES]
+    compile_and_link(flags, files, binary)
+    return binary
+
+
+def pad(code):
+    return bytes(code) + b'\xff' * (FIRMWARE_SIZE - len(code))
+
+
+def insert(code, offset, data):
+    return code[:offset] + data + code[offset:]
+
+
+def cases():
+    generator = random.Random(1)
+    code = bytes(generator.randrange(256) for _ in range(CODE_SIZE))
+
+    def noise(length):
+        return bytes(generator.randrange(256) for _ in range(length))
+
+    local_fix = bytearray(code)
+    local_fix[0x11000:0x11018] = noise(0x18)
+    local_fix[0x1E400:0x1E408] = noise(0x08)
+
+    version_bump = bytearray(code)
+    version_bump[0x400:0x404] = noise(4)
+
+    # A last page with only a few longwords of data, cheap enough to check
+    sparse = code + noise(0x40)
+
+    # Each case is a name, the old and the new image and the offset of a weak
+    # longword
+    return pad(code), [
+        ('same image', pad(code), pad(code), None),
+        ('version bump', pad(code), pad(version_bump), None),
+        ('local fix', pad(code), pad(local_fix), None),
+        ('append 1.5 KB', pad(code), pad(code + noise(0x600)), None),
+        ('grow late', pad(code), pad(insert(code, 0x20000, noise(0x30))), None),
+        ('grow early', pad(code), pad(insert(code, 0x08000, noise(0x30))), None),
+        ('sparse tail', pad(sparse), pad(sparse), None),
+        ('weak code', pad(code), pad(code), 0x10000),
+        ('weak erased', pad(code), pad(code), 0x2A000),
+        ('weak append', pad(code), pad(code + noise(0x600)), 0x24800),
+        ('weak sparse', pad(sparse), pad(sparse), 0x24020),
+    ]
+
+
+def erase_all_cost(image):
+    # Erasing every page first leaves only the erased longwords of the image
+    # already in place.
+    longwords = sum(1 for i in range(0, len(image), LONGWORD_SIZE)
+                    if image[i:i + LONGWORD_SIZE] != b'\xff' * LONGWORD_SIZE)
+    return len(image) // PAGE_SIZE, longwords
+
+
+def update(binary, work_dir, old_image, new_image, weak_offset):
+    flash = os.path.join(work_dir, 'flash.img')
+    old_path = os.path.join(work_dir, 'old.bin')
+    new_path = os.path.join(work_dir, 'new.bin')
+
+    with open(old_path, 'wb') as old_file, open(new_path, 'wb') as new_file:
+        old_file.write(old_image)
+        new_file.write(new_image)
+
+    run(binary, 'init', flash, old_path)
+    weak = [] if weak_offset is None else ['0x%X' % (FIRMWARE_START + weak_offset)]
+    fields = run(binary, 'update', flash, new_path, *weak).split()
+    return tuple(int(field) for field in fields[1:5])
+
+
+def check_ms(sections, checks):
+    return (sections * VERIFY_SECTION_US + checks * PROGRAM_CHECK_US) / 1000
+
+
+def reject(binary, work_dir, old_image):
+    flash = os.path.join(work_dir, 'flash.img')
+    old_path = os.path.join(work_dir, 'old.bin')
+
+    with open(old_path, 'wb') as old_file:
+        old_file.write(old_image)
+
+    run(binary, 'init', flash, old_path)
+    if run(binary, 'reject', flash, old_path).strip() != 'rejected':
+        sys.exit('A tampered image was not rejected')
+
+
+def main():
+    if len(sys.argv) != 1:
+        sys.exit(USAGE)
+
+    base_image, updates = cases()
+
+    work_dir = tempfile.mkdtemp()
+    try:
+        binary = build(work_dir)
+        reject(binary, work_dir, base_image)
+        results = [(name, erase_all_cost(new_image), update(binary, work_dir, old_image, new_image, weak_offset))
+                   for name, old_image, new_image, weak_offset in updates]
+    finally:
+        shutil.rmtree(work_dir)
+
+    print('%d KB of code in the %d KB firmware region, a tampered image is rejected before any write' % (
+        CODE_SIZE // 1024, FIRMWARE_SIZE // 1024))
+    print()
+    print('%-14s %22s %44s %22s' % ('', 'erase all', 'changed pages', 'flash ms'))
+    print('%-14s %10s %11s %10s %11s %10s %11s %10s %11s' % ('case', 'erases', 'longwords', 'erases', 'longwords',
+                                                            'sections', 'checks', 'before', 'after'))
+    for name, (erases_before, longwords_before), (erases, longwords, sections, checks) in results:
+        print('%-14s %10d %11d %10d %11d %10d %11d %10.1f %11.1f' % (
+            name, erases_before, longwords_before, erases, longwords, sections, checks,
+            flash_ms(longwords_before, erases_before), flash_ms(longwords, erases) + check_ms(sections, checks)))
+
+
+if __name__ == '__main__':
+    main()
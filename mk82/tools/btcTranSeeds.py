@@ -0,0 +1,228 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Writes the seeds of the btcTran fuzz target to fuzzHost/corpus/btcTran.
+# Each seed is the APDU sequence a btchip-python wallet sends for one
+# operation: public key export, message signing, trusted input generation
+# and legacy and segwit transaction signing, with the reads of the
+# transaction a companion app makes while the user is asked to confirm.
+# The trusted inputs carry the MAC of the stand-in in btcTranFuzz.c.
+#
+# Usage:
+#   btcTranSeeds.py
+#
+
+import hashlib
+import os
+import struct
+
+from fsRecordStore import TOOLS_DIR
+
+CORPUS_DIR = os.path.join(TOOLS_DIR, 'fuzzHost', 'corpus', 'btcTran')
+
+CONTROL_CCID = 0x01
+CONTROL_WHILE_WAITING = 0x02
+CONTROL_DECLINE = 0x04
+
+PIN = b'1234'
+MAC_KEY = b'btcTranFuzz'
+
+CHUNK_SIZE = 200
+HARDENED = 0x80000000
+PATH = [44 | HARDENED, 0 | HARDENED, 0 | HARDENED, 0, 0]
+SEQUENCE = b'\xff\xff\xff\xff'
+SIGHASH_ALL = 0x01
+
+
+def record(apdu, control=0):
+    return bytes([control]) + struct.pack('>H', len(apdu)) + apdu
+
+
+def apdu(ins, p1p2, data=None):
+    command = bytes([0xE0, ins]) + struct.pack('>H', p1p2)
+    if data is None:
+        return command + b'\x00'
+    if len(data) > 0xFF:
+        return command + b'\x00' + struct.pack('>H', len(data)) + data
+    return command + bytes([len(data)]) + data
+
+
+def varint(value):
+    if value < 0xFD:
+        return bytes([value])
+    return b'\xfd' + struct.pack('<H', value)
+
+
+def path(indexes):
+    return bytes([len(indexes)]) + b''.join(struct.pack('>I', index) for index in indexes)
+
+
+def sha256d(data):
+    return hashlib.sha256(hashlib.sha256(data).digest()).digest()
+
+
+def p2pkh(number):
+    return b'\x76\xa9\x14' + bytes([number]) * 20 + b'\x88\xac'
+
+
+def transaction(inputs, outputs):
+    data = struct.pack('<I', 1) + varint(len(inputs))
+    for prevout, script in inputs:
+        data += prevout + varint(len(script)) + script + SEQUENCE
+    data += varint(len(outputs))
+    for amount, script in outputs:
+        data += struct.pack('<q', amount) + varint(len(script)) + script
+    return data + struct.pack('<I', 0)
+
+
+def trusted_input(previous, index, amount):
+    blob = struct.pack('<I', 0xBB1) + sha256d(previous) + struct.pack('<I', index) + struct.pack('<q', amount)
+    return blob + hashlib.sha256(MAC_KEY + blob).digest()[:8]
+
+
+def chunks(data):
+    return [data[i:i + CHUNK_SIZE] for i in range(0, len(data), CHUNK_SIZE)]
+
+
+def verify_pin():
+    return record(apdu(0x22, 0x0000, PIN))
+
+
+def get_trusted_input(previous, index):
+    records = b''
+    for number, chunk in enumerate(chunks(struct.pack('>I', index) + previous)):
+        records += record(apdu(0x42, 0x0000 if number == 0 else 0x8000, chunk))
+    return records
+
+
+def outputs_data(outputs):
+    data = varint(len(outputs))
+    for amount, script in outputs:
+        data += struct.pack('<q', amount) + varint(len(script)) + script
+    return data
+
+
+def finalize_full(outputs, control=0):
+    records = b''
+    pieces = chunks(outputs_data(outputs))
+    for number, chunk in enumerate(pieces):
+        records += record(apdu(0x4A, 0x8000 if number == len(pieces) - 1 else 0x0000, chunk), control)
+    return records
+
+
+def hash_sign(control=0):
+    return record(apdu(0x48, 0x0000, path(PATH) + b'\x00' + struct.pack('>I', 0) + bytes([SIGHASH_ALL])), control)
+
+
+def read_transaction():
+    return (record(apdu(0xE0, 0x0000), CONTROL_WHILE_WAITING) +
+            record(apdu(0xE0, 0x0100, b'\x00\x00'), CONTROL_WHILE_WAITING) +
+            record(apdu(0xE0, 0x0200), CONTROL_WHILE_WAITING))
+
+
+def previous_transactions(count):
+    previous = []
+    for number in range(count):
+        inputs = [(bytes([0x10 + number]) * 32 + struct.pack('<I', 0), b'\x00' * 107)]
+        outputs = [(50000 + number, p2pkh(1)), (100000 + number, p2pkh(2))]
+        previous.append((transaction(inputs, outputs), 1, 100000 + number, p2pkh(2)))
+    return previous
+
+
+def legacy_signing(count, control=0):
+    previous = previous_transactions(count)
+    outputs = [(120000, p2pkh(3)), (count * 1000, p2pkh(4))]
+
+    records = verify_pin()
+    for tx, index, _, _ in previous:
+        records += get_trusted_input(tx, index)
+
+    for signing in range(count):
+        records += record(apdu(0x44, 0x0000 if signing == 0 else 0x0080, struct.pack('<I', 1) + varint(count)),
+                          control)
+        for number, (tx, index, amount, script) in enumerate(previous):
+            script = script if number == signing else b''
+            data = b'\x01\x38' + trusted_input(tx, index, amount) + varint(len(script)) + script + SEQUENCE
+            records += record(apdu(0x44, 0x8000, data), control)
+        records += finalize_full(outputs, control)
+        records += hash_sign(control)
+        if signing == 0:
+            records += read_transaction()
+    return records
+
+
+def segwit_input(number, amount, script):
+    prevout = bytes([0x20 + number]) * 32 + struct.pack('<I', number)
+    return b'\x02' + prevout + struct.pack('<q', amount) + varint(len(script)) + script + SEQUENCE
+
+
+def segwit_signing(count, control=0):
+    outputs = [(120000, p2pkh(3)), (count * 1000, p2pkh(4))]
+
+    records = verify_pin()
+    data = struct.pack('<I', 2) + varint(count)
+    for number in range(count):
+        data += segwit_input(number, 100000 + number, b'')
+    for number, chunk in enumerate(chunks(data)):
+        records += record(apdu(0x44, 0x0002 if number == 0 else 0x8000, chunk), control)
+    records += finalize_full(outputs, control)
+
+    for signing in range(count):
+        records += record(apdu(0x44, 0x0080, struct.pack('<I', 2) + varint(1)), control)
+        records += record(apdu(0x44, 0x8000, segwit_input(signing, 100000 + signing, p2pkh(2))), control)
+        records += hash_sign(control)
+        if signing == 0:
+            records += read_transaction()
+    return records
+
+
+def segwit_too_many_inputs():
+    count = 101
+    data = struct.pack('<I', 2) + varint(count)
+    for number in range(count):
+        data += segwit_input(number, 1000, b'')
+    records = verify_pin()
+    records += record(apdu(0x44, 0x0002, data[:2000]), CONTROL_CCID)
+    records += record(apdu(0x44, 0x8000, data[2000:4000]), CONTROL_CCID)
+    records += record(apdu(0x44, 0x8000, data[4000:]), CONTROL_CCID)
+    return records
+
+
+def message_signing(message, control=0):
+    return (verify_pin() +
+            record(apdu(0x4E, 0x0000, path(PATH) + bytes([len(message)]) + message)) +
+            record(apdu(0x4E, 0x8000, b'\x00'), control))
+
+
+SEEDS = {
+    'getFirmwareVersion': record(apdu(0xC4, 0x0000)),
+    'getRandom': record(apdu(0xC0, 0x0000)),
+    'verifyPinWrong': record(apdu(0x22, 0x0000, b'4321')) + record(apdu(0x22, 0x8000, b'\x00')),
+    'getWalletPublicKey': verify_pin() + record(apdu(0x40, 0x0000, path(PATH))),
+    'signMessage': message_signing(b'Secalot'),
+    'signMessageDeclined': message_signing(b'Secalot', CONTROL_DECLINE),
+    'getTrustedInput': verify_pin() + get_trusted_input(previous_transactions(1)[0][0], 1),
+    'signLegacy': legacy_signing(2),
+    'signLegacyCcid': legacy_signing(1, CONTROL_CCID),
+    'signSegwit': segwit_signing(2),
+    'signSegwitDeclined': segwit_signing(1, CONTROL_DECLINE),
+    'segwitTooManyInputs': segwit_too_many_inputs(),
+}
+
+
+def main():
+    os.makedirs(CORPUS_DIR, exist_ok=True)
+    for name, data in sorted(SEEDS.items()):
+        with open(os.path.join(CORPUS_DIR, name), 'wb') as seed:
+            seed.write(data)
+        print('%-20s %5d bytes' % (name, len(data)))
+
+
+if __name__ == '__main__':
+    main()
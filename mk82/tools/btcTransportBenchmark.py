@@ -0,0 +1,190 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Compares the wallet HID interface with the vendor bulk interface of a device
+# built with USE_VENDOR_BULK. Both carry the same APDU stream, so the tool
+# replays the APDU sizes of signing a transaction with the given number of
+# inputs over each of them and prints the time spent on the wire.
+#
+# The APDUs use an instruction the wallet does not implement, so the device
+# rejects each one at once and the timings do not include any signing.
+#
+# model prints what the USB schedule alone allows, without a device: every
+# HID report waits for its 5 ms interrupt slot, while a bulk transfer of up
+# to 320 bytes fits in one 1 ms full speed frame and its response in the
+# next. Device processing time is not included.
+#
+# Usage:
+#   btcTransportBenchmark.py [inputs]          default 100 inputs
+#   btcTransportBenchmark.py model [inputs]
+#
+
+import sys
+import time
+
+VENDOR_ID = 0x1209
+PRODUCT_ID = 0x7000
+HID_INTERFACE = 3
+BULK_INTERFACE = 4
+BULK_OUT_ENDPOINT = 0x05
+BULK_IN_ENDPOINT = 0x85
+
+HID_FRAME_SIZE = 64
+HID_CHANNEL = 0x0101
+HID_TAG_APDU = 0x05
+
+BULK_PACKET_SIZE = 64
+MAX_RESPONSE_SIZE = 320
+TIMEOUT_MS = 5000
+
+HID_INTERVAL_MS = 5
+FRAME_MS = 1
+HID_FIRST_FRAME_HEADER = 7
+HID_FRAME_HEADER = 5
+STATUS_WORD_SIZE = 2
+
+CLA = 0xE0
+INS_UNUSED = 0x00
+
+USAGE = 'usage: btcTransportBenchmark.py [model] [inputs]'
+
+
+def transaction_apdu_sizes(inputs):
+    # Per input: the previous transaction split into a trusted input request,
+    # then the input itself hashed twice, once with its script for signing.
+    sizes = [60]
+    for _ in range(inputs):
+        sizes += [255, 255, 60, 60, 110]
+    sizes += [60, 255, 60]
+    return sizes
+
+
+def build_apdu(size):
+    data_length = size - 5
+    return bytes([CLA, INS_UNUSED, 0x00, 0x00, data_length]) + bytes(data_length)
+
+
+class HidTransport:
+    def __init__(self):
+        import hid
+
+        for info in hid.enumerate(VENDOR_ID, PRODUCT_ID):
+            if info['interface_number'] == HID_INTERFACE:
+                self.device = hid.device()
+                self.device.open_path(info['path'])
+                return
+
+        sys.exit('Secalot wallet HID interface not found')
+
+    def exchange(self, apdu):
+        data = len(apdu).to_bytes(2, 'big') + apdu
+        sequence = 0
+        while data:
+            header = HID_CHANNEL.to_bytes(2, 'big') + bytes([HID_TAG_APDU]) + sequence.to_bytes(2, 'big')
+            frame = (header + data[:HID_FRAME_SIZE - len(header)]).ljust(HID_FRAME_SIZE, b'\x00')
+            data = data[HID_FRAME_SIZE - len(header):]
+            self.device.write(b'\x00' + frame)
+            sequence += 1
+
+        response = b''
+        response_length = None
+        while response_length is None or len(response) < response_length:
+            frame = bytes(self.device.read(HID_FRAME_SIZE, TIMEOUT_MS))
+            if len(frame) != HID_FRAME_SIZE:
+                sys.exit('HID read timed out')
+            payload = frame[5:]
+            if response_length is None:
+                response_length = int.from_bytes(payload[:2], 'big')
+                payload = payload[2:]
+            response += payload
+        return response[:response_length]
+
+    def close(self):
+        self.device.close()
+
+
+class BulkTransport:
+    def __init__(self):
+        import usb.core
+        import usb.util
+
+        self.device = usb.core.find(idVendor=VENDOR_ID, idProduct=PRODUCT_ID)
+        if self.device is None:
+            sys.exit('Secalot device not found')
+        usb.util.claim_interface(self.device, BULK_INTERFACE)
+
+    def exchange(self, apdu):
+        self.device.write(BULK_OUT_ENDPOINT, apdu, TIMEOUT_MS)
+        # The device ends a transfer with a short packet, so a multiple of the
+        # packet size needs an explicit zero length packet.
+        if len(apdu) % BULK_PACKET_SIZE == 0:
+            self.device.write(BULK_OUT_ENDPOINT, b'', TIMEOUT_MS)
+        return bytes(self.device.read(BULK_IN_ENDPOINT, MAX_RESPONSE_SIZE, TIMEOUT_MS))
+
+    def close(self):
+        import usb.util
+
+        usb.util.release_interface(self.device, BULK_INTERFACE)
+
+
+def hid_frames(length):
+    first = HID_FRAME_SIZE - HID_FIRST_FRAME_HEADER
+    if length <= first:
+        return 1
+    rest = HID_FRAME_SIZE - HID_FRAME_HEADER
+    return 1 + (length - first + rest - 1) // rest
+
+
+def model(apdus, total):
+    hid = sum((hid_frames(len(apdu)) + hid_frames(STATUS_WORD_SIZE)) * HID_INTERVAL_MS for apdu in apdus) / 1000
+    bulk = len(apdus) * 2 * FRAME_MS / 1000
+    for name, elapsed in (('hid', hid), ('bulk', bulk)):
+        print('%-5s %8.3f s %8.2f ms/APDU %8.1f KB/s  (schedule bound)' % (name, elapsed, 1000 * elapsed / len(apdus),
+                                                                          total / elapsed / 1024))
+
+
+def run(transport, apdus):
+    start = time.perf_counter()
+    for apdu in apdus:
+        response = transport.exchange(apdu)
+        if len(response) < 2:
+            sys.exit('Short response %s' % response.hex())
+    return time.perf_counter() - start
+
+
+def main():
+    args = sys.argv[1:]
+    modelled = bool(args) and args[0] == 'model'
+    if modelled:
+        args = args[1:]
+    if len(args) > 1 or (args and not args[0].isdigit()):
+        sys.exit(USAGE)
+
+    inputs = int(args[0]) if args else 100
+    apdus = [build_apdu(size) for size in transaction_apdu_sizes(inputs)]
+    total = sum(len(apdu) for apdu in apdus)
+
+    print('%d inputs, %d APDUs, %d bytes' % (inputs, len(apdus), total))
+
+    if modelled:
+        model(apdus, total)
+        return
+
+    for name, transport_class in (('hid', HidTransport), ('bulk', BulkTransport)):
+        transport = transport_class()
+        try:
+            elapsed = run(transport, apdus)
+        finally:
+            transport.close()
+        print('%-5s %8.3f s %8.2f ms/APDU %8.1f KB/s' % (name, elapsed, 1000 * elapsed / len(apdus),
+                                                         total / elapsed / 1024))
+
+
+if __name__ == '__main__':
+    main()
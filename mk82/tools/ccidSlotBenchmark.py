@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Interleaves an OpenPGP signing client with an SSL tunnel client, first
+# through a single reader and then with each client on its own CCID slot.
+#
+# On a shared reader every switch between the clients re-SELECTs the applet,
+# and selecting OpenPGP drops the PIN status, so the signer has to VERIFY
+# again. On separate slots both applets stay selected.
+#
+# Without a PIN the signing client only reads its application data, which
+# still shows the cost of the reselects.
+#
+# Connecting powers the slot on, which resets it, so every run starts with
+# nothing selected and the PIN not verified.
+#
+# Usage:
+#   ccidSlotBenchmark.py [rounds] [pin]     default 50 rounds, no PIN
+#
+
+import hashlib
+import sys
+import time
+
+OPGP_AID = [0xD2, 0x76, 0x00, 0x01, 0x24, 0x01]
+SSL_AID = [0x53, 0x53, 0x4C, 0x41, 0x50, 0x50, 0x4C, 0x45, 0x54]
+
+OPGP_GET_APPLICATION_DATA = [0x00, 0xCA, 0x00, 0x6E, 0x00]
+SSL_GET_PUBLIC_KEY = [0x80, 0x10, 0x00, 0x00, 0x00]
+
+SHA256_DIGEST_INFO = bytes.fromhex('3031300d060960864801650304020105000420')
+
+SW_NO_ERROR = 0x9000
+SW_SECURITY_STATUS_NOT_SATISFIED = 0x6982
+
+USAGE = 'usage: ccidSlotBenchmark.py [rounds] [pin]'
+
+
+def find_slots():
+    from smartcard.System import readers
+
+    slots = [reader for reader in readers() if 'Secalot' in str(reader)]
+    if not slots:
+        sys.exit('Secalot reader not found')
+    return slots
+
+
+def connect(reader):
+    connection = reader.createConnection()
+    connection.connect()
+    return connection
+
+
+def transmit(connection, apdu):
+    data, sw1, sw2 = connection.transmit(list(apdu))
+    return data, (sw1 << 8) | sw2
+
+
+def check(connection, apdu):
+    data, sw = transmit(connection, apdu)
+    if sw != SW_NO_ERROR:
+        sys.exit('APDU %s failed with SW %04X' % (bytes(apdu[:4]).hex(), sw))
+    return data
+
+
+class Counters:
+    def __init__(self):
+        self.selects = 0
+        self.verifies = 0
+
+
+def select(connection, aid, counters):
+    check(connection, [0x00, 0xA4, 0x04, 0x00, len(aid)] + aid)
+    counters.selects += 1
+
+
+def sign(connection, pin, counters):
+    if pin is None:
+        check(connection, OPGP_GET_APPLICATION_DATA)
+        return
+
+    digest = SHA256_DIGEST_INFO + hashlib.sha256(b'ccidSlotBenchmark').digest()
+    apdu = [0x00, 0x2A, 0x9E, 0x9A, len(digest)] + list(digest) + [0x00]
+
+    _, sw = transmit(connection, apdu)
+    if sw == SW_SECURITY_STATUS_NOT_SATISFIED:
+        check(connection, [0x00, 0x20, 0x00, 0x81, len(pin)] + list(pin))
+        counters.verifies += 1
+        _, sw = transmit(connection, apdu)
+    if sw != SW_NO_ERROR:
+        sys.exit('Signature failed with SW %04X' % sw)
+
+
+def run_shared(reader, rounds, pin):
+    counters = Counters()
+    connection = connect(reader)
+    start = time.perf_counter()
+    for _ in range(rounds):
+        select(connection, OPGP_AID, counters)
+        sign(connection, pin, counters)
+        select(connection, SSL_AID, counters)
+        check(connection, SSL_GET_PUBLIC_KEY)
+    elapsed = time.perf_counter() - start
+    connection.disconnect()
+    return elapsed, counters
+
+
+def run_slots(signer_reader, tunnel_reader, rounds, pin):
+    counters = Counters()
+    signer = connect(signer_reader)
+    tunnel = connect(tunnel_reader)
+    start = time.perf_counter()
+    select(signer, OPGP_AID, counters)
+    select(tunnel, SSL_AID, counters)
+    for _ in range(rounds):
+        sign(signer, pin, counters)
+        check(tunnel, SSL_GET_PUBLIC_KEY)
+    elapsed = time.perf_counter() - start
+    signer.disconnect()
+    tunnel.disconnect()
+    return elapsed, counters
+
+
+def report(name, rounds, elapsed, counters):
+    print('%-7s %8.3f s %8.2f ms/round %5d SELECT %5d VERIFY' % (name, elapsed, 1000 * elapsed / rounds,
+                                                                 counters.selects, counters.verifies))
+
+
+def main():
+    if len(sys.argv) > 3:
+        sys.exit(USAGE)
+
+    rounds = int(sys.argv[1]) if len(sys.argv) >= 2 else 50
+    pin = sys.argv[2].encode() if len(sys.argv) == 3 else None
+
+    slots = find_slots()
+
+    report('shared', rounds, *run_shared(slots[0], rounds, pin))
+
+    if len(slots) < 2:
+        print('Only one slot found, skipping the multi-slot run')
+        return
+
+    report('slots', rounds, *run_slots(slots[0], slots[1], rounds, pin))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Reads the file system wear counters from a device built with USE_DIAG and
+# projects how many more U2F authentications, HOTP codes and OpenPGP
+# signatures the file system flash region can take at the observed erase
+# rates.
+#
+# image reads the counters out of a flash image instead, such as a dump of
+# the file system region taken with a debugger. The file system is mounted
+# on Linux by fsHost, so the counters include what is not saved yet on the
+# device only up to its last save.
+#
+# Usage:
+#   flashWearReport.py dump <file>                   save the raw counters as JSON
+#   flashWearReport.py report [file]                 print counters and projected lifetime
+#   flashWearReport.py image <fs.hex> [uffs|record]  print them for a flash image, UFFS by default
+#
+
+import json
+import os
+import shutil
+import sys
+import tempfile
+
+DIAG_AID = [0x44, 0x49, 0x41, 0x47, 0x41, 0x50, 0x50, 0x4C, 0x45, 0x54]
+
+NUMBER_OF_BLOCKS = 8
+NUMBER_OF_FILE_IDS = 22
+PAGES_PER_BLOCK = 16
+
+# Guaranteed program/erase cycles per sector of the K82 program flash.
+FLASH_ENDURANCE = 10000
+
+FILE_NAMES = ['(internal)', 'OPGP_COUNTERS', 'OPGP_CERTIFICATES', 'OPGP_KEYS', 'OPGP_DATA', 'SF_COUNTERS',
+              'KEYSAFE_DATA', 'OTP_COUNTERS', 'OTP_KEYS', 'OTP_DATA', 'BTC_COUNTERS', 'BTC_KEYS', 'BTC_DATA',
+              'ETH_COUNTERS', 'ETH_KEYS', 'ETH_DATA', 'SSL_KEYS', 'XRP_COUNTERS', 'XRP_KEYS', 'XRP_DATA', 'OTP_TIME',
+              'OPGP_PRIME_POOL', 'OTP_KEY_MIDSTATES']
+
+# Each of these operations commits its counter file exactly once.
+WORKLOADS = [('U2F authentication', 5), ('HOTP code', 7), ('OpenPGP signature', 1)]
+
+USAGE = 'usage: flashWearReport.py dump <file> | report [file] | image <fs.hex> [uffs|record]'
+
+
+def connect():
+    from smartcard.System import readers
+
+    for reader in readers():
+        if 'Secalot' in str(reader):
+            connection = reader.createConnection()
+            connection.connect()
+            transmit(connection, [0x00, 0xA4, 0x04, 0x00, len(DIAG_AID)] + DIAG_AID)
+            return connection
+
+    sys.exit('Secalot reader not found')
+
+
+def transmit(connection, apdu):
+    data, sw1, sw2 = connection.transmit(apdu)
+    if (sw1, sw2) != (0x90, 0x00):
+        sys.exit('APDU %s failed with SW %02X%02X' % (bytes(apdu[:4]).hex(), sw1, sw2))
+    return bytes(data)
+
+
+def read_counters(connection):
+    data = transmit(connection, [0x80, 0x04, 0x00, 0x00, 0x00])
+    return parse_counters([int.from_bytes(data[i:i + 4], 'big') for i in range(0, len(data), 4)])
+
+
+def read_image_counters(hex_path, record_store):
+    import fsRecordStore
+
+    work_dir = tempfile.mkdtemp()
+    try:
+        binary = fsRecordStore.build(work_dir, record_store)
+        image = os.path.join(work_dir, 'fs.img')
+        fsRecordStore.write_image(image, fsRecordStore.read_hex(hex_path))
+        values = [int(value) for value in fsRecordStore.run(binary, 'wear', image).split()]
+    finally:
+        shutil.rmtree(work_dir)
+
+    return parse_counters(values)
+
+
+def parse_counters(values):
+    files = NUMBER_OF_FILE_IDS + 1
+    return {
+        'blockErases': values[:NUMBER_OF_BLOCKS],
+        'pageWrites': values[NUMBER_OF_BLOCKS],
+        'fileCommits': values[NUMBER_OF_BLOCKS + 1:NUMBER_OF_BLOCKS + 1 + files],
+        'fileErases': values[NUMBER_OF_BLOCKS + 1 + files:NUMBER_OF_BLOCKS + 1 + 2 * files],
+    }
+
+
+def report(counters):
+    blockErases = counters['blockErases']
+    totalErases = sum(blockErases)
+
+    print('Block erases: %s (max %d, total %d)' % (' '.join(str(e) for e in blockErases), max(blockErases),
+                                                  totalErases))
+    print('Page writes:  %d' % counters['pageWrites'])
+    print()
+    print('%-18s %10s %10s' % ('File', 'Commits', 'Erases'))
+    for name, commits, erases in zip(FILE_NAMES, counters['fileCommits'], counters['fileErases']):
+        if commits or erases:
+            print('%-18s %10d %10d' % (name, commits, erases))
+
+    # UFFS spreads erases over all blocks, so the budget is shared by the whole region.
+    remainingErases = NUMBER_OF_BLOCKS * FLASH_ENDURANCE - totalErases
+    print()
+    print('Remaining erase budget: %d of %d' % (remainingErases, NUMBER_OF_BLOCKS * FLASH_ENDURANCE))
+
+    for name, fileID in WORKLOADS:
+        commits = counters['fileCommits'][fileID]
+        erases = counters['fileErases'][fileID]
+        if commits == 0:
+            print('%-20s no data' % name)
+            continue
+        if erases == 0:
+            # Not enough history yet, assume every page of a block is used once before it is erased.
+            erasesPerOperation = 1.0 / PAGES_PER_BLOCK
+            source = 'estimated'
+        else:
+            erasesPerOperation = erases / commits
+            source = 'observed over %d operations' % commits
+        print('%-20s %.4f erases each, ~%d more operations (%s)' %
+              (name, erasesPerOperation, remainingErases / erasesPerOperation, source))
+
+
+def main(argv):
+    if len(argv) >= 2 and argv[1] == 'dump' and len(argv) == 3:
+        with open(argv[2], 'w') as f:
+            json.dump(read_counters(connect()), f)
+    elif len(argv) >= 2 and argv[1] == 'report' and len(argv) <= 3:
+        if len(argv) == 3:
+            with open(argv[2]) as f:
+                counters = json.load(f)
+        else:
+            counters = read_counters(connect())
+        report(counters)
+    elif len(argv) in (3, 4) and argv[1] == 'image' and argv[3:] in ([], ['uffs'], ['record']):
+        report(read_image_counters(argv[2], argv[3:] == ['record']))
+    else:
+        sys.exit(USAGE)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,710 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Runs the file system of the firmware on a Linux host. The file system region is a raw image file mapped at its real
+ * address, and the flash driver below gives it the program and erase behaviour of the K82 program flash.
+ *
+ * Built by fsRecordStore.py, once with UFFS and once with USE_RECORD_STORE, and used by fsLatencyReport.py.
+ *
+ * Usage:
+ *   fsHost mount <image>              mount the image and print the time it took
+ *   fsHost dump <image> <file>        save the contents of every file ID
+ *   fsHost load <image> <file>        write the contents saved by dump, one commit per file ID
+ *   fsHost bench <image> <rounds>     run a set of application writes and print the flash work they cost
+ *   fsHost latency <image> <rounds> <idle>
+ *                                     print the flash work of each write, with idle passes in between if idle is 1
+ *   fsHost map <image> <rounds>       check mk82FsMapFile against mk82FsReadFile and time both on the OpenPGP
+ *                                     certificate
+ *   fsHost crc <image> <rounds>       check the CRC UFFS gets through CONFIG_PLATFORM_CRC16 against its table
+ *   fsHost wear <image>               print the wear counters kept in the image, in the order the diagnostic applet
+ *                                     sends them
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "mk82Global.h"
+#include "mk82System.h"
+#include "mk82Fs.h"
+#include "fs/mk82FsInt.h"
+#include "uffs/uffs_crc.h"
+
+#include "fsl_device_registers.h"
+
+#define FS_HOST_WRITE_UNIT_SIZE (FSL_FEATURE_FLASH_PFLASH_BLOCK_WRITE_UNIT_SIZE)
+/* Superloop passes between two commands, each one calls mk82FsIdleTask */
+#define FS_HOST_IDLE_PASSES (4)
+/* Kept small so that mapping a file takes several calls */
+#define FS_HOST_MAP_EXTENTS (4)
+#define FS_HOST_MAP_SLICES (50)
+/* MK82_SYSTEM_CRC16_POLYNOMIAL reflected */
+#define FS_HOST_CRC16_POLYNOMIAL (0x8408)
+#define FS_HOST_CRC_MAX_LENGTH (MK82_FLASH_PAGE_SIZE)
+
+flash_config_t mk82FlashDriver;
+
+static uint8_t *fsHostFlash;
+static uint32_t fsHostLongwordsProgrammed;
+static uint32_t fsHostProgramCalls;
+static uint32_t fsHostSectorErases[MK82_FLASH_FILE_SYSTEM_SIZE / MK82_FLASH_PAGE_SIZE];
+
+static uint8_t fsHostFileBuffer[MK82_FS_NUMBER_OF_FILE_IDS + 1][4096];
+static uint8_t fsHostFill;
+
+static void fsHostDie(const char *message)
+{
+    fprintf(stderr, "fsHost: %s\n", message);
+    exit(1);
+}
+
+static int fsHostInFileSystem(uint32_t start, uint32_t length)
+{
+    return (start >= MK82_FLASH_FILE_SYSTEM_START) &&
+           ((start + length) <= (MK82_FLASH_FILE_SYSTEM_START + MK82_FLASH_FILE_SYSTEM_SIZE));
+}
+
+status_t FLASH_Program(flash_config_t *config, uint32_t start, uint32_t *src, uint32_t lengthInBytes)
+{
+    uint8_t *data = (uint8_t *)src;
+    uint32_t i;
+
+    (void)config;
+
+    if (!fsHostInFileSystem(start, lengthInBytes) || (start % FS_HOST_WRITE_UNIT_SIZE) ||
+        (lengthInBytes % FS_HOST_WRITE_UNIT_SIZE))
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    /* NOR flash can only clear bits */
+    for (i = 0; i < lengthInBytes; i++)
+    {
+        fsHostFlash[start - MK82_FLASH_FILE_SYSTEM_START + i] &= data[i];
+    }
+
+    fsHostLongwordsProgrammed += lengthInBytes / FS_HOST_WRITE_UNIT_SIZE;
+    fsHostProgramCalls++;
+
+    return kStatus_FLASH_Success;
+}
+
+status_t FLASH_Erase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, uint32_t key)
+{
+    uint32_t sector;
+
+    (void)config;
+
+
+    if (!fsHostInFileSystem(start, lengthInBytes) || (start % MK82_FLASH_PAGE_SIZE) ||
+        (lengthInBytes % MK82_FLASH_PAGE_SIZE) || (key != kFLASH_apiEraseKey))
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    memset(&fsHostFlash[start - MK82_FLASH_FILE_SYSTEM_START], 0xFF, lengthInBytes);
+
+    for (sector = (start - MK82_FLASH_FILE_SYSTEM_START) / MK82_FLASH_PAGE_SIZE;
+         sector < (start - MK82_FLASH_FILE_SYSTEM_START + lengthInBytes) / MK82_FLASH_PAGE_SIZE; sector++)
+    {
+        fsHostSectorErases[sector]++;
+    }
+
+    return kStatus_FLASH_Success;
+}
+
+status_t FLASH_VerifyErase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, uint32_t margin)
+{
+    uint32_t i;
+
+    (void)config;
+    (void)margin;
+
+    if (!fsHostInFileSystem(start, lengthInBytes))
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    for (i = 0; i < lengthInBytes; i++)
+    {
+        if (fsHostFlash[start - MK82_FLASH_FILE_SYSTEM_START + i] != 0xFF)
+        {
+            return kStatus_FLASH_Failure;
+        }
+    }
+
+    return kStatus_FLASH_Success;
+}
+
+status_t FLASH_VerifyProgram(flash_config_t *config, uint32_t start, uint32_t lengthInBytes,
+                             const uint32_t *expectedData, uint32_t margin, uint32_t *failedAddress,
+                             uint32_t *failedData)
+{
+    (void)config;
+    (void)margin;
+    (void)failedAddress;
+    (void)failedData;
+
+    if (!fsHostInFileSystem(start, lengthInBytes) ||
+        memcmp(&fsHostFlash[start - MK82_FLASH_FILE_SYSTEM_START], expectedData, lengthInBytes))
+    {
+        return kStatus_FLASH_Failure;
+    }
+
+    return kStatus_FLASH_Success;
+}
+
+void mk82SystemMemCpy(uint8_t *dst, uint8_t *src, uint16_t length) { memmove(dst, src, length); }
+
+void mk82SystemMemSet(uint8_t *dst, uint8_t value, uint16_t length) { memset(dst, value, length); }
+
+uint16_t mk82SystemMemCmp(uint8_t *array1, uint8_t *array2, uint16_t length)
+{
+    return memcmp(array1, array2, length) ? MK82_CMP_NOT_EQUAL : MK82_CMP_EQUAL;
+}
+
+void mk82SystemFatalError(void) { fsHostDie("fatal error in the file system"); }
+
+void mk82SystemGetRandom(uint8_t *buffer, uint32_t bufferLength)
+{
+    while (bufferLength--)
+    {
+        *buffer++ = (uint8_t)rand();
+    }
+}
+
+void mk82SystemTickerGetSessionID(uint32_t *sessionID) { *sessionID = (uint32_t)getpid(); }
+
+/*
+ * CRC0 in software. The table is built here from the polynomial, so that it does not share the table in uffs_crc.c it
+ * is checked against, and it keeps host timings close to a table or CRC0 on the device instead of a bitwise loop.
+ */
+uint16_t mk82SystemCrc16Update(const uint8_t *data, uint32_t length, uint16_t crc)
+{
+    static uint16_t table[256];
+    static int tableReady = 0;
+    uint32_t i;
+    uint32_t j;
+
+    if (!tableReady)
+    {
+        for (i = 0; i < 256; i++)
+        {
+            uint16_t entry = (uint16_t)i;
+
+            for (j = 0; j < 8; j++)
+            {
+                entry = (entry & 1) ? ((entry >> 1) ^ FS_HOST_CRC16_POLYNOMIAL) : (entry >> 1);
+            }
+
+            table[i] = entry;
+        }
+
+        tableReady = 1;
+    }
+
+    while (length--)
+    {
+        crc = (crc >> 8) ^ table[(crc ^ *data++) & 0xFF];
+    }
+
+    return crc;
+}
+
+static void fsHostMapImage(const char *path)
+{
+    FILE *file;
+
+    fsHostFlash = mmap((void *)MK82_FLASH_FILE_SYSTEM_START, MK82_FLASH_FILE_SYSTEM_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+
+    if (fsHostFlash != (uint8_t *)MK82_FLASH_FILE_SYSTEM_START)
+    {
+        fsHostDie("can not map the file system region, build with -no-pie");
+    }
+
+    file = fopen(path, "rb");
+
+    if ((file == NULL) || (fread(fsHostFlash, 1, MK82_FLASH_FILE_SYSTEM_SIZE, file) != MK82_FLASH_FILE_SYSTEM_SIZE))
+    {
+        fsHostDie("can not read the image");
+    }
+
+    fclose(file);
+}
+
+static void fsHostSaveImage(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+
+    if ((file == NULL) || (fwrite(fsHostFlash, 1, MK82_FLASH_FILE_SYSTEM_SIZE, file) != MK82_FLASH_FILE_SYSTEM_SIZE))
+    {
+        fsHostDie("can not write the image");
+    }
+
+    fclose(file);
+}
+
+static uint32_t fsHostFileLength(uint8_t fileID) { return mk82FsGetFileDescriptor(fileID, 0, 0)->maxLength; }
+
+static double fsHostMount(void)
+{
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    mk82FsInit();
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+static void fsHostDump(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    uint8_t fileID;
+
+    if (file == NULL)
+    {
+        fsHostDie("can not write the dump");
+    }
+
+    for (fileID = 1; fileID <= MK82_FS_NUMBER_OF_FILE_IDS; fileID++)
+    {
+        mk82FsReadFile(fileID, 0, fsHostFileBuffer[fileID], fsHostFileLength(fileID));
+        fwrite(fsHostFileBuffer[fileID], 1, fsHostFileLength(fileID), file);
+    }
+
+    fclose(file);
+}
+
+static void fsHostWear(void)
+{
+    MK82_FS_WEAR_INFO wearInfo;
+    uint32_t i;
+
+    mk82FsGetWearInfo(&wearInfo);
+
+    for (i = 0; i < MK82_FS_NUMBER_OF_BLOCKS; i++)
+    {
+        printf("%u ", wearInfo.blockEraseCounters[i]);
+    }
+
+    printf("%u", wearInfo.pageWriteCounter);
+
+    for (i = 0; i <= MK82_FS_NUMBER_OF_FILE_IDS; i++)
+    {
+        printf(" %u", wearInfo.fileCommitCounters[i]);
+    }
+
+    for (i = 0; i <= MK82_FS_NUMBER_OF_FILE_IDS; i++)
+    {
+        printf(" %u", wearInfo.fileEraseCounters[i]);
+    }
+
+    printf("\n");
+}
+
+static void fsHostLoad(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    uint8_t fileID;
+
+    if (file == NULL)
+    {
+        fsHostDie("can not read the dump");
+    }
+
+    for (fileID = 1; fileID <= MK82_FS_NUMBER_OF_FILE_IDS; fileID++)
+    {
+        if (fread(fsHostFileBuffer[fileID], 1, fsHostFileLength(fileID), file) != fsHostFileLength(fileID))
+        {
+            fsHostDie("the dump is too short");
+        }
+
+        mk82FsWriteFile(fileID, 0, fsHostFileBuffer[fileID], fsHostFileLength(fileID));
+        mk82FsCommitWrite(fileID);
+    }
+
+    fclose(file);
+}
+
+static void fsHostWrite(uint8_t fileID, uint32_t offset, uint32_t length)
+{
+    memset(fsHostFileBuffer[0], fsHostFill, length);
+    mk82FsWriteFile(fileID, offset, fsHostFileBuffer[0], length);
+}
+
+#define FS_HOST_OPGP_KEY(field) (offsetof(OPGP_HAL_NVM_KEYS, signatureKey) + offsetof(OPGP_HAL_KEY, field))
+#define FS_HOST_OPGP_KEY_WRITE(field) \
+    fsHostWrite(MK82_FS_FILE_ID_OPGP_KEYS, FS_HOST_OPGP_KEY(field), sizeof(((OPGP_HAL_KEY *)0)->field))
+#define FS_HOST_WRITE(id, type, field) fsHostWrite((id), offsetof(type, field), sizeof(((type *)0)->field))
+
+static void fsHostOpgpKeygen(void)
+{
+    FS_HOST_OPGP_KEY_WRITE(n);
+    FS_HOST_OPGP_KEY_WRITE(e);
+    FS_HOST_OPGP_KEY_WRITE(p);
+    FS_HOST_OPGP_KEY_WRITE(pNonce);
+    FS_HOST_OPGP_KEY_WRITE(pTag);
+    FS_HOST_OPGP_KEY_WRITE(q);
+    FS_HOST_OPGP_KEY_WRITE(qNonce);
+    FS_HOST_OPGP_KEY_WRITE(qTag);
+    FS_HOST_OPGP_KEY_WRITE(dp1);
+    FS_HOST_OPGP_KEY_WRITE(dp1Nonce);
+    FS_HOST_OPGP_KEY_WRITE(dp1Tag);
+    FS_HOST_OPGP_KEY_WRITE(dq1);
+    FS_HOST_OPGP_KEY_WRITE(dq1Nonce);
+    FS_HOST_OPGP_KEY_WRITE(dq1Tag);
+    FS_HOST_OPGP_KEY_WRITE(pq);
+    FS_HOST_OPGP_KEY_WRITE(pqNonce);
+    FS_HOST_OPGP_KEY_WRITE(pqTag);
+    FS_HOST_OPGP_KEY_WRITE(keyInitialized);
+    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_KEYS);
+}
+
+static void fsHostKeysafeInit(void)
+{
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, sfKek);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, sfKekNonce);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, sfKekTag);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, otpKek);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, otpKekNonce);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, otpKekTag);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, ccrKek);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, ccrKekNonce);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, ccrKekTag);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, opgpKek);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, opgpKekNonce);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, opgpKekTag);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_KEYSAFE_DATA, KEYSAFE_NVM_DATA, dataInitialized);
+    mk82FsCommitWrite(MK82_FS_FILE_ID_KEYSAFE_DATA);
+}
+
+static void fsHostBtcSetup(void)
+{
+    mk82FsBeginTransaction();
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_KEYS, BTC_HAL_NVM_KEYS, masterKey);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_KEYS, BTC_HAL_NVM_KEYS, masterKeyNonce);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_KEYS, BTC_HAL_NVM_KEYS, masterKeyTag);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_KEYS, BTC_HAL_NVM_KEYS, masterKeyInitialized);
+    mk82FsCommitWrite(MK82_FS_FILE_ID_BTC_KEYS);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_KEYS, BTC_HAL_NVM_KEYS, trustedInputKey);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_KEYS, BTC_HAL_NVM_KEYS, trustedInputKeyNonce);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_KEYS, BTC_HAL_NVM_KEYS, trustedInputKeyTag);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_KEYS, BTC_HAL_NVM_KEYS, trustedInputKeyInitialized);
+    mk82FsCommitWrite(MK82_FS_FILE_ID_BTC_KEYS);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_COUNTERS, BTC_HAL_NVM_COUNTERS, pinErrorCounter);
+    mk82FsCommitWrite(MK82_FS_FILE_ID_BTC_COUNTERS);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_DATA, BTC_HAL_NVM_DATA, regularCoinVersion);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_DATA, BTC_HAL_NVM_DATA, p2shCoinVersion);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_DATA, BTC_HAL_NVM_DATA, pinHash);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_BTC_DATA, BTC_HAL_NVM_DATA, walletState);
+    mk82FsCommitWrite(MK82_FS_FILE_ID_BTC_DATA);
+    mk82FsCommitTransaction();
+}
+
+static void fsHostPinChange(void)
+{
+    FS_HOST_WRITE(MK82_FS_FILE_ID_OPGP_DATA, OPGP_HAL_NVM_DATA, pw1Length);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_OPGP_DATA, OPGP_HAL_NVM_DATA, pw1);
+    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_DATA);
+    FS_HOST_WRITE(MK82_FS_FILE_ID_OPGP_COUNTERS, OPGP_HAL_NVM_COUNTERS, pw1ErrorCounter);
+    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_COUNTERS);
+}
+
+static void fsHostU2fCounter(void)
+{
+    fsHostWrite(MK82_FS_FILE_ID_SF_COUNTERS, 0, sizeof(uint32_t));
+    mk82FsCommitWrite(MK82_FS_FILE_ID_SF_COUNTERS);
+}
+
+static const struct
+{
+    const char *name;
+    void (*run)(void);
+} fsHostOperations[] = {{"opgp-keygen", fsHostOpgpKeygen},
+                        {"keysafe-init", fsHostKeysafeInit},
+                        {"btc-setup", fsHostBtcSetup},
+                        {"pin-change", fsHostPinChange},
+                        {"u2f-counter", fsHostU2fCounter}};
+
+static void fsHostBench(uint32_t rounds)
+{
+    uint32_t sectorErases[MK82_FLASH_FILE_SYSTEM_SIZE / MK82_FLASH_PAGE_SIZE];
+    uint32_t minErases = 0xFFFFFFFF;
+    uint32_t maxErases = 0;
+    uint32_t i, j;
+
+    memset(fsHostSectorErases, 0, sizeof(fsHostSectorErases));
+
+    for (i = 0; i < sizeof(fsHostOperations) / sizeof(fsHostOperations[0]); i++)
+    {
+        uint32_t longwords = fsHostLongwordsProgrammed;
+        uint32_t calls = fsHostProgramCalls;
+        uint32_t erases = 0;
+
+        memcpy(sectorErases, fsHostSectorErases, sizeof(sectorErases));
+
+        for (j = 0; j < rounds; j++)
+        {
+            fsHostFill++;
+            fsHostOperations[i].run();
+        }
+
+        for (j = 0; j < sizeof(sectorErases) / sizeof(sectorErases[0]); j++)
+        {
+            erases += fsHostSectorErases[j] - sectorErases[j];
+        }
+
+        printf("op %s %.2f %.3f %.2f\n", fsHostOperations[i].name,
+               (double)(fsHostLongwordsProgrammed - longwords) / rounds, (double)erases / rounds,
+               (double)(fsHostProgramCalls - calls) / rounds);
+    }
+
+    for (j = 0; j < sizeof(fsHostSectorErases) / sizeof(fsHostSectorErases[0]); j++)
+    {
+        minErases = (fsHostSectorErases[j] < minErases) ? fsHostSectorErases[j] : minErases;
+        maxErases = (fsHostSectorErases[j] > maxErases) ? fsHostSectorErases[j] : maxErases;
+    }
+
+    printf("wear %u %u\n", minErases, maxErases);
+}
+
+static uint32_t fsHostTotalErases(void)
+{
+    uint32_t erases = 0;
+    uint32_t i;
+
+    for (i = 0; i < sizeof(fsHostSectorErases) / sizeof(fsHostSectorErases[0]); i++)
+    {
+        erases += fsHostSectorErases[i];
+    }
+
+    return erases;
+}
+
+/* Prints the flash work of every single operation, which is what the command that caused it waits for */
+static void fsHostLatency(uint32_t rounds, int idle)
+{
+    uint32_t i, j, k;
+
+    for (j = 0; j < rounds; j++)
+    {
+        for (i = 0; i < sizeof(fsHostOperations) / sizeof(fsHostOperations[0]); i++)
+        {
+            uint32_t longwords = fsHostLongwordsProgrammed;
+            uint32_t erases = fsHostTotalErases();
+
+            fsHostFill++;
+            fsHostOperations[i].run();
+
+            printf("lat %s %u %u\n", fsHostOperations[i].name, fsHostLongwordsProgrammed - longwords,
+                   fsHostTotalErases() - erases);
+
+            for (k = 0; idle && (k < FS_HOST_IDLE_PASSES); k++)
+            {
+                mk82FsIdleTask();
+            }
+        }
+    }
+}
+
+static void fsHostMapRead(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+{
+    MK82_FS_EXTENT extents[FS_HOST_MAP_EXTENTS];
+    uint32_t numberOfExtents;
+    uint32_t mappedLength;
+    uint32_t i;
+
+    while (length > 0)
+    {
+        mappedLength = mk82FsMapFile(fileID, offset, length, extents, FS_HOST_MAP_EXTENTS, &numberOfExtents);
+
+        for (i = 0; i < numberOfExtents; i++)
+        {
+            memcpy(buffer, extents[i].data, extents[i].length);
+            buffer += extents[i].length;
+        }
+
+        offset += mappedLength;
+        length -= mappedLength;
+    }
+}
+
+static void fsHostMapCheck(void)
+{
+    uint8_t fileID;
+    uint32_t i;
+
+    for (fileID = 1; fileID <= MK82_FS_NUMBER_OF_FILE_IDS; fileID++)
+    {
+        for (i = 0; i <= FS_HOST_MAP_SLICES; i++)
+        {
+            uint32_t offset = (i == 0) ? 0 : (uint32_t)rand() % fsHostFileLength(fileID);
+            uint32_t length = (i == 0) ? fsHostFileLength(fileID)
+                                       : (uint32_t)rand() % (fsHostFileLength(fileID) - offset + 1);
+
+            mk82FsReadFile(fileID, offset, fsHostFileBuffer[0], length);
+            fsHostMapRead(fileID, offset, fsHostFileBuffer[fileID], length);
+
+            if (memcmp(fsHostFileBuffer[0], fsHostFileBuffer[fileID], length))
+            {
+                fsHostDie("mapped data differs from the data read");
+            }
+        }
+    }
+}
+
+static double fsHostTimeCertificateRead(int mapped, int evict)
+{
+    uint32_t length = fsHostFileLength(MK82_FS_FILE_ID_OPGP_CERTIFICATES);
+    struct timespec start, end;
+    uint8_t fileID;
+
+    /* Other commands in between leave other pages in the UFFS page buffers */
+    for (fileID = 1; evict && (fileID <= MK82_FS_NUMBER_OF_FILE_IDS); fileID++)
+    {
+        if (fileID != MK82_FS_FILE_ID_OPGP_CERTIFICATES)
+        {
+            mk82FsReadFile(fileID, 0, fsHostFileBuffer[fileID], fsHostFileLength(fileID));
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (mapped)
+    {
+        fsHostMapRead(MK82_FS_FILE_ID_OPGP_CERTIFICATES, 0, fsHostFileBuffer[0], length);
+    }
+    else
+    {
+        mk82FsReadFile(MK82_FS_FILE_ID_OPGP_CERTIFICATES, 0, fsHostFileBuffer[0], length);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+/* Checks the mapped data before and after writes, then prints the time of every certificate read */
+static void fsHostMap(uint32_t rounds)
+{
+    uint32_t i, j;
+
+    fsHostMapCheck();
+
+    for (j = 0; j < sizeof(fsHostOperations) / sizeof(fsHostOperations[0]); j++)
+    {
+        fsHostFill++;
+        fsHostOperations[j].run();
+        fsHostMapCheck();
+    }
+
+    for (i = 0; i < rounds; i++)
+    {
+        printf("map read-warm %.2f\n", fsHostTimeCertificateRead(0, 0));
+        printf("map read-evicted %.2f\n", fsHostTimeCertificateRead(0, 1));
+        printf("map mapped-warm %.2f\n", fsHostTimeCertificateRead(1, 0));
+        printf("map mapped-evicted %.2f\n", fsHostTimeCertificateRead(1, 1));
+    }
+}
+
+/* Checks the CRC UFFS gets from the platform against its table on random data, seeds and lengths */
+static void fsHostCrc(uint32_t rounds)
+{
+    uint32_t i;
+
+    for (i = 0; i < rounds; i++)
+    {
+        int length = rand() % (FS_HOST_CRC_MAX_LENGTH + 1);
+        int split = rand() % (length + 1);
+        u16 seed = (u16)rand();
+        u16 crc;
+
+        mk82SystemGetRandom(fsHostFileBuffer[0], length);
+
+        if (uffs_crc16update(fsHostFileBuffer[0], length, seed) !=
+            uffs_crc16update_table(fsHostFileBuffer[0], length, seed))
+        {
+            fsHostDie("platform CRC differs from the table");
+        }
+
+        crc = uffs_crc16sum(fsHostFileBuffer[0], split);
+
+        if (uffs_crc16update(fsHostFileBuffer[0] + split, length - split, crc) !=
+            uffs_crc16update_table(fsHostFileBuffer[0], length, 0xFFFF))
+        {
+            fsHostDie("continued platform CRC differs from the table");
+        }
+    }
+
+    printf("crc %u checks passed\n", rounds);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fsHostDie("usage: fsHost mount|dump|load|bench|latency|map|crc <image> [file|rounds] [idle]");
+    }
+
+    fsHostMapImage(argv[2]);
+
+    if (!strcmp(argv[1], "mount") && (argc == 3))
+    {
+        printf("mount %.1f\n", fsHostMount());
+    }
+    else if (!strcmp(argv[1], "dump") && (argc == 4))
+    {
+        fsHostMount();
+        fsHostDump(argv[3]);
+    }
+    else if (!strcmp(argv[1], "load") && (argc == 4))
+    {
+        fsHostMount();
+        fsHostLoad(argv[3]);
+        fsHostSaveImage(argv[2]);
+    }
+    else if (!strcmp(argv[1], "bench") && (argc == 4))
+    {
+        fsHostMount();
+        fsHostBench((uint32_t)atoi(argv[3]));
+    }
+    else if (!strcmp(argv[1], "latency") && (argc == 5))
+    {
+        fsHostMount();
+        fsHostLatency((uint32_t)atoi(argv[3]), atoi(argv[4]));
+    }
+    else if (!strcmp(argv[1], "map") && (argc == 4))
+    {
+        fsHostMount();
+        fsHostMap((uint32_t)atoi(argv[3]));
+    }
+    else if (!strcmp(argv[1], "crc") && (argc == 4))
+    {
+        fsHostCrc((uint32_t)atoi(argv[3]));
+    }
+    else if (!strcmp(argv[1], "wear") && (argc == 3))
+    {
+        fsHostMount();
+        fsHostWear();
+    }
+    else
+    {
+        fsHostDie("unknown command");
+    }
+
+    return 0;
+}
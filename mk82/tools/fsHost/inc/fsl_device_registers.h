@@ -0,0 +1,26 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Host replacement of the device headers, there are no interrupts to mask. */
+
+#ifndef __FS_HOST_FSL_DEVICE_REGISTERS_H__
+#define __FS_HOST_FSL_DEVICE_REGISTERS_H__
+
+#include <stdint.h>
+
+#define FSL_FEATURE_FLASH_PFLASH_BLOCK_WRITE_UNIT_SIZE (4)
+#define FSL_FEATURE_FLASH_PFLASH_SECTION_CMD_ADDRESS_ALIGMENT (16)
+
+static inline void __DSB(void) {}
+static inline void __ISB(void) {}
+
+static inline uint32_t DisableGlobalIRQ(void) { return 0; }
+static inline void EnableGlobalIRQ(uint32_t primask) { (void)primask; }
+
+#endif /* __FS_HOST_FSL_DEVICE_REGISTERS_H__ */
@@ -0,0 +1,42 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Host replacement of the KSDK flash driver, implemented by fsHost.c and bldrHost.c over a file backed image. */
+
+#ifndef __FS_HOST_FSL_FLASH_H__
+#define __FS_HOST_FSL_FLASH_H__
+
+#include <stdint.h>
+
+typedef int32_t status_t;
+
+typedef struct
+{
+    uint32_t unused;
+} flash_config_t;
+
+enum
+{
+    kStatus_FLASH_Success = 0,
+    kStatus_FLASH_Failure = 1
+};
+
+#define kFLASH_apiEraseKey (0x6B65666BU)
+#define kFLASH_marginValueNormal (0)
+#define kFLASH_marginValueUser (1)
+#define kFLASH_marginValueFactory (2)
+
+status_t FLASH_Program(flash_config_t *config, uint32_t start, uint32_t *src, uint32_t lengthInBytes);
+status_t FLASH_Erase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, uint32_t key);
+status_t FLASH_VerifyErase(flash_config_t *config, uint32_t start, uint32_t lengthInBytes, uint32_t margin);
+status_t FLASH_VerifyProgram(flash_config_t *config, uint32_t start, uint32_t lengthInBytes,
+                             const uint32_t *expectedData, uint32_t margin, uint32_t *failedAddress,
+                             uint32_t *failedData);
+
+#endif /* __FS_HOST_FSL_FLASH_H__ */
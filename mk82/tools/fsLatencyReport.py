@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Shows how long commands that write to the file system wait for flash, with
+# and without the idle task erasing blocks between commands.
+#
+# Both file systems are built for the host as in fsRecordStore.py, loaded with
+# the files of a UFFS image and made to run the benchmark writes in turn. Each
+# write is turned into flash time with the K82 timings from fsRecordStore.py,
+# and the distribution is printed per write and file system, first as
+# percentiles and then as the number of writes in each latency bucket. A
+# sector erase in the tail of a write shows up as a p99 or max of 14 ms and
+# more.
+#
+# Usage:
+#   fsLatencyReport.py [rounds] [uffs.hex]     default 200 rounds, mk82/fs.hex
+#
+
+import shutil
+import sys
+import tempfile
+
+from fsRecordStore import DEFAULT_IMAGE, build, flash_ms, migrate_image, run
+
+USAGE = 'usage: fsLatencyReport.py [rounds] [uffs.hex]'
+
+# Upper bounds of the latency buckets in ms: no erase, up to one, two and
+# four sector erases, and more
+BUCKET_LIMITS_MS = [1.0, 14.0, 28.0, 56.0]
+
+
+def percentile(values, fraction):
+    return values[int(fraction * (len(values) - 1))]
+
+
+def histogram(values):
+    counts = [0] * (len(BUCKET_LIMITS_MS) + 1)
+    for value in values:
+        counts[sum(1 for limit in BUCKET_LIMITS_MS if value >= limit)] += 1
+    return counts
+
+
+def bucket_names():
+    names = ['<%g' % BUCKET_LIMITS_MS[0]]
+    names += ['%g-%g' % (low, high) for low, high in zip(BUCKET_LIMITS_MS, BUCKET_LIMITS_MS[1:])]
+    names.append('>=%g' % BUCKET_LIMITS_MS[-1])
+    return names
+
+
+def measure(binary, image, rounds, idle):
+    # Every run starts from the same image
+    work_image = image + '.work'
+    shutil.copyfile(image, work_image)
+
+    latencies = {}
+    erase_waits = {}
+    for line in run(binary, 'latency', work_image, str(rounds), '1' if idle else '0').splitlines():
+        fields = line.split()
+        if fields[0] != 'lat':
+            continue
+        name, longwords, erases = fields[1], int(fields[2]), int(fields[3])
+        latencies.setdefault(name, []).append(flash_ms(longwords, erases))
+        erase_waits[name] = erase_waits.get(name, 0) + (1 if erases else 0)
+
+    return latencies, erase_waits
+
+
+def main():
+    if len(sys.argv) > 3:
+        sys.exit(USAGE)
+
+    rounds = int(sys.argv[1]) if len(sys.argv) >= 2 else 200
+    uffs_hex = sys.argv[2] if len(sys.argv) == 3 else DEFAULT_IMAGE
+
+    work_dir = tempfile.mkdtemp()
+    try:
+        uffs_binary = build(work_dir, False)
+        record_binary = build(work_dir, True)
+        uffs_image, record_image = migrate_image(work_dir, uffs_binary, record_binary, uffs_hex)
+
+        results = []
+        for name, binary, image in (('uffs', uffs_binary, uffs_image), ('record', record_binary, record_image)):
+            for idle in (False, True):
+                results.append((name, idle, measure(binary, image, rounds, idle)))
+    finally:
+        shutil.rmtree(work_dir)
+
+    print('%d rounds, flash ms per write' % rounds)
+    print()
+    print('%-8s %-6s %-14s %8s %8s %8s %8s %12s' % ('', 'idle', 'operation', 'p50', 'p90', 'p99', 'max',
+                                                   'erase waits'))
+    for name, idle, (latencies, erase_waits) in results:
+        for operation in latencies:
+            values = sorted(latencies[operation])
+            print('%-8s %-6s %-14s %8.2f %8.2f %8.2f %8.2f %6d/%-5d' % (
+                name, 'on' if idle else 'off', operation, percentile(values, 0.5), percentile(values, 0.9),
+                percentile(values, 0.99), values[-1], erase_waits[operation], len(values)))
+
+    print()
+    print('writes per latency bucket, ms')
+    print()
+    print('%-8s %-6s %-14s' % ('', 'idle', 'operation') + ''.join('%8s' % name for name in bucket_names()))
+    for name, idle, (latencies, _) in results:
+        for operation in latencies:
+            print('%-8s %-6s %-14s' % (name, 'on' if idle else 'off', operation) +
+                  ''.join('%8d' % count for count in histogram(latencies[operation])))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Host side of the record store that replaces UFFS in firmware built with
+# USE_RECORD_STORE. Both file systems are built for Linux from the firmware
+# sources in fsHost/ and run over a file backed image of the 0x38000 region.
+#
+# migrate reads every file out of a UFFS image, such as mk82/fs.hex, and
+# writes it into an empty record store. The wear counters start over.
+#
+# benchmark runs the same application writes against both file systems and
+# prints the mount time, the flash work per operation and the flash time it
+# takes on the K82, along with how evenly the erases were spread.
+#
+# Usage:
+#   fsRecordStore.py migrate <uffs.hex> <out.hex>
+#   fsRecordStore.py benchmark [rounds] [uffs.hex]     default 200 rounds, mk82/fs.hex
+#
+
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+
+FS_START = 0x38000
+FS_SIZE = 0x8000
+
+# Typical K82 program flash timings: one longword program, one 4 KB sector
+# erase.
+LONGWORD_PROGRAM_US = 7.5
+SECTOR_ERASE_MS = 14.0
+
+MOUNT_RUNS = 20
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.normpath(os.path.join(TOOLS_DIR, '..', '..'))
+MIDDLEWARE_DIR = os.path.join(REPO_DIR, 'mk82', 'middleware')
+DEFAULT_IMAGE = os.path.join(REPO_DIR, 'mk82', 'fs.hex')
+
+INCLUDE_DIRS = ['mk82/tools/fsHost/inc', 'platform/mk82/inc', 'platform/mk82/src', 'platform/mk82/src/system',
+                'mk82/middleware/uffs/inc', 'mk82/middleware/uffs/platform', 'mk82/middleware/mbedtls_2.1.2/include',
+                'u2f/inc', 'otp/inc', 'opgp/inc', 'btc/inc', 'eth/inc', 'xrp/inc', 'apdu/inc', 'ccid/inc', 'bldr/inc']
+
+USAGE = 'usage: fsRecordStore.py migrate <uffs.hex> <out.hex> | benchmark [rounds] [uffs.hex]'
+
+
+def sources(record_store):
+    files = [os.path.join(TOOLS_DIR, 'fsHost', 'fsHost.c'),
+             os.path.join(REPO_DIR, 'platform', 'mk82', 'src', 'fs', 'mk82FsFiles.c'),
+             os.path.join(REPO_DIR, 'platform', 'mk82', 'src', 'system', 'mk82SystemFlash.c')]
+    if record_store:
+        files += [os.path.join(REPO_DIR, 'platform', 'mk82', 'src', 'fs', 'mk82FsRecord.c'),
+                  os.path.join(MIDDLEWARE_DIR, 'uffs', 'uffs', 'uffs_crc.c'),
+                  os.path.join(MIDDLEWARE_DIR, 'uffs', 'uffs', 'uffs_debug.c'),
+                  os.path.join(MIDDLEWARE_DIR, 'uffs', 'platform', 'uffs_os.c')]
+    else:
+        uffs_dir = os.path.join(MIDDLEWARE_DIR, 'uffs', 'uffs')
+        files += [os.path.join(REPO_DIR, 'platform', 'mk82', 'src', 'fs', 'mk82Fs.c'),
+                  os.path.join(MIDDLEWARE_DIR, 'uffs', 'platform', 'uffs_os.c')]
+        files += [os.path.join(uffs_dir, name) for name in sorted(os.listdir(uffs_dir)) if name.endswith('.c')]
+    return files
+
+
+def build(work_dir, record_store):
+    # The tree is edited on Windows and some includes differ from the file
+    # names in case only.
+    case_dir = os.path.join(work_dir, 'inc')
+    os.makedirs(case_dir, exist_ok=True)
+    if not os.path.exists(os.path.join(REPO_DIR, 'platform', 'mk82', 'inc', 'mk82Keysafe.h')):
+        with open(os.path.join(case_dir, 'mk82Keysafe.h'), 'w') as header:
+            header.write('#include "mk82KeySafe.h"\n')
+
+    binary = os.path.join(work_dir, 'fsHostRecord' if record_store else 'fsHostUffs')
+    flags = ['-O2', '-std=gnu99', '-no-pie', '-fno-pie', '-DFIRMWARE', '-I' + case_dir]
+    flags += ['-I' + os.path.join(REPO_DIR, path) for path in INCLUDE_DIRS]
+    if record_store:
+        flags.append('-DUSE_RECORD_STORE')
+    compile_and_link(flags, sources(record_store), binary)
+    return binary
+
+
+def compile_and_link(flags, files, binary):
+    # The middleware is built as shipped, without warnings. The rest is
+    # built with -Wall -Wextra, less the warnings about firmware addresses
+    # held in 32 bit integers and about attributes gcc has only for ARM.
+    objects = []
+    for source in files:
+        if source.startswith(MIDDLEWARE_DIR):
+            objects.append('%s-%s.o' % (binary, os.path.splitext(os.path.basename(source))[0]))
+            subprocess.run(['gcc'] + flags + ['-w', '-c', source, '-o', objects[-1]], check=True)
+    command = ['gcc'] + flags + ['-Wall', '-Wextra', '-Wno-int-to-pointer-cast', '-Wno-pointer-to-int-cast',
+                                 '-Wno-attributes']
+    command += [source for source in files if not source.startswith(MIDDLEWARE_DIR)] + objects + ['-o', binary]
+    subprocess.run(command, check=True)
+
+
+def run(binary, *args):
+    result = subprocess.run([binary] + list(args), check=True, stdout=subprocess.PIPE, universal_newlines=True)
+    return result.stdout
+
+
+def read_hex(path):
+    image = bytearray(b'\xff' * FS_SIZE)
+    base = 0
+    with open(path) as hex_file:
+        for line in hex_file:
+            line = line.strip()
+            if not line.startswith(':'):
+                continue
+            record = bytes.fromhex(line[1:])
+            length, address, record_type, data = record[0], int.from_bytes(record[1:3], 'big'), record[3], record[4:-1]
+            if len(data) != length or sum(record) & 0xFF:
+                sys.exit('Bad record in %s: %s' % (path, line))
+            if record_type == 0x00:
+                for i, byte in enumerate(data):
+                    if FS_START <= base + address + i < FS_START + FS_SIZE:
+                        image[base + address + i - FS_START] = byte
+            elif record_type == 0x02:
+                base = int.from_bytes(data, 'big') << 4
+            elif record_type == 0x04:
+                base = int.from_bytes(data, 'big') << 16
+    return image
+
+
+def write_hex(path, image):
+    def record(address, record_type, data):
+        body = bytes([len(data)]) + address.to_bytes(2, 'big') + bytes([record_type]) + data
+        return ':%s%02X\n' % (body.hex().upper(), -sum(body) & 0xFF)
+
+    with open(path, 'w') as hex_file:
+        hex_file.write(record(0, 0x02, ((FS_START & 0xF0000) >> 4).to_bytes(2, 'big')))
+        for offset in range(0, FS_SIZE, 16):
+            hex_file.write(record((FS_START & 0xFFFF) + offset, 0x00, bytes(image[offset:offset + 16])))
+        hex_file.write(record(0, 0x01, b''))
+
+
+def write_image(path, image):
+    with open(path, 'wb') as image_file:
+        image_file.write(image)
+
+
+def migrate_image(work_dir, uffs_binary, record_binary, uffs_hex):
+    uffs_image = os.path.join(work_dir, 'uffs.img')
+    record_image = os.path.join(work_dir, 'record.img')
+    dump = os.path.join(work_dir, 'files.bin')
+
+    write_image(uffs_image, read_hex(uffs_hex))
+    write_image(record_image, b'\xff' * FS_SIZE)
+    run(uffs_binary, 'dump', uffs_image, dump)
+    run(record_binary, 'load', record_image, dump)
+
+    check = os.path.join(work_dir, 'check.bin')
+    run(record_binary, 'dump', record_image, check)
+    with open(dump, 'rb') as expected, open(check, 'rb') as actual:
+        if expected.read() != actual.read():
+            sys.exit('The migrated image reads back different files')
+
+    return uffs_image, record_image
+
+
+def migrate(uffs_hex, out_hex):
+    work_dir = tempfile.mkdtemp()
+    try:
+        uffs_binary = build(work_dir, False)
+        record_binary = build(work_dir, True)
+        _, record_image = migrate_image(work_dir, uffs_binary, record_binary, uffs_hex)
+        with open(record_image, 'rb') as image_file:
+            write_hex(out_hex, image_file.read())
+    finally:
+        shutil.rmtree(work_dir)
+
+
+def measure(binary, image, work_dir, rounds):
+    mount_times = [float(run(binary, 'mount', image).split()[1]) for _ in range(MOUNT_RUNS)]
+
+    operations = []
+    wear = None
+    for line in run(binary, 'bench', image, str(rounds)).splitlines():
+        fields = line.split()
+        if fields[0] == 'op':
+            operations.append((fields[1], float(fields[2]), float(fields[3]), float(fields[4])))
+        elif fields[0] == 'wear':
+            wear = (int(fields[1]), int(fields[2]))
+
+    return statistics.median(mount_times), operations, wear
+
+
+def flash_ms(longwords, erases):
+    return longwords * LONGWORD_PROGRAM_US / 1000 + erases * SECTOR_ERASE_MS
+
+
+def benchmark(rounds, uffs_hex):
+    work_dir = tempfile.mkdtemp()
+    try:
+        uffs_binary = build(work_dir, False)
+        record_binary = build(work_dir, True)
+        uffs_image, record_image = migrate_image(work_dir, uffs_binary, record_binary, uffs_hex)
+
+        results = [('uffs', measure(uffs_binary, uffs_image, work_dir, rounds)),
+                   ('record', measure(record_binary, record_image, work_dir, rounds))]
+    finally:
+        shutil.rmtree(work_dir)
+
+    print('%d rounds, %.1f us per longword, %.1f ms per sector erase' % (rounds, LONGWORD_PROGRAM_US,
+                                                                           SECTOR_ERASE_MS))
+    print()
+    print('%-8s %-14s %10s %10s %10s %10s' % ('', 'operation', 'longwords', 'runs', 'erases', 'flash ms'))
+    for name, (_, operations, _) in results:
+        for operation, longwords, erases, runs in operations:
+            print('%-8s %-14s %10.1f %10.1f %10.3f %10.2f' % (name, operation, longwords, runs, erases,
+                                                              flash_ms(longwords, erases)))
+    print()
+    for name, (mount_us, _, wear) in results:
+        print('%-8s mount %8.1f us   sector erases min %d max %d' % (name, mount_us, wear[0], wear[1]))
+
+
+def main():
+    if len(sys.argv) == 4 and sys.argv[1] == 'migrate':
+        migrate(sys.argv[2], sys.argv[3])
+    elif 2 <= len(sys.argv) <= 4 and sys.argv[1] == 'benchmark':
+        rounds = int(sys.argv[2]) if len(sys.argv) >= 3 else 200
+        uffs_hex = sys.argv[3] if len(sys.argv) == 4 else DEFAULT_IMAGE
+        benchmark(rounds, uffs_hex)
+    else:
+        sys.exit(USAGE)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,43 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * APDU parser fuzz target. The input is one command APDU. A parsed APDU with a data field must place it inside the
+ * input, and every applet reads that field.
+ */
+
+#include "apduGlobal.h"
+#include "apduCore.h"
+
+#include "fuzzHost.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    APDU_CORE_COMMAND_APDU parsedAPDU;
+
+    if (apduCoreParseIncomingAPDU((uint8_t *)data, size, &parsedAPDU) != APDU_NO_ERROR)
+    {
+        return 0;
+    }
+
+    if ((parsedAPDU.lc != 0) && ((parsedAPDU.data < data) || (parsedAPDU.data > (data + size)) ||
+                                 (parsedAPDU.lc > (size_t)((data + size) - parsedAPDU.data))))
+    {
+        fuzzHostFail("data field outside the APDU");
+    }
+
+    if ((parsedAPDU.lcPresent == APDU_FALSE) && (parsedAPDU.lc != 0))
+    {
+        fuzzHostFail("Lc without a data field");
+    }
+
+    fuzzHostTouch(parsedAPDU.data, parsedAPDU.lc);
+
+    return 0;
+}
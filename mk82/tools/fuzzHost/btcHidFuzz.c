@@ -0,0 +1,82 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * BTC HID fuzz target. The input is a sequence of interrupt OUT reports, cut into BTC_HID_FRAME_SIZE pieces, the last
+ * one padded with zeroes. A reassembled APDU is answered with a response as long as the APDU, sent frame by frame the
+ * way mk82Usb sends it.
+ */
+
+#include <string.h>
+
+#include "btcGlobal.h"
+#include "btcHid.h"
+
+#include "fuzzHost.h"
+
+static BTC_HID_HANDLE btcHidFuzzHandle;
+static uint8_t btcHidFuzzDataBuffer[BTC_HID_MAX_DATA_SIZE];
+
+static void btcHidFuzzProcessCommand(void)
+{
+    uint8_t frame[BTC_HID_FRAME_SIZE];
+    uint16_t incomingDataSize;
+    uint16_t moreFramesAvailable;
+
+    btcHidGetIncomingDataSize(&btcHidFuzzHandle, &incomingDataSize);
+
+    if (incomingDataSize > BTC_HID_MAX_DATA_SIZE)
+    {
+        fuzzHostFail("APDU length out of range");
+    }
+
+    fuzzHostTouch(btcHidFuzzDataBuffer, incomingDataSize);
+
+    btcHidSetOutgoingDataLength(&btcHidFuzzHandle, incomingDataSize);
+
+    do
+    {
+        btcHidProcessOutgoingData(&btcHidFuzzHandle, frame, &moreFramesAvailable);
+    } while (moreFramesAvailable == BTC_TRUE);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    uint8_t frame[BTC_HID_FRAME_SIZE];
+    size_t offset;
+
+    btcHidInit(&btcHidFuzzHandle, btcHidFuzzDataBuffer);
+
+    for (offset = 0; offset < size; offset += BTC_HID_FRAME_SIZE)
+    {
+        size_t frameLength = size - offset;
+        uint16_t requiredAction;
+
+        if (frameLength > BTC_HID_FRAME_SIZE)
+        {
+            frameLength = BTC_HID_FRAME_SIZE;
+        }
+
+        memset(frame, 0x00, sizeof(frame));
+        memcpy(frame, &data[offset], frameLength);
+
+        btcHidProcessIncomingFrame(&btcHidFuzzHandle, frame, &requiredAction);
+
+        if (requiredAction == BTC_HID_ACTION_PROCESS_RECEIVED_COMMAND)
+        {
+            btcHidFuzzProcessCommand();
+        }
+        else if (requiredAction != BTC_HID_ACTION_DO_NOTHING)
+        {
+            fuzzHostFail("unknown action");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,421 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * BTC applet fuzz target, through btcCoreProcessAPDU into the transaction and message parsers of btcTran. The input
+ * is a sequence of records, each a control byte, a two byte big-endian length and a command APDU. Every input starts
+ * from a wallet set up with the PIN BTC_TRAN_FUZZ_PIN and a fresh btcCoreInit.
+ *
+ * An APDU arrives over BTC HID, into a buffer of BTC_HID_MAX_DATA_SIZE bytes, or with BTC_TRAN_FUZZ_CONTROL_CCID set
+ * over CCID, into a buffer of CCID_MAX_APDU_SIZE bytes. An APDU that does not fit its buffer is never delivered. While
+ * an APDU from BTC HID waits for the user, the records that follow with BTC_TRAN_FUZZ_CONTROL_WHILE_WAITING set are
+ * sent over CCID, the way btcHalWaitForComfirmation lets mk82As through. The user then confirms, unless the waiting
+ * APDU has BTC_TRAN_FUZZ_CONTROL_DECLINE set.
+ *
+ * Key derivation, signatures and the trusted input MAC are stand-ins: the MAC is the first bytes of
+ * SHA-256(BTC_TRAN_FUZZ_MAC_KEY || blob), so that the seeds can carry valid trusted inputs.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "mbedtls/sha256.h"
+
+#include "btcGlobal.h"
+#include "btcGlobalInt.h"
+#include "btcHal.h"
+#include "btcCore.h"
+#include "btcHid.h"
+#include "ccidGlobal.h"
+
+#include "fuzzHost.h"
+
+#define BTC_TRAN_FUZZ_CONTROL_CCID (0x01)
+#define BTC_TRAN_FUZZ_CONTROL_WHILE_WAITING (0x02)
+#define BTC_TRAN_FUZZ_CONTROL_DECLINE (0x04)
+
+#define BTC_TRAN_FUZZ_RECORD_HEADER_LENGTH (3)
+
+#define BTC_TRAN_FUZZ_PIN "1234"
+#define BTC_TRAN_FUZZ_MAC_KEY "btcTranFuzz"
+
+#define BTC_TRAN_FUZZ_NUMBER_OF_HASHES (7)
+
+#define BTC_TRAN_FUZZ_CONFIRMATION_TIMEOUT_IN_MS (30000)
+
+#define BTC_TRAN_FUZZ_SIGNATURE_LENGTH (71)
+
+static const uint8_t *btcTranFuzzData;
+static size_t btcTranFuzzSize;
+static size_t btcTranFuzzOffset;
+
+static uint8_t btcTranFuzzControl;
+static uint16_t btcTranFuzzWaiting;
+
+static uint16_t btcTranFuzzWalletState;
+static uint16_t btcTranFuzzWipeoutInProgress;
+static uint8_t btcTranFuzzPinErrorCounter;
+static uint8_t btcTranFuzzPinHash[BTC_GLOBAL_PIN_HASH_LENGTH];
+static uint8_t btcTranFuzzRegularCoinVersion;
+static uint8_t btcTranFuzzP2shCoinVersion;
+
+static const uint16_t btcTranFuzzHashIDs[BTC_TRAN_FUZZ_NUMBER_OF_HASHES] = {
+    BTC_HAL_HASH_ID_TRUSTED_INPUT,   BTC_HAL_HASH_ID_TRANSACTION_SIGNING, BTC_HAL_HASH_ID_TRANSACTION_INTEGRITY_CHECK,
+    BTC_HAL_HASH_ID_MESSAGE_SIGNING, BTC_HAL_HASH_ID_SEGWIT_PREVOUTS,     BTC_HAL_HASH_ID_SEGWIT_SEQUENCE,
+    BTC_HAL_HASH_ID_SEGWIT_OUTPUTS};
+static mbedtls_sha256_context btcTranFuzzHashContexts[BTC_TRAN_FUZZ_NUMBER_OF_HASHES];
+static uint16_t btcTranFuzzHashStarted[BTC_TRAN_FUZZ_NUMBER_OF_HASHES];
+
+static void btcTranFuzzProcessNextRecord(void);
+
+static mbedtls_sha256_context *btcTranFuzzGetHashContext(uint16_t hashID, uint16_t start)
+{
+    uint32_t i;
+
+    for (i = 0; i < BTC_TRAN_FUZZ_NUMBER_OF_HASHES; i++)
+    {
+        if (btcTranFuzzHashIDs[i] == hashID)
+        {
+            if (start == BTC_TRUE)
+            {
+                btcTranFuzzHashStarted[i] = BTC_TRUE;
+            }
+            else if (btcTranFuzzHashStarted[i] != BTC_TRUE)
+            {
+                fuzzHostFail("hash used before it is started");
+            }
+
+            return &btcTranFuzzHashContexts[i];
+        }
+    }
+
+    fuzzHostFail("unknown hash ID");
+
+    return NULL;
+}
+
+static void btcTranFuzzFill(uint8_t *data, uint32_t length, uint32_t *derivationIndexes,
+                            uint32_t numberOfKeyDerivations, uint8_t label)
+{
+    uint8_t hash[BTC_GLOBAL_SHA256_SIZE];
+    mbedtls_sha256_context context;
+    uint32_t i;
+
+    mbedtls_sha256_init(&context);
+    mbedtls_sha256_starts(&context, 0);
+    mbedtls_sha256_update(&context, &label, sizeof(label));
+    mbedtls_sha256_update(&context, (uint8_t *)derivationIndexes, numberOfKeyDerivations * sizeof(uint32_t));
+    mbedtls_sha256_finish(&context, hash);
+    mbedtls_sha256_free(&context);
+
+    for (i = 0; i < length; i++)
+    {
+        data[i] = hash[i % sizeof(hash)];
+    }
+}
+
+void btcHalInit(void) {}
+
+void btcHalDeinit(void) {}
+
+uint16_t btcHalMemCmp(uint8_t *array1, uint8_t *array2, uint16_t length)
+{
+    return (memcmp(array1, array2, length) == 0) ? BTC_CMP_EQUAL : BTC_CMP_NOT_EQUAL;
+}
+
+void btcHalGetPinErrorCounter(uint8_t *errorCounter) { *errorCounter = btcTranFuzzPinErrorCounter; }
+
+void btcHalSetPinErrorCounter(uint8_t errorCounter) { btcTranFuzzPinErrorCounter = errorCounter; }
+
+void btcHalGetPinHash(uint8_t *pinHash) { memcpy(pinHash, btcTranFuzzPinHash, BTC_GLOBAL_PIN_HASH_LENGTH); }
+
+void btcHalComputePinHash(uint8_t *pin, uint32_t pinLength, uint8_t *pinHash)
+{
+    mbedtls_sha256(pin, pinLength, pinHash, 0);
+}
+
+void btcHalGetCoinVersions(uint8_t *regularCoinVersion, uint8_t *p2shCoinVersion)
+{
+    *regularCoinVersion = btcTranFuzzRegularCoinVersion;
+    *p2shCoinVersion = btcTranFuzzP2shCoinVersion;
+}
+
+void btcHalWriteSetupInfoAndFinalizeSetup(uint8_t regularCoinVersion, uint8_t p2shCoinVersion, uint8_t *pinHash)
+{
+    btcTranFuzzRegularCoinVersion = regularCoinVersion;
+    btcTranFuzzP2shCoinVersion = p2shCoinVersion;
+    memcpy(btcTranFuzzPinHash, pinHash, BTC_GLOBAL_PIN_HASH_LENGTH);
+    btcTranFuzzPinErrorCounter = BTC_GLOBAL_PIN_INITIAL_ERROR_COUNTER_VALUE;
+    btcTranFuzzWalletState = BTC_GLOBAL_WALLET_STATE_OPERATIONAL;
+}
+
+void btcHalSetMasterKey(uint8_t *seed, uint32_t seedLength)
+{
+    if ((seedLength < BTC_GLOBAL_SEED_MINIMUM_LENGTH) || (seedLength > BTC_GLOBAL_SEED_MAXIMUM_LENGTH))
+    {
+        fuzzHostFail("seed length out of range");
+    }
+
+    fuzzHostTouch(seed, seedLength);
+}
+
+void btcHalSetRandomTrustedInputKey(void) {}
+
+void btcHalBeginSetupTransaction(void) {}
+
+void btcHalCommitSetupTransaction(void) {}
+
+uint16_t btcHalGetWalletState(void) { return btcTranFuzzWalletState; }
+
+uint16_t btcHalIsWipeoutInProgress(void) { return btcTranFuzzWipeoutInProgress; }
+
+uint16_t btcHalDerivePublicKey(uint32_t *derivationIndexes, uint32_t numberOfKeyDerivations, uint8_t *fullPublicKey,
+                               uint8_t *compressedPublicKey, uint8_t *chainCode, uint16_t computeFull,
+                               uint16_t computeCompressed)
+{
+    if (numberOfKeyDerivations > BTC_GLOBAL_MAXIMAL_NUMBER_OF_KEY_DERIVATIONS)
+    {
+        fuzzHostFail("too many key derivations");
+    }
+
+    if (computeFull == BTC_TRUE)
+    {
+        btcTranFuzzFill(fullPublicKey, BTC_GLOBAL_ENCODED_FULL_POINT_SIZE, derivationIndexes, numberOfKeyDerivations,
+                        0);
+        fullPublicKey[0] = 0x04;
+    }
+
+    if (computeCompressed == BTC_TRUE)
+    {
+        btcTranFuzzFill(compressedPublicKey, BTC_GLOBAL_ENCODED_COMPRESSED_POINT_SIZE, derivationIndexes,
+                        numberOfKeyDerivations, 0);
+        compressedPublicKey[0] = 0x02;
+    }
+
+    if (chainCode != NULL)
+    {
+        btcTranFuzzFill(chainCode, BTC_GLOBAL_CHAIN_CODE_SIZE, derivationIndexes, numberOfKeyDerivations, 1);
+    }
+
+    return BTC_NO_ERROR;
+}
+
+uint16_t btcHalSignHash(uint32_t *derivationIndexes, uint32_t numberOfKeyDerivations, uint8_t *hash,
+                        uint8_t *signature, uint32_t *signatureLength, uint16_t isTransactionSignature)
+{
+    (void)isTransactionSignature;
+
+    if (numberOfKeyDerivations > BTC_GLOBAL_MAXIMAL_NUMBER_OF_KEY_DERIVATIONS)
+    {
+        fuzzHostFail("too many key derivations");
+    }
+
+    fuzzHostTouch(hash, BTC_GLOBAL_SHA256_SIZE);
+
+    btcTranFuzzFill(signature, BTC_TRAN_FUZZ_SIGNATURE_LENGTH, derivationIndexes, numberOfKeyDerivations, 2);
+    *signatureLength = BTC_TRAN_FUZZ_SIGNATURE_LENGTH;
+
+    return BTC_NO_ERROR;
+}
+
+void btcHalHash160(uint8_t *data, uint32_t dataLength, uint8_t *hash)
+{
+    uint8_t internalHashBuffer[BTC_GLOBAL_SHA256_SIZE];
+
+    mbedtls_sha256(data, dataLength, internalHashBuffer, 0);
+    memcpy(hash, internalHashBuffer, BTC_GLOBAL_RIPEMD160_SIZE);
+}
+
+static void btcTranFuzzComputeMac(uint8_t *blob, uint8_t *mac)
+{
+    mbedtls_sha256_context context;
+
+    mbedtls_sha256_init(&context);
+    mbedtls_sha256_starts(&context, 0);
+    mbedtls_sha256_update(&context, (const uint8_t *)BTC_TRAN_FUZZ_MAC_KEY, strlen(BTC_TRAN_FUZZ_MAC_KEY));
+    mbedtls_sha256_update(&context, blob, BTC_GLOBAL_TRUSTED_INPUT_BLOB_MAC_OFFSET);
+    mbedtls_sha256_finish(&context, mac);
+    mbedtls_sha256_free(&context);
+}
+
+void btcHalComputeTrustedInputMAC(uint8_t *blob)
+{
+    uint8_t mac[BTC_GLOBAL_SHA256_SIZE];
+
+    btcTranFuzzComputeMac(blob, mac);
+    memcpy(&blob[BTC_GLOBAL_TRUSTED_INPUT_BLOB_MAC_OFFSET], mac, BTC_GLOBAL_TRUSTED_INPUT_BLOB_MAC_LENGTH);
+}
+
+uint16_t btcHalCheckTrustedInputMAC(uint8_t *blob)
+{
+    uint8_t mac[BTC_GLOBAL_SHA256_SIZE];
+
+    btcTranFuzzComputeMac(blob, mac);
+
+    if (memcmp(&blob[BTC_GLOBAL_TRUSTED_INPUT_BLOB_MAC_OFFSET], mac, BTC_GLOBAL_TRUSTED_INPUT_BLOB_MAC_LENGTH) != 0)
+    {
+        return BTC_INVALID_MAC_ERROR;
+    }
+
+    return BTC_NO_ERROR;
+}
+
+void btcHalSha256Start(uint16_t hashID) { mbedtls_sha256_starts(btcTranFuzzGetHashContext(hashID, BTC_TRUE), 0); }
+
+void btcHalSha256Update(uint16_t hashID, uint8_t *data, uint32_t dataLength)
+{
+    mbedtls_sha256_update(btcTranFuzzGetHashContext(hashID, BTC_FALSE), data, dataLength);
+}
+
+void btcHalSha256Finalize(uint16_t hashID, uint8_t *hash)
+{
+    mbedtls_sha256_finish(btcTranFuzzGetHashContext(hashID, BTC_FALSE), hash);
+}
+
+void btcHalSha256(uint8_t *data, uint32_t dataLength, uint8_t *hash) { mbedtls_sha256(data, dataLength, hash, 0); }
+
+void btcHalWaitForComfirmation(uint16_t allowCcidApdus, uint16_t *confirmed)
+{
+    uint8_t control = btcTranFuzzControl;
+
+    if (btcTranFuzzWaiting == BTC_TRUE)
+    {
+        fuzzHostFail("confirmation requested while waiting for one");
+    }
+
+    btcTranFuzzWaiting = BTC_TRUE;
+
+    if ((allowCcidApdus == BTC_TRUE) && ((control & BTC_TRAN_FUZZ_CONTROL_CCID) == 0))
+    {
+        while (((btcTranFuzzOffset + BTC_TRAN_FUZZ_RECORD_HEADER_LENGTH) <= btcTranFuzzSize) &&
+               ((btcTranFuzzData[btcTranFuzzOffset] & BTC_TRAN_FUZZ_CONTROL_WHILE_WAITING) != 0))
+        {
+            btcTranFuzzProcessNextRecord();
+        }
+    }
+
+    btcTranFuzzWaiting = BTC_FALSE;
+    btcTranFuzzControl = control;
+
+    *confirmed = ((control & BTC_TRAN_FUZZ_CONTROL_DECLINE) == 0) ? BTC_TRUE : BTC_FALSE;
+}
+
+uint64_t btcHalGetRemainingConfirmationTime(void)
+{
+    if (btcTranFuzzWaiting != BTC_TRUE)
+    {
+        fuzzHostFail("confirmation time read while not waiting");
+    }
+
+    return BTC_TRAN_FUZZ_CONFIRMATION_TIMEOUT_IN_MS;
+}
+
+void btcHalGenerateNewSeed(uint8_t *seed, uint32_t seedLength) { memset(seed, 0x5A, seedLength); }
+
+void btcHalGetRandom(uint8_t *buffer, uint32_t length) { memset(buffer, 0xA5, length); }
+
+void btcHalWipeout(void)
+{
+    btcTranFuzzWalletState = BTC_GLOBAL_WALLET_STATE_INITIALIZATION;
+    btcTranFuzzWipeoutInProgress = BTC_FALSE;
+    btcTranFuzzPinErrorCounter = BTC_GLOBAL_PIN_INITIAL_ERROR_COUNTER_VALUE;
+    memset(btcTranFuzzPinHash, 0x00, sizeof(btcTranFuzzPinHash));
+}
+
+/* Sends the next record to the applet from a buffer of the size its interface has, with the APDU at its start */
+static void btcTranFuzzProcessNextRecord(void)
+{
+    uint8_t *buffer;
+    size_t bufferSize;
+    uint32_t apduLength;
+    uint8_t control;
+
+    control = btcTranFuzzData[btcTranFuzzOffset];
+    apduLength = ((uint32_t)btcTranFuzzData[btcTranFuzzOffset + 1] << 8) | btcTranFuzzData[btcTranFuzzOffset + 2];
+    btcTranFuzzOffset += BTC_TRAN_FUZZ_RECORD_HEADER_LENGTH;
+
+    if (apduLength > (btcTranFuzzSize - btcTranFuzzOffset))
+    {
+        apduLength = btcTranFuzzSize - btcTranFuzzOffset;
+    }
+
+    if ((btcTranFuzzWaiting == BTC_TRUE) || ((control & BTC_TRAN_FUZZ_CONTROL_CCID) != 0))
+    {
+        control |= BTC_TRAN_FUZZ_CONTROL_CCID;
+        bufferSize = CCID_MAX_APDU_SIZE;
+    }
+    else
+    {
+        bufferSize = BTC_HID_MAX_DATA_SIZE;
+    }
+
+    if (apduLength > bufferSize)
+    {
+        btcTranFuzzOffset += apduLength;
+        return;
+    }
+
+    buffer = malloc(bufferSize);
+    if (buffer == NULL)
+    {
+        fuzzHostFail("out of memory");
+    }
+
+    memset(buffer, 0x00, bufferSize);
+    memcpy(buffer, &btcTranFuzzData[btcTranFuzzOffset], apduLength);
+    btcTranFuzzOffset += apduLength;
+
+    btcTranFuzzControl = control;
+
+    btcCoreProcessAPDU(buffer, &apduLength);
+
+    if ((apduLength < 2) || (apduLength > bufferSize))
+    {
+        fuzzHostFail("response length out of range");
+    }
+
+    fuzzHostTouch(buffer, apduLength);
+
+    free(buffer);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    uint8_t pin[] = BTC_TRAN_FUZZ_PIN;
+    uint32_t i;
+
+    btcTranFuzzData = data;
+    btcTranFuzzSize = size;
+    btcTranFuzzOffset = 0;
+    btcTranFuzzWaiting = BTC_FALSE;
+
+    btcTranFuzzWipeoutInProgress = BTC_FALSE;
+    btcTranFuzzRegularCoinVersion = 0x00;
+    btcTranFuzzP2shCoinVersion = 0x05;
+    btcHalComputePinHash(pin, sizeof(pin) - 1, btcTranFuzzPinHash);
+    btcTranFuzzPinErrorCounter = BTC_GLOBAL_PIN_INITIAL_ERROR_COUNTER_VALUE;
+    btcTranFuzzWalletState = BTC_GLOBAL_WALLET_STATE_OPERATIONAL;
+
+    for (i = 0; i < BTC_TRAN_FUZZ_NUMBER_OF_HASHES; i++)
+    {
+        mbedtls_sha256_init(&btcTranFuzzHashContexts[i]);
+        btcTranFuzzHashStarted[i] = BTC_FALSE;
+    }
+
+    btcCoreInit();
+
+    while ((btcTranFuzzOffset + BTC_TRAN_FUZZ_RECORD_HEADER_LENGTH) <= btcTranFuzzSize)
+    {
+        btcTranFuzzProcessNextRecord();
+    }
+
+    btcCoreDeinit();
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * CCID core fuzz target. The input is a sequence of bulk OUT packets, each one a length byte, taken modulo
+ * CCID_MAX_PACKET_SIZE + 1, followed by the packet. The core is driven the way mk82Usb drives it: a response it builds
+ * is sent, an APDU it hands out is answered with a response as long as the APDU.
+ */
+
+#include <string.h>
+
+#include "ccidCore.h"
+#include "ccidGlobal.h"
+
+#include "fuzzHost.h"
+
+static CCID_CORE_HANDLE ccidFuzzHandle;
+static uint8_t ccidFuzzDataBuffer[CCID_MAX_MESSAGE_LENGTH];
+static uint8_t ccidFuzzHistChars[] = {'S', 'e', 'c', 'a', 'l', 'o', 't'};
+
+static void ccidFuzzSendResponse(void)
+{
+    uint8_t *response;
+    uint32_t responseLength;
+
+    ccidCoreGetResponse(&ccidFuzzHandle, &response, &responseLength);
+
+    if ((responseLength < CCID_MESSAGE_HEADER_SIZE) || (responseLength > CCID_MAX_MESSAGE_LENGTH))
+    {
+        fuzzHostFail("response length out of range");
+    }
+
+    fuzzHostTouch(response, responseLength);
+
+    ccidCoreResponseSent(&ccidFuzzHandle);
+}
+
+static void ccidFuzzProcessAPDU(void)
+{
+    uint8_t *apdu;
+    uint32_t apduLength;
+    uint8_t slot;
+    uint8_t *response;
+    uint32_t responseLength;
+
+    ccidCoreGetAPDU(&ccidFuzzHandle, &apdu, &apduLength);
+    ccidCoreGetSlot(&ccidFuzzHandle, &slot);
+
+    if ((apduLength > CCID_MAX_APDU_SIZE) || (slot >= CCID_NUMBER_OF_SLOTS))
+    {
+        fuzzHostFail("APDU or slot out of range");
+    }
+
+    /* The applets read the whole APDU */
+    fuzzHostTouch(apdu, apduLength);
+
+    ccidCorePrepareResponseAPDU(&ccidFuzzHandle, apduLength, &response, &responseLength);
+
+    if (responseLength != (apduLength + CCID_MESSAGE_HEADER_SIZE))
+    {
+        fuzzHostFail("response length does not match the APDU");
+    }
+
+    ccidCoreResponseSent(&ccidFuzzHandle);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    uint8_t packet[CCID_MAX_PACKET_SIZE];
+    size_t offset = 0;
+
+    ccidCoreInit(&ccidFuzzHandle, ccidFuzzDataBuffer, ccidFuzzHistChars, sizeof(ccidFuzzHistChars));
+
+    while (offset < size)
+    {
+        uint16_t packetLength = data[offset++] % (CCID_MAX_PACKET_SIZE + 1);
+        uint16_t requiredAction;
+
+        if (packetLength > (size - offset))
+        {
+            packetLength = (uint16_t)(size - offset);
+        }
+
+        memcpy(packet, &data[offset], packetLength);
+        offset += packetLength;
+
+        ccidCoreProcessIncomingPacket(&ccidFuzzHandle, packet, packetLength, &requiredAction);
+
+        if (requiredAction == CCID_CORE_ACTION_SEND_RESPOSE)
+        {
+            ccidFuzzSendResponse();
+        }
+        else if (requiredAction == CCID_CORE_ACTION_PROCESS_RECEIVED_APDU)
+        {
+            ccidFuzzProcessAPDU();
+        }
+        else if (requiredAction != CCID_CORE_ACTION_DO_NOTHING)
+        {
+            fuzzHostFail("unknown action");
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,459 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Host side of the USB parser fuzz targets. Stubs out the HAL calls the CCID core, the BTC and U2F HID layers and the
+ * APDU parser make, so that each of them runs on Linux exactly as written for the K82. A fatal error is reported as a
+ * crash: every one of them is reachable from the host only if a parser trusts what it receives.
+ *
+ * Every target defines LLVMFuzzerTestOneInput. Built with -DFUZZ_HOST_LIBFUZZER and -fsanitize=fuzzer, libFuzzer
+ * drives it. Otherwise the driver below does, which also works for AFL through @@.
+ *
+ * The driver times every input and reports the slowest one, which -slowest saves to a file. With -budget, an input that
+ * takes longer than that many milliseconds is reported as a crash.
+ *
+ * Built and run by usbParserFuzz.py.
+ *
+ * Usage:
+ *   <target> [-runs <count>] [-seed <seed>] [-budget <ms>] [-slowest <file>] <file or directory>...
+ *                                     run every input once, then count inputs mutated from them
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#ifdef __SANITIZE_ADDRESS__
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+#include "ccidGlobal.h"
+#include "ccidHal.h"
+#include "btcGlobal.h"
+#include "btcGlobalInt.h"
+#include "btcHal.h"
+#include "sfGlobal.h"
+#include "sfGlobalInt.h"
+#include "sfHal.h"
+
+#include "fuzzHost.h"
+
+#define FUZZ_HOST_MAX_INPUTS (1024)
+#define FUZZ_HOST_MAX_MUTATIONS (8)
+#define FUZZ_HOST_CRASH_FILE "fuzzHostCrash.bin"
+
+static uint32_t fuzzHostRandomState = 1;
+static volatile uint8_t fuzzHostSink;
+
+#ifndef FUZZ_HOST_LIBFUZZER
+static uint8_t *fuzzHostInputs[FUZZ_HOST_MAX_INPUTS];
+static size_t fuzzHostInputSizes[FUZZ_HOST_MAX_INPUTS];
+static size_t fuzzHostInputCount;
+
+static const uint8_t *fuzzHostCurrentInput;
+static size_t fuzzHostCurrentInputSize;
+
+static double fuzzHostBudgetInMs;
+static const char *fuzzHostSlowestPath;
+static double fuzzHostSlowestInMs;
+static uint8_t fuzzHostSlowestInput[FUZZ_HOST_MAX_INPUT_SIZE];
+static size_t fuzzHostSlowestInputSize;
+#endif /* FUZZ_HOST_LIBFUZZER */
+
+static uint32_t fuzzHostRandom(void)
+{
+    fuzzHostRandomState ^= fuzzHostRandomState << 13;
+    fuzzHostRandomState ^= fuzzHostRandomState >> 17;
+    fuzzHostRandomState ^= fuzzHostRandomState << 5;
+
+    return fuzzHostRandomState;
+}
+
+#ifndef FUZZ_HOST_LIBFUZZER
+static void fuzzHostSaveCurrentInput(void)
+{
+    FILE *file;
+
+    if (fuzzHostCurrentInput == NULL)
+    {
+        return;
+    }
+
+    file = fopen(FUZZ_HOST_CRASH_FILE, "wb");
+    if (file != NULL)
+    {
+        fwrite(fuzzHostCurrentInput, 1, fuzzHostCurrentInputSize, file);
+        fclose(file);
+        fprintf(stderr, "fuzzHost: input saved to " FUZZ_HOST_CRASH_FILE "\n");
+    }
+}
+#endif /* FUZZ_HOST_LIBFUZZER */
+
+void fuzzHostFail(const char *message)
+{
+    fprintf(stderr, "fuzzHost: %s\n", message);
+#ifdef __SANITIZE_ADDRESS__
+    __sanitizer_print_stack_trace();
+#endif
+#ifndef FUZZ_HOST_LIBFUZZER
+    fuzzHostSaveCurrentInput();
+    fuzzHostCurrentInput = NULL;
+#endif /* FUZZ_HOST_LIBFUZZER */
+    abort();
+}
+
+void fuzzHostTouch(const uint8_t *data, size_t length)
+{
+    const volatile uint8_t *bytes = data;
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        fuzzHostSink ^= bytes[i];
+    }
+}
+
+void ccidhalInit(void) {}
+
+void ccidHalDeinit(void) {}
+
+void ccidHalMemCpy(uint8_t *dst, uint8_t *src, uint16_t length) { memcpy(dst, src, length); }
+
+void ccidHalMemSet(uint8_t *dst, uint8_t value, uint16_t length) { memset(dst, value, length); }
+
+void ccidHalResetSlot(uint8_t slot)
+{
+    if (slot >= CCID_NUMBER_OF_SLOTS)
+    {
+        fuzzHostFail("ccidHalResetSlot slot out of range");
+    }
+}
+
+void ccidHalFatalError(void) { fuzzHostFail("ccidHalFatalError"); }
+
+void btcHalMemCpy(uint8_t *dst, uint8_t *src, uint16_t length) { memcpy(dst, src, length); }
+
+void btcHalMemSet(uint8_t *dst, uint8_t value, uint16_t length) { memset(dst, value, length); }
+
+void btcHalFatalError(void) { fuzzHostFail("btcHalFatalError"); }
+
+void sfHalMemCpy(uint8_t *dst, uint8_t *src, uint16_t length) { memcpy(dst, src, length); }
+
+void sfHalMemSet(uint8_t *dst, uint8_t value, uint16_t length) { memset(dst, value, length); }
+
+void sfHalGenerateNonSecureRandom(uint8_t *data, uint16_t length)
+{
+    uint16_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        data[i] = (uint8_t)fuzzHostRandom();
+    }
+}
+
+void sfHalFatalError(void) { fuzzHostFail("sfHalFatalError"); }
+
+#ifndef FUZZ_HOST_LIBFUZZER
+
+static void fuzzHostDie(const char *message, const char *argument)
+{
+    fprintf(stderr, "fuzzHost: %s %s\n", message, argument);
+    exit(1);
+}
+
+static void fuzzHostLoadFile(const char *path)
+{
+    FILE *file;
+    uint8_t *input;
+    size_t size;
+
+    if (fuzzHostInputCount == FUZZ_HOST_MAX_INPUTS)
+    {
+        fuzzHostDie("too many inputs at", path);
+    }
+
+    input = malloc(FUZZ_HOST_MAX_INPUT_SIZE);
+    file = fopen(path, "rb");
+    if ((input == NULL) || (file == NULL))
+    {
+        fuzzHostDie("cannot read", path);
+    }
+
+    size = fread(input, 1, FUZZ_HOST_MAX_INPUT_SIZE, file);
+    fclose(file);
+
+    fuzzHostInputs[fuzzHostInputCount] = input;
+    fuzzHostInputSizes[fuzzHostInputCount] = size;
+    fuzzHostInputCount++;
+}
+
+static void fuzzHostLoad(const char *path)
+{
+    struct stat status;
+    struct dirent *entry;
+    DIR *directory;
+    char entryPath[4096];
+
+    if (stat(path, &status) != 0)
+    {
+        fuzzHostDie("cannot read", path);
+    }
+
+    if (!S_ISDIR(status.st_mode))
+    {
+        fuzzHostLoadFile(path);
+        return;
+    }
+
+    directory = opendir(path);
+    if (directory == NULL)
+    {
+        fuzzHostDie("cannot read", path);
+    }
+
+    while ((entry = readdir(directory)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        snprintf(entryPath, sizeof(entryPath), "%s/%s", path, entry->d_name);
+        fuzzHostLoadFile(entryPath);
+    }
+
+    closedir(directory);
+}
+
+static double fuzzHostGetMs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec * 1e3) + (now.tv_nsec / 1e6);
+}
+
+/* Runs one input from a buffer of exactly its size, so that the sanitizers see any read past its end */
+static void fuzzHostRun(const uint8_t *input, size_t size)
+{
+    uint8_t *copy;
+    double start;
+    double elapsed;
+
+    copy = malloc(size != 0 ? size : 1);
+    if (copy == NULL)
+    {
+        fuzzHostDie("out of memory", "");
+    }
+    memcpy(copy, input, size);
+
+    fuzzHostCurrentInput = copy;
+    fuzzHostCurrentInputSize = size;
+
+    start = fuzzHostGetMs();
+    LLVMFuzzerTestOneInput(copy, size);
+    elapsed = fuzzHostGetMs() - start;
+
+    if (elapsed > fuzzHostSlowestInMs)
+    {
+        fuzzHostSlowestInMs = elapsed;
+        memcpy(fuzzHostSlowestInput, copy, size);
+        fuzzHostSlowestInputSize = size;
+    }
+
+    if ((fuzzHostBudgetInMs != 0) && (elapsed > fuzzHostBudgetInMs))
+    {
+        fprintf(stderr, "fuzzHost: input took %.3f ms\n", elapsed);
+        fuzzHostFail("input over the time budget");
+    }
+
+    fuzzHostCurrentInput = NULL;
+    free(copy);
+}
+
+static size_t fuzzHostMutate(uint8_t *input, size_t size)
+{
+    static const uint8_t interestingBytes[] = {0x00, 0x01, 0x05, 0x40, 0x41, 0x7F, 0x80, 0x81, 0xFE, 0xFF};
+    uint32_t mutations;
+    uint32_t i;
+
+    mutations = 1 + fuzzHostRandom() % FUZZ_HOST_MAX_MUTATIONS;
+
+    for (i = 0; i < mutations; i++)
+    {
+        size_t position = (size != 0) ? (fuzzHostRandom() % size) : 0;
+        size_t length;
+
+        switch (fuzzHostRandom() % 6)
+        {
+            case 0:
+                if (size != 0)
+                {
+                    input[position] ^= (uint8_t)(1 << (fuzzHostRandom() % 8));
+                }
+                break;
+            case 1:
+                if (size != 0)
+                {
+                    input[position] = (uint8_t)fuzzHostRandom();
+                }
+                break;
+            case 2:
+                if (size != 0)
+                {
+                    input[position] = interestingBytes[fuzzHostRandom() % sizeof(interestingBytes)];
+                }
+                break;
+            case 3:
+                /* Insert random bytes */
+                length = 1 + fuzzHostRandom() % 64;
+                if ((size + length) <= FUZZ_HOST_MAX_INPUT_SIZE)
+                {
+                    memmove(&input[position + length], &input[position], size - position);
+                    for (; length > 0; length--, size++)
+                    {
+                        input[position + length - 1] = (uint8_t)fuzzHostRandom();
+                    }
+                }
+                break;
+            case 4:
+                /* Erase a range */
+                if (size != 0)
+                {
+                    length = 1 + fuzzHostRandom() % (size - position);
+                    memmove(&input[position], &input[position + length], size - position - length);
+                    size -= length;
+                }
+                break;
+            default:
+            {
+                /* Overwrite a range with a piece of another input */
+                size_t other = fuzzHostRandom() % fuzzHostInputCount;
+                size_t source;
+
+                if ((size == 0) || (fuzzHostInputSizes[other] == 0))
+                {
+                    break;
+                }
+
+                source = fuzzHostRandom() % fuzzHostInputSizes[other];
+                length = 1 + fuzzHostRandom() % (fuzzHostInputSizes[other] - source);
+                if (length > (size - position))
+                {
+                    length = size - position;
+                }
+                memcpy(&input[position], &fuzzHostInputs[other][source], length);
+            }
+            break;
+        }
+    }
+
+    return size;
+}
+
+static void fuzzHostSaveSlowestInput(void)
+{
+    FILE *file;
+
+    file = fopen(fuzzHostSlowestPath, "wb");
+    if (file == NULL)
+    {
+        fuzzHostDie("cannot write", fuzzHostSlowestPath);
+    }
+
+    fwrite(fuzzHostSlowestInput, 1, fuzzHostSlowestInputSize, file);
+    fclose(file);
+}
+
+static void fuzzHostDeathCallback(void)
+{
+    fuzzHostSaveCurrentInput();
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t mutated[FUZZ_HOST_MAX_INPUT_SIZE];
+    unsigned long runs = 0;
+    unsigned long run;
+    size_t i;
+    int arg;
+
+#ifdef __SANITIZE_ADDRESS__
+    __sanitizer_set_death_callback(fuzzHostDeathCallback);
+#else
+    (void)fuzzHostDeathCallback;
+#endif
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if ((strcmp(argv[arg], "-runs") == 0) && ((arg + 1) < argc))
+        {
+            runs = strtoul(argv[++arg], NULL, 0);
+        }
+        else if ((strcmp(argv[arg], "-seed") == 0) && ((arg + 1) < argc))
+        {
+            fuzzHostRandomState = (uint32_t)strtoul(argv[++arg], NULL, 0);
+            if (fuzzHostRandomState == 0)
+            {
+                fuzzHostRandomState = 1;
+            }
+        }
+        else if ((strcmp(argv[arg], "-budget") == 0) && ((arg + 1) < argc))
+        {
+            fuzzHostBudgetInMs = strtod(argv[++arg], NULL);
+        }
+        else if ((strcmp(argv[arg], "-slowest") == 0) && ((arg + 1) < argc))
+        {
+            fuzzHostSlowestPath = argv[++arg];
+        }
+        else
+        {
+            fuzzHostLoad(argv[arg]);
+        }
+    }
+
+    if (fuzzHostInputCount == 0)
+    {
+        fuzzHostDie("usage:",
+                    "<target> [-runs <count>] [-seed <seed>] [-budget <ms>] [-slowest <file>] <file or directory>...");
+    }
+
+    for (i = 0; i < fuzzHostInputCount; i++)
+    {
+        fuzzHostRun(fuzzHostInputs[i], fuzzHostInputSizes[i]);
+    }
+
+    for (run = 0; run < runs; run++)
+    {
+        size_t size;
+
+        i = fuzzHostRandom() % fuzzHostInputCount;
+        memcpy(mutated, fuzzHostInputs[i], fuzzHostInputSizes[i]);
+
+        size = fuzzHostMutate(mutated, fuzzHostInputSizes[i]);
+
+        fuzzHostRun(mutated, size);
+    }
+
+    if (fuzzHostSlowestPath != NULL)
+    {
+        fuzzHostSaveSlowestInput();
+    }
+
+    printf("%u inputs and %lu mutations run, slowest input %.3f ms\n", (unsigned)fuzzHostInputCount, runs,
+           fuzzHostSlowestInMs);
+
+    return 0;
+}
+
+#endif /* FUZZ_HOST_LIBFUZZER */
@@ -0,0 +1,28 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __FUZZ_HOST_H__
+#define __FUZZ_HOST_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Largest input the standalone driver reads or produces, enough for a maximal CCID message split into packets */
+#define FUZZ_HOST_MAX_INPUT_SIZE (8192)
+
+/* Implemented by every target, the libFuzzer entry point */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+/* Reads every byte, so that the sanitizers check the whole range */
+void fuzzHostTouch(const uint8_t *data, size_t length);
+
+/* Reports a broken invariant or a reachable fatal error as a crash */
+void fuzzHostFail(const char *message);
+
+#endif /* __FUZZ_HOST_H__ */
@@ -0,0 +1,105 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * U2F HID fuzz target. The input is a sequence of interrupt OUT reports, cut into SF_HID_FRAME_SIZE pieces, the last
+ * one padded with zeroes. A reassembled MSG or PING is answered with a response as long as the request, sent frame by
+ * frame the way mk82Usb sends it. A transaction still open after the last report runs into the message timeout.
+ */
+
+#include <string.h>
+
+#include "sfGlobal.h"
+#include "sfHid.h"
+
+#include "fuzzHost.h"
+
+static SF_HID_HANDLE sfHidFuzzHandle;
+static uint8_t sfHidFuzzDataBuffer[SF_HID_MAX_DATA_SIZE];
+
+static void sfHidFuzzProcessCommand(void)
+{
+    uint8_t frame[SF_HID_FRAME_SIZE];
+    uint16_t command;
+    uint16_t incomingDataSize;
+    uint16_t moreFramesAvailable;
+
+    sfHidGetIncomingCommandAndDataSize(&sfHidFuzzHandle, &command, &incomingDataSize);
+
+    if (incomingDataSize > SF_HID_MAX_DATA_SIZE)
+    {
+        fuzzHostFail("message length out of range");
+    }
+
+    fuzzHostTouch(sfHidFuzzDataBuffer, incomingDataSize);
+
+    sfHidSetOutgoingDataLength(&sfHidFuzzHandle, incomingDataSize);
+
+    do
+    {
+        sfHidProcessOutgoingData(&sfHidFuzzHandle, frame, &moreFramesAvailable);
+    } while (moreFramesAvailable == SF_TRUE);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    uint8_t frame[SF_HID_FRAME_SIZE];
+    uint8_t immediateFrame[SF_HID_FRAME_SIZE];
+    uint16_t timerRunning = SF_FALSE;
+    size_t offset;
+
+    sfHidInit(&sfHidFuzzHandle, sfHidFuzzDataBuffer);
+
+    for (offset = 0; offset < size; offset += SF_HID_FRAME_SIZE)
+    {
+        size_t frameLength = size - offset;
+        uint16_t requiredAction;
+        uint16_t timerAction;
+
+        if (frameLength > SF_HID_FRAME_SIZE)
+        {
+            frameLength = SF_HID_FRAME_SIZE;
+        }
+
+        memset(frame, 0x00, sizeof(frame));
+        memcpy(frame, &data[offset], frameLength);
+
+        sfHidProcessIncomingFrame(&sfHidFuzzHandle, frame, immediateFrame, &requiredAction, &timerAction, SF_TRUE);
+
+        if (timerAction == SF_HID_TIMER_ACTION_START)
+        {
+            timerRunning = SF_TRUE;
+        }
+        else if (timerAction == SF_HID_TIMER_ACTION_STOP)
+        {
+            timerRunning = SF_FALSE;
+        }
+        else if (timerAction != SF_HID_TIMER_ACTION_DO_NOTHING)
+        {
+            fuzzHostFail("unknown timer action");
+        }
+
+        if (requiredAction == SF_HID_ACTION_PROCESS_RECEIVED_COMMAND)
+        {
+            sfHidFuzzProcessCommand();
+        }
+        else if ((requiredAction != SF_HID_ACTION_DO_NOTHING) &&
+                 (requiredAction != SF_HID_ACTION_SEND_IMMEDIATE_OUTGOING_FRAME))
+        {
+            fuzzHostFail("unknown action");
+        }
+    }
+
+    if (timerRunning == SF_TRUE)
+    {
+        sfHidTimeoutHandler(&sfHidFuzzHandle, immediateFrame);
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Checks the Keccak permutation of the sha3 middleware against known answers
+# and for messages absorbed in pieces. sha3.c is built for Linux unchanged
+# in sha3Host/, which also prints the host throughput.
+#
+# device reads the cycles one Keccak-256 takes on the K82 from a device
+# built with USE_DIAG and prints them per byte. The message is eight blocks,
+# so the figure includes one block worth of padding and squeezing.
+#
+# Usage:
+#   keccakTest.py           run the host test
+#   keccakTest.py device    print the cycles/byte of the device
+#
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from fsRecordStore import REPO_DIR, TOOLS_DIR
+
+DIAG_AID = [0x44, 0x49, 0x41, 0x47, 0x41, 0x50, 0x50, 0x4C, 0x45, 0x54]
+
+USAGE = 'usage: keccakTest.py [device]'
+
+
+def build(work_dir):
+    binary = os.path.join(work_dir, 'sha3Host')
+    command = ['gcc', '-O2', '-Wall', '-Wextra', '-std=gnu99',
+               '-I' + os.path.join(REPO_DIR, 'mk82', 'middleware', 'sha3'),
+               os.path.join(TOOLS_DIR, 'sha3Host', 'sha3Host.c'),
+               os.path.join(REPO_DIR, 'mk82', 'middleware', 'sha3', 'sha3.c'), '-o', binary]
+    subprocess.run(command, check=True)
+    return binary
+
+
+def host():
+    work_dir = tempfile.mkdtemp()
+    try:
+        result = subprocess.run([build(work_dir)])
+    finally:
+        shutil.rmtree(work_dir)
+
+    sys.exit(result.returncode)
+
+
+def transmit(connection, apdu):
+    data, sw1, sw2 = connection.transmit(apdu)
+    if (sw1, sw2) != (0x90, 0x00):
+        sys.exit('APDU %s failed with SW %02X%02X' % (bytes(apdu[:4]).hex(), sw1, sw2))
+    return bytes(data)
+
+
+def device():
+    from smartcard.System import readers
+
+    for reader in readers():
+        if 'Secalot' in str(reader):
+            connection = reader.createConnection()
+            connection.connect()
+            transmit(connection, [0x00, 0xA4, 0x04, 0x00, len(DIAG_AID)] + DIAG_AID)
+            break
+    else:
+        sys.exit('Secalot reader not found')
+
+    data = transmit(connection, [0x80, 0x07, 0x00, 0x00, 0x00])
+    length = int.from_bytes(data[0:4], 'big')
+    cycles = int.from_bytes(data[4:8], 'big')
+    clock = int.from_bytes(data[8:12], 'big')
+
+    print('Keccak-256 of %d bytes: %d cycles, %.1f cycles/byte, %.2f ms at %d MHz' % (
+        length, cycles, cycles / length, cycles * 1e3 / clock, clock // 1000000))
+
+
+def main():
+    if len(sys.argv) == 1:
+        host()
+    elif len(sys.argv) == 2 and sys.argv[1] == 'device':
+        device()
+    else:
+        sys.exit(USAGE)
+
+
+if __name__ == '__main__':
+    main()
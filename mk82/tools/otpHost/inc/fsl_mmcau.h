@@ -0,0 +1,22 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/* Host replacement of the MMCAU SHA-1 calls, implemented in software by otpHost.c. */
+
+#ifndef __OTP_HOST_FSL_MMCAU_H__
+#define __OTP_HOST_FSL_MMCAU_H__
+
+#include <stdint.h>
+
+#include "fsl_flash.h"
+
+status_t MMCAU_SHA1_InitializeOutput(uint32_t *sha1State);
+status_t MMCAU_SHA1_HashN(const uint8_t *msgData, uint32_t numBlocks, uint32_t *sha1State);
+
+#endif /* __OTP_HOST_FSL_MMCAU_H__ */
@@ -0,0 +1,349 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Host test of the OTP HAL, which computes HOTP codes from SHA-1 midstates stored in place of the key. otpHal.c is
+ * built unchanged for Linux. MMCAU SHA-1 is replaced by a software SHA-1, the file system by one RAM buffer per file
+ * and the keysafe by a reversible scramble with a checked tag, so that a value read back without unwrapping it is
+ * caught.
+ *
+ * Runs the RFC 4226 Appendix D vectors twice: for a key set through otpHalSetKeySetTypeAndResetCounter and for the
+ * same key stored raw, the way an older firmware stored it, which otpHal converts on first use. Prints one line per
+ * failed check and exits with 1 if there was any.
+ *
+ * Built and run by otpHotpTest.py.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "otpGlobal.h"
+#include "otpGlobalInt.h"
+#include "otpHal.h"
+
+#include "mk82Global.h"
+#include "mk82System.h"
+#include "mk82KeySafe.h"
+#include "mk82Fs.h"
+
+#include "fsl_mmcau.h"
+
+#define OTP_HOST_NUMBER_OF_FILES (32)
+#define OTP_HOST_MAX_FILE_SIZE (256)
+#define OTP_HOST_SCRAMBLE (0xA5)
+#define OTP_HOST_DIGITS_MODULUS (1000000)
+
+#define OTP_HOST_ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static uint8_t otpHostFiles[OTP_HOST_NUMBER_OF_FILES][OTP_HOST_MAX_FILE_SIZE];
+static uint32_t otpHostFailures;
+
+/* RFC 4226 Appendix D */
+static uint8_t otpHostKey[] = "12345678901234567890";
+
+static const char *otpHostExpectedHmacs[] = {
+    "cc93cf18508d94934c64b65d8ba7667fb7cde4b0", "75a48a19d4cbe100644e8ac1397eea747a2d33ab",
+    "0bacb7fa082fef30782211938bc1c5e70416ff44", "66c28227d03a2d5529262ff016a1e6ef76557ece",
+    "a904c900a64b35909874b33e61c5938a8e15ed1c", "a37e783d7b7233c083d4f62926c7a25f238d0316",
+    "bc9cd28561042c83f219324d3c607256c03272ae", "a4fb960c0bc06e1eabb804e5b397cdc4b45596fa",
+    "1b3c89f65e6c9e883012052823443f048b4332db", "1637409809a679dc698207310c8c7fc07290d9e5"};
+
+static const uint32_t otpHostExpectedCodes[] = {755224, 287082, 359152, 969429, 338314,
+                                                254676, 287922, 162583, 399871, 520489};
+
+static void otpHostDie(const char *message)
+{
+    fprintf(stderr, "otpHost: %s\n", message);
+    exit(1);
+}
+
+static void otpHostCheck(int condition, const char *message, uint32_t counter)
+{
+    if (!condition)
+    {
+        printf("FAIL %s, counter %u\n", message, (unsigned)counter);
+        otpHostFailures++;
+    }
+}
+
+status_t MMCAU_SHA1_InitializeOutput(uint32_t *sha1State)
+{
+    sha1State[0] = 0x67452301;
+    sha1State[1] = 0xEFCDAB89;
+    sha1State[2] = 0x98BADCFE;
+    sha1State[3] = 0x10325476;
+    sha1State[4] = 0xC3D2E1F0;
+
+    return kStatus_FLASH_Success;
+}
+
+status_t MMCAU_SHA1_HashN(const uint8_t *msgData, uint32_t numBlocks, uint32_t *sha1State)
+{
+    uint32_t w[80];
+    uint32_t a, b, c, d, e, f, k, t;
+    uint32_t block;
+    uint32_t i;
+
+    for (block = 0; block < numBlocks; block++, msgData += 64)
+    {
+        for (i = 0; i < 16; i++)
+        {
+            w[i] = ((uint32_t)msgData[4 * i] << 24) | ((uint32_t)msgData[4 * i + 1] << 16) |
+                   ((uint32_t)msgData[4 * i + 2] << 8) | (uint32_t)msgData[4 * i + 3];
+        }
+
+        for (i = 16; i < 80; i++)
+        {
+            w[i] = OTP_HOST_ROTL(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        a = sha1State[0];
+        b = sha1State[1];
+        c = sha1State[2];
+        d = sha1State[3];
+        e = sha1State[4];
+
+        for (i = 0; i < 80; i++)
+        {
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            t = OTP_HOST_ROTL(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = OTP_HOST_ROTL(b, 30);
+            b = a;
+            a = t;
+        }
+
+        sha1State[0] += a;
+        sha1State[1] += b;
+        sha1State[2] += c;
+        sha1State[3] += d;
+        sha1State[4] += e;
+    }
+
+    return kStatus_FLASH_Success;
+}
+
+void mk82FsReadFile(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+{
+    if ((fileID >= OTP_HOST_NUMBER_OF_FILES) || (offset > OTP_HOST_MAX_FILE_SIZE) ||
+        (length > (OTP_HOST_MAX_FILE_SIZE - offset)))
+    {
+        otpHostDie("file read out of range");
+    }
+
+    memcpy(buffer, &otpHostFiles[fileID][offset], length);
+}
+
+void mk82FsWriteFile(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+{
+    if ((fileID >= OTP_HOST_NUMBER_OF_FILES) || (offset > OTP_HOST_MAX_FILE_SIZE) ||
+        (length > (OTP_HOST_MAX_FILE_SIZE - offset)))
+    {
+        otpHostDie("file write out of range");
+    }
+
+    memcpy(&otpHostFiles[fileID][offset], buffer, length);
+}
+
+void mk82FsCommitWrite(uint8_t fileID) { (void)fileID; }
+
+/* The tag is a sum over the plain key, the nonce a count of wraps. Only the round trip is checked here. */
+void mk82KeysafeWrapKey(uint16_t kekID, uint8_t *key, uint32_t keyLength, uint8_t *encryptedKey, uint8_t *appData,
+                        uint32_t appDataLength, uint8_t *nonce, uint8_t *tag)
+{
+    static uint8_t wraps;
+    uint8_t sum = 0;
+    uint32_t i;
+
+    (void)appData;
+    (void)appDataLength;
+
+    if (kekID != MK82_KEYSAFE_OTP_KEK_ID)
+    {
+        otpHostDie("wrong KEK");
+    }
+
+    for (i = 0; i < keyLength; i++)
+    {
+        sum += key[i];
+        encryptedKey[i] = key[i] ^ OTP_HOST_SCRAMBLE;
+    }
+
+    memset(nonce, ++wraps, MK82_KEYSAFE_NONCE_LENGTH);
+    memset(tag, sum, MK82_KEYSAFE_TAG_LENGTH);
+}
+
+uint16_t mk82KeysafeUnwrapKey(uint16_t kekID, uint8_t *encryptedKey, uint32_t keyLength, uint8_t *key,
+                              uint8_t *appData, uint32_t appDataLength, uint8_t *nonce, uint8_t *tag)
+{
+    uint8_t sum = 0;
+    uint32_t i;
+
+    (void)appData;
+    (void)appDataLength;
+    (void)nonce;
+
+    if (kekID != MK82_KEYSAFE_OTP_KEK_ID)
+    {
+        otpHostDie("wrong KEK");
+    }
+
+    for (i = 0; i < keyLength; i++)
+    {
+        key[i] = encryptedKey[i] ^ OTP_HOST_SCRAMBLE;
+        sum += key[i];
+    }
+
+    for (i = 0; i < MK82_KEYSAFE_TAG_LENGTH; i++)
+    {
+        if (tag[i] != sum)
+        {
+            return MK82_FALSE;
+        }
+    }
+
+    return MK82_NO_ERROR;
+}
+
+void mk82SystemMemCpy(uint8_t *dst, uint8_t *src, uint16_t length) { memmove(dst, src, length); }
+
+void mk82SystemMemSet(uint8_t *dst, uint8_t value, uint16_t length) { memset(dst, value, length); }
+
+uint16_t mk82SystemMemCmp(uint8_t *array1, uint8_t *array2, uint16_t length)
+{
+    return (memcmp(array1, array2, length) == 0) ? MK82_TRUE : MK82_FALSE;
+}
+
+void mk82SystemTickerGetMsPassed(uint64_t *ms) { *ms = 0; }
+
+void mk82SystemTickerGetSessionID(uint32_t *sessionID) { *sessionID = 0; }
+
+void mk82SystemFatalError(void) { otpHostDie("fatal error in the OTP HAL"); }
+
+static uint32_t otpHostTruncate(uint8_t *hmac)
+{
+    uint32_t offset = hmac[OTP_GLOBAL_HAMC_LENGTH - 1] & 0x0F;
+
+    return ((((uint32_t)hmac[offset] & 0x7F) << 24) | ((uint32_t)hmac[offset + 1] << 16) |
+            ((uint32_t)hmac[offset + 2] << 8) | (uint32_t)hmac[offset + 3]) %
+           OTP_HOST_DIGITS_MODULUS;
+}
+
+static void otpHostRunVectors(void)
+{
+    uint8_t counter[OTP_GLOBAL_COUNTER_LENGTH];
+    uint8_t hmac[OTP_GLOBAL_HAMC_LENGTH];
+    char hmacHex[2 * OTP_GLOBAL_HAMC_LENGTH + 1];
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < (sizeof(otpHostExpectedCodes) / sizeof(otpHostExpectedCodes[0])); i++)
+    {
+        memset(counter, 0x00, sizeof(counter));
+        counter[OTP_GLOBAL_COUNTER_LENGTH - 1] = (uint8_t)i;
+
+        otpHalComputeHmac(counter, hmac);
+
+        for (j = 0; j < OTP_GLOBAL_HAMC_LENGTH; j++)
+        {
+            sprintf(&hmacHex[2 * j], "%02x", hmac[j]);
+        }
+
+        otpHostCheck(strcmp(hmacHex, otpHostExpectedHmacs[i]) == 0, "HMAC", i);
+        otpHostCheck(otpHostTruncate(hmac) == otpHostExpectedCodes[i], "HOTP value", i);
+    }
+}
+
+static void otpHostTestStoredMidstates(void)
+{
+    uint8_t key[OTP_GLOBAL_MAX_KEYLENGTH];
+    OTP_HAL_NVM_KEYS *keys = (OTP_HAL_NVM_KEYS *)otpHostFiles[MK82_FS_FILE_ID_OTP_KEYS];
+    uint32_t i;
+
+    memset(otpHostFiles, 0x00, sizeof(otpHostFiles));
+    otpHalWipeout();
+
+    memcpy(key, otpHostKey, sizeof(otpHostKey) - 1);
+    otpHalSetKeySetTypeAndResetCounter(key, sizeof(otpHostKey) - 1, OTP_GLOBAL_TYPE_HOTP);
+
+    for (i = 0; i < OTP_GLOBAL_MAX_KEYLENGTH; i++)
+    {
+        otpHostCheck(keys->key[i] == 0x00, "raw key stored with the midstates", 0);
+    }
+
+    otpHostRunVectors();
+}
+
+static void otpHostTestMigratedKey(void)
+{
+    OTP_HAL_NVM_KEYS *keys = (OTP_HAL_NVM_KEYS *)otpHostFiles[MK82_FS_FILE_ID_OTP_KEYS];
+    OTP_HAL_NVM_KEY_MIDSTATES *midstates = (OTP_HAL_NVM_KEY_MIDSTATES *)otpHostFiles[MK82_FS_FILE_ID_OTP_KEY_MIDSTATES];
+    uint8_t key[OTP_GLOBAL_MAX_KEYLENGTH];
+    uint32_t keyLength = sizeof(otpHostKey) - 1;
+    uint16_t trueFalse = OTP_TRUE;
+    uint32_t i;
+
+    memset(otpHostFiles, 0x00, sizeof(otpHostFiles));
+    otpHalWipeout();
+
+    /* What an older firmware left behind: the wrapped raw key and no midstates */
+    memset(key, 0x00, sizeof(key));
+    memcpy(key, otpHostKey, keyLength);
+    mk82KeysafeWrapKey(MK82_KEYSAFE_OTP_KEK_ID, key, sizeof(key), keys->key, NULL, 0, keys->keyNonce, keys->keyTag);
+    memcpy(&keys->keyLength, &keyLength, sizeof(keyLength));
+    memcpy(&keys->keyInitialized, &trueFalse, sizeof(trueFalse));
+
+    otpHostRunVectors();
+
+    memcpy(&trueFalse, &midstates->midstatesInitialized, sizeof(trueFalse));
+    otpHostCheck(trueFalse == OTP_TRUE, "midstates not stored after conversion", 0);
+
+    for (i = 0; i < OTP_GLOBAL_MAX_KEYLENGTH; i++)
+    {
+        otpHostCheck(keys->key[i] == 0x00, "raw key kept after conversion", 0);
+    }
+}
+
+int main(void)
+{
+    otpHostTestStoredMidstates();
+    otpHostTestMigratedKey();
+
+    if (otpHostFailures != 0)
+    {
+        printf("%u checks failed\n", (unsigned)otpHostFailures);
+        return 1;
+    }
+
+    printf("RFC 4226 vectors passed for stored and converted keys\n");
+
+    return 0;
+}
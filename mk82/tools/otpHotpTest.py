@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Checks the HOTP codes the OTP HAL computes from stored SHA-1 midstates
+# against the RFC 4226 Appendix D vectors, for a freshly set key and for a
+# raw key left by an older firmware. otpHal.c is built for Linux with the
+# MMCAU, file system and keysafe calls replaced in otpHost/.
+#
+# Usage:
+#   otpHotpTest.py
+#
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from fsRecordStore import REPO_DIR, TOOLS_DIR
+
+INCLUDE_DIRS = ['mk82/tools/otpHost/inc', 'mk82/tools/fsHost/inc', 'platform/mk82/inc', 'otp/inc', 'otp/src']
+
+
+def build(work_dir):
+    # The tree is edited on Windows and some includes differ from the file
+    # names in case only.
+    case_dir = os.path.join(work_dir, 'inc')
+    os.makedirs(case_dir, exist_ok=True)
+    if not os.path.exists(os.path.join(REPO_DIR, 'platform', 'mk82', 'inc', 'mk82Keysafe.h')):
+        with open(os.path.join(case_dir, 'mk82Keysafe.h'), 'w') as header:
+            header.write('#include "mk82KeySafe.h"\n')
+
+    binary = os.path.join(work_dir, 'otpHost')
+    command = ['gcc', '-O2', '-Wall', '-Wextra', '-std=gnu99', '-DFIRMWARE', '-I' + case_dir]
+    command += ['-I' + os.path.join(REPO_DIR, path) for path in INCLUDE_DIRS]
+    command += [os.path.join(TOOLS_DIR, 'otpHost', 'otpHost.c'),
+                os.path.join(REPO_DIR, 'otp', 'src', 'hal', 'k82', 'otpHal.c')]
+    command += ['-o', binary]
+    subprocess.run(command, check=True)
+    return binary
+
+
+def main():
+    if len(sys.argv) != 1:
+        sys.exit('usage: otpHotpTest.py')
+
+    work_dir = tempfile.mkdtemp()
+    try:
+        result = subprocess.run([build(work_dir)])
+    finally:
+        shutil.rmtree(work_dir)
+
+    sys.exit(result.returncode)
+
+
+if __name__ == '__main__':
+    main()
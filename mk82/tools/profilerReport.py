@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Reads the sampling profiler histogram from a device built with USE_DIAG and
+# USE_PROFILER and maps its buckets back to function symbols of the firmware
+# ELF.
+#
+# Usage:
+#   profilerReport.py start [rate]         start sampling (default 1000 Hz)
+#   profilerReport.py stop                 stop sampling
+#   profilerReport.py dump <file>          save the raw histogram as JSON
+#   profilerReport.py report <elf> [file]  print per-function samples
+#
+
+import json
+import subprocess
+import sys
+
+DIAG_AID = [0x44, 0x49, 0x41, 0x47, 0x41, 0x50, 0x50, 0x4C, 0x45, 0x54]
+NM = 'arm-none-eabi-nm'
+
+USAGE = 'usage: profilerReport.py start [rate] | stop | dump <file> | report <elf> [file]'
+
+
+def connect():
+    from smartcard.System import readers
+
+    for reader in readers():
+        if 'Secalot' in str(reader):
+            connection = reader.createConnection()
+            connection.connect()
+            transmit(connection, [0x00, 0xA4, 0x04, 0x00, len(DIAG_AID)] + DIAG_AID)
+            return connection
+
+    sys.exit('Secalot reader not found')
+
+
+def transmit(connection, apdu):
+    data, sw1, sw2 = connection.transmit(apdu)
+    if (sw1, sw2) != (0x90, 0x00):
+        sys.exit('APDU %s failed with SW %02X%02X' % (bytes(apdu[:4]).hex(), sw1, sw2))
+    return bytes(data)
+
+
+def read_histogram(connection):
+    info = transmit(connection, [0x80, 0x00, 0x00, 0x00, 0x00])
+    fields = [int.from_bytes(info[i:i + 4], 'big') for i in range(0, 24, 4)]
+    result = dict(zip(['rate', 'regionStart', 'bucketSize', 'numberOfBuckets', 'totalSamples',
+                       'outOfRegionSamples'], fields))
+    buckets = []
+    while len(buckets) < result['numberOfBuckets']:
+        first = len(buckets)
+        data = transmit(connection, [0x80, 0x03, first >> 8, first & 0xFF, 0x00])
+        buckets += [int.from_bytes(data[i:i + 2], 'big') for i in range(0, len(data), 2)]
+    result['buckets'] = buckets
+    return result
+
+
+def load_symbols(elf):
+    output = subprocess.check_output([NM, '--print-size', '--size-sort', '--defined-only', elf]).decode()
+    symbols = []
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) == 4 and parts[2] in 'tTwW':
+            symbols.append((int(parts[0], 16) & ~1, int(parts[1], 16), parts[3]))
+    symbols.sort()
+    return symbols
+
+
+def report(elf, histogram):
+    symbols = load_symbols(elf)
+    perSymbol = {}
+    bucketSize = histogram['bucketSize']
+
+    for index, count in enumerate(histogram['buckets']):
+        if count == 0:
+            continue
+        start = histogram['regionStart'] + index * bucketSize
+        end = start + bucketSize
+        attributed = 0.0
+        for address, size, name in symbols:
+            overlap = min(end, address + size) - max(start, address)
+            if overlap > 0:
+                share = count * overlap / bucketSize
+                perSymbol[name] = perSymbol.get(name, 0.0) + share
+                attributed += share
+        if attributed < count:
+            perSymbol['<unknown>'] = perSymbol.get('<unknown>', 0.0) + count - attributed
+
+    total = histogram['totalSamples']
+    print('%d samples at %d Hz, %d outside of the firmware region' %
+          (total, histogram['rate'], histogram['outOfRegionSamples']))
+    for name, count in sorted(perSymbol.items(), key=lambda item: -item[1]):
+        print('%6.2f%% %10.1f  %s' % (100.0 * count / max(total, 1), count, name))
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(USAGE)
+
+    command = sys.argv[1]
+
+    if command == 'start':
+        rate = int(sys.argv[2]) if len(sys.argv) > 2 else 1000
+        transmit(connect(), [0x80, 0x01, 0x00, 0x00, 0x04] + list(rate.to_bytes(4, 'big')))
+    elif command == 'stop':
+        transmit(connect(), [0x80, 0x02, 0x00, 0x00])
+    elif command == 'dump':
+        with open(sys.argv[2], 'w') as f:
+            json.dump(read_histogram(connect()), f)
+    elif command == 'report':
+        if len(sys.argv) > 3:
+            with open(sys.argv[3]) as f:
+                histogram = json.load(f)
+        else:
+            histogram = read_histogram(connect())
+        report(sys.argv[2], histogram)
+    else:
+        sys.exit(USAGE)
+
+
+if __name__ == '__main__':
+    main()
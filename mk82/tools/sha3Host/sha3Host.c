@@ -0,0 +1,233 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+/*
+ * Host test of the Keccak implementation in the sha3 middleware, built unchanged for Linux. Checks Keccak-256/384/512
+ * known answers (the original Keccak padding that sha3.c is built with) and that absorbing a message in pieces gives
+ * the digest of absorbing it at once, for every length up to three blocks. Prints one line per failed check and exits
+ * with 1 if there was any, otherwise prints the throughput of Keccak-256 on the host.
+ *
+ * The expected digests come from an independent Keccak that matches hashlib's SHA3 when given the SHA3 padding.
+ *
+ * Built and run by keccakTest.py.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "sha3.h"
+
+#define SHA3_HOST_FOX "The quick brown fox jumps over the lazy dog"
+#define SHA3_HOST_LONG_LENGTH (200)
+#define SHA3_HOST_LONG_BYTE (0xA3)
+/* Three blocks of Keccak-256 and one byte more */
+#define SHA3_HOST_MAX_LENGTH (3 * 136 + 1)
+#define SHA3_HOST_MAX_PIECE (13)
+#define SHA3_HOST_BENCHMARK_LENGTH (1024 * 1024)
+#define SHA3_HOST_BENCHMARK_ROUNDS (16)
+
+typedef struct
+{
+    unsigned bits;
+    const char *message;
+    const char *digest;
+} SHA3_HOST_KAT;
+
+/* A NULL message stands for SHA3_HOST_LONG_LENGTH bytes of SHA3_HOST_LONG_BYTE, more than one block of every variant */
+static const SHA3_HOST_KAT sha3HostKats[] = {
+    {256, "",
+     "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470"},
+    {256, "abc",
+     "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45"},
+    {256, SHA3_HOST_FOX,
+     "4d741b6f1eb29cb2a9b9911c82f56fa8d73b04959d3d9d222895df6c0b28aa15"},
+    {256, NULL,
+     "3a57666b048777f2c953dc4456f45a2588e1cb6f2da760122d530ac2ce607d4a"},
+    {384, "",
+     "2c23146a63a29acf99e73b88f8c24eaa7dc60aa771780ccc006afbfa8fe2479b"
+     "2dd2b21362337441ac12b515911957ff"},
+    {384, "abc",
+     "f7df1165f033337be098e7d288ad6a2f74409d7a60b49c36642218de161b1f99"
+     "f8c681e4afaf31a34db29fb763e3c28e"},
+    {384, SHA3_HOST_FOX,
+     "283990fa9d5fb731d786c5bbee94ea4db4910f18c62c03d173fc0a5e494422e8"
+     "a0b3da7574dae7fa0baf005e504063b3"},
+    {384, NULL,
+     "94026c78412d4739a463ec02ef157216ba9001e18d870c3575d69f17c77b2164"
+     "6e8dbc4e6436d207cec1785159bb7897"},
+    {512, "",
+     "0eab42de4c3ceb9235fc91acffe746b29c29a8c366b7c60e4e67c466f36a4304"
+     "c00fa9caf9d87976ba469bcbe06713b435f091ef2769fb160cdab33d3670680e"},
+    {512, "abc",
+     "18587dc2ea106b9a1563e32b3312421ca164c7f1f07bc922a9c83d77cea3a1e5"
+     "d0c69910739025372dc14ac9642629379540c17e2a65b19d77aa511a9d00bb96"},
+    {512, SHA3_HOST_FOX,
+     "d135bb84d0439dbac432247ee573a23ea7d3c9deb2a968eb31d47c4fb45f1ef4"
+     "422d6c531b5b9bd6f449ebcc449ea94d0a8f05f62130fda612da53c79659f609"},
+    {512, NULL,
+     "f4f846d140847539f53c3f082cc4e6810e143a5b4fc62a20597b5d76043246b8"
+     "6bd7149b906140bb9665a6ce83d991f032f2291d2fae80eedfc6f845cc16d5ae"},
+};
+
+static uint32_t sha3HostFailures;
+
+static void sha3HostInit(sha3_context *context, unsigned bits)
+{
+    if (bits == 256)
+    {
+        sha3_Init256(context);
+    }
+    else if (bits == 384)
+    {
+        sha3_Init384(context);
+    }
+    else
+    {
+        sha3_Init512(context);
+    }
+}
+
+static void sha3HostCheckKats(void)
+{
+    uint8_t longMessage[SHA3_HOST_LONG_LENGTH];
+    uint32_t i;
+    uint32_t j;
+
+    memset(longMessage, SHA3_HOST_LONG_BYTE, sizeof(longMessage));
+
+    for (i = 0; i < sizeof(sha3HostKats) / sizeof(sha3HostKats[0]); i++)
+    {
+        const SHA3_HOST_KAT *kat = &sha3HostKats[i];
+        const uint8_t *digest;
+        sha3_context context;
+        char hex[129];
+
+        sha3HostInit(&context, kat->bits);
+
+        if (kat->message != NULL)
+        {
+            sha3_Update(&context, kat->message, strlen(kat->message));
+        }
+        else
+        {
+            sha3_Update(&context, longMessage, sizeof(longMessage));
+        }
+
+        digest = sha3_Finalize(&context);
+
+        for (j = 0; j < kat->bits / 8; j++)
+        {
+            sprintf(&hex[j * 2], "%02x", digest[j]);
+        }
+
+        if (strcmp(hex, kat->digest))
+        {
+            printf("FAIL Keccak-%u of %s\n", kat->bits, (kat->message != NULL) ? kat->message : "the long message");
+            sha3HostFailures++;
+        }
+    }
+}
+
+/*
+ * Absorbs every message up to SHA3_HOST_MAX_LENGTH bytes at once and in pieces of 1 to SHA3_HOST_MAX_PIECE bytes, so
+ * that every offset of a partial lane and of a block boundary is crossed.
+ */
+static void sha3HostCheckPieces(void)
+{
+    static const unsigned bits[] = {256, 384, 512};
+    uint8_t message[SHA3_HOST_MAX_LENGTH];
+    size_t length;
+    size_t offset;
+    size_t piece;
+    uint32_t i;
+
+    for (length = 0; length < sizeof(message); length++)
+    {
+        message[length] = (uint8_t)(length * 167 + 13);
+    }
+
+    for (i = 0; i < sizeof(bits) / sizeof(bits[0]); i++)
+    {
+        for (length = 0; length <= sizeof(message); length++)
+        {
+            uint8_t expected[64];
+            sha3_context context;
+
+            sha3HostInit(&context, bits[i]);
+            sha3_Update(&context, message, length);
+            memcpy(expected, sha3_Finalize(&context), bits[i] / 8);
+
+            sha3HostInit(&context, bits[i]);
+
+            for (offset = 0, piece = 1; offset < length; offset += piece, piece = (piece % SHA3_HOST_MAX_PIECE) + 1)
+            {
+                if (piece > (length - offset))
+                {
+                    piece = length - offset;
+                }
+
+                sha3_Update(&context, &message[offset], piece);
+            }
+
+            if (memcmp(expected, sha3_Finalize(&context), bits[i] / 8))
+            {
+                printf("FAIL Keccak-%u in pieces, %u bytes\n", bits[i], (unsigned)length);
+                sha3HostFailures++;
+            }
+        }
+    }
+}
+
+static void sha3HostBenchmark(void)
+{
+    static uint8_t message[SHA3_HOST_BENCHMARK_LENGTH];
+    struct timespec start;
+    struct timespec stop;
+    sha3_context context;
+    double seconds;
+    uint32_t i;
+
+    memset(message, SHA3_HOST_LONG_BYTE, sizeof(message));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0; i < SHA3_HOST_BENCHMARK_ROUNDS; i++)
+    {
+        sha3_Init256(&context);
+        sha3_Update(&context, message, sizeof(message));
+        sha3_Finalize(&context);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    seconds = (double)(stop.tv_sec - start.tv_sec) + ((double)(stop.tv_nsec - start.tv_nsec) / 1e9);
+    seconds /= SHA3_HOST_BENCHMARK_ROUNDS;
+
+    printf("Keccak-256 of 1 MB: %.1f ms on the host, %.2f ns/byte\n", seconds * 1e3, seconds * 1e9 / sizeof(message));
+}
+
+int main(void)
+{
+    sha3HostCheckKats();
+    sha3HostCheckPieces();
+
+    if (sha3HostFailures)
+    {
+        printf("%u failures\n", sha3HostFailures);
+        return 1;
+    }
+
+    printf("Keccak known answers and absorbing in pieces pass\n");
+
+    sha3HostBenchmark();
+
+    return 0;
+}
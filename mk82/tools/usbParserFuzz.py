@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+#
+# Secalot firmware.
+# Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+#
+# This Source Code Form is subject to the terms of the Mozilla Public
+# License, v. 2.0. If a copy of the MPL was not distributed with this
+# file, You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+# Fuzzes the parsers that see host data first: the CCID core, the BTC and
+# U2F HID layers and the APDU parser, and behind them the BTC applet with
+# its transaction parser. Each one is built for Linux from the firmware
+# sources with the HAL stubbed out in fuzzHost/, under ASan and UBSan.
+# Every input of fuzzHost/corpus/<target> is run first, then inputs mutated
+# from them. A crash leaves the input in fuzzHostCrash.bin in the working
+# directory. The seeds of btcTran are written by btcTranSeeds.py.
+#
+# Every input must also finish within the CCID WTX budget, scaled down by
+# HOST_SPEEDUP: the K82 runs at 150 MHz, the host at a few GHz with several
+# times the instructions per cycle, which ASan and UBSan give back in part.
+# The slowest input of every target is printed; it is an upper bound for
+# each APDU in it. Key derivation and signing are stubbed out in btcTran,
+# so its figure covers the parsers and hashing only.
+#
+# With --libfuzzer the target is built with clang -fsanitize=fuzzer instead
+# and libFuzzer is started on a copy of the corpus. For AFL, build the
+# standalone target the same way with afl-gcc and run it with @@.
+#
+# Usage:
+#   usbParserFuzz.py [runs] [target...]          default 100000 mutations, every target
+#   usbParserFuzz.py --libfuzzer <target> [libFuzzer options...]
+#
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from fsRecordStore import REPO_DIR, TOOLS_DIR, run
+
+FUZZ_DIR = os.path.join(TOOLS_DIR, 'fuzzHost')
+CORPUS_DIR = os.path.join(FUZZ_DIR, 'corpus')
+
+DEFAULT_RUNS = 100000
+
+CCID_WTX_TIMEOUT_IN_MS = 2000
+HOST_SPEEDUP = 40
+
+TARGETS = {
+    'ccid': ['ccid/src/core/ccidCore.c'],
+    'btcHid': ['btc/src/hid/btcHid.c'],
+    'sfHid': ['u2f/src/hid/sfHid.c'],
+    'apdu': ['apdu/src/core/apduCore.c'],
+    'btcTran': ['btc/src/core/btcCore.c', 'btc/src/tran/btcTran.c', 'btc/src/pin/btcPin.c',
+                'btc/src/base58/btcBase58.c', 'apdu/src/core/apduCore.c'],
+}
+
+# Third party sources a target links, built without warnings
+LIBRARIES = {
+    'btcTran': ['mk82/middleware/libbase58/base58.c', 'mk82/middleware/mbedtls_2.1.2/library/sha256.c'],
+}
+
+INCLUDE_DIRS = ['mk82/tools/fuzzHost', 'mk82/tools/fsHost/inc', 'platform/mk82/inc', 'ccid/inc', 'ccid/src/core',
+                'btc/inc', 'btc/src', 'u2f/inc', 'u2f/src', 'apdu/inc', 'apdu/src', 'mk82/middleware/libbase58',
+                'mk82/middleware/mbedtls_2.1.2/include']
+
+USAGE = 'usage: usbParserFuzz.py [runs] [target...] | --libfuzzer <target> [libFuzzer options...]'
+
+
+def build(work_dir, target, libfuzzer):
+    # The tree is edited on Windows and some includes differ from the file
+    # names in case only.
+    case_dir = os.path.join(work_dir, 'inc')
+    os.makedirs(case_dir, exist_ok=True)
+    if not os.path.exists(os.path.join(REPO_DIR, 'platform', 'mk82', 'inc', 'mk82Keysafe.h')):
+        with open(os.path.join(case_dir, 'mk82Keysafe.h'), 'w') as header:
+            header.write('#include "mk82KeySafe.h"\n')
+
+    binary = os.path.join(work_dir, target + 'Fuzz')
+    if libfuzzer:
+        command = ['clang', '-fsanitize=fuzzer,address,undefined', '-DFUZZ_HOST_LIBFUZZER']
+    else:
+        command = ['gcc', '-fsanitize=address,undefined']
+    # The APDU parser compares lengths against sums of bytes, which are int,
+    # and applet handlers share one signature whether they read the command
+    # or not.
+    command += ['-O1', '-g', '-Wall', '-Wextra', '-Wno-sign-compare', '-Wno-unused-parameter', '-std=gnu99',
+                '-fno-sanitize-recover=undefined',
+                '-DFIRMWARE', '-DMBEDTLS_CONFIG_FILE=<../port/ksdk/ksdk_mbedtls_config_bldr.h>', '-I' + case_dir]
+    command += ['-I' + os.path.join(REPO_DIR, path) for path in INCLUDE_DIRS]
+
+    objects = []
+    for path in LIBRARIES.get(target, []):
+        objects.append(os.path.join(work_dir, os.path.basename(path) + '.o'))
+        subprocess.run(command + ['-w', '-c', os.path.join(REPO_DIR, path), '-o', objects[-1]], check=True)
+
+    command += [os.path.join(FUZZ_DIR, 'fuzzHost.c'), os.path.join(FUZZ_DIR, target + 'Fuzz.c')]
+    command += [os.path.join(REPO_DIR, path) for path in TARGETS[target]]
+    command += objects + ['-o', binary]
+    subprocess.run(command, check=True)
+    return binary
+
+
+def libfuzzer(target, options):
+    work_dir = tempfile.mkdtemp()
+    try:
+        binary = build(work_dir, target, True)
+        corpus = os.path.join(work_dir, 'corpus')
+        shutil.copytree(os.path.join(CORPUS_DIR, target), corpus)
+        subprocess.run([binary, corpus] + options)
+    finally:
+        shutil.rmtree(work_dir)
+
+
+def main():
+    args = sys.argv[1:]
+
+    if args and args[0] == '--libfuzzer':
+        if len(args) < 2 or args[1] not in TARGETS:
+            sys.exit(USAGE)
+        libfuzzer(args[1], args[2:])
+        return
+
+    runs = DEFAULT_RUNS
+    if args and args[0].isdigit():
+        runs = int(args.pop(0))
+    targets = args or sorted(TARGETS)
+    if any(target not in TARGETS for target in targets):
+        sys.exit(USAGE)
+
+    work_dir = tempfile.mkdtemp()
+    try:
+        for target in targets:
+            binary = build(work_dir, target, False)
+            result = run(binary, '-runs', str(runs), '-budget', str(CCID_WTX_TIMEOUT_IN_MS / HOST_SPEEDUP),
+                         os.path.join(CORPUS_DIR, target))
+            print('%-8s %s' % (target, result.strip()))
+    finally:
+        shutil.rmtree(work_dir)
+
+
+if __name__ == '__main__':
+    main()
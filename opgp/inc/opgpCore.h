@@ -16,6 +16,7 @@ extern "C"
 #endif
 
     void opgpCoreInit(void);
+    void opgpCoreIdleTask(void);
     void opgpCoreProcessAPDU(uint8_t* apdu, uint32_t* apduLength);
     void opgpCoreSelect(uint16_t* sw);
     void opgpCoreGetAID(uint8_t* aid, uint32_t* aidLength);
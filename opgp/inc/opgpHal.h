@@ -24,6 +24,12 @@ extern "C"
 #define OPGP_GLOBAL_PUBLIC_EXPONENT_LENGTH (0x04)
 #define OPGP_GLOBAL_MODULUS_LENGTH (0x100)
 #define OPGP_GLOBAL_PRIME_LENGTH (0x80)
+#define OPGP_HAL_PUBLIC_EXPONENT (65537)
+
+#define OPGP_HAL_PRIME_POOL_SIZE (4)
+
+/* Extents per mk82FsMapFile call when reading the cardholder certificate */
+#define OPGP_HAL_CERTIFICATE_EXTENTS (8)
 
     OPGP_MAKE_PACKED(typedef struct)
     {
@@ -118,6 +124,33 @@ extern "C"
     }
     OPGP_HAL_NVM_DATA;
 
+    OPGP_MAKE_PACKED(typedef struct)
+    {
+        uint16_t primeAvailable; /* OPGP_FALSE16 */
+        uint8_t prime[OPGP_GLOBAL_PRIME_LENGTH];
+        uint8_t primeNonce[MK82_KEYSAFE_NONCE_LENGTH];
+        uint8_t primeTag[MK82_KEYSAFE_TAG_LENGTH];
+    }
+    OPGP_HAL_POOLED_PRIME;
+
+    OPGP_MAKE_PACKED(typedef struct)
+    {
+        OPGP_HAL_POOLED_PRIME primes[OPGP_HAL_PRIME_POOL_SIZE];
+    }
+    OPGP_HAL_NVM_PRIME_POOL;
+
+    typedef struct
+    {
+        uint32_t pooledPrimes;
+        uint32_t coldGenerations;
+        uint32_t coldLastTimeInMs;
+        uint32_t coldTotalTimeInMs;
+        uint32_t warmGenerations;
+        uint32_t warmLastTimeInMs;
+        uint32_t warmTotalTimeInMs;
+        uint32_t poolUnwrapFailures;
+    } OPGP_HAL_KEY_GENERATION_INFO;
+
     void opgpHalInit(void);
     void opgpHalDeinit(void);
 
@@ -150,6 +183,8 @@ extern "C"
     void opgpHalInternalAuthenticate(uint8_t* authenticationInput, uint32_t authenticationInputLength,
                                      uint8_t* signature);
     void opgpHalGenerateKeyPair(uint16_t keyType);
+    void opgpHalFillPrimePool(void);
+    void opgpHalGetKeyGenerationInfo(OPGP_HAL_KEY_GENERATION_INFO* info);
     void opgpHalGetPublicKey(uint16_t keyType, uint8_t* modulus, uint8_t* publicExponent);
     void opgpHalGetRandom(uint8_t* buffer, uint32_t length);
 
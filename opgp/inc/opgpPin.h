@@ -17,11 +17,28 @@ extern "C"
 
 #include "stdint.h"
 
+    typedef struct
+    {
+        uint16_t PW1_81_Verified;
+        uint16_t PW1_82_Verified;
+        uint16_t PW3Verified;
+
+    } OPGP_PIN_VOLATILE_PIN_STATUS;
+
     void opgpPinInit(void);
 
     void opgpPinResetVolatilePinStatus(void);
+    void opgpPinGetVolatilePinStatus(OPGP_PIN_VOLATILE_PIN_STATUS* pinStatus);
+    void opgpPinSetVolatilePinStatus(OPGP_PIN_VOLATILE_PIN_STATUS* pinStatus);
     void opgpPinResetPW1_81_Status(void);
 
+    /*
+     * A PIN that was verified elsewhere no longer counts once a PIN is changed, blocked or wiped out. The status
+     * loaded with opgpPinSetVolatilePinStatus is kept up to date, every other copy of it has to be reset.
+     */
+    void opgpPinInvalidatePinStatus(void);
+    uint16_t opgpPinIsPinStatusInvalidated(void);
+
     uint16_t opgpPinIsPW1_81_Verified(void);
     uint16_t opgpPinIsPW1_82_Verified(void);
     uint16_t opgpPinIsPW3Verified(void);
@@ -43,6 +43,8 @@ void opgpCoreInit(void)
     opgpHalInit();
 }
 
+void opgpCoreIdleTask(void) { opgpHalFillPrimePool(); }
+
 static void opgpCoreProcessGetData(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU)
 {
     uint16_t sw;
@@ -1134,6 +1136,8 @@ static void opgpCoreProcessTerminateDF(APDU_CORE_COMMAND_APDU* commandAPDU, APDU
 
     opgpHalSetCardState(OPGP_GLOBAL_CARD_STATE_INITIALIZATION);
 
+    opgpPinInvalidatePinStatus();
+
     sw = APDU_CORE_SW_NO_ERROR;
 
 END:
@@ -1172,6 +1176,7 @@ static void opgpCoreProcessActivateFile(APDU_CORE_COMMAND_APDU* commandAPDU, APD
     if (cardState == OPGP_GLOBAL_CARD_STATE_INITIALIZATION)
     {
         opgpHalWipeout();
+        opgpPinInvalidatePinStatus();
     }
     else
     {
@@ -32,9 +32,18 @@ static void opgpHalGetDoWithVariableLengthInfo(uint16_t tag, uint32_t* dataOffse
                                                uint32_t* maximalLength);
 static void opgpHalGetPinOffsets(uint8_t pinID, uint32_t* dataOffset, uint32_t* lengthOffset,
                                  uint32_t* errorCounterOffset);
+static void opgpHalAddPrimeToPool(mbedtls_mpi* prime);
+static uint16_t opgpHalTakePrimeFromPool(mbedtls_mpi* prime);
+static uint16_t opgpHalAssembleKeyFromPool(mbedtls_rsa_context* rsaKey);
+static void opgpHalReadCertificate(uint32_t offset, uint8_t* data, uint32_t length);
 
 static uint8_t opgpHalTempBuffer[OPGP_GLOBAL_MODULUS_LENGTH];
 
+static mbedtls_mpi opgpHalPrimeCandidate;
+static uint16_t opgpHalPrimeCandidateValid = OPGP_FALSE;
+static uint32_t opgpHalPooledPrimes = 0;
+static OPGP_HAL_KEY_GENERATION_INFO opgpHalKeyGenerationInfo;
+
 static void opgpHalGetRsaKeyFromFile(uint16_t keyType, mbedtls_rsa_context* rsaKey)
 {
     int calleeRetVal;
@@ -362,7 +371,248 @@ static void opgpHalGetPinOffsets(uint8_t pinID, uint32_t* dataOffset, uint32_t*
     }
 }
 
-void opgpHalInit(void) {}
+static void opgpHalAddPrimeToPool(mbedtls_mpi* prime)
+{
+    int calleeRetVal;
+    uint16_t primeAvailable;
+    uint32_t slotOffset;
+    uint8_t tag[MK82_KEYSAFE_TAG_LENGTH];
+    uint8_t nonce[MK82_KEYSAFE_NONCE_LENGTH];
+    uint32_t i;
+
+    for (i = 0; i < OPGP_HAL_PRIME_POOL_SIZE; i++)
+    {
+        slotOffset = offsetof(OPGP_HAL_NVM_PRIME_POOL, primes) + i * sizeof(OPGP_HAL_POOLED_PRIME);
+
+        mk82FsReadFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeAvailable),
+                       (uint8_t*)&primeAvailable, sizeof(uint16_t));
+
+        if (primeAvailable != OPGP_TRUE)
+        {
+            break;
+        }
+    }
+
+    if (i == OPGP_HAL_PRIME_POOL_SIZE)
+    {
+        opgpHalFatalError();
+    }
+
+    calleeRetVal = mbedtls_mpi_write_binary(prime, opgpHalTempBuffer, OPGP_GLOBAL_PRIME_LENGTH);
+    if (calleeRetVal != 0)
+    {
+        opgpHalFatalError();
+    }
+    mk82KeysafeWrapKey(MK82_KEYSAFE_OPGP_KEK_ID, opgpHalTempBuffer, OPGP_GLOBAL_PRIME_LENGTH, opgpHalTempBuffer, NULL,
+                       0, nonce, tag);
+    mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, prime),
+                    opgpHalTempBuffer, OPGP_GLOBAL_PRIME_LENGTH);
+    mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeNonce), nonce,
+                    MK82_KEYSAFE_NONCE_LENGTH);
+    mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeTag), tag,
+                    MK82_KEYSAFE_TAG_LENGTH);
+
+    primeAvailable = OPGP_TRUE;
+    mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeAvailable),
+                    (uint8_t*)&primeAvailable, sizeof(uint16_t));
+
+    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_PRIME_POOL);
+
+    opgpHalPooledPrimes++;
+
+    opgpHalWipeoutBuffer(opgpHalTempBuffer, sizeof(opgpHalTempBuffer));
+}
+
+/* The slot is released and its wrapped prime, nonce and tag are overwritten before the prime is handed out, so a
+ * prime is never used for more than one key even if the key is not stored afterwards. A slot that does not unwrap is
+ * released the same way and counted, opgpHalFillPrimePool refills it. Returns OPGP_FALSE if the pool is empty or the
+ * slot did not unwrap. */
+static uint16_t opgpHalTakePrimeFromPool(mbedtls_mpi* prime)
+{
+    uint16_t retVal = OPGP_FALSE;
+    int calleeRetVal;
+    uint16_t mk82CalleeRetVal;
+    uint16_t primeAvailable;
+    uint32_t slotOffset;
+    uint8_t tag[MK82_KEYSAFE_TAG_LENGTH];
+    uint8_t nonce[MK82_KEYSAFE_NONCE_LENGTH];
+    uint32_t i;
+
+    for (i = 0; i < OPGP_HAL_PRIME_POOL_SIZE; i++)
+    {
+        slotOffset = offsetof(OPGP_HAL_NVM_PRIME_POOL, primes) + i * sizeof(OPGP_HAL_POOLED_PRIME);
+
+        mk82FsReadFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeAvailable),
+                       (uint8_t*)&primeAvailable, sizeof(uint16_t));
+
+        if (primeAvailable == OPGP_TRUE)
+        {
+            break;
+        }
+    }
+
+    if (i == OPGP_HAL_PRIME_POOL_SIZE)
+    {
+        opgpHalPooledPrimes = 0;
+        goto END;
+    }
+
+    mk82FsReadFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, prime),
+                   opgpHalTempBuffer, OPGP_GLOBAL_PRIME_LENGTH);
+    mk82FsReadFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeNonce), nonce,
+                   MK82_KEYSAFE_NONCE_LENGTH);
+    mk82FsReadFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeTag), tag,
+                   MK82_KEYSAFE_TAG_LENGTH);
+
+    mk82CalleeRetVal = mk82KeysafeUnwrapKey(MK82_KEYSAFE_OPGP_KEK_ID, opgpHalTempBuffer, OPGP_GLOBAL_PRIME_LENGTH,
+                                            opgpHalTempBuffer, NULL, 0, nonce, tag);
+    if (mk82CalleeRetVal == MK82_TRUE)
+    {
+        calleeRetVal = mbedtls_mpi_read_binary(prime, opgpHalTempBuffer, OPGP_GLOBAL_PRIME_LENGTH);
+        if (calleeRetVal != 0)
+        {
+            opgpHalFatalError();
+        }
+    }
+
+    opgpHalWipeoutBuffer(opgpHalTempBuffer, sizeof(opgpHalTempBuffer));
+    opgpHalWipeoutBuffer(nonce, sizeof(nonce));
+    opgpHalWipeoutBuffer(tag, sizeof(tag));
+
+    mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, prime),
+                    opgpHalTempBuffer, OPGP_GLOBAL_PRIME_LENGTH);
+    mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeNonce), nonce,
+                    MK82_KEYSAFE_NONCE_LENGTH);
+    mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeTag), tag,
+                    MK82_KEYSAFE_TAG_LENGTH);
+
+    primeAvailable = OPGP_FALSE;
+    mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL, slotOffset + offsetof(OPGP_HAL_POOLED_PRIME, primeAvailable),
+                    (uint8_t*)&primeAvailable, sizeof(uint16_t));
+    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_PRIME_POOL);
+
+    if (opgpHalPooledPrimes > 0)
+    {
+        opgpHalPooledPrimes--;
+    }
+
+    if (mk82CalleeRetVal != MK82_TRUE)
+    {
+        opgpHalKeyGenerationInfo.poolUnwrapFailures++;
+        goto END;
+    }
+
+    retVal = OPGP_TRUE;
+
+END:
+    opgpHalWipeoutBuffer(opgpHalTempBuffer, sizeof(opgpHalTempBuffer));
+
+    return retVal;
+}
+
+/* Same construction as mbedtls_rsa_gen_key, but with P and Q taken from the pool. Returns OPGP_FALSE if the pool
+ * could not supply a usable pair, in which case the caller has to generate the key from scratch. */
+static uint16_t opgpHalAssembleKeyFromPool(mbedtls_rsa_context* rsaKey)
+{
+    uint16_t retVal = OPGP_FALSE;
+    int calleeRetVal;
+    mbedtls_mpi p1;
+    mbedtls_mpi q1;
+    mbedtls_mpi h;
+    mbedtls_mpi g;
+
+    if (opgpHalPooledPrimes < 2)
+    {
+        return OPGP_FALSE;
+    }
+
+    mbedtls_mpi_init(&p1);
+    mbedtls_mpi_init(&q1);
+    mbedtls_mpi_init(&h);
+    mbedtls_mpi_init(&g);
+
+    if (opgpHalTakePrimeFromPool(&rsaKey->P) != OPGP_TRUE)
+    {
+        goto END;
+    }
+
+    if (opgpHalTakePrimeFromPool(&rsaKey->Q) != OPGP_TRUE)
+    {
+        goto END;
+    }
+
+    if (mbedtls_mpi_cmp_mpi(&rsaKey->P, &rsaKey->Q) < 0)
+    {
+        mbedtls_mpi_swap(&rsaKey->P, &rsaKey->Q);
+    }
+
+    if (mbedtls_mpi_cmp_mpi(&rsaKey->P, &rsaKey->Q) == 0)
+    {
+        goto END;
+    }
+
+    calleeRetVal = 0x00;
+
+    calleeRetVal |= mbedtls_mpi_lset(&rsaKey->E, OPGP_HAL_PUBLIC_EXPONENT);
+    calleeRetVal |= mbedtls_mpi_mul_mpi(&rsaKey->N, &rsaKey->P, &rsaKey->Q);
+    calleeRetVal |= mbedtls_mpi_sub_int(&p1, &rsaKey->P, 1);
+    calleeRetVal |= mbedtls_mpi_sub_int(&q1, &rsaKey->Q, 1);
+    calleeRetVal |= mbedtls_mpi_mul_mpi(&h, &p1, &q1);
+    calleeRetVal |= mbedtls_mpi_gcd(&g, &rsaKey->E, &h);
+
+    if (calleeRetVal != 0)
+    {
+        opgpHalFatalError();
+    }
+
+    if ((mbedtls_mpi_bitlen(&rsaKey->N) != (OPGP_GLOBAL_MODULUS_LENGTH * 8)) || (mbedtls_mpi_cmp_int(&g, 1) != 0))
+    {
+        goto END;
+    }
+
+    calleeRetVal |= mbedtls_mpi_inv_mod(&rsaKey->D, &rsaKey->E, &h);
+    calleeRetVal |= mbedtls_mpi_mod_mpi(&rsaKey->DP, &rsaKey->D, &p1);
+    calleeRetVal |= mbedtls_mpi_mod_mpi(&rsaKey->DQ, &rsaKey->D, &q1);
+    calleeRetVal |= mbedtls_mpi_inv_mod(&rsaKey->QP, &rsaKey->Q, &rsaKey->P);
+
+    if (calleeRetVal != 0)
+    {
+        opgpHalFatalError();
+    }
+
+    rsaKey->len = OPGP_GLOBAL_MODULUS_LENGTH;
+
+    retVal = OPGP_TRUE;
+
+END:
+    mbedtls_mpi_free(&p1);
+    mbedtls_mpi_free(&q1);
+    mbedtls_mpi_free(&h);
+    mbedtls_mpi_free(&g);
+
+    return retVal;
+}
+
+void opgpHalInit(void)
+{
+    uint16_t primeAvailable;
+    uint32_t i;
+
+    opgpHalPooledPrimes = 0;
+
+    for (i = 0; i < OPGP_HAL_PRIME_POOL_SIZE; i++)
+    {
+        mk82FsReadFile(MK82_FS_FILE_ID_OPGP_PRIME_POOL,
+                       offsetof(OPGP_HAL_NVM_PRIME_POOL, primes) + i * sizeof(OPGP_HAL_POOLED_PRIME) +
+                           offsetof(OPGP_HAL_POOLED_PRIME, primeAvailable),
+                       (uint8_t*)&primeAvailable, sizeof(uint16_t));
+
+        if (primeAvailable == OPGP_TRUE)
+        {
+            opgpHalPooledPrimes++;
+        }
+    }
+}
 
 void opgpHalDeinit(void) {}
 
@@ -483,12 +733,11 @@ void opgpHalSetPW1HashAndLengthAndUnblock(uint8_t* pinHash, uint32_t pinLength)
     dataOffset = offsetof(OPGP_HAL_NVM_DATA, pw1);
     counterValueOffset = offsetof(OPGP_HAL_NVM_COUNTERS, pw1ErrorCounter);
 
+    mk82FsBeginTransaction();
     mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_DATA, lengthOffset, (uint8_t*)&pinLength, sizeof(uint8_t));
     mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_DATA, dataOffset, pinHash, OPGP_GLOBAL_PIN_HASH_LENGTH);
-    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_DATA);
-
     mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_COUNTERS, counterValueOffset, (uint8_t*)&counterValue, sizeof(uint8_t));
-    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_COUNTERS);
+    mk82FsCommitTransaction();
 }
 
 void opgpHalSetRCHashAndLengthAndSetErrorCounter(uint8_t* pinHash, uint32_t pinLength, uint8_t errorCounter)
@@ -506,12 +755,11 @@ void opgpHalSetRCHashAndLengthAndSetErrorCounter(uint8_t* pinHash, uint32_t pinL
     dataOffset = offsetof(OPGP_HAL_NVM_DATA, rc);
     counterValueOffset = offsetof(OPGP_HAL_NVM_COUNTERS, rcErrorCounter);
 
+    mk82FsBeginTransaction();
     mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_DATA, lengthOffset, (uint8_t*)&pinLength, sizeof(uint8_t));
     mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_DATA, dataOffset, pinHash, OPGP_GLOBAL_PIN_HASH_LENGTH);
-    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_DATA);
-
     mk82FsWriteFile(MK82_FS_FILE_ID_OPGP_COUNTERS, counterValueOffset, (uint8_t*)&errorCounter, sizeof(uint8_t));
-    mk82FsCommitWrite(MK82_FS_FILE_ID_OPGP_COUNTERS);
+    mk82FsCommitTransaction();
 }
 
 void opgpHalCalculatePinHash(uint8_t* pinValue, uint32_t pinLength, uint8_t* pinHash)
@@ -539,6 +787,30 @@ void opgpHalGetDataObject(uint16_t tag, uint8_t* data)
     mk82FsReadFile(MK82_FS_FILE_ID_OPGP_DATA, offset, data, length);
 }
 
+/* Copied out of the mapped file in one pass rather than through a UFFS page buffer */
+static void opgpHalReadCertificate(uint32_t offset, uint8_t* data, uint32_t length)
+{
+    MK82_FS_EXTENT extents[OPGP_HAL_CERTIFICATE_EXTENTS];
+    uint32_t numberOfExtents;
+    uint32_t mappedLength;
+    uint32_t i;
+
+    while (length > 0)
+    {
+        mappedLength = mk82FsMapFile(MK82_FS_FILE_ID_OPGP_CERTIFICATES, offset, length, extents,
+                                     OPGP_HAL_CERTIFICATE_EXTENTS, &numberOfExtents);
+
+        for (i = 0; i < numberOfExtents; i++)
+        {
+            mk82SystemMemCpy(data, (uint8_t*)extents[i].data, extents[i].length);
+            data += extents[i].length;
+        }
+
+        offset += mappedLength;
+        length -= mappedLength;
+    }
+}
+
 void opgpHalGetDataObjectWithLength(uint16_t tag, uint8_t* data, uint32_t* length)
 {
     uint32_t dataOffset;
@@ -555,7 +827,7 @@ void opgpHalGetDataObjectWithLength(uint16_t tag, uint8_t* data, uint32_t* lengt
         lengthOffset = offsetof(OPGP_HAL_NVM_CERTIFICATES, doCertificateLength);
 
         mk82FsReadFile(MK82_FS_FILE_ID_OPGP_CERTIFICATES, lengthOffset, (uint8_t*)length, sizeof(uint32_t));
-        mk82FsReadFile(MK82_FS_FILE_ID_OPGP_CERTIFICATES, dataOffset, data, *length);
+        opgpHalReadCertificate(dataOffset, data, *length);
     }
     else
     {
@@ -1007,16 +1279,31 @@ void opgpHalGenerateKeyPair(uint16_t keyType)
     uint16_t trueFalse;
     uint8_t tag[MK82_KEYSAFE_TAG_LENGTH];
     uint8_t nonce[MK82_KEYSAFE_NONCE_LENGTH];
+    uint16_t keyFromPool;
+    uint64_t startTime;
+    uint64_t endTime;
+    uint32_t elapsedTime;
 
     opgpHalGetKeyInfo(keyType, &keyOffset);
 
+    mk82SystemTickerGetMsPassed(&startTime);
+
     mbedtls_rsa_init(&generatedKey, MBEDTLS_RSA_PKCS_V15, MBEDTLS_MD_NONE);
 
-    calleeRetVal = mbedtls_rsa_gen_key(&generatedKey, mk82SystemGetRandomForTLS, NULL, 2048, 65537);
+    keyFromPool = opgpHalAssembleKeyFromPool(&generatedKey);
 
-    if (calleeRetVal != 0)
+    if (keyFromPool != OPGP_TRUE)
     {
-        opgpHalFatalError();
+        mbedtls_rsa_free(&generatedKey);
+        mbedtls_rsa_init(&generatedKey, MBEDTLS_RSA_PKCS_V15, MBEDTLS_MD_NONE);
+
+        calleeRetVal = mbedtls_rsa_gen_key(&generatedKey, mk82SystemGetRandomForTLS, NULL,
+                                           OPGP_GLOBAL_MODULUS_LENGTH * 8, OPGP_HAL_PUBLIC_EXPONENT);
+
+        if (calleeRetVal != 0)
+        {
+            opgpHalFatalError();
+        }
     }
 
     calleeRetVal = mbedtls_mpi_write_binary(&generatedKey.N, opgpHalTempBuffer, OPGP_GLOBAL_MODULUS_LENGTH);
@@ -1110,6 +1397,107 @@ void opgpHalGenerateKeyPair(uint16_t keyType)
 
     mbedtls_rsa_free(&generatedKey);
     opgpHalWipeoutBuffer(opgpHalTempBuffer, sizeof(opgpHalTempBuffer));
+
+    mk82SystemTickerGetMsPassed(&endTime);
+
+    elapsedTime = (uint32_t)(endTime - startTime);
+
+    if (keyFromPool == OPGP_TRUE)
+    {
+        opgpHalKeyGenerationInfo.warmGenerations++;
+        opgpHalKeyGenerationInfo.warmLastTimeInMs = elapsedTime;
+        opgpHalKeyGenerationInfo.warmTotalTimeInMs += elapsedTime;
+    }
+    else
+    {
+        opgpHalKeyGenerationInfo.coldGenerations++;
+        opgpHalKeyGenerationInfo.coldLastTimeInMs = elapsedTime;
+        opgpHalKeyGenerationInfo.coldTotalTimeInMs += elapsedTime;
+    }
+}
+
+/* Tests a single candidate per call so that it can run between USB commands without delaying them noticeably. */
+void opgpHalFillPrimePool(void)
+{
+    int calleeRetVal;
+    mbedtls_mpi_uint remainder;
+
+    if (opgpHalPooledPrimes >= OPGP_HAL_PRIME_POOL_SIZE)
+    {
+        return;
+    }
+
+    if (opgpHalPrimeCandidateValid != OPGP_TRUE)
+    {
+        mbedtls_mpi_init(&opgpHalPrimeCandidate);
+
+        calleeRetVal = 0x00;
+
+        calleeRetVal |= mbedtls_mpi_fill_random(&opgpHalPrimeCandidate, OPGP_GLOBAL_PRIME_LENGTH,
+                                                mk82SystemGetRandomForTLS, NULL);
+        /* With the two top bits set the product of any two pooled primes is exactly 2048 bits long. */
+        calleeRetVal |= mbedtls_mpi_set_bit(&opgpHalPrimeCandidate, OPGP_GLOBAL_PRIME_LENGTH * 8 - 1, 1);
+        calleeRetVal |= mbedtls_mpi_set_bit(&opgpHalPrimeCandidate, OPGP_GLOBAL_PRIME_LENGTH * 8 - 2, 1);
+        calleeRetVal |= mbedtls_mpi_set_bit(&opgpHalPrimeCandidate, 0, 1);
+
+        if (calleeRetVal != 0)
+        {
+            opgpHalFatalError();
+        }
+
+        opgpHalPrimeCandidateValid = OPGP_TRUE;
+    }
+
+    if (mbedtls_mpi_bitlen(&opgpHalPrimeCandidate) > (OPGP_GLOBAL_PRIME_LENGTH * 8))
+    {
+        goto DISCARD;
+    }
+
+    /* The public exponent is prime, so it is coprime with P - 1 unless P mod E == 1. */
+    calleeRetVal = mbedtls_mpi_mod_int(&remainder, &opgpHalPrimeCandidate, OPGP_HAL_PUBLIC_EXPONENT);
+    if (calleeRetVal != 0)
+    {
+        opgpHalFatalError();
+    }
+
+    if (remainder != 1)
+    {
+        calleeRetVal = mbedtls_mpi_is_prime(&opgpHalPrimeCandidate, mk82SystemGetRandomForTLS, NULL);
+
+        if (calleeRetVal == 0)
+        {
+            opgpHalAddPrimeToPool(&opgpHalPrimeCandidate);
+            goto DISCARD;
+        }
+        else if (calleeRetVal != MBEDTLS_ERR_MPI_NOT_ACCEPTABLE)
+        {
+            opgpHalFatalError();
+        }
+    }
+
+    calleeRetVal = mbedtls_mpi_add_int(&opgpHalPrimeCandidate, &opgpHalPrimeCandidate, 2);
+    if (calleeRetVal != 0)
+    {
+        opgpHalFatalError();
+    }
+
+    return;
+
+DISCARD:
+    mbedtls_mpi_free(&opgpHalPrimeCandidate);
+    opgpHalPrimeCandidateValid = OPGP_FALSE;
+}
+
+void opgpHalGetKeyGenerationInfo(OPGP_HAL_KEY_GENERATION_INFO* info)
+{
+    if (info == NULL)
+    {
+        opgpHalFatalError();
+    }
+
+    opgpHalMemCpy((uint8_t*)info, (uint8_t*)&opgpHalKeyGenerationInfo, sizeof(OPGP_HAL_KEY_GENERATION_INFO));
+
+    info->pooledPrimes = opgpHalPooledPrimes;
 }
 
 void opgpHalGetPublicKey(uint16_t keyType, uint8_t* modulus, uint8_t* publicExponent)
@@ -16,10 +16,16 @@
 #include "opgpPin.h"
 
 OPGP_PIN_VOLATILE_PIN_STATUS opgpCoreVolatilePinStatus;
+/* Set when a PIN was changed, blocked or wiped out since the PIN status was last loaded */
+static uint16_t opgpPinStatusInvalidated;
 
 static void opgpPinSetPinStatus(uint8_t pinID, uint16_t pinStatus);
 
-void opgpPinInit(void) { opgpPinResetVolatilePinStatus(); }
+void opgpPinInit(void)
+{
+    opgpPinResetVolatilePinStatus();
+    opgpPinStatusInvalidated = OPGP_FALSE;
+}
 
 void opgpPinResetVolatilePinStatus(void)
 {
@@ -28,6 +34,35 @@ void opgpPinResetVolatilePinStatus(void)
     opgpCoreVolatilePinStatus.PW3Verified = OPGP_FALSE;
 }
 
+void opgpPinGetVolatilePinStatus(OPGP_PIN_VOLATILE_PIN_STATUS* pinStatus)
+{
+    if (pinStatus == NULL)
+    {
+        opgpHalFatalError();
+    }
+
+    *pinStatus = opgpCoreVolatilePinStatus;
+}
+
+void opgpPinSetVolatilePinStatus(OPGP_PIN_VOLATILE_PIN_STATUS* pinStatus)
+{
+    if (pinStatus == NULL)
+    {
+        opgpHalFatalError();
+    }
+
+    opgpCoreVolatilePinStatus = *pinStatus;
+    opgpPinStatusInvalidated = OPGP_FALSE;
+}
+
+void opgpPinInvalidatePinStatus(void)
+{
+    opgpPinResetVolatilePinStatus();
+    opgpPinStatusInvalidated = OPGP_TRUE;
+}
+
+uint16_t opgpPinIsPinStatusInvalidated(void) { return opgpPinStatusInvalidated; }
+
 void opgpPinResetPW1_81_Status(void) { opgpCoreVolatilePinStatus.PW1_81_Verified = OPGP_FALSE; }
 
 uint16_t opgpPinIsPW1_81_Verified() { return opgpCoreVolatilePinStatus.PW1_81_Verified; }
@@ -109,6 +144,11 @@ uint16_t opgpPinVerifyPin(uint8_t pinID, uint8_t* input, uint32_t inputLength)
         if (pinID != OPGP_GLOBAL_PIN_ID_RC)
         {
             opgpPinSetPinStatus(pinID, OPGP_FALSE);
+
+            if (errorCounter == OPGP_GLOBAL_PIN_BLOCKED_ERROR_COUNTER_VALUE)
+            {
+                opgpPinStatusInvalidated = OPGP_TRUE;
+            }
         }
 
         retVal = OPGP_INVALID_PIN_ERROR;
@@ -199,6 +239,8 @@ uint16_t opgpPinChangePin(uint8_t pinID, uint8_t* input, uint32_t inputLength)
 
     opgpHalSetPinHashAndLength(pinID, newPinHash, newPinLength);
 
+    opgpPinStatusInvalidated = OPGP_TRUE;
+
     retVal = OPGP_NO_ERROR;
 
 END:
@@ -257,6 +299,8 @@ uint16_t opgpPinUnblockPW1WithRC(uint8_t* input, uint32_t inputLength)
 
     opgpHalSetPW1HashAndLengthAndUnblock(newPinHash, newPinLength);
 
+    opgpPinStatusInvalidated = OPGP_TRUE;
+
     retVal = OPGP_NO_ERROR;
 
 END:
@@ -295,6 +339,8 @@ uint16_t opgpPinUnblockPW1(uint8_t* input, uint32_t inputLength)
 
     opgpHalSetPW1HashAndLengthAndUnblock(newPinHash, inputLength);
 
+    opgpPinStatusInvalidated = OPGP_TRUE;
+
     retVal = OPGP_NO_ERROR;
 
 END:
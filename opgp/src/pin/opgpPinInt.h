@@ -17,14 +17,6 @@ extern "C"
 
 #include "stdint.h"
 
-    typedef struct
-    {
-        uint16_t PW1_81_Verified;
-        uint16_t PW1_82_Verified;
-        uint16_t PW3Verified;
-
-    } OPGP_PIN_VOLATILE_PIN_STATUS;
-
 #ifdef __cplusplus
 }
 #endif
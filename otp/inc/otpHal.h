@@ -18,6 +18,8 @@ extern "C"
 {
 #endif
 
+#define OTP_HAL_MIDSTATES_LENGTH (40)
+
     OTP_MAKE_PACKED(typedef struct) { uint64_t counter; }
     OTP_HAL_NVM_COUNTERS;
 
@@ -38,6 +40,23 @@ extern "C"
     }
     OTP_HAL_NVM_KEYS;
 
+    OTP_MAKE_PACKED(typedef struct)
+    {
+        uint16_t midstatesInitialized; /* OTP_FALSE16 */
+        uint8_t midstates[OTP_HAL_MIDSTATES_LENGTH];
+        uint8_t midstatesNonce[MK82_KEYSAFE_NONCE_LENGTH];
+        uint8_t midstatesTag[MK82_KEYSAFE_TAG_LENGTH];
+    }
+    OTP_HAL_NVM_KEY_MIDSTATES;
+
+    OTP_MAKE_PACKED(typedef struct)
+    {
+        uint16_t driftCalibrated; /* OTP_FALSE16 */
+        int32_t driftInPpm;
+        uint32_t lastSyncedTime;
+    }
+    OTP_HAL_NVM_TIME;
+
     void otpHalInit(void);
     void otpHalDeinit(void);
 
@@ -49,11 +68,10 @@ extern "C"
     void otpHalSetOptions(uint8_t numberOfDigits);
     void otpHalGetOptions(uint8_t* numberOfDigits);
     void otpHalIsKeyInitialized(uint16_t* result);
-    void otpHalGetKey(uint8_t* key, uint32_t* keyLength);
     void otpHalGetType(uint16_t* type);
     void otpHalGetCounter(uint64_t* counter);
     void otpHalSetCounter(uint64_t counter);
-    void otpHalComputeHmac(uint8_t* key, uint32_t keyLength, uint8_t* counter, uint8_t* hmac);
+    void otpHalComputeHmac(uint8_t* counter, uint8_t* hmac);
     void otpHalSetExternalTime(uint32_t externalTime);
     uint16_t otpHalGetCurrentTime(uint32_t* time);
 
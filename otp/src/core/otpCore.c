@@ -282,8 +282,6 @@ uint16_t otpCoreComputeOtp(uint8_t* otp, uint32_t* otpLength)
 {
     uint16_t retVal = OTP_GENERAL_ERROR;
     uint16_t keyInitialized = OTP_FALSE;
-    uint8_t key[OTP_GLOBAL_MAX_KEYLENGTH];
-    uint32_t keyLength;
     uint8_t numberOfDigits;
     uint16_t type;
     uint64_t counter;
@@ -309,8 +307,6 @@ uint16_t otpCoreComputeOtp(uint8_t* otp, uint32_t* otpLength)
         goto END;
     }
 
-    otpHalGetKey(key, &keyLength);
-
     otpHalGetOptions(&numberOfDigits);
 
     otpHalGetType(&type);
@@ -351,7 +347,7 @@ uint16_t otpCoreComputeOtp(uint8_t* otp, uint32_t* otpLength)
         counter >>= 8;
     }
 
-    otpHalComputeHmac(key, keyLength, counterAsAByteArray, hmac);
+    otpHalComputeHmac(counterAsAByteArray, hmac);
 
     offset = hmac[OTP_GLOBAL_HAMC_LENGTH - 1] & 0x0F;
 
@@ -367,6 +363,5 @@ uint16_t otpCoreComputeOtp(uint8_t* otp, uint32_t* otpLength)
     retVal = OTP_NO_ERROR;
 
 END:
-    otpHalMemSet(key, 0x00, sizeof(key));
     return retVal;
 }
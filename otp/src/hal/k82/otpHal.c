@@ -17,13 +17,296 @@
 #include "mk82KeySafe.h"
 #include "mk82Fs.h"
 
-#include "mbedtls/md.h"
+#include "fsl_mmcau.h"
 
 static uint16_t otpHalReferenceTimeSet;
-static uint32_t otpHalExternalReferenceTimeInSec;
-static uint64_t otpHalInternalReferenceTimeInMs;
+static int32_t otpHalDriftInPpm;
+/* Kept out of .bss so that a synced time survives warm resets. */
+static OTP_HAL_TIME_BASE otpHalTimeBase MK82_PLACE_IN_SECTION(".noinit");
+
+static uint32_t otpHalComputeTimeBaseCheck(void);
+static void otpHalCalibrateDrift(uint32_t externalTime, uint64_t internalTimeInMs);
+static void otpHalComputeMidstates(uint8_t* key, uint32_t keyLength, uint32_t* midstates);
+static void otpHalStoreMidstates(uint32_t* midstates);
+static void otpHalClearRawKey(void);
+static void otpHalGetRawKey(uint8_t* key, uint32_t* keyLength);
+static void otpHalGetMidstates(uint32_t* midstates);
+static void otpHalSha1FinishBlock(uint32_t* state, uint8_t* message, uint32_t messageLength);
+static void otpHalSha1StateToDigest(uint32_t* state, uint8_t* digest);
+
+static uint32_t otpHalComputeTimeBaseCheck(void)
+{
+    return otpHalTimeBase.externalReferenceTimeInSec ^ (uint32_t)otpHalTimeBase.internalReferenceTimeInMs ^
+           (uint32_t)(otpHalTimeBase.internalReferenceTimeInMs >> 32) ^ otpHalTimeBase.externalCalibrationTimeInSec ^
+           (uint32_t)otpHalTimeBase.internalCalibrationTimeInMs ^
+           (uint32_t)(otpHalTimeBase.internalCalibrationTimeInMs >> 32) ^ otpHalTimeBase.sessionID ^
+           OTP_HAL_TIME_BASE_CHECK_MAGIC;
+}
+
+static void otpHalCalibrateDrift(uint32_t externalTime, uint64_t internalTimeInMs)
+{
+    OTP_HAL_NVM_TIME nvmTime;
+    int64_t externalMsPassed;
+    int64_t internalMsPassed;
+    int32_t driftInPpm;
+
+    if (externalTime < otpHalTimeBase.externalCalibrationTimeInSec)
+    {
+        goto RESTART;
+    }
+
+    if ((externalTime - otpHalTimeBase.externalCalibrationTimeInSec) < OTP_HAL_MIN_CALIBRATION_INTERVAL_IN_SEC)
+    {
+        return;
+    }
+
+    externalMsPassed = (int64_t)(externalTime - otpHalTimeBase.externalCalibrationTimeInSec) * 1000;
+    internalMsPassed = internalTimeInMs - otpHalTimeBase.internalCalibrationTimeInMs;
+
+    if (internalMsPassed <= 0)
+    {
+        goto RESTART;
+    }
+
+    driftInPpm = ((externalMsPassed - internalMsPassed) * 1000000) / internalMsPassed;
+
+    if ((driftInPpm > OTP_HAL_MAX_DRIFT_IN_PPM) || (driftInPpm < -OTP_HAL_MAX_DRIFT_IN_PPM))
+    {
+        /* The host clock has most likely been adjusted in between */
+        goto RESTART;
+    }
+
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_TIME, 0, (uint8_t*)&nvmTime, sizeof(nvmTime));
+
+    if ((nvmTime.driftCalibrated != OTP_TRUE) ||
+        ((driftInPpm - nvmTime.driftInPpm) >= OTP_HAL_DRIFT_PERSIST_THRESHOLD_IN_PPM) ||
+        ((nvmTime.driftInPpm - driftInPpm) >= OTP_HAL_DRIFT_PERSIST_THRESHOLD_IN_PPM))
+    {
+        nvmTime.driftCalibrated = OTP_TRUE;
+        nvmTime.driftInPpm = driftInPpm;
+        nvmTime.lastSyncedTime = externalTime;
+
+        mk82FsWriteFile(MK82_FS_FILE_ID_OTP_TIME, 0, (uint8_t*)&nvmTime, sizeof(nvmTime));
+        mk82FsCommitWrite(MK82_FS_FILE_ID_OTP_TIME);
+    }
+
+    otpHalDriftInPpm = driftInPpm;
+
+RESTART:
+    otpHalTimeBase.externalCalibrationTimeInSec = externalTime;
+    otpHalTimeBase.internalCalibrationTimeInMs = internalTimeInMs;
+}
+
+/*
+ * The key is only needed as the SHA-1 states after the ipad and opad blocks, so these are stored instead of the
+ * key itself. The first half of the midstates is the inner state, the second half is the outer one.
+ */
+static void otpHalComputeMidstates(uint8_t* key, uint32_t keyLength, uint32_t* midstates)
+{
+    uint8_t block[OTP_HAL_SHA1_BLOCK_SIZE];
+    uint32_t i;
+
+    mk82SystemMemSet(block, 0x00, sizeof(block));
+    mk82SystemMemCpy(block, key, keyLength);
+
+    for (i = 0; i < sizeof(block); i++)
+    {
+        block[i] ^= OTP_HAL_HMAC_IPAD;
+    }
+
+    MMCAU_SHA1_InitializeOutput(&midstates[0]);
+    MMCAU_SHA1_HashN(block, 1, &midstates[0]);
+
+    for (i = 0; i < sizeof(block); i++)
+    {
+        block[i] ^= (OTP_HAL_HMAC_IPAD ^ OTP_HAL_HMAC_OPAD);
+    }
+
+    MMCAU_SHA1_InitializeOutput(&midstates[OTP_HAL_SHA1_STATE_WORDS]);
+    MMCAU_SHA1_HashN(block, 1, &midstates[OTP_HAL_SHA1_STATE_WORDS]);
+
+    mk82SystemMemSet(block, 0x00, sizeof(block));
+}
+
+static void otpHalStoreMidstates(uint32_t* midstates)
+{
+    uint8_t encryptedMidstates[OTP_HAL_MIDSTATES_LENGTH];
+    uint8_t nonce[MK82_KEYSAFE_NONCE_LENGTH];
+    uint8_t tag[MK82_KEYSAFE_TAG_LENGTH];
+    uint16_t trueFalse;
+
+    mk82KeysafeWrapKey(MK82_KEYSAFE_OTP_KEK_ID, (uint8_t*)midstates, OTP_HAL_MIDSTATES_LENGTH, encryptedMidstates,
+                       NULL, 0, nonce, tag);
+
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstates),
+                    encryptedMidstates, sizeof(encryptedMidstates));
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstatesNonce), nonce,
+                    sizeof(nonce));
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstatesTag), tag,
+                    sizeof(tag));
+    trueFalse = OTP_TRUE;
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstatesInitialized),
+                    (uint8_t*)&trueFalse, sizeof(trueFalse));
+
+    mk82FsCommitWrite(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES);
+}
+
+static void otpHalClearRawKey(void)
+{
+    uint8_t zeroes[OTP_GLOBAL_MAX_KEYLENGTH];
 
-void otpHalInit(void) { otpHalReferenceTimeSet = OTP_FALSE; }
+    mk82SystemMemSet(zeroes, 0x00, sizeof(zeroes));
+
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, key), zeroes, OTP_GLOBAL_MAX_KEYLENGTH);
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyNonce), zeroes,
+                    MK82_KEYSAFE_NONCE_LENGTH);
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyTag), zeroes, MK82_KEYSAFE_TAG_LENGTH);
+}
+
+/* Only used for keys that were set before the midstates were stored. */
+static void otpHalGetRawKey(uint8_t* key, uint32_t* keyLength)
+{
+    uint8_t encryptedKey[OTP_GLOBAL_MAX_KEYLENGTH];
+    uint8_t decryptedKey[OTP_GLOBAL_MAX_KEYLENGTH];
+    uint8_t nonce[MK82_KEYSAFE_NONCE_LENGTH];
+    uint8_t tag[MK82_KEYSAFE_TAG_LENGTH];
+    uint16_t calleeRetVal;
+
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, key), encryptedKey, sizeof(encryptedKey));
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyNonce), nonce, sizeof(nonce));
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyTag), tag, sizeof(tag));
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyLength), (uint8_t*)keyLength,
+                   sizeof(uint32_t));
+
+    calleeRetVal = mk82KeysafeUnwrapKey(MK82_KEYSAFE_OTP_KEK_ID, encryptedKey, sizeof(encryptedKey), decryptedKey, NULL,
+                                        0, nonce, tag);
+
+    if (calleeRetVal != MK82_NO_ERROR)
+    {
+        otpHalFatalError();
+    }
+
+    if ((*keyLength < OTP_GLOBAL_MIN_KEYLENGTH) || (*keyLength > OTP_GLOBAL_MAX_KEYLENGTH))
+    {
+        otpHalFatalError();
+    }
+
+    mk82SystemMemCpy(key, decryptedKey, *keyLength);
+
+    mk82SystemMemSet(decryptedKey, 0x00, sizeof(decryptedKey));
+}
+
+static void otpHalGetMidstates(uint32_t* midstates)
+{
+    uint8_t encryptedMidstates[OTP_HAL_MIDSTATES_LENGTH];
+    uint8_t nonce[MK82_KEYSAFE_NONCE_LENGTH];
+    uint8_t tag[MK82_KEYSAFE_TAG_LENGTH];
+    uint8_t key[OTP_GLOBAL_MAX_KEYLENGTH];
+    uint32_t keyLength;
+    uint16_t midstatesInitialized = OTP_FALSE;
+    uint16_t calleeRetVal;
+
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstatesInitialized),
+                   (uint8_t*)&midstatesInitialized, sizeof(midstatesInitialized));
+
+    if (midstatesInitialized != OTP_TRUE)
+    {
+        /* The key was set by an older firmware. Convert it once and drop the raw copy. */
+        otpHalGetRawKey(key, &keyLength);
+        otpHalComputeMidstates(key, keyLength, midstates);
+        mk82SystemMemSet(key, 0x00, sizeof(key));
+
+        otpHalStoreMidstates(midstates);
+
+        otpHalClearRawKey();
+        mk82FsCommitWrite(MK82_FS_FILE_ID_OTP_KEYS);
+
+        return;
+    }
+
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstates),
+                   encryptedMidstates, sizeof(encryptedMidstates));
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstatesNonce), nonce,
+                   sizeof(nonce));
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstatesTag), tag,
+                   sizeof(tag));
+
+    calleeRetVal = mk82KeysafeUnwrapKey(MK82_KEYSAFE_OTP_KEK_ID, encryptedMidstates, sizeof(encryptedMidstates),
+                                        (uint8_t*)midstates, NULL, 0, nonce, tag);
+
+    if (calleeRetVal != MK82_NO_ERROR)
+    {
+        otpHalFatalError();
+    }
+}
+
+/* Pads a message that fits into a single block after the 64 byte key block and runs the last compression. */
+static void otpHalSha1FinishBlock(uint32_t* state, uint8_t* message, uint32_t messageLength)
+{
+    uint8_t block[OTP_HAL_SHA1_BLOCK_SIZE];
+    uint32_t bitLength;
+
+    if (messageLength >= OTP_HAL_SHA1_LENGTH_FIELD_OFFSET)
+    {
+        otpHalFatalError();
+    }
+
+    bitLength = (OTP_HAL_SHA1_BLOCK_SIZE + messageLength) * 8;
+
+    mk82SystemMemSet(block, 0x00, sizeof(block));
+    mk82SystemMemCpy(block, message, messageLength);
+
+    block[messageLength] = 0x80;
+    block[OTP_HAL_SHA1_BLOCK_SIZE - 4] = (uint8_t)(bitLength >> 24);
+    block[OTP_HAL_SHA1_BLOCK_SIZE - 3] = (uint8_t)(bitLength >> 16);
+    block[OTP_HAL_SHA1_BLOCK_SIZE - 2] = (uint8_t)(bitLength >> 8);
+    block[OTP_HAL_SHA1_BLOCK_SIZE - 1] = (uint8_t)bitLength;
+
+    MMCAU_SHA1_HashN(block, 1, state);
+
+    mk82SystemMemSet(block, 0x00, sizeof(block));
+}
+
+static void otpHalSha1StateToDigest(uint32_t* state, uint8_t* digest)
+{
+    uint32_t i;
+
+    for (i = 0; i < OTP_HAL_SHA1_STATE_WORDS; i++)
+    {
+        digest[4 * i] = (uint8_t)(state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)state[i];
+    }
+}
+
+void otpHalInit(void)
+{
+    OTP_HAL_NVM_TIME nvmTime;
+    uint64_t currentInternalTimeInMs;
+    uint32_t sessionID;
+
+    otpHalReferenceTimeSet = OTP_FALSE;
+    otpHalDriftInPpm = 0;
+
+    mk82FsReadFile(MK82_FS_FILE_ID_OTP_TIME, 0, (uint8_t*)&nvmTime, sizeof(nvmTime));
+
+    if ((nvmTime.driftCalibrated == OTP_TRUE) && (nvmTime.driftInPpm <= OTP_HAL_MAX_DRIFT_IN_PPM) &&
+        (nvmTime.driftInPpm >= -OTP_HAL_MAX_DRIFT_IN_PPM))
+    {
+        otpHalDriftInPpm = nvmTime.driftInPpm;
+    }
+
+    mk82SystemTickerGetMsPassed(&currentInternalTimeInMs);
+    mk82SystemTickerGetSessionID(&sessionID);
+
+    if ((otpHalTimeBase.check == otpHalComputeTimeBaseCheck()) && (otpHalTimeBase.sessionID == sessionID) &&
+        (otpHalTimeBase.internalReferenceTimeInMs <= currentInternalTimeInMs) &&
+        (otpHalTimeBase.internalCalibrationTimeInMs <= currentInternalTimeInMs))
+    {
+        otpHalReferenceTimeSet = OTP_TRUE;
+    }
+}
 
 void otpHalDeinit(void) {}
 
@@ -49,10 +332,7 @@ void otpHalMemCpy(uint8_t* dst, uint8_t* src, uint16_t length) { mk82SystemMemCp
 
 void otpHalSetKeySetTypeAndResetCounter(uint8_t* key, uint32_t keyLength, uint16_t type)
 {
-    uint8_t paddedKey[OTP_GLOBAL_MAX_KEYLENGTH];
-    uint8_t encryptedKey[OTP_GLOBAL_MAX_KEYLENGTH];
-    uint8_t nonce[MK82_KEYSAFE_NONCE_LENGTH];
-    uint8_t tag[MK82_KEYSAFE_TAG_LENGTH];
+    uint32_t midstates[2 * OTP_HAL_SHA1_STATE_WORDS];
     uint16_t trueFalse;
     uint64_t zeroCounter = 0;
 
@@ -71,13 +351,7 @@ void otpHalSetKeySetTypeAndResetCounter(uint8_t* key, uint32_t keyLength, uint16
         otpHalFatalError();
     }
 
-    mk82SystemMemSet(paddedKey, 0x00, sizeof(paddedKey));
-
-    mk82SystemMemCpy(paddedKey, key, keyLength);
-
-    mk82KeysafeWrapKey(MK82_KEYSAFE_OTP_KEK_ID, paddedKey, sizeof(paddedKey), encryptedKey, NULL, 0, nonce, tag);
-
-    mk82SystemMemSet(paddedKey, 0x00, sizeof(paddedKey));
+    otpHalComputeMidstates(key, keyLength, midstates);
 
     trueFalse = OTP_FALSE;
     mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyInitialized), (uint8_t*)&trueFalse,
@@ -91,9 +365,11 @@ void otpHalSetKeySetTypeAndResetCounter(uint8_t* key, uint32_t keyLength, uint16
     mk82FsWriteFile(MK82_FS_FILE_ID_OTP_DATA, offsetof(OTP_HAL_NVM_DATA, type), (uint8_t*)&type, sizeof(type));
     mk82FsCommitWrite(MK82_FS_FILE_ID_OTP_DATA);
 
-    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, key), encryptedKey, OTP_GLOBAL_MAX_KEYLENGTH);
-    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyNonce), nonce, MK82_KEYSAFE_NONCE_LENGTH);
-    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyTag), tag, MK82_KEYSAFE_TAG_LENGTH);
+    otpHalStoreMidstates(midstates);
+
+    mk82SystemMemSet((uint8_t*)midstates, 0x00, sizeof(midstates));
+
+    otpHalClearRawKey();
     mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyLength), (uint8_t*)&keyLength,
                     sizeof(keyLength));
     trueFalse = OTP_TRUE;
@@ -142,50 +418,6 @@ void otpHalIsKeyInitialized(uint16_t* result)
                    sizeof(uint16_t));
 }
 
-void otpHalGetKey(uint8_t* key, uint32_t* keyLength)
-{
-    uint8_t encryptedKey[OTP_GLOBAL_MAX_KEYLENGTH];
-    uint8_t decryptedKey[OTP_GLOBAL_MAX_KEYLENGTH];
-    uint8_t nonce[MK82_KEYSAFE_NONCE_LENGTH];
-    uint8_t tag[MK82_KEYSAFE_TAG_LENGTH];
-    uint16_t calleeRetVal;
-
-    uint16_t keyInitialized = OTP_FALSE;
-
-    if ((key == NULL) || (keyLength == NULL))
-    {
-        otpHalFatalError();
-    }
-
-    otpHalIsKeyInitialized(&keyInitialized);
-
-    if (keyInitialized != OTP_TRUE)
-    {
-        otpHalFatalError();
-    }
-
-    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, key), encryptedKey, sizeof(encryptedKey));
-    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyNonce), nonce, sizeof(nonce));
-    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyTag), tag, sizeof(tag));
-    mk82FsReadFile(MK82_FS_FILE_ID_OTP_KEYS, offsetof(OTP_HAL_NVM_KEYS, keyLength), (uint8_t*)keyLength,
-                   sizeof(uint32_t));
-
-    calleeRetVal = mk82KeysafeUnwrapKey(MK82_KEYSAFE_OTP_KEK_ID, encryptedKey, sizeof(encryptedKey), decryptedKey, NULL,
-                                        0, nonce, tag);
-
-    if (calleeRetVal != MK82_NO_ERROR)
-    {
-        otpHalFatalError();
-    }
-
-    if ((*keyLength < OTP_GLOBAL_MIN_KEYLENGTH) || (*keyLength > OTP_GLOBAL_MAX_KEYLENGTH))
-    {
-        otpHalFatalError();
-    }
-
-    mk82SystemMemCpy(key, decryptedKey, *keyLength);
-}
-
 void otpHalGetType(uint16_t* type)
 {
     if (type == NULL)
@@ -214,24 +446,58 @@ void otpHalSetCounter(uint64_t counter)
     mk82FsCommitWrite(MK82_FS_FILE_ID_OTP_COUNTERS);
 }
 
-void otpHalComputeHmac(uint8_t* key, uint32_t keyLength, uint8_t* counter, uint8_t* hmac)
+void otpHalComputeHmac(uint8_t* counter, uint8_t* hmac)
 {
-    int calleeRetVal;
+    uint32_t midstates[2 * OTP_HAL_SHA1_STATE_WORDS];
+    uint8_t innerHash[OTP_GLOBAL_HAMC_LENGTH];
+    uint16_t keyInitialized = OTP_FALSE;
 
-    calleeRetVal = mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA1), key, keyLength, counter,
-                                   OTP_GLOBAL_COUNTER_LENGTH, hmac);
+    if ((counter == NULL) || (hmac == NULL))
+    {
+        otpHalFatalError();
+    }
+
+    otpHalIsKeyInitialized(&keyInitialized);
 
-    if (calleeRetVal != 0)
+    if (keyInitialized != OTP_TRUE)
     {
         otpHalFatalError();
     }
+
+    otpHalGetMidstates(midstates);
+
+    otpHalSha1FinishBlock(&midstates[0], counter, OTP_GLOBAL_COUNTER_LENGTH);
+    otpHalSha1StateToDigest(&midstates[0], innerHash);
+
+    otpHalSha1FinishBlock(&midstates[OTP_HAL_SHA1_STATE_WORDS], innerHash, sizeof(innerHash));
+    otpHalSha1StateToDigest(&midstates[OTP_HAL_SHA1_STATE_WORDS], hmac);
+
+    mk82SystemMemSet((uint8_t*)midstates, 0x00, sizeof(midstates));
+    mk82SystemMemSet(innerHash, 0x00, sizeof(innerHash));
 }
 
 void otpHalSetExternalTime(uint32_t externalTime)
 {
-    otpHalExternalReferenceTimeInSec = externalTime;
+    uint64_t currentInternalTimeInMs;
+    uint32_t sessionID;
 
-    mk82SystemTickerGetMsPassed(&otpHalInternalReferenceTimeInMs);
+    mk82SystemTickerGetMsPassed(&currentInternalTimeInMs);
+    mk82SystemTickerGetSessionID(&sessionID);
+
+    if (otpHalReferenceTimeSet == OTP_TRUE)
+    {
+        otpHalCalibrateDrift(externalTime, currentInternalTimeInMs);
+    }
+    else
+    {
+        otpHalTimeBase.externalCalibrationTimeInSec = externalTime;
+        otpHalTimeBase.internalCalibrationTimeInMs = currentInternalTimeInMs;
+    }
+
+    otpHalTimeBase.externalReferenceTimeInSec = externalTime;
+    otpHalTimeBase.internalReferenceTimeInMs = currentInternalTimeInMs;
+    otpHalTimeBase.sessionID = sessionID;
+    otpHalTimeBase.check = otpHalComputeTimeBaseCheck();
 
     otpHalReferenceTimeSet = OTP_TRUE;
 }
@@ -240,6 +506,7 @@ uint16_t otpHalGetCurrentTime(uint32_t* time)
 {
     uint16_t retVal = OTP_GENERAL_ERROR;
     uint64_t currentInternalTimeInMs;
+    int64_t msPassed;
     uint32_t secondsPassed;
 
     if (time == NULL)
@@ -255,14 +522,17 @@ uint16_t otpHalGetCurrentTime(uint32_t* time)
 
     mk82SystemTickerGetMsPassed(&currentInternalTimeInMs);
 
-    if (currentInternalTimeInMs < otpHalInternalReferenceTimeInMs)
+    if (currentInternalTimeInMs < otpHalTimeBase.internalReferenceTimeInMs)
     {
         otpHalFatalError();
     }
 
-    secondsPassed = (currentInternalTimeInMs - otpHalInternalReferenceTimeInMs) / 1000;
+    msPassed = currentInternalTimeInMs - otpHalTimeBase.internalReferenceTimeInMs;
+    msPassed += (msPassed * otpHalDriftInPpm) / 1000000;
+
+    secondsPassed = msPassed / 1000;
 
-    *time = otpHalExternalReferenceTimeInSec + secondsPassed;
+    *time = otpHalTimeBase.externalReferenceTimeInSec + secondsPassed;
 
     retVal = OTP_NO_ERROR;
 
@@ -298,6 +568,12 @@ void otpHalWipeout(void)
 
     mk82FsCommitWrite(MK82_FS_FILE_ID_OTP_KEYS);
 
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstates), wipeoutBuffer,
+                    OTP_HAL_MIDSTATES_LENGTH);
+    mk82FsWriteFile(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, offsetof(OTP_HAL_NVM_KEY_MIDSTATES, midstatesInitialized),
+                    (uint8_t*)&trueOrFalse, sizeof(trueOrFalse));
+    mk82FsCommitWrite(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES);
+
     mk82FsWriteFile(MK82_FS_FILE_ID_OTP_DATA, 0, (uint8_t*)&data, sizeof(data));
     mk82FsCommitWrite(MK82_FS_FILE_ID_OTP_DATA);
 
@@ -12,4 +12,28 @@
 
 #define OTP_HAL_WIPEOUT_BUFFER_SIZE (64)
 
+#define OTP_HAL_SHA1_BLOCK_SIZE (64)
+#define OTP_HAL_SHA1_STATE_WORDS (5)
+#define OTP_HAL_SHA1_LENGTH_FIELD_OFFSET (OTP_HAL_SHA1_BLOCK_SIZE - 8)
+#define OTP_HAL_HMAC_IPAD (0x36)
+#define OTP_HAL_HMAC_OPAD (0x5C)
+
+#define OTP_HAL_TIME_BASE_CHECK_MAGIC (0x3C5AA5C3)
+
+/* Drift is only measured over long enough intervals for the 1 second host time resolution not to matter. */
+#define OTP_HAL_MIN_CALIBRATION_INTERVAL_IN_SEC (6 * 60 * 60)
+#define OTP_HAL_MAX_DRIFT_IN_PPM (20000)
+/* The calibration is written to flash only when it moves by at least this much. */
+#define OTP_HAL_DRIFT_PERSIST_THRESHOLD_IN_PPM (10)
+
+typedef struct
+{
+    uint32_t externalReferenceTimeInSec;
+    uint64_t internalReferenceTimeInMs;
+    uint32_t externalCalibrationTimeInSec;
+    uint64_t internalCalibrationTimeInMs;
+    uint32_t sessionID;
+    uint32_t check;
+} OTP_HAL_TIME_BASE;
+
 #endif /* __OTP_HAL_K82_INT_H__ */
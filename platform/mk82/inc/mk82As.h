@@ -22,11 +22,13 @@ extern "C"
 #define MK82_AS_ALLOW_SSL_COMMANDS (0x10)
 #define MK82_AS_ALLOW_BTC_COMMANDS (0x20)
 #define MK82_AS_ALLOW_XRP_COMMANDS (0x40)
+#define MK82_AS_ALLOW_DIAG_COMMANDS (0x80)
 
 #define MK82_AS_ALLOW_ALL_COMMANDS (0xFFFFFFFF)
 
     void mk82AsInit(void);
-    void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedCommands);
+    void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedCommands, uint8_t slot);
+    void mk82AsResetSlot(uint8_t slot);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,28 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __MK82_DIAG_H__
+#define __MK82_DIAG_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef USE_DIAG
+    void mk82DiagGetAID(uint8_t* aid, uint32_t* aidLength);
+
+    void mk82DiagProcessAPDU(uint8_t* apdu, uint32_t* apduLength);
+#endif /* USE_DIAG */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MK82_DIAG_H__ */
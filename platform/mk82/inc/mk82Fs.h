@@ -34,11 +34,40 @@ extern "C"
 #define MK82_FS_FILE_ID_XRP_COUNTERS (17)
 #define MK82_FS_FILE_ID_XRP_KEYS (18)
 #define MK82_FS_FILE_ID_XRP_DATA (19)
+#define MK82_FS_FILE_ID_OTP_TIME (20)
+#define MK82_FS_FILE_ID_OPGP_PRIME_POOL (21)
+#define MK82_FS_FILE_ID_OTP_KEY_MIDSTATES (22)
+
+#define MK82_FS_NUMBER_OF_FILE_IDS (22)
+#define MK82_FS_NUMBER_OF_BLOCKS (MK82_FLASH_FILE_SYSTEM_SIZE / MK82_FLASH_PAGE_SIZE)
+
+    /* Index 0 of the per-file counters accounts for activity not caused by a file write, e.g. mount and
+     * wear counter saves. */
+    typedef struct
+    {
+        uint32_t blockEraseCounters[MK82_FS_NUMBER_OF_BLOCKS];
+        uint32_t pageWriteCounter;
+        uint32_t fileCommitCounters[MK82_FS_NUMBER_OF_FILE_IDS + 1];
+        uint32_t fileEraseCounters[MK82_FS_NUMBER_OF_FILE_IDS + 1];
+    } MK82_FS_WEAR_INFO;
+
+    /* A piece of a file that can be read in place, see mk82FsMapFile */
+    typedef struct
+    {
+        const uint8_t* data;
+        uint32_t length;
+    } MK82_FS_EXTENT;
 
     void mk82FsInit(void);
     void mk82FsReadFile(uint8_t fileID, uint32_t offset, uint8_t* buffer, uint32_t length);
+    uint32_t mk82FsMapFile(uint8_t fileID, uint32_t offset, uint32_t length, MK82_FS_EXTENT* extents,
+                           uint32_t maxExtents, uint32_t* numberOfExtents);
     void mk82FsWriteFile(uint8_t fileID, uint32_t offset, uint8_t* buffer, uint32_t length);
     void mk82FsCommitWrite(uint8_t fileID);
+    void mk82FsBeginTransaction(void);
+    void mk82FsCommitTransaction(void);
+    void mk82FsGetWearInfo(MK82_FS_WEAR_INFO* wearInfo);
+    void mk82FsIdleTask(void);
 
 #ifdef __cplusplus
 }
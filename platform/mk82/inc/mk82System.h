@@ -23,10 +23,55 @@ extern "C"
 
     void mk82SystemGetSerialNumber(uint32_t* serialNumber);
 
+    void mk82SystemFlashProgram(uint32_t address, uint8_t* data, uint32_t length);
+    void mk82SystemFlashBeginOperation(void);
+    void mk82SystemFlashEndOperation(void);
+
 #ifdef FIRMWARE
     void mk82SystemTickerGetMsPassed(uint64_t* ms);
+    void mk82SystemTickerGetUsPassed(uint64_t* us);
+    void mk82SystemTickerGetSessionID(uint32_t* sessionID);
     void mk82SystemGetRandom(uint8_t* buffer, uint32_t bufferLength);
     int mk82SystemGetRandomForTLS(void* param, unsigned char* buffer, size_t bufferLength);
+
+    uint16_t mk82SystemCrc16Update(const uint8_t* data, uint32_t length, uint16_t crc);
+
+#define MK82_SYSTEM_MAX_INIT_STAGES (16)
+
+    typedef struct
+    {
+        uint32_t completedStages;
+        uint32_t delayedCommands;
+        uint32_t firstStageStartTimeInMs;
+        uint32_t lastStageEndTimeInMs;
+        uint32_t stageTimeInUs[MK82_SYSTEM_MAX_INIT_STAGES];
+    } MK82_SYSTEM_INIT_INFO;
+
+    void mk82SystemInitStageCompleted(uint32_t stage, uint64_t startTimeInUs, uint64_t endTimeInUs);
+    void mk82SystemInitCommandDelayed(void);
+    void mk82SystemGetInitInfo(MK82_SYSTEM_INIT_INFO* info);
+
+#ifdef USE_PROFILER
+/* SysTick reload is 24 bits wide, which limits the lowest rate at the core clock of 150 MHz. */
+#define MK82_SYSTEM_PROFILER_MIN_SAMPLING_RATE (10)
+#define MK82_SYSTEM_PROFILER_MAX_SAMPLING_RATE (20000)
+
+    typedef struct
+    {
+        uint32_t samplingRate;
+        uint32_t regionStart;
+        uint32_t bucketSize;
+        uint32_t numberOfBuckets;
+        uint32_t totalSamples;
+        uint32_t outOfRegionSamples;
+        uint16_t running;
+    } MK82_SYSTEM_PROFILER_INFO;
+
+    void mk82SystemProfilerStart(uint32_t samplingRate);
+    void mk82SystemProfilerStop(void);
+    void mk82SystemProfilerGetInfo(MK82_SYSTEM_PROFILER_INFO* info);
+    void mk82SystemProfilerReadHistogram(uint32_t firstBucket, uint16_t* buckets, uint32_t numberOfBuckets);
+#endif /* USE_PROFILER */
 #endif /* FIRMWARE */
 
 #endif /* BOOTSTRAPPER */
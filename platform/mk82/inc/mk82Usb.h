@@ -25,7 +25,10 @@ extern "C"
 
 #ifdef FIRMWARE
     void mk82UsbTypeStringWithAKeyboard(uint8_t* stringToType, uint32_t stringLength);
+    uint16_t mk82UsbKeyboardIsBusy(void);
     void mk82UsbFakeU2fWtx(void);
+    uint16_t mk82UsbIsConfigured(void);
+    uint8_t mk82UsbGetCcidSlot(void);
 #endif /* FIRMWARE */
 
 #ifdef __cplusplus
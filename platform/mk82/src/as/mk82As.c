@@ -18,6 +18,7 @@
 
 #include "opgpGlobal.h"
 #include "opgpCore.h"
+#include "opgpPin.h"
 
 #include "otpGlobal.h"
 #include "otpCore.h"
@@ -35,9 +36,15 @@
 #include "xrpCore.h"
 
 #include "mk82Ssl.h"
+#include "mk82Diag.h"
 
 static void mk82AsFatalError(void);
 static void mk82AsPutSWToAPDUBuffer(uint8_t* apdu, uint32_t* apduLength, uint16_t sw);
+static void mk82AsResetChannel(uint8_t slot, uint8_t channel);
+static void mk82AsResetOpgpPinStatus(void);
+static void mk82AsProcessManageChannel(uint8_t* apdu, uint32_t* apduLength, uint8_t slot, uint8_t channel);
+static void mk82AsDispatchAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedCommands,
+                               uint32_t* selectedApplication);
 
 static uint8_t mk82AsOPGPAid[MK82_AS_MAX_AID_LENGTH];
 static uint32_t mk82AsOPGPAidLength;
@@ -53,12 +60,22 @@ static uint8_t mk82AsBtcAid[MK82_AS_MAX_AID_LENGTH];
 static uint32_t mk82AsBtcAidLength;
 static uint8_t mk82AsXrpAid[MK82_AS_MAX_AID_LENGTH];
 static uint32_t mk82AsXrpAidLength;
-static uint32_t mk82AsSelectedApplication = MK82_AS_NONE_SELECTED;
+#ifdef USE_DIAG
+static uint8_t mk82AsDiagAid[MK82_AS_MAX_AID_LENGTH];
+static uint32_t mk82AsDiagAidLength;
+#endif /* USE_DIAG */
+static uint32_t mk82AsSelectedApplication[MK82_AS_NUMBER_OF_SLOTS][MK82_AS_NUMBER_OF_CHANNELS];
+static uint16_t mk82AsChannelOpen[MK82_AS_NUMBER_OF_SLOTS][MK82_AS_NUMBER_OF_CHANNELS];
+/* OpenPGP PIN status of every channel, loaded into opgpPin only while that channel's APDU is processed. */
+static OPGP_PIN_VOLATILE_PIN_STATUS mk82AsOpgpPinStatus[MK82_AS_NUMBER_OF_SLOTS][MK82_AS_NUMBER_OF_CHANNELS];
 
 static void mk82AsFatalError(void) { mk82SystemFatalError(); }
 
 void mk82AsInit(void)
 {
+    uint32_t i;
+    uint32_t j;
+
     opgpCoreGetAID(mk82AsOPGPAid, &mk82AsOPGPAidLength);
     otpCoreGetAID(mk82AsOTPAid, &mk82AsOTPAidLength);
     bldrCoreGetAID(mk82AsBldrAid, &mk82AsBldrAidLength);
@@ -66,6 +83,20 @@ void mk82AsInit(void)
     mk82SslGetAID(mk82AsSslAid, &mk82AsSslAidLength);
     btcCoreGetAID(mk82AsBtcAid, &mk82AsBtcAidLength);
     xrpCoreGetAID(mk82AsXrpAid, &mk82AsXrpAidLength);
+#ifdef USE_DIAG
+    mk82DiagGetAID(mk82AsDiagAid, &mk82AsDiagAidLength);
+#endif /* USE_DIAG */
+
+    for (i = 0; i < MK82_AS_NUMBER_OF_SLOTS; i++)
+    {
+        for (j = 0; j < MK82_AS_NUMBER_OF_CHANNELS; j++)
+        {
+            mk82AsResetChannel(i, j);
+            mk82AsChannelOpen[i][j] = MK82_FALSE;
+        }
+
+        mk82AsChannelOpen[i][MK82_AS_BASIC_CHANNEL] = MK82_TRUE;
+    }
 }
 
 static void mk82AsPutSWToAPDUBuffer(uint8_t* apdu, uint32_t* apduLength, uint16_t sw)
@@ -75,27 +106,193 @@ static void mk82AsPutSWToAPDUBuffer(uint8_t* apdu, uint32_t* apduLength, uint16_
     *apduLength = 2;
 }
 
-void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedCommands)
+static void mk82AsResetChannel(uint8_t slot, uint8_t channel)
 {
-    uint16_t sw = MK82_AS_SW_UNKNOWN;
-    uint8_t applicationSelectHeader[] = MK82_AS_APPLICATION_SELECT_HEADER;
+    mk82AsSelectedApplication[slot][channel] = MK82_AS_NONE_SELECTED;
+
+    mk82AsOpgpPinStatus[slot][channel].PW1_81_Verified = OPGP_FALSE;
+    mk82AsOpgpPinStatus[slot][channel].PW1_82_Verified = OPGP_FALSE;
+    mk82AsOpgpPinStatus[slot][channel].PW3Verified = OPGP_FALSE;
+}
+
+static void mk82AsResetOpgpPinStatus(void)
+{
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0; i < MK82_AS_NUMBER_OF_SLOTS; i++)
+    {
+        for (j = 0; j < MK82_AS_NUMBER_OF_CHANNELS; j++)
+        {
+            mk82AsOpgpPinStatus[i][j].PW1_81_Verified = OPGP_FALSE;
+            mk82AsOpgpPinStatus[i][j].PW1_82_Verified = OPGP_FALSE;
+            mk82AsOpgpPinStatus[i][j].PW3Verified = OPGP_FALSE;
+        }
+    }
+}
+
+/* Nothing stays selected or verified in the slot across an ICC power cycle, and only the basic channel stays open. */
+void mk82AsResetSlot(uint8_t slot)
+{
+    uint8_t i;
+
+    if (slot >= MK82_AS_NUMBER_OF_SLOTS)
+    {
+        mk82AsFatalError();
+    }
+
+    for (i = 0; i < MK82_AS_NUMBER_OF_CHANNELS; i++)
+    {
+        mk82AsResetChannel(slot, i);
+        mk82AsChannelOpen[slot][i] = MK82_FALSE;
+    }
+
+    mk82AsChannelOpen[slot][MK82_AS_BASIC_CHANNEL] = MK82_TRUE;
+}
+
+static void mk82AsProcessManageChannel(uint8_t* apdu, uint32_t* apduLength, uint8_t slot, uint8_t channel)
+{
+    uint8_t p1 = apdu[MK82_AS_OFFSET_P1];
+    uint8_t p2 = apdu[MK82_AS_OFFSET_P2];
+    uint8_t i;
+
+    if (p1 == MK82_AS_MANAGE_CHANNEL_OPEN)
+    {
+        if (p2 == 0x00)
+        {
+            for (i = 1; i < MK82_AS_NUMBER_OF_CHANNELS; i++)
+            {
+                if (mk82AsChannelOpen[slot][i] != MK82_TRUE)
+                {
+                    break;
+                }
+            }
+
+            if (i == MK82_AS_NUMBER_OF_CHANNELS)
+            {
+                mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_FUNCTION_NOT_SUPPORTED);
+                goto END;
+            }
+
+            mk82AsResetChannel(slot, i);
+            mk82AsChannelOpen[slot][i] = MK82_TRUE;
+
+            apdu[0] = i;
+            mk82AsPutSWToAPDUBuffer(&apdu[1], apduLength, MK82_AS_SW_NO_ERROR);
+            *apduLength += 1;
+            goto END;
+        }
+        else if ((p2 < MK82_AS_NUMBER_OF_CHANNELS) && (mk82AsChannelOpen[slot][p2] != MK82_TRUE))
+        {
+            mk82AsResetChannel(slot, p2);
+            mk82AsChannelOpen[slot][p2] = MK82_TRUE;
+
+            mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_NO_ERROR);
+            goto END;
+        }
+        else
+        {
+            mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_INCORRECT_P1P2);
+            goto END;
+        }
+    }
+    else if (p1 == MK82_AS_MANAGE_CHANNEL_CLOSE)
+    {
+        if (p2 == 0x00)
+        {
+            p2 = channel;
+        }
+
+        if ((p2 == MK82_AS_BASIC_CHANNEL) || (p2 >= MK82_AS_NUMBER_OF_CHANNELS) ||
+            (mk82AsChannelOpen[slot][p2] != MK82_TRUE))
+        {
+            mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_INCORRECT_P1P2);
+            goto END;
+        }
+
+        mk82AsResetChannel(slot, p2);
+        mk82AsChannelOpen[slot][p2] = MK82_FALSE;
+
+        mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_NO_ERROR);
+        goto END;
+    }
+    else
+    {
+        mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_INCORRECT_P1P2);
+        goto END;
+    }
+
+END:;
+}
+
+void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedCommands, uint8_t slot)
+{
+    uint8_t channel = MK82_AS_BASIC_CHANNEL;
 
     if ((apdu == NULL) || (apduLength == NULL))
     {
         mk82AsFatalError();
     }
 
+    if (slot >= MK82_AS_NUMBER_OF_SLOTS)
+    {
+        mk82AsFatalError();
+    }
+
+    if (*apduLength >= MK82_AS_APDU_HEADER_LENGTH)
+    {
+        if ((apdu[MK82_AS_OFFSET_CLA] & MK82_AS_CLA_CHANNEL_CODING_MASK) == 0x00)
+        {
+            /* Applications only ever see the basic channel CLA. */
+            channel = apdu[MK82_AS_OFFSET_CLA] & MK82_AS_CLA_CHANNEL_MASK;
+            apdu[MK82_AS_OFFSET_CLA] &= ~MK82_AS_CLA_CHANNEL_MASK;
+        }
+
+        if (mk82AsChannelOpen[slot][channel] != MK82_TRUE)
+        {
+            mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_LOGICAL_CHANNEL_NOT_SUPPORTED);
+            goto END;
+        }
+
+        if ((apdu[MK82_AS_OFFSET_CLA] == MK82_AS_MANAGE_CHANNEL_CLA) &&
+            (apdu[MK82_AS_OFFSET_INS] == MK82_AS_INS_MANAGE_CHANNEL))
+        {
+            mk82AsProcessManageChannel(apdu, apduLength, slot, channel);
+            goto END;
+        }
+    }
+
+    opgpPinSetVolatilePinStatus(&mk82AsOpgpPinStatus[slot][channel]);
+
+    mk82AsDispatchAPDU(apdu, apduLength, allowedCommands, &mk82AsSelectedApplication[slot][channel]);
+
+    if (opgpPinIsPinStatusInvalidated() == OPGP_TRUE)
+    {
+        mk82AsResetOpgpPinStatus();
+    }
+
+    opgpPinGetVolatilePinStatus(&mk82AsOpgpPinStatus[slot][channel]);
+
+END:;
+}
+
+static void mk82AsDispatchAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedCommands,
+                               uint32_t* selectedApplication)
+{
+    uint16_t sw = MK82_AS_SW_UNKNOWN;
+    uint8_t applicationSelectHeader[] = MK82_AS_APPLICATION_SELECT_HEADER;
+
     if ((apdu[MK82_AS_OFFSET_LC] != 0x00) &&
         ((*apduLength == (0x05 + apdu[MK82_AS_OFFSET_LC])) || (*apduLength == (0x06 + apdu[MK82_AS_OFFSET_LC]))) &&
         (mk82SystemMemCmp(apdu, applicationSelectHeader, sizeof(applicationSelectHeader)) == MK82_CMP_EQUAL))
     {
-        mk82AsSelectedApplication = MK82_AS_NONE_SELECTED;
+        *selectedApplication = MK82_AS_NONE_SELECTED;
 
         if ((apdu[MK82_AS_OFFSET_LC] <= mk82AsOPGPAidLength) &&
             (mk82SystemMemCmp(&apdu[MK82_AS_OFFSET_DATA], mk82AsOPGPAid, apdu[MK82_AS_OFFSET_LC]) == MK82_CMP_EQUAL))
         {
             opgpCoreSelect(&sw);
-            mk82AsSelectedApplication = MK82_AS_OPGP_SELECTED;
+            *selectedApplication = MK82_AS_OPGP_SELECTED;
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, sw);
             goto END;
         }
@@ -103,7 +300,7 @@ void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedComm
                  (mk82SystemMemCmp(&apdu[MK82_AS_OFFSET_DATA], mk82AsOTPAid, apdu[MK82_AS_OFFSET_LC]) ==
                   MK82_CMP_EQUAL))
         {
-            mk82AsSelectedApplication = MK82_AS_OTP_SELECTED;
+            *selectedApplication = MK82_AS_OTP_SELECTED;
             sw = MK82_AS_SW_NO_ERROR;
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, sw);
             goto END;
@@ -112,7 +309,7 @@ void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedComm
                  (mk82SystemMemCmp(&apdu[MK82_AS_OFFSET_DATA], mk82AsBldrAid, apdu[MK82_AS_OFFSET_LC]) ==
                   MK82_CMP_EQUAL))
         {
-            mk82AsSelectedApplication = MK82_AS_BLDR_SELECTED;
+            *selectedApplication = MK82_AS_BLDR_SELECTED;
             sw = MK82_AS_SW_NO_ERROR;
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, sw);
             goto END;
@@ -121,7 +318,7 @@ void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedComm
                  (mk82SystemMemCmp(&apdu[MK82_AS_OFFSET_DATA], mk82AsEthAid, apdu[MK82_AS_OFFSET_LC]) ==
                   MK82_CMP_EQUAL))
         {
-            mk82AsSelectedApplication = MK82_AS_ETH_SELECTED;
+            *selectedApplication = MK82_AS_ETH_SELECTED;
             sw = MK82_AS_SW_NO_ERROR;
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, sw);
             goto END;
@@ -130,7 +327,7 @@ void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedComm
                  (mk82SystemMemCmp(&apdu[MK82_AS_OFFSET_DATA], mk82AsSslAid, apdu[MK82_AS_OFFSET_LC]) ==
                   MK82_CMP_EQUAL))
         {
-            mk82AsSelectedApplication = MK82_AS_SSL_SELECTED;
+            *selectedApplication = MK82_AS_SSL_SELECTED;
             sw = MK82_AS_SW_NO_ERROR;
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, sw);
             goto END;
@@ -139,7 +336,7 @@ void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedComm
                  (mk82SystemMemCmp(&apdu[MK82_AS_OFFSET_DATA], mk82AsBtcAid, apdu[MK82_AS_OFFSET_LC]) ==
                   MK82_CMP_EQUAL))
         {
-            mk82AsSelectedApplication = MK82_AS_BTC_SELECTED;
+            *selectedApplication = MK82_AS_BTC_SELECTED;
             sw = MK82_AS_SW_NO_ERROR;
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, sw);
             goto END;
@@ -148,11 +345,22 @@ void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedComm
                  (mk82SystemMemCmp(&apdu[MK82_AS_OFFSET_DATA], mk82AsXrpAid, apdu[MK82_AS_OFFSET_LC]) ==
                   MK82_CMP_EQUAL))
         {
-            mk82AsSelectedApplication = MK82_AS_XRP_SELECTED;
+            *selectedApplication = MK82_AS_XRP_SELECTED;
             sw = MK82_AS_SW_NO_ERROR;
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, sw);
             goto END;
         }
+#ifdef USE_DIAG
+        else if ((apdu[MK82_AS_OFFSET_LC] <= mk82AsDiagAidLength) &&
+                 (mk82SystemMemCmp(&apdu[MK82_AS_OFFSET_DATA], mk82AsDiagAid, apdu[MK82_AS_OFFSET_LC]) ==
+                  MK82_CMP_EQUAL))
+        {
+            *selectedApplication = MK82_AS_DIAG_SELECTED;
+            sw = MK82_AS_SW_NO_ERROR;
+            mk82AsPutSWToAPDUBuffer(apdu, apduLength, sw);
+            goto END;
+        }
+#endif /* USE_DIAG */
         else
         {
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_REF_DATA_NOT_FOUND);
@@ -161,42 +369,48 @@ void mk82AsProcessAPDU(uint8_t* apdu, uint32_t* apduLength, uint32_t allowedComm
     }
     else
     {
-        if ((mk82AsSelectedApplication == MK82_AS_OPGP_SELECTED) && (allowedCommands & MK82_AS_ALLOW_OPGP_COMMANDS))
+        if ((*selectedApplication == MK82_AS_OPGP_SELECTED) && (allowedCommands & MK82_AS_ALLOW_OPGP_COMMANDS))
         {
             opgpCoreProcessAPDU(apdu, apduLength);
             goto END;
         }
-        else if ((mk82AsSelectedApplication == MK82_AS_OTP_SELECTED) && (allowedCommands & MK82_AS_ALLOW_OTP_COMMANDS))
+        else if ((*selectedApplication == MK82_AS_OTP_SELECTED) && (allowedCommands & MK82_AS_ALLOW_OTP_COMMANDS))
         {
             otpCoreProcessControlAPDU(apdu, apduLength);
             goto END;
         }
-        else if ((mk82AsSelectedApplication == MK82_AS_BLDR_SELECTED) &&
-                 (allowedCommands & MK82_AS_ALLOW_BLDR_COMMANDS))
+        else if ((*selectedApplication == MK82_AS_BLDR_SELECTED) && (allowedCommands & MK82_AS_ALLOW_BLDR_COMMANDS))
         {
             bldrCoreProcessAPDU(apdu, apduLength);
             goto END;
         }
-        else if ((mk82AsSelectedApplication == MK82_AS_ETH_SELECTED) && (allowedCommands & MK82_AS_ALLOW_ETH_COMMANDS))
+        else if ((*selectedApplication == MK82_AS_ETH_SELECTED) && (allowedCommands & MK82_AS_ALLOW_ETH_COMMANDS))
         {
             ethCoreProcessAPDU(apdu, apduLength);
             goto END;
         }
-        else if ((mk82AsSelectedApplication == MK82_AS_SSL_SELECTED) && (allowedCommands & MK82_AS_ALLOW_SSL_COMMANDS))
+        else if ((*selectedApplication == MK82_AS_SSL_SELECTED) && (allowedCommands & MK82_AS_ALLOW_SSL_COMMANDS))
         {
             mk82SslProcessAPDU(apdu, apduLength);
             goto END;
         }
-        else if ((mk82AsSelectedApplication == MK82_AS_BTC_SELECTED) && (allowedCommands & MK82_AS_ALLOW_BTC_COMMANDS))
+        else if ((*selectedApplication == MK82_AS_BTC_SELECTED) && (allowedCommands & MK82_AS_ALLOW_BTC_COMMANDS))
         {
             btcCoreProcessAPDU(apdu, apduLength);
             goto END;
         }
-        else if ((mk82AsSelectedApplication == MK82_AS_XRP_SELECTED) && (allowedCommands & MK82_AS_ALLOW_XRP_COMMANDS))
+        else if ((*selectedApplication == MK82_AS_XRP_SELECTED) && (allowedCommands & MK82_AS_ALLOW_XRP_COMMANDS))
         {
             xrpCoreProcessAPDU(apdu, apduLength);
             goto END;
         }
+#ifdef USE_DIAG
+        else if ((*selectedApplication == MK82_AS_DIAG_SELECTED) && (allowedCommands & MK82_AS_ALLOW_DIAG_COMMANDS))
+        {
+            mk82DiagProcessAPDU(apdu, apduLength);
+            goto END;
+        }
+#endif /* USE_DIAG */
         else
         {
             mk82AsPutSWToAPDUBuffer(apdu, apduLength, MK82_AS_SW_UNKNOWN);
@@ -11,6 +11,7 @@
 #define __MK82_AS_INT_H__
 
 #include "stdint.h"
+#include "ccidGlobal.h"
 
 #define MK82_AS_NONE_SELECTED (0x00)
 #define MK82_AS_OPGP_SELECTED (0x01)
@@ -20,12 +21,34 @@
 #define MK82_AS_SSL_SELECTED (0x05)
 #define MK82_AS_BTC_SELECTED (0x06)
 #define MK82_AS_XRP_SELECTED (0x07)
+#define MK82_AS_DIAG_SELECTED (0x08)
 
 #define MK82_AS_MAX_AID_LENGTH (32)
 
+/* Each CCID slot keeps its own selected application. */
+#define MK82_AS_NUMBER_OF_SLOTS (CCID_NUMBER_OF_SLOTS)
+
+/* ISO 7816-4 logical channels 0-3, coded in the two low bits of the CLA. */
+#define MK82_AS_NUMBER_OF_CHANNELS (4)
+#define MK82_AS_BASIC_CHANNEL (0x00)
+#define MK82_AS_CLA_CHANNEL_MASK (0x03)
+/* Channels are coded only in interindustry style CLAs, 0x00-0x1F and 0x80-0x9F. */
+#define MK82_AS_CLA_CHANNEL_CODING_MASK (0x60)
+
+#define MK82_AS_INS_MANAGE_CHANNEL (0x70)
+#define MK82_AS_MANAGE_CHANNEL_CLA (0x00)
+#define MK82_AS_MANAGE_CHANNEL_OPEN (0x00)
+#define MK82_AS_MANAGE_CHANNEL_CLOSE (0x80)
+
+#define MK82_AS_OFFSET_CLA (0x00)
+#define MK82_AS_OFFSET_INS (0x01)
+#define MK82_AS_OFFSET_P1 (0x02)
+#define MK82_AS_OFFSET_P2 (0x03)
 #define MK82_AS_OFFSET_LC (0x04)
 #define MK82_AS_OFFSET_DATA (0x05)
 
+#define MK82_AS_APDU_HEADER_LENGTH (0x04)
+
 #define MK82_AS_APPLICATION_SELECT_HEADER \
     {                                     \
         0x00, 0xA4, 0x04, 0x00            \
@@ -33,6 +56,9 @@
 
 #define MK82_AS_SW_UNKNOWN (0x6F00)
 #define MK82_AS_SW_REF_DATA_NOT_FOUND (0x6A88)
+#define MK82_AS_SW_LOGICAL_CHANNEL_NOT_SUPPORTED (0x6881)
+#define MK82_AS_SW_FUNCTION_NOT_SUPPORTED (0x6A81)
+#define MK82_AS_SW_INCORRECT_P1P2 (0x6A86)
 #define MK82_AS_SW_NO_ERROR (0x9000)
 
 #endif /* __MK82_AS_INT_H__ */
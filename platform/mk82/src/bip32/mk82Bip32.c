@@ -16,12 +16,50 @@
 #include "mbedtls/sha256.h"
 #include "mbedtls/sha512.h"
 #include "mbedtls/ripemd160.h"
-#include "mbedtls/md.h"
 #include "mbedtls/ecdsa.h"
 #include "mbedtls/ecp.h"
 
 static void mk82Bip32PrivateKeyToPublicKey(uint8_t* privateKey, uint8_t* fullPublicKey, uint8_t* compressedPublicKey,
                                            uint16_t computeFull, uint16_t computeCompressed);
+static void mk82Bip32HmacSha512(uint8_t* chainCode, uint8_t* data, uint32_t dataLength, uint8_t* hmac);
+
+/*
+ * HMAC-SHA512 keyed with a chain code. The key is shorter than a block, so the ipad and opad blocks are formed
+ * directly and each HMAC costs exactly four compressions, without the heap allocations of mbedtls_md_setup.
+ */
+static void mk82Bip32HmacSha512(uint8_t* chainCode, uint8_t* data, uint32_t dataLength, uint8_t* hmac)
+{
+    mbedtls_sha512_context shaContext;
+    uint8_t pad[MK82_BIP32_SHA512_BLOCK_SIZE];
+    uint32_t i;
+
+    mk82SystemMemSet(pad, MK82_BIP32_HMAC_IPAD, sizeof(pad));
+
+    for (i = 0; i < MK82_BIP32_CHAIN_CODE_SIZE; i++)
+    {
+        pad[i] ^= chainCode[i];
+    }
+
+    mbedtls_sha512_init(&shaContext);
+
+    mbedtls_sha512_starts(&shaContext, 0);
+    mbedtls_sha512_update(&shaContext, pad, sizeof(pad));
+    mbedtls_sha512_update(&shaContext, data, dataLength);
+    mbedtls_sha512_finish(&shaContext, hmac);
+
+    for (i = 0; i < sizeof(pad); i++)
+    {
+        pad[i] ^= (MK82_BIP32_HMAC_IPAD ^ MK82_BIP32_HMAC_OPAD);
+    }
+
+    mbedtls_sha512_starts(&shaContext, 0);
+    mbedtls_sha512_update(&shaContext, pad, sizeof(pad));
+    mbedtls_sha512_update(&shaContext, hmac, MK82_BIP32_SHA512_SIZE);
+    mbedtls_sha512_finish(&shaContext, hmac);
+
+    mbedtls_sha512_free(&shaContext);
+    mk82SystemMemSet(pad, 0x00, sizeof(pad));
+}
 
 static void mk82Bip32PrivateKeyToPublicKey(uint8_t* privateKey, uint8_t* fullPublicKey, uint8_t* compressedPublicKey,
                                            uint16_t computeFull, uint16_t computeCompressed)
@@ -99,8 +137,7 @@ uint16_t mk82Bip32DerivePrivateKey(uint32_t* derivationIndexes, uint32_t numberO
     uint8_t masterKey[MK82_BIP32_MASTER_KEY_SIZE];
     uint32_t i;
     int calleeRetVal;
-    mbedtls_md_context_t mdCtx;
-    uint8_t serializedDerivationIndex[sizeof(uint32_t)];
+    uint8_t hmacData[MK82_BIP32_HMAC_DATA_SIZE];
     uint8_t hmac[MK82_BIP32_SHA512_SIZE];
     uint8_t intermediateDerivedPrivateKey[MK82_BIP32_PRIVATE_KEY_SIZE];
     uint8_t intermediateDerivedChainCode[MK82_BIP32_CHAIN_CODE_SIZE];
@@ -119,80 +156,24 @@ uint16_t mk82Bip32DerivePrivateKey(uint32_t* derivationIndexes, uint32_t numberO
     mk82SystemMemCpy(intermediateDerivedChainCode, &masterKey[MK82_BIP32_MASTER_KEY_CHAIN_CODE_OFFSET],
                      MK82_BIP32_CHAIN_CODE_SIZE);
 
-    mbedtls_md_init(&mdCtx);
-
     for (i = 0; i < numberOfKeyDerivations; i++)
     {
-        serializedDerivationIndex[0] = derivationIndexes[i] >> 24;
-        serializedDerivationIndex[1] = derivationIndexes[i] >> 16;
-        serializedDerivationIndex[2] = derivationIndexes[i] >> 8;
-        serializedDerivationIndex[3] = derivationIndexes[i];
-
-        calleeRetVal = mbedtls_md_setup(&mdCtx, mbedtls_md_info_from_type(MBEDTLS_MD_SHA512), 1);
-        if (calleeRetVal != 0)
-        {
-            mk82SystemFatalError();
-        }
-
         if ((derivationIndexes[i] & MK82_BIP32_HARDENED_KEY_MASK) == MK82_BIP32_HARDENED_KEY_MASK)
         {
-            uint8_t zero = 0;
-
-            calleeRetVal = mbedtls_md_hmac_starts(&mdCtx, intermediateDerivedChainCode, MK82_BIP32_CHAIN_CODE_SIZE);
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
-            calleeRetVal = mbedtls_md_hmac_update(&mdCtx, &zero, sizeof(zero));
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
-            calleeRetVal = mbedtls_md_hmac_update(&mdCtx, intermediateDerivedPrivateKey, MK82_BIP32_PRIVATE_KEY_SIZE);
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
-            calleeRetVal = mbedtls_md_hmac_update(&mdCtx, serializedDerivationIndex, sizeof(serializedDerivationIndex));
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
-            calleeRetVal = mbedtls_md_hmac_finish(&mdCtx, hmac);
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
+            hmacData[0] = 0x00;
+            mk82SystemMemCpy(&hmacData[1], intermediateDerivedPrivateKey, MK82_BIP32_PRIVATE_KEY_SIZE);
         }
         else
         {
-            uint8_t compressedPoint[MK82_BIP32_ENCODED_COMPRESSED_POINT_SIZE];
-
-            mk82Bip32PrivateKeyToPublicKey(intermediateDerivedPrivateKey, NULL, compressedPoint, MK82_FALSE, MK82_TRUE);
-
-            calleeRetVal = mbedtls_md_hmac_starts(&mdCtx, intermediateDerivedChainCode, MK82_BIP32_CHAIN_CODE_SIZE);
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
-            calleeRetVal = mbedtls_md_hmac_update(&mdCtx, compressedPoint, MK82_BIP32_ENCODED_COMPRESSED_POINT_SIZE);
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
-            calleeRetVal = mbedtls_md_hmac_update(&mdCtx, serializedDerivationIndex, sizeof(serializedDerivationIndex));
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
-            calleeRetVal = mbedtls_md_hmac_finish(&mdCtx, hmac);
-            if (calleeRetVal != 0)
-            {
-                mk82SystemFatalError();
-            }
+            mk82Bip32PrivateKeyToPublicKey(intermediateDerivedPrivateKey, NULL, hmacData, MK82_FALSE, MK82_TRUE);
         }
 
-        mbedtls_md_free(&mdCtx);
+        hmacData[MK82_BIP32_ENCODED_COMPRESSED_POINT_SIZE] = derivationIndexes[i] >> 24;
+        hmacData[MK82_BIP32_ENCODED_COMPRESSED_POINT_SIZE + 1] = derivationIndexes[i] >> 16;
+        hmacData[MK82_BIP32_ENCODED_COMPRESSED_POINT_SIZE + 2] = derivationIndexes[i] >> 8;
+        hmacData[MK82_BIP32_ENCODED_COMPRESSED_POINT_SIZE + 3] = derivationIndexes[i];
+
+        mk82Bip32HmacSha512(intermediateDerivedChainCode, hmacData, sizeof(hmacData), hmac);
 
         {
             mbedtls_mpi mpiLeftSideOfHash;
@@ -295,6 +276,7 @@ uint16_t mk82Bip32DerivePrivateKey(uint32_t* derivationIndexes, uint32_t numberO
     mk82SystemMemSet(intermediateDerivedPrivateKey, 0x00, sizeof(intermediateDerivedPrivateKey));
     mk82SystemMemSet(intermediateDerivedChainCode, 0x00, sizeof(intermediateDerivedChainCode));
     mk82SystemMemSet(hmac, 0x00, sizeof(hmac));
+    mk82SystemMemSet(hmacData, 0x00, sizeof(hmacData));
 
     return retVal;
 }
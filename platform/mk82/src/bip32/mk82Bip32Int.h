@@ -10,4 +10,12 @@
 #ifndef __MK82_BIP32_INT_H__
 #define __MK82_BIP32_INT_H__
 
+#define MK82_BIP32_SHA512_BLOCK_SIZE (128)
+
+#define MK82_BIP32_HMAC_IPAD (0x36)
+#define MK82_BIP32_HMAC_OPAD (0x5C)
+
+/* Either 0x00 || private key or the compressed public key, followed by the index. */
+#define MK82_BIP32_HMAC_DATA_SIZE (MK82_BIP32_ENCODED_COMPRESSED_POINT_SIZE + sizeof(uint32_t))
+
 #endif /* __MK82_BIP32_INT_H__ */
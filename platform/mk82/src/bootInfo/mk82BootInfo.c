@@ -87,9 +87,8 @@ static void mk82BootInfoGetStructures(MK82_BOOT_INFO** structureToUse, MK82_BOOT
 static void mk82BootInfoCheckIfStructureIsErased(MK82_BOOT_INFO* bootInfo, uint16_t* structureIsErased)
 {
     status_t calleeRetVal;
-    uint32_t primask;
 
-    primask = DisableGlobalIRQ();
+    mk82SystemFlashBeginOperation();
 
     calleeRetVal =
         FLASH_VerifyErase(&mk82FlashDriver, (uint32_t)bootInfo, MK82_FLASH_PAGE_SIZE, kFLASH_marginValueUser);
@@ -103,15 +102,14 @@ static void mk82BootInfoCheckIfStructureIsErased(MK82_BOOT_INFO* bootInfo, uint1
         *structureIsErased = MK82_TRUE;
     }
 
-    EnableGlobalIRQ(primask);
+    mk82SystemFlashEndOperation();
 }
 
 static void mk82BootInfoEraseStructure(MK82_BOOT_INFO* bootInfo)
 {
     status_t calleeRetVal;
-    uint32_t primask;
 
-    primask = DisableGlobalIRQ();
+    mk82SystemFlashBeginOperation();
 
     calleeRetVal = FLASH_Erase(&mk82FlashDriver, (uint32_t)bootInfo, MK82_FLASH_PAGE_SIZE, kFLASH_apiEraseKey);
 
@@ -120,24 +118,12 @@ static void mk82BootInfoEraseStructure(MK82_BOOT_INFO* bootInfo)
         mk82SystemFatalError();
     }
 
-    EnableGlobalIRQ(primask);
+    mk82SystemFlashEndOperation();
 }
 
 static void mk82BootInfoProgramStructure(MK82_BOOT_INFO* address, MK82_BOOT_INFO* dataToProgram)
 {
-    status_t calleeRetVal;
-    uint32_t primask;
-
-    primask = DisableGlobalIRQ();
-
-    calleeRetVal = FLASH_Program(&mk82FlashDriver, (uint32_t)address, (uint32_t*)dataToProgram, sizeof(MK82_BOOT_INFO));
-
-    if (calleeRetVal != kStatus_FLASH_Success)
-    {
-        mk82SystemFatalError();
-    }
-
-    EnableGlobalIRQ(primask);
+    mk82SystemFlashProgram((uint32_t)address, (uint8_t*)dataToProgram, sizeof(MK82_BOOT_INFO));
 }
 
 static void mk82BootInfoSetStructure(MK82_BOOT_INFO* structureToSet, MK82_BOOT_INFO* bootInfo)
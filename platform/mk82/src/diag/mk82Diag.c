@@ -0,0 +1,491 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "mk82Global.h"
+#include "mk82GlobalInt.h"
+#include "mk82System.h"
+#include "mk82Fs.h"
+#include "mk82Diag.h"
+#include "mk82DiagInt.h"
+
+#include "opgpGlobal.h"
+#include "opgpHal.h"
+
+#include <apduGlobal.h>
+#include <apduCore.h>
+
+#include "sha3.h"
+
+#include "fsl_device_registers.h"
+
+/*
+ * The applet answers without any authentication, so it is only built into firmware made for measurements, never into
+ * a release.
+ */
+#ifdef USE_DIAG
+
+static void mk82DiagPutUint32(uint8_t* buffer, uint32_t value);
+
+static void mk82DiagProcessGetFlashWearInfo(APDU_CORE_COMMAND_APDU* commandAPDU,
+                                            APDU_CORE_RESPONSE_APDU* responseAPDU);
+static void mk82DiagProcessGetKeyGenerationInfo(APDU_CORE_COMMAND_APDU* commandAPDU,
+                                                APDU_CORE_RESPONSE_APDU* responseAPDU);
+static void mk82DiagProcessGetInitInfo(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU);
+static void mk82DiagProcessMeasureKeccak(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU);
+
+#ifdef USE_PROFILER
+static void mk82DiagProcessGetProfilerInfo(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU);
+static void mk82DiagProcessStartProfiler(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU);
+static void mk82DiagProcessStopProfiler(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU);
+static void mk82DiagProcessReadProfilerHistogram(APDU_CORE_COMMAND_APDU* commandAPDU,
+                                                 APDU_CORE_RESPONSE_APDU* responseAPDU);
+#endif /* USE_PROFILER */
+
+static void mk82DiagPutUint32(uint8_t* buffer, uint32_t value)
+{
+    buffer[0] = MK82_HIBYTE(MK82_HIWORD(value));
+    buffer[1] = MK82_LOBYTE(MK82_HIWORD(value));
+    buffer[2] = MK82_HIBYTE(MK82_LOWORD(value));
+    buffer[3] = MK82_LOBYTE(MK82_LOWORD(value));
+}
+
+static void mk82DiagProcessGetFlashWearInfo(APDU_CORE_COMMAND_APDU* commandAPDU,
+                                            APDU_CORE_RESPONSE_APDU* responseAPDU)
+{
+    uint16_t sw;
+    MK82_FS_WEAR_INFO wearInfo;
+    uint32_t offset = 0;
+    uint32_t i;
+
+    if (commandAPDU->lcPresent != APDU_FALSE)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    if (commandAPDU->p1p2 != MK82_DIAG_P1P2_GET_FLASH_WEAR_INFO)
+    {
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
+    }
+
+    mk82FsGetWearInfo(&wearInfo);
+
+    for (i = 0; i < MK82_FS_NUMBER_OF_BLOCKS; i++)
+    {
+        mk82DiagPutUint32(&responseAPDU->data[offset], wearInfo.blockEraseCounters[i]);
+        offset += 4;
+    }
+
+    mk82DiagPutUint32(&responseAPDU->data[offset], wearInfo.pageWriteCounter);
+    offset += 4;
+
+    for (i = 0; i <= MK82_FS_NUMBER_OF_FILE_IDS; i++)
+    {
+        mk82DiagPutUint32(&responseAPDU->data[offset], wearInfo.fileCommitCounters[i]);
+        offset += 4;
+    }
+
+    for (i = 0; i <= MK82_FS_NUMBER_OF_FILE_IDS; i++)
+    {
+        mk82DiagPutUint32(&responseAPDU->data[offset], wearInfo.fileEraseCounters[i]);
+        offset += 4;
+    }
+
+    responseAPDU->dataLength = offset;
+
+    sw = APDU_CORE_SW_NO_ERROR;
+
+END:
+    responseAPDU->sw = sw;
+}
+
+static void mk82DiagProcessGetKeyGenerationInfo(APDU_CORE_COMMAND_APDU* commandAPDU,
+                                                APDU_CORE_RESPONSE_APDU* responseAPDU)
+{
+    uint16_t sw;
+    OPGP_HAL_KEY_GENERATION_INFO info;
+
+    if (commandAPDU->lcPresent != APDU_FALSE)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    if (commandAPDU->p1p2 != MK82_DIAG_P1P2_GET_KEY_GENERATION_INFO)
+    {
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
+    }
+
+    opgpHalGetKeyGenerationInfo(&info);
+
+    mk82DiagPutUint32(&responseAPDU->data[0], info.pooledPrimes);
+    mk82DiagPutUint32(&responseAPDU->data[4], info.coldGenerations);
+    mk82DiagPutUint32(&responseAPDU->data[8], info.coldLastTimeInMs);
+    mk82DiagPutUint32(&responseAPDU->data[12], info.coldTotalTimeInMs);
+    mk82DiagPutUint32(&responseAPDU->data[16], info.warmGenerations);
+    mk82DiagPutUint32(&responseAPDU->data[20], info.warmLastTimeInMs);
+    mk82DiagPutUint32(&responseAPDU->data[24], info.warmTotalTimeInMs);
+    mk82DiagPutUint32(&responseAPDU->data[28], info.poolUnwrapFailures);
+
+    responseAPDU->dataLength = MK82_DIAG_KEY_GENERATION_INFO_LENGTH;
+
+    sw = APDU_CORE_SW_NO_ERROR;
+
+END:
+    responseAPDU->sw = sw;
+}
+
+static void mk82DiagProcessGetInitInfo(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU)
+{
+    uint16_t sw;
+    MK82_SYSTEM_INIT_INFO info;
+    uint32_t offset = 0;
+    uint32_t i;
+
+    if (commandAPDU->lcPresent != APDU_FALSE)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    if (commandAPDU->p1p2 != MK82_DIAG_P1P2_GET_INIT_INFO)
+    {
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
+    }
+
+    mk82SystemGetInitInfo(&info);
+
+    mk82DiagPutUint32(&responseAPDU->data[offset], info.completedStages);
+    offset += 4;
+    mk82DiagPutUint32(&responseAPDU->data[offset], info.delayedCommands);
+    offset += 4;
+    mk82DiagPutUint32(&responseAPDU->data[offset], info.firstStageStartTimeInMs);
+    offset += 4;
+    mk82DiagPutUint32(&responseAPDU->data[offset], info.lastStageEndTimeInMs);
+    offset += 4;
+
+    for (i = 0; i < info.completedStages; i++)
+    {
+        mk82DiagPutUint32(&responseAPDU->data[offset], info.stageTimeInUs[i]);
+        offset += 4;
+    }
+
+    responseAPDU->dataLength = offset;
+
+    sw = APDU_CORE_SW_NO_ERROR;
+
+END:
+    responseAPDU->sw = sw;
+}
+
+/*
+ * Counts the core cycles of one Keccak-256 over MK82_DIAG_KECCAK_MESSAGE_LENGTH bytes with the DWT cycle counter.
+ * Interrupts are masked for the measurement, it takes well under a millisecond.
+ */
+static void mk82DiagProcessMeasureKeccak(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU)
+{
+    uint16_t sw;
+    sha3_context context;
+    uint32_t primask;
+    uint32_t startCycles;
+    uint32_t cycles;
+
+    if (commandAPDU->lcPresent != APDU_FALSE)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    if (commandAPDU->p1p2 != MK82_DIAG_P1P2_MEASURE_KECCAK)
+    {
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    primask = DisableGlobalIRQ();
+
+    startCycles = DWT->CYCCNT;
+
+    sha3_Init256(&context);
+    sha3_Update(&context, (void const*)MK82_DIAG_KECCAK_MESSAGE_ADDRESS, MK82_DIAG_KECCAK_MESSAGE_LENGTH);
+    sha3_Finalize(&context);
+
+    cycles = DWT->CYCCNT - startCycles;
+
+    EnableGlobalIRQ(primask);
+
+    mk82DiagPutUint32(&responseAPDU->data[0], MK82_DIAG_KECCAK_MESSAGE_LENGTH);
+    mk82DiagPutUint32(&responseAPDU->data[4], cycles);
+    mk82DiagPutUint32(&responseAPDU->data[8], SystemCoreClock);
+
+    responseAPDU->dataLength = MK82_DIAG_KECCAK_INFO_LENGTH;
+
+    sw = APDU_CORE_SW_NO_ERROR;
+
+END:
+    responseAPDU->sw = sw;
+}
+
+#ifdef USE_PROFILER
+
+static void mk82DiagProcessGetProfilerInfo(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU)
+{
+    uint16_t sw;
+    MK82_SYSTEM_PROFILER_INFO info;
+
+    if (commandAPDU->lcPresent != APDU_FALSE)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    if (commandAPDU->p1p2 != MK82_DIAG_P1P2_GET_PROFILER_INFO)
+    {
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
+    }
+
+    mk82SystemProfilerGetInfo(&info);
+
+    mk82DiagPutUint32(&responseAPDU->data[0], info.samplingRate);
+    mk82DiagPutUint32(&responseAPDU->data[4], info.regionStart);
+    mk82DiagPutUint32(&responseAPDU->data[8], info.bucketSize);
+    mk82DiagPutUint32(&responseAPDU->data[12], info.numberOfBuckets);
+    mk82DiagPutUint32(&responseAPDU->data[16], info.totalSamples);
+    mk82DiagPutUint32(&responseAPDU->data[20], info.outOfRegionSamples);
+
+    if (info.running == MK82_TRUE)
+    {
+        responseAPDU->data[24] = 0x01;
+    }
+    else
+    {
+        responseAPDU->data[24] = 0x00;
+    }
+
+    responseAPDU->dataLength = MK82_DIAG_PROFILER_INFO_LENGTH;
+
+    sw = APDU_CORE_SW_NO_ERROR;
+
+END:
+    responseAPDU->sw = sw;
+}
+
+static void mk82DiagProcessStartProfiler(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU)
+{
+    uint16_t sw;
+    uint32_t samplingRate;
+
+    if (commandAPDU->lcPresent != APDU_TRUE)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    if (commandAPDU->p1p2 != MK82_DIAG_P1P2_START_PROFILER)
+    {
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
+    }
+
+    if (commandAPDU->lc != MK82_DIAG_START_PROFILER_SAMPLING_RATE_LENGTH)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    samplingRate = MK82_MAKEDWORD(MK82_MAKEWORD(commandAPDU->data[3], commandAPDU->data[2]),
+                                  MK82_MAKEWORD(commandAPDU->data[1], commandAPDU->data[0]));
+
+    if ((samplingRate < MK82_SYSTEM_PROFILER_MIN_SAMPLING_RATE) ||
+        (samplingRate > MK82_SYSTEM_PROFILER_MAX_SAMPLING_RATE))
+    {
+        sw = APDU_CORE_SW_WRONG_DATA;
+        goto END;
+    }
+
+    mk82SystemProfilerStart(samplingRate);
+
+    sw = APDU_CORE_SW_NO_ERROR;
+
+END:
+    responseAPDU->sw = sw;
+}
+
+static void mk82DiagProcessStopProfiler(APDU_CORE_COMMAND_APDU* commandAPDU, APDU_CORE_RESPONSE_APDU* responseAPDU)
+{
+    uint16_t sw;
+
+    if (commandAPDU->lcPresent != APDU_FALSE)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    if (commandAPDU->p1p2 != MK82_DIAG_P1P2_STOP_PROFILER)
+    {
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
+    }
+
+    mk82SystemProfilerStop();
+
+    sw = APDU_CORE_SW_NO_ERROR;
+
+END:
+    responseAPDU->sw = sw;
+}
+
+static void mk82DiagProcessReadProfilerHistogram(APDU_CORE_COMMAND_APDU* commandAPDU,
+                                                 APDU_CORE_RESPONSE_APDU* responseAPDU)
+{
+    uint16_t sw;
+    MK82_SYSTEM_PROFILER_INFO info;
+    uint16_t buckets[MK82_DIAG_MAX_BUCKETS_PER_READ];
+    uint32_t numberOfBuckets;
+    uint32_t i;
+
+    if (commandAPDU->lcPresent != APDU_FALSE)
+    {
+        sw = APDU_CORE_SW_WRONG_LENGTH;
+        goto END;
+    }
+
+    mk82SystemProfilerGetInfo(&info);
+
+    if (commandAPDU->p1p2 >= info.numberOfBuckets)
+    {
+        sw = APDU_CORE_SW_WRONG_P1P2;
+        goto END;
+    }
+
+    numberOfBuckets = info.numberOfBuckets - commandAPDU->p1p2;
+
+    if (numberOfBuckets > MK82_DIAG_MAX_BUCKETS_PER_READ)
+    {
+        numberOfBuckets = MK82_DIAG_MAX_BUCKETS_PER_READ;
+    }
+
+    mk82SystemProfilerReadHistogram(commandAPDU->p1p2, buckets, numberOfBuckets);
+
+    for (i = 0; i < numberOfBuckets; i++)
+    {
+        responseAPDU->data[i * 2] = MK82_HIBYTE(buckets[i]);
+        responseAPDU->data[i * 2 + 1] = MK82_LOBYTE(buckets[i]);
+    }
+
+    responseAPDU->dataLength = numberOfBuckets * 2;
+
+    sw = APDU_CORE_SW_NO_ERROR;
+
+END:
+    responseAPDU->sw = sw;
+}
+
+#endif /* USE_PROFILER */
+
+void mk82DiagGetAID(uint8_t* aid, uint32_t* aidLength)
+{
+    uint8_t aidTemplate[] = MK82_DIAG_AID;
+
+    if ((aid == NULL) || (aidLength == NULL))
+    {
+        mk82SystemFatalError();
+    }
+
+    mk82SystemMemCpy(aid, aidTemplate, MK82_DIAG_AID_LENGTH);
+
+    *aidLength = MK82_DIAG_AID_LENGTH;
+}
+
+void mk82DiagProcessAPDU(uint8_t* apdu, uint32_t* apduLength)
+{
+    APDU_CORE_COMMAND_APDU commandAPDU;
+    APDU_CORE_RESPONSE_APDU responseAPDU;
+    uint16_t calleeRetVal = APDU_GENERAL_ERROR;
+
+    if ((apdu == NULL) || (apduLength == NULL))
+    {
+        mk82SystemFatalError();
+    }
+
+    apduCorePrepareResponseAPDUStructure(apdu, &responseAPDU);
+
+    calleeRetVal = apduCoreParseIncomingAPDU(apdu, *apduLength, &commandAPDU);
+
+    if (calleeRetVal != APDU_NO_ERROR)
+    {
+        if (calleeRetVal == APDU_GENERAL_ERROR)
+        {
+            responseAPDU.sw = APDU_CORE_SW_WRONG_LENGTH;
+            goto END;
+        }
+        else
+        {
+            mk82SystemFatalError();
+        }
+    }
+
+    if (commandAPDU.cla != MK82_DIAG_CLA)
+    {
+        responseAPDU.sw = APDU_CORE_SW_CLA_NOT_SUPPORTED;
+        goto END;
+    }
+
+    switch (commandAPDU.ins)
+    {
+#ifdef USE_PROFILER
+        case MK82_DIAG_INS_GET_PROFILER_INFO:
+            mk82DiagProcessGetProfilerInfo(&commandAPDU, &responseAPDU);
+            break;
+        case MK82_DIAG_INS_START_PROFILER:
+            mk82DiagProcessStartProfiler(&commandAPDU, &responseAPDU);
+            break;
+        case MK82_DIAG_INS_STOP_PROFILER:
+            mk82DiagProcessStopProfiler(&commandAPDU, &responseAPDU);
+            break;
+        case MK82_DIAG_INS_READ_PROFILER_HISTOGRAM:
+            mk82DiagProcessReadProfilerHistogram(&commandAPDU, &responseAPDU);
+            break;
+#endif /* USE_PROFILER */
+        case MK82_DIAG_INS_GET_FLASH_WEAR_INFO:
+            mk82DiagProcessGetFlashWearInfo(&commandAPDU, &responseAPDU);
+            break;
+        case MK82_DIAG_INS_GET_KEY_GENERATION_INFO:
+            mk82DiagProcessGetKeyGenerationInfo(&commandAPDU, &responseAPDU);
+            break;
+        case MK82_DIAG_INS_GET_INIT_INFO:
+            mk82DiagProcessGetInitInfo(&commandAPDU, &responseAPDU);
+            break;
+        case MK82_DIAG_INS_MEASURE_KECCAK:
+            mk82DiagProcessMeasureKeccak(&commandAPDU, &responseAPDU);
+            break;
+        default:
+            responseAPDU.sw = APDU_CORE_SW_INS_NOT_SUPPORTED;
+            break;
+    }
+
+END:
+
+    apduCorePrepareOutgoingAPDU(apdu, apduLength, &responseAPDU);
+}
+
+#else
+
+#ifdef USE_PROFILER
+#error The profiler is read out through the diagnostic applet, build it with USE_DIAG
+#endif /* USE_PROFILER */
+
+#endif /* USE_DIAG */
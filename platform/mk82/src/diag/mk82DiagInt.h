@@ -0,0 +1,49 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __MK82_DIAG_INT_H__
+#define __MK82_DIAG_INT_H__
+
+#define MK82_DIAG_CLA (0x80)
+
+#define MK82_DIAG_INS_GET_PROFILER_INFO (0x00)
+#define MK82_DIAG_INS_START_PROFILER (0x01)
+#define MK82_DIAG_INS_STOP_PROFILER (0x02)
+#define MK82_DIAG_INS_READ_PROFILER_HISTOGRAM (0x03)
+#define MK82_DIAG_INS_GET_FLASH_WEAR_INFO (0x04)
+#define MK82_DIAG_INS_GET_KEY_GENERATION_INFO (0x05)
+#define MK82_DIAG_INS_GET_INIT_INFO (0x06)
+#define MK82_DIAG_INS_MEASURE_KECCAK (0x07)
+
+#define MK82_DIAG_P1P2_GET_PROFILER_INFO (0x0000)
+#define MK82_DIAG_P1P2_START_PROFILER (0x0000)
+#define MK82_DIAG_P1P2_STOP_PROFILER (0x0000)
+#define MK82_DIAG_P1P2_GET_FLASH_WEAR_INFO (0x0000)
+#define MK82_DIAG_P1P2_GET_KEY_GENERATION_INFO (0x0000)
+#define MK82_DIAG_P1P2_GET_INIT_INFO (0x0000)
+#define MK82_DIAG_P1P2_MEASURE_KECCAK (0x0000)
+
+#define MK82_DIAG_START_PROFILER_SAMPLING_RATE_LENGTH (4)
+
+#define MK82_DIAG_PROFILER_INFO_LENGTH (25)
+#define MK82_DIAG_MAX_BUCKETS_PER_READ (120)
+#define MK82_DIAG_KEY_GENERATION_INFO_LENGTH (32)
+#define MK82_DIAG_KECCAK_INFO_LENGTH (12)
+
+/* Eight blocks of Keccak-256, read from the firmware code so that no RAM buffer is needed */
+#define MK82_DIAG_KECCAK_MESSAGE_ADDRESS (MK82_FLASH_FIRMWARE_START)
+#define MK82_DIAG_KECCAK_MESSAGE_LENGTH (8 * 136)
+
+#define MK82_DIAG_AID                                              \
+    {                                                              \
+        0x44, 0x49, 0x41, 0x47, 0x41, 0x50, 0x50, 0x4C, 0x45, 0x54 \
+    }
+#define MK82_DIAG_AID_LENGTH (0x0A)
+
+#endif /* __MK82_DIAG_INT_H__ */
@@ -23,18 +23,22 @@
 #include "uffs/uffs_core.h"
 #include "uffs/uffs_mtb.h"
 #include "uffs/uffs_fd.h"
+#include "uffs/uffs_crc.h"
+#include "uffs/uffs_buf.h"
 
 #include "stddef.h"
 
+#if !defined(USE_RECORD_STORE)
+
 static struct uffs_StorageAttrSt mk82FsFlashStorage;
 static uffs_Device mk82FsDevice;
 
-static struct uffs_MountTableEntrySt mk82FsMountTable = {&mk82FsDevice, 0, (MK82_FS_TOTAL_BLOCKS - 1), "/", NULL};
+static struct uffs_MountTableEntrySt mk82FsMountTable = {&mk82FsDevice, 0, (MK82_FS_TOTAL_BLOCKS - 1), "/", NULL, NULL};
 
 static int
     mk82FsStaticMemoryPool[UFFS_STATIC_BUFF_SIZE(MK82_FS_PAGES_PER_BLOCK, MK82_FS_PAGE_SIZE, MK82_FS_TOTAL_BLOCKS) /
                            sizeof(int)];
-static uint8_t mk82FsPageBuffer[MK82_FS_PAGE_SIZE];
+static uint8_t MK82_ALIGN(4) mk82FsPageBuffer[MK82_FS_PAGE_SIZE];
 
 static void mk82FsFatalError(void);
 static int mk82FsReadPage(uffs_Device *dev, u32 block, u32 page, u8 *data, int data_len, u8 *ecc, u8 *spare,
@@ -42,18 +46,48 @@ static int mk82FsReadPage(uffs_Device *dev, u32 block, u32 page, u8 *data, int d
 static int mk82FsWritePage(uffs_Device *dev, u32 block, u32 page, const u8 *data, int data_len, const u8 *spare,
                            int spare_len);
 static int mk82FsEraseBlock(uffs_Device *dev, u32 block);
+static void mk82FsCompletePendingErase(uint32_t index);
+static void mk82FsCompletePendingEraseOfBlock(uint32_t block);
+static uint32_t mk82FsGetBlockOwner(uffs_Device *dev, uint32_t block);
+static int mk82FsMarkBadBlock(uffs_Device *dev, u32 block);
 static int mk82FsInitFlash(uffs_Device *dev);
 static int mk82FsReleaseFlash(uffs_Device *dev);
 static URET mk82FsInitDevice(uffs_Device *dev);
 static URET mk82FsReleaseDevice(uffs_Device *dev);
 static int mk82FsCheckErasedBlock(uffs_Device *dev, u32 block);
 
-static void mk82FsGetFileHandleAndOffset(uint8_t fileID, int *fileHandle, uint32_t *fileOffset);
-
 static int mk82FsCountersFileHandle;
 static int mk82FsCertificatesFileHandle;
 static int mk82FsKeysFileHandle;
 static int mk82FsDataFileHandle;
+static int mk82FsJournalFileHandle;
+
+/* Indexed by MK82_FS_FILE_xxx */
+static int *const mk82FsFileHandles[MK82_FS_NUMBER_OF_FILES] = {
+    &mk82FsCountersFileHandle, &mk82FsCertificatesFileHandle, &mk82FsKeysFileHandle, &mk82FsDataFileHandle};
+
+static MK82_FS_WEAR_INFO mk82FsWearInfo;
+static uint8_t mk82FsCurrentFileID = MK82_FS_FILE_ID_NONE;
+static uint32_t mk82FsUnsavedErases;
+static MK82_FS_PENDING_ERASE mk82FsPendingErase[MK82_FS_MAX_PENDING_ERASES];
+static uint32_t mk82FsPendingErases = 0;
+
+/* Pages whose data mk82FsMapPage has checked, a page is checked again after it is programmed or erased */
+static uint32_t mk82FsCheckedPages[MK82_FS_CHECKED_PAGE_WORDS];
+
+static void mk82FsLoadWearInfo(void);
+static void mk82FsSaveWearInfo(void);
+
+static uint8_t mk82FsTransactionBuffer[MK82_FS_TRANSACTION_BUFFER_SIZE];
+static uint32_t mk82FsTransactionLength;
+static uint16_t mk82FsTransactionActive = MK82_FALSE;
+
+static void mk82FsOpenJournal(void);
+static void mk82FsWriteJournal(uint16_t committed, uint8_t *data, uint32_t dataLength);
+static void mk82FsRecoverJournal(void);
+static void mk82FsApplyTransaction(uint8_t *records, uint32_t recordsLength);
+static void mk82FsReadStagedWrites(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length);
+static const uint8_t *mk82FsMapPage(uint32_t block, uint32_t page);
 
 static uffs_FlashOps mk82FsFunctionPointers = {mk82FsInitFlash,     // InitFlash()
                                                mk82FsReleaseFlash,  // ReleaseFlash()
@@ -62,7 +96,7 @@ static uffs_FlashOps mk82FsFunctionPointers = {mk82FsInitFlash,     // InitFlash
                                                mk82FsWritePage,     // WritePage()
                                                NULL,                // WirtePageWithLayout
                                                NULL,                // IsBadBlock(), let UFFS take care of it.
-                                               NULL,                // MarkBadBlock(), let UFFS take care of it.
+                                               mk82FsMarkBadBlock,  // MarkBadBlock()
                                                mk82FsEraseBlock,    // EraseBlock()
                                                mk82FsCheckErasedBlock};
 
@@ -75,6 +109,16 @@ static int mk82FsReadPage(uffs_Device *dev, u32 block, u32 page, u8 *data, int d
 {
     int ret = UFFS_FLASH_NO_ERR;
 
+    (void)dev;
+    (void)ecc;
+
+    if ((block >= MK82_FS_TOTAL_BLOCKS) || (page >= MK82_FS_PAGES_PER_BLOCK))
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsCompletePendingEraseOfBlock(block);
+
     if (data && data_len > 0)
     {
         uint32_t flashAddress;
@@ -116,7 +160,15 @@ static int mk82FsWritePage(uffs_Device *dev, u32 block, u32 page, const u8 *data
                            int spare_len)
 {
     int ret = UFFS_FLASH_NO_ERR;
-    uint32_t primask;
+
+    (void)dev;
+
+    if ((block >= MK82_FS_TOTAL_BLOCKS) || (page >= MK82_FS_PAGES_PER_BLOCK))
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsCompletePendingEraseOfBlock(block);
 
     if (data && data_len > 0 && spare && spare_len > 0)
     {
@@ -136,18 +188,15 @@ static int mk82FsWritePage(uffs_Device *dev, u32 block, u32 page, const u8 *data
             mk82FsFatalError();
         }
 
+        MK82_FS_CLEAR_PAGE_CHECKED(mk82FsCheckedPages, block * MK82_FS_PAGES_PER_BLOCK + page);
+
         mk82SystemMemSet(mk82FsPageBuffer, 0x00, sizeof(mk82FsPageBuffer));
         mk82SystemMemCpy(mk82FsPageBuffer, (uint8_t *)data, data_len);
         mk82SystemMemCpy(mk82FsPageBuffer + MK82_FS_PAGE_DATA_SIZE, (uint8_t *)spare, spare_len);
 
-        primask = DisableGlobalIRQ();
+        mk82SystemFlashProgram(flashAddress, mk82FsPageBuffer, MK82_FS_PAGE_SIZE);
 
-        result = FLASH_Program(&mk82FlashDriver, flashAddress, (uint32_t *)mk82FsPageBuffer, MK82_FS_PAGE_SIZE);
-
-        if (kStatus_FLASH_Success != result)
-        {
-            mk82FsFatalError();
-        }
+        mk82SystemFlashBeginOperation();
 
         result = FLASH_VerifyProgram(&mk82FlashDriver, flashAddress, MK82_FS_PAGE_SIZE, (uint32_t *)mk82FsPageBuffer,
                                      kFLASH_marginValueUser, &failAddr, &failDat);
@@ -157,7 +206,9 @@ static int mk82FsWritePage(uffs_Device *dev, u32 block, u32 page, const u8 *data
             mk82FsFatalError();
         }
 
-        EnableGlobalIRQ(primask);
+        mk82SystemFlashEndOperation();
+
+        mk82FsWearInfo.pageWriteCounter++;
     }
     else
     {
@@ -167,16 +218,25 @@ static int mk82FsWritePage(uffs_Device *dev, u32 block, u32 page, const u8 *data
     return ret;
 }
 
-static int mk82FsEraseBlock(uffs_Device *dev, u32 block)
+static void mk82FsCompletePendingErase(uint32_t index)
 {
-    int ret = UFFS_FLASH_NO_ERR;
     uint32_t flashAddress;
     status_t result;
-    uint32_t primask;
+    uint32_t i;
 
-    flashAddress = MK82_FLASH_FILE_SYSTEM_START + (block * MK82_FS_BLOCK_SIZE);
+    if (index >= mk82FsPendingErases)
+    {
+        mk82FsFatalError();
+    }
+
+    flashAddress = MK82_FLASH_FILE_SYSTEM_START + (mk82FsPendingErase[index].block * MK82_FS_BLOCK_SIZE);
+
+    for (i = 0; i < MK82_FS_PAGES_PER_BLOCK; i++)
+    {
+        MK82_FS_CLEAR_PAGE_CHECKED(mk82FsCheckedPages, mk82FsPendingErase[index].block * MK82_FS_PAGES_PER_BLOCK + i);
+    }
 
-    primask = DisableGlobalIRQ();
+    mk82SystemFlashBeginOperation();
 
     result = FLASH_Erase(&mk82FlashDriver, flashAddress, MK82_FS_BLOCK_SIZE, kFLASH_apiEraseKey);
     if (kStatus_FLASH_Success != result)
@@ -192,21 +252,123 @@ static int mk82FsEraseBlock(uffs_Device *dev, u32 block)
         mk82FsFatalError();
     }
 
-    EnableGlobalIRQ(primask);
+    mk82SystemFlashEndOperation();
+
+    for (i = index + 1; i < mk82FsPendingErases; i++)
+    {
+        mk82FsPendingErase[i - 1] = mk82FsPendingErase[i];
+    }
+
+    mk82FsPendingErases--;
+}
+
+static void mk82FsCompletePendingEraseOfBlock(uint32_t block)
+{
+    uint32_t i;
+
+    for (i = 0; i < mk82FsPendingErases; i++)
+    {
+        if (mk82FsPendingErase[i].block == block)
+        {
+            mk82FsCompletePendingErase(i);
+            return;
+        }
+    }
+}
+
+/* The UFFS object a block belongs to, going by the tag of its first page */
+static uint32_t mk82FsGetBlockOwner(uffs_Device *dev, uint32_t block)
+{
+    uffs_TagStore tagStore;
+    uint32_t firstWord;
+
+    uffs_FlashUnloadSpare(dev,
+                          (uint8_t *)(MK82_FLASH_FILE_SYSTEM_START + (block * MK82_FS_BLOCK_SIZE) +
+                                      MK82_FS_PAGE_DATA_SIZE),
+                          &tagStore, NULL);
+
+    mk82SystemMemCpy((uint8_t *)&firstWord, (uint8_t *)&tagStore, sizeof(firstWord));
+
+    if (firstWord == 0xFFFFFFFF)
+    {
+        return MK82_FS_BLOCK_OWNER_NONE;
+    }
+
+    return ((uint32_t)tagStore.type << 24) | ((uint32_t)tagStore.parent << 14) | tagStore.serial;
+}
+
+/*
+ * UFFS only writes to an erased block after taking it off the erased list, so the erase itself is left to
+ * mk82FsIdleTask. Any access to the block before that erases it first.
+ *
+ * A block waiting for its erase may still hold an older copy of an object in use, and a mount after a reset picks
+ * the newer of two copies by their time stamps. That only works for two, so a block is never left waiting while
+ * another one of the same object is.
+ */
+static int mk82FsEraseBlock(uffs_Device *dev, u32 block)
+{
+    int ret = UFFS_FLASH_NO_ERR;
+    uint32_t owner;
+    uint32_t i;
+
+    if (block >= MK82_FS_TOTAL_BLOCKS)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsCompletePendingEraseOfBlock(block);
+
+    owner = mk82FsGetBlockOwner(dev, block);
+
+    for (i = 0; (owner != MK82_FS_BLOCK_OWNER_NONE) && (i < mk82FsPendingErases); i++)
+    {
+        if (mk82FsPendingErase[i].owner == owner)
+        {
+            mk82FsCompletePendingErase(i);
+            break;
+        }
+    }
+
+    if (mk82FsPendingErases >= MK82_FS_MAX_PENDING_ERASES)
+    {
+        mk82FsCompletePendingErase(0);
+    }
+
+    mk82FsPendingErase[mk82FsPendingErases].block = block;
+    mk82FsPendingErase[mk82FsPendingErases].owner = owner;
+    mk82FsPendingErases++;
+
+    mk82FsWearInfo.blockEraseCounters[block]++;
+    mk82FsWearInfo.fileEraseCounters[mk82FsCurrentFileID]++;
+    mk82FsUnsavedErases++;
 
     return ret;
 }
 
+/*
+ * UFFS marks a block bad when it finds a page that fails its CRC, which on this flash only happens after a power loss
+ * during programming. Program flash has no bad blocks, so just erase it and let it be reused after the next mount.
+ */
+static int mk82FsMarkBadBlock(uffs_Device *dev, u32 block) { return mk82FsEraseBlock(dev, block); }
+
 static int mk82FsCheckErasedBlock(uffs_Device *dev, u32 block)
 {
     int ret = UFFS_FLASH_NO_ERR;
     uint32_t flashAddress;
     status_t result;
-    uint32_t primask;
+
+    (void)dev;
+
+    if (block >= MK82_FS_TOTAL_BLOCKS)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsCompletePendingEraseOfBlock(block);
 
     flashAddress = MK82_FLASH_FILE_SYSTEM_START + (block * MK82_FS_BLOCK_SIZE);
 
-    primask = DisableGlobalIRQ();
+    mk82SystemFlashBeginOperation();
 
     /* Verify sector if it's been erased. */
     result = FLASH_VerifyErase(&mk82FlashDriver, flashAddress, MK82_FS_BLOCK_SIZE, kFLASH_marginValueUser);
@@ -216,7 +378,7 @@ static int mk82FsCheckErasedBlock(uffs_Device *dev, u32 block)
         ret = -1;
     }
 
-    EnableGlobalIRQ(primask);
+    mk82SystemFlashEndOperation();
 
     return ret;
 }
@@ -225,6 +387,8 @@ static int mk82FsInitFlash(uffs_Device *dev)
 {
     int ret = UFFS_FLASH_NO_ERR;
 
+    (void)dev;
+
     return ret;
 }
 
@@ -232,6 +396,8 @@ static int mk82FsReleaseFlash(uffs_Device *dev)
 {
     int ret = UFFS_FLASH_NO_ERR;
 
+    (void)dev;
+
     return ret;
 }
 
@@ -244,7 +410,12 @@ static URET mk82FsInitDevice(uffs_Device *dev)
     return U_SUCC;
 }
 
-static URET mk82FsReleaseDevice(uffs_Device *dev) { return U_SUCC; }
+static URET mk82FsReleaseDevice(uffs_Device *dev)
+{
+    (void)dev;
+
+    return U_SUCC;
+}
 
 static void mk82FsOpenAndCheckAllFiles(void)
 {
@@ -275,185 +446,669 @@ static void mk82FsOpenAndCheckAllFiles(void)
     {
         mk82FsFatalError();
     }
+
+    mk82FsOpenJournal();
 }
 
-static void mk82FsGetFileHandleAndOffset(uint8_t fileID, int *fileHandle, uint32_t *fileOffset)
+static void mk82FsOpenJournal(void)
 {
-    if (fileID == MK82_FS_FILE_ID_OPGP_COUNTERS)
+    MK82_FS_JOURNAL journal;
+    int calleeRetVal;
+
+    mk82FsJournalFileHandle = uffs_open("/5", UO_RDWR);
+
+    if (mk82FsJournalFileHandle >= 0)
     {
-        *fileHandle = mk82FsCountersFileHandle;
-        *fileOffset = offsetof(MK82_FS_COUNTERS, opgpCounters);
+        return;
     }
-    else if (fileID == MK82_FS_FILE_ID_OPGP_CERTIFICATES)
+
+    /* File systems created before transactions were introduced have no journal yet */
+    mk82FsJournalFileHandle = uffs_open("/5", UO_RDWR | UO_CREATE);
+
+    if (mk82FsJournalFileHandle < 0)
     {
-        *fileHandle = mk82FsCertificatesFileHandle;
-        *fileOffset = offsetof(MK82_FS_CERTIFICATES, opgpCertificates);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_OPGP_KEYS)
+
+    mk82SystemMemSet((uint8_t *)&journal, 0x00, sizeof(journal));
+
+    calleeRetVal = uffs_write(mk82FsJournalFileHandle, &journal, sizeof(journal));
+
+    if (calleeRetVal != sizeof(journal))
     {
-        *fileHandle = mk82FsKeysFileHandle;
-        *fileOffset = offsetof(MK82_FS_KEYS, opgpKeys);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_OPGP_DATA)
+
+    calleeRetVal = uffs_flush(mk82FsJournalFileHandle);
+
+    if (calleeRetVal < 0)
     {
-        *fileHandle = mk82FsDataFileHandle;
-        *fileOffset = offsetof(MK82_FS_DATA, opgpData);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_SF_COUNTERS)
+}
+
+void mk82FsReadFile(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+{
+    int calleeRetVal;
+    const MK82_FS_FILE_DESCRIPTOR *descriptor;
+    int fileHandle;
+    uint32_t fileOffset;
+
+    if (buffer == NULL)
     {
-        *fileHandle = mk82FsCountersFileHandle;
-        *fileOffset = offsetof(MK82_FS_COUNTERS, sfCounters);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_KEYSAFE_DATA)
+
+    descriptor = mk82FsGetFileDescriptor(fileID, offset, length);
+    fileHandle = *mk82FsFileHandles[descriptor->file];
+    fileOffset = descriptor->offset;
+
+    offset += fileOffset;
+
+    calleeRetVal = uffs_seek(fileHandle, offset, USEEK_SET);
+
+    if ((uint32_t)calleeRetVal != offset)
     {
-        *fileHandle = mk82FsDataFileHandle;
-        *fileOffset = offsetof(MK82_FS_DATA, keysafeData);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_OTP_COUNTERS)
+
+    calleeRetVal = uffs_read(fileHandle, buffer, length);
+
+    if ((uint32_t)calleeRetVal != length)
     {
-        *fileHandle = mk82FsCountersFileHandle;
-        *fileOffset = offsetof(MK82_FS_COUNTERS, otpCounters);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_OTP_KEYS)
+
+    if (mk82FsTransactionActive == MK82_TRUE)
     {
-        *fileHandle = mk82FsKeysFileHandle;
-        *fileOffset = offsetof(MK82_FS_KEYS, otpKeys);
+        mk82FsReadStagedWrites(fileID, offset - fileOffset, buffer, length);
     }
-    else if (fileID == MK82_FS_FILE_ID_OTP_DATA)
+}
+
+/*
+ * The page data as UFFS would load it into a page buffer. It is checked against the CRC in its mini header the first
+ * time it is mapped, the page can only change after that by being programmed or erased through the driver.
+ */
+static const uint8_t *mk82FsMapPage(uint32_t block, uint32_t page)
+{
+    const uint8_t *pageAddress;
+    const struct uffs_MiniHeaderSt *header;
+    uint32_t pageNumber;
+
+    if ((block >= MK82_FS_TOTAL_BLOCKS) || (page >= MK82_FS_PAGES_PER_BLOCK))
     {
-        *fileHandle = mk82FsDataFileHandle;
-        *fileOffset = offsetof(MK82_FS_DATA, otpData);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_BTC_COUNTERS)
+
+    pageNumber = block * MK82_FS_PAGES_PER_BLOCK + page;
+    pageAddress =
+        (const uint8_t *)(MK82_FLASH_FILE_SYSTEM_START + (block * MK82_FS_BLOCK_SIZE) + (page * MK82_FS_PAGE_SIZE));
+
+    if (!MK82_FS_IS_PAGE_CHECKED(mk82FsCheckedPages, pageNumber))
     {
-        *fileHandle = mk82FsCountersFileHandle;
-        *fileOffset = offsetof(MK82_FS_COUNTERS, btcCounters);
+        header = (const struct uffs_MiniHeaderSt *)pageAddress;
+
+        if (header->crc != uffs_crc16sum(&pageAddress[MK82_FS_INTERNAL_INFO_PER_PAGE], MK82_FS_FILE_PAGE_SIZE))
+        {
+            mk82FsFatalError();
+        }
+
+        MK82_FS_SET_PAGE_CHECKED(mk82FsCheckedPages, pageNumber);
     }
-    else if (fileID == MK82_FS_FILE_ID_BTC_KEYS)
+
+    return &pageAddress[MK82_FS_INTERNAL_INFO_PER_PAGE];
+}
+
+/*
+ * Returns where the data of a file ID lives instead of copying it: one extent per UFFS page, pointing at the flash
+ * page or at the page buffer that caches it. Maps as much of the range as fits in the extents and returns its length,
+ * the caller goes on from there. The extents stay valid until the next call into the file system.
+ */
+uint32_t mk82FsMapFile(uint8_t fileID, uint32_t offset, uint32_t length, MK82_FS_EXTENT *extents,
+                       uint32_t maxExtents, uint32_t *numberOfExtents)
+{
+    int calleeRetVal;
+    const MK82_FS_FILE_DESCRIPTOR *descriptor;
+    int fileHandle;
+    uint32_t mappedLength = 0;
+    uint32_t extentCount = 0;
+
+    if ((extents == NULL) || (numberOfExtents == NULL) || (maxExtents == 0))
     {
-        *fileHandle = mk82FsKeysFileHandle;
-        *fileOffset = offsetof(MK82_FS_KEYS, btcKeys);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_BTC_DATA)
+
+    /* Staged writes are not in the pages yet */
+    if (mk82FsTransactionActive == MK82_TRUE)
     {
-        *fileHandle = mk82FsDataFileHandle;
-        *fileOffset = offsetof(MK82_FS_DATA, btcData);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_ETH_COUNTERS)
+
+    descriptor = mk82FsGetFileDescriptor(fileID, offset, length);
+    fileHandle = *mk82FsFileHandles[descriptor->file];
+
+    offset += descriptor->offset;
+
+    calleeRetVal = uffs_seek(fileHandle, offset, USEEK_SET);
+
+    if ((uint32_t)calleeRetVal != offset)
     {
-        *fileHandle = mk82FsCountersFileHandle;
-        *fileOffset = offsetof(MK82_FS_COUNTERS, ethCounters);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_ETH_KEYS)
+
+    while ((mappedLength < length) && (extentCount < maxExtents))
     {
-        *fileHandle = mk82FsKeysFileHandle;
-        *fileOffset = offsetof(MK82_FS_KEYS, ethKeys);
+        uffs_Buf *buf;
+        u16 block;
+        u16 page;
+        u32 pageOffset;
+        uint32_t extentLength;
+
+        calleeRetVal = uffs_locate(fileHandle, &buf, &block, &page, &pageOffset);
+
+        if (calleeRetVal <= 0)
+        {
+            mk82FsFatalError();
+        }
+
+        if (buf != NULL)
+        {
+            extents[extentCount].data = &buf->data[pageOffset];
+        }
+        else
+        {
+            extents[extentCount].data = &mk82FsMapPage(block, page)[pageOffset];
+        }
+
+        extentLength = calleeRetVal;
+
+        if (extentLength > (length - mappedLength))
+        {
+            extentLength = length - mappedLength;
+        }
+
+        extents[extentCount].length = extentLength;
+
+        mappedLength += extentLength;
+        extentCount++;
     }
-    else if (fileID == MK82_FS_FILE_ID_ETH_DATA)
+
+    *numberOfExtents = extentCount;
+
+    return mappedLength;
+}
+
+void mk82FsWriteFile(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+{
+    int calleeRetVal;
+    const MK82_FS_FILE_DESCRIPTOR *descriptor;
+    int fileHandle;
+    uint32_t fileOffset;
+
+    if (buffer == NULL)
     {
-        *fileHandle = mk82FsDataFileHandle;
-        *fileOffset = offsetof(MK82_FS_DATA, ethData);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_SSL_KEYS)
+
+    descriptor = mk82FsGetFileDescriptor(fileID, offset, length);
+    fileHandle = *mk82FsFileHandles[descriptor->file];
+    fileOffset = descriptor->offset;
+
+    if (mk82FsTransactionActive == MK82_TRUE)
     {
-        *fileHandle = mk82FsKeysFileHandle;
-        *fileOffset = offsetof(MK82_FS_KEYS, sslKeys);
+        uint8_t *record;
+
+        if ((length > MK82_FS_TRANSACTION_BUFFER_SIZE) ||
+            ((mk82FsTransactionLength + MK82_FS_TRANSACTION_RECORD_HEADER_SIZE + length) >
+             MK82_FS_TRANSACTION_BUFFER_SIZE))
+        {
+            mk82FsFatalError();
+        }
+
+        record = &mk82FsTransactionBuffer[mk82FsTransactionLength];
+
+        record[0] = fileID;
+        record[1] = MK82_LOBYTE(offset);
+        record[2] = MK82_HIBYTE(offset);
+        record[3] = MK82_LOBYTE(length);
+        record[4] = MK82_HIBYTE(length);
+        mk82SystemMemCpy(&record[MK82_FS_TRANSACTION_RECORD_HEADER_SIZE], buffer, length);
+
+        mk82FsTransactionLength += MK82_FS_TRANSACTION_RECORD_HEADER_SIZE + length;
+
+        return;
     }
-    else if (fileID == MK82_FS_FILE_ID_XRP_COUNTERS)
+
+    offset += fileOffset;
+
+    calleeRetVal = uffs_seek(fileHandle, offset, USEEK_SET);
+
+    if ((uint32_t)calleeRetVal != offset)
     {
-        *fileHandle = mk82FsCountersFileHandle;
-        *fileOffset = offsetof(MK82_FS_COUNTERS, xrpCounters);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_XRP_KEYS)
+
+    mk82FsCurrentFileID = fileID;
+
+    calleeRetVal = uffs_write(fileHandle, buffer, length);
+
+    mk82FsCurrentFileID = MK82_FS_FILE_ID_NONE;
+
+    if (calleeRetVal < 0)
     {
-        *fileHandle = mk82FsKeysFileHandle;
-        *fileOffset = offsetof(MK82_FS_KEYS, xrpKeys);
+        mk82FsFatalError();
     }
-    else if (fileID == MK82_FS_FILE_ID_XRP_DATA)
+}
+
+void mk82FsCommitWrite(uint8_t fileID)
+{
+    int calleeRetVal;
+    int fileHandle;
+
+    fileHandle = *mk82FsFileHandles[mk82FsGetFileDescriptor(fileID, 0, 0)->file];
+
+    if (mk82FsTransactionActive == MK82_TRUE)
     {
-        *fileHandle = mk82FsDataFileHandle;
-        *fileOffset = offsetof(MK82_FS_DATA, xrpData);
+        /* Applied by mk82FsCommitTransaction */
+        return;
     }
-    else
+
+    mk82FsCurrentFileID = fileID;
+
+    calleeRetVal = uffs_flush(fileHandle);
+
+    mk82FsCurrentFileID = MK82_FS_FILE_ID_NONE;
+
+    if (calleeRetVal < 0)
     {
         mk82FsFatalError();
     }
+
+    mk82FsWearInfo.fileCommitCounters[fileID]++;
+
+    if (mk82FsUnsavedErases >= MK82_FS_WEAR_SAVE_LIMIT)
+    {
+        mk82FsSaveWearInfo();
+    }
 }
 
-void mk82FsReadFile(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+static void mk82FsReadStagedWrites(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
 {
+    uint32_t position = 0;
+
+    while (position < mk82FsTransactionLength)
+    {
+        uint8_t *record = &mk82FsTransactionBuffer[position];
+        uint32_t recordOffset = MK82_MAKEWORD(record[1], record[2]);
+        uint32_t recordLength = MK82_MAKEWORD(record[3], record[4]);
+        uint8_t *recordData = &record[MK82_FS_TRANSACTION_RECORD_HEADER_SIZE];
+
+        position += MK82_FS_TRANSACTION_RECORD_HEADER_SIZE + recordLength;
+
+        if ((record[0] != fileID) || (recordOffset >= (offset + length)) ||
+            ((recordOffset + recordLength) <= offset))
+        {
+            continue;
+        }
+
+        if (recordOffset < offset)
+        {
+            recordData += offset - recordOffset;
+            recordLength -= offset - recordOffset;
+            recordOffset = offset;
+        }
+
+        if ((recordOffset + recordLength) > (offset + length))
+        {
+            recordLength = offset + length - recordOffset;
+        }
+
+        mk82SystemMemCpy(&buffer[recordOffset - offset], recordData, recordLength);
+    }
+}
+
+static void mk82FsApplyTransaction(uint8_t *records, uint32_t recordsLength)
+{
+    int fileHandles[MK82_FS_MAX_FILES_PER_TRANSACTION];
+    uint8_t fileIDs[MK82_FS_MAX_FILES_PER_TRANSACTION];
+    uint32_t numberOfFiles = 0;
+    uint32_t committedFileIDs = 0;
+    uint32_t position = 0;
     int calleeRetVal;
-    int fileHandle;
-    uint32_t fileOffset;
+    uint32_t i;
 
-    if (buffer == NULL)
+    while (position < recordsLength)
     {
-        mk82FsFatalError();
+        uint8_t *record = &records[position];
+        uint32_t recordOffset;
+        uint32_t recordLength;
+        const MK82_FS_FILE_DESCRIPTOR *descriptor;
+        int fileHandle;
+        uint32_t fileOffset;
+
+        if ((position + MK82_FS_TRANSACTION_RECORD_HEADER_SIZE) > recordsLength)
+        {
+            mk82FsFatalError();
+        }
+
+        recordOffset = MK82_MAKEWORD(record[1], record[2]);
+        recordLength = MK82_MAKEWORD(record[3], record[4]);
+
+        position += MK82_FS_TRANSACTION_RECORD_HEADER_SIZE + recordLength;
+
+        if (position > recordsLength)
+        {
+            mk82FsFatalError();
+        }
+
+        descriptor = mk82FsGetFileDescriptor(record[0], recordOffset, recordLength);
+        fileHandle = *mk82FsFileHandles[descriptor->file];
+        fileOffset = descriptor->offset;
+
+        for (i = 0; i < numberOfFiles; i++)
+        {
+            if (fileHandles[i] == fileHandle)
+            {
+                break;
+            }
+        }
+
+        if (i == numberOfFiles)
+        {
+            if (numberOfFiles == MK82_FS_MAX_FILES_PER_TRANSACTION)
+            {
+                mk82FsFatalError();
+            }
+
+            fileHandles[numberOfFiles] = fileHandle;
+            fileIDs[numberOfFiles] = record[0];
+            numberOfFiles++;
+        }
+
+        committedFileIDs |= (1UL << record[0]);
+
+        calleeRetVal = uffs_seek(fileHandle, fileOffset + recordOffset, USEEK_SET);
+
+        if ((uint32_t)calleeRetVal != (fileOffset + recordOffset))
+        {
+            mk82FsFatalError();
+        }
+
+        mk82FsCurrentFileID = record[0];
+
+        calleeRetVal = uffs_write(fileHandle, &record[MK82_FS_TRANSACTION_RECORD_HEADER_SIZE], recordLength);
+
+        mk82FsCurrentFileID = MK82_FS_FILE_ID_NONE;
+
+        if (calleeRetVal < 0)
+        {
+            mk82FsFatalError();
+        }
     }
 
-    mk82FsGetFileHandleAndOffset(fileID, &fileHandle, &fileOffset);
+    /* One flush per file, each of which rewrites every touched page once */
+    for (i = 0; i < numberOfFiles; i++)
+    {
+        mk82FsCurrentFileID = fileIDs[i];
 
-    offset += fileOffset;
+        calleeRetVal = uffs_flush(fileHandles[i]);
 
-    calleeRetVal = uffs_seek(fileHandle, offset, USEEK_SET);
+        mk82FsCurrentFileID = MK82_FS_FILE_ID_NONE;
+
+        if (calleeRetVal < 0)
+        {
+            mk82FsFatalError();
+        }
+    }
 
-    if (calleeRetVal != offset)
+    for (i = 0; i <= MK82_FS_NUMBER_OF_FILE_IDS; i++)
+    {
+        if ((committedFileIDs & (1UL << i)) != 0)
+        {
+            mk82FsWearInfo.fileCommitCounters[i]++;
+        }
+    }
+}
+
+static void mk82FsWriteJournal(uint16_t committed, uint8_t *data, uint32_t dataLength)
+{
+    MK82_FS_JOURNAL journal;
+    uint32_t length;
+    int calleeRetVal;
+
+    journal.committed = committed;
+    journal.dataLength = 0;
+    journal.crc = 0;
+
+    length = offsetof(MK82_FS_JOURNAL, data);
+
+    if (data != NULL)
+    {
+        journal.dataLength = dataLength;
+        journal.crc = uffs_crc16sum(data, dataLength);
+        mk82SystemMemCpy(journal.data, data, dataLength);
+        length += dataLength;
+    }
+
+    calleeRetVal = uffs_seek(mk82FsJournalFileHandle, 0, USEEK_SET);
+
+    if (calleeRetVal != 0)
     {
         mk82FsFatalError();
     }
 
-    calleeRetVal = uffs_read(fileHandle, buffer, length);
+    calleeRetVal = uffs_write(mk82FsJournalFileHandle, &journal, length);
 
-    if (calleeRetVal != length)
+    if ((uint32_t)calleeRetVal != length)
     {
         mk82FsFatalError();
     }
+
+    calleeRetVal = uffs_flush(mk82FsJournalFileHandle);
+
+    if (calleeRetVal < 0)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82SystemMemSet((uint8_t *)&journal, 0x00, sizeof(journal));
 }
 
-void mk82FsWriteFile(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+static void mk82FsRecoverJournal(void)
 {
+    MK82_FS_JOURNAL journal;
     int calleeRetVal;
+
+    calleeRetVal = uffs_seek(mk82FsJournalFileHandle, 0, USEEK_SET);
+
+    if (calleeRetVal != 0)
+    {
+        mk82FsFatalError();
+    }
+
+    calleeRetVal = uffs_read(mk82FsJournalFileHandle, &journal, sizeof(journal));
+
+    if (calleeRetVal != sizeof(journal))
+    {
+        mk82FsFatalError();
+    }
+
+    if (journal.committed != MK82_TRUE)
+    {
+        return;
+    }
+
+    /* A journal that was torn while being written is discarded, none of its files have been touched yet */
+    if ((journal.dataLength <= sizeof(journal.data)) &&
+        (journal.crc == uffs_crc16sum(journal.data, journal.dataLength)))
+    {
+        mk82FsApplyTransaction(journal.data, journal.dataLength);
+    }
+
+    mk82FsWriteJournal(MK82_FALSE, NULL, 0);
+
+    mk82SystemMemSet((uint8_t *)&journal, 0x00, sizeof(journal));
+}
+
+void mk82FsBeginTransaction(void)
+{
+    if (mk82FsTransactionActive == MK82_TRUE)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsTransactionActive = MK82_TRUE;
+    mk82FsTransactionLength = 0;
+}
+
+void mk82FsCommitTransaction(void)
+{
+    int firstFileHandle = -1;
     int fileHandle;
-    uint32_t fileOffset;
+    uint16_t journalNeeded = MK82_FALSE;
+    uint32_t position = 0;
 
-    if (buffer == NULL)
+    if (mk82FsTransactionActive != MK82_TRUE)
     {
         mk82FsFatalError();
     }
 
-    mk82FsGetFileHandleAndOffset(fileID, &fileHandle, &fileOffset);
+    mk82FsTransactionActive = MK82_FALSE;
 
-    offset += fileOffset;
+    while (position < mk82FsTransactionLength)
+    {
+        uint8_t *record = &mk82FsTransactionBuffer[position];
+        uint32_t recordOffset = MK82_MAKEWORD(record[1], record[2]);
+        uint32_t recordLength = MK82_MAKEWORD(record[3], record[4]);
 
-    calleeRetVal = uffs_seek(fileHandle, offset, USEEK_SET);
+        fileHandle = *mk82FsFileHandles[mk82FsGetFileDescriptor(record[0], recordOffset, recordLength)->file];
 
-    if (calleeRetVal != offset)
+        if (position == 0)
+        {
+            firstFileHandle = fileHandle;
+        }
+        else if (fileHandle != firstFileHandle)
+        {
+            journalNeeded = MK82_TRUE;
+        }
+
+        position += MK82_FS_TRANSACTION_RECORD_HEADER_SIZE + recordLength;
+    }
+
+    if (journalNeeded == MK82_TRUE)
+    {
+        if (mk82FsTransactionLength > sizeof(((MK82_FS_JOURNAL *)0)->data))
+        {
+            mk82FsFatalError();
+        }
+
+        mk82FsWriteJournal(MK82_TRUE, mk82FsTransactionBuffer, mk82FsTransactionLength);
+    }
+
+    mk82FsApplyTransaction(mk82FsTransactionBuffer, mk82FsTransactionLength);
+
+    if (journalNeeded == MK82_TRUE)
+    {
+        mk82FsWriteJournal(MK82_FALSE, NULL, 0);
+    }
+
+    mk82SystemMemSet(mk82FsTransactionBuffer, 0x00, mk82FsTransactionLength);
+    mk82FsTransactionLength = 0;
+
+    if (mk82FsUnsavedErases >= MK82_FS_WEAR_SAVE_LIMIT)
+    {
+        mk82FsSaveWearInfo();
+    }
+}
+
+static void mk82FsLoadWearInfo(void)
+{
+    MK82_FS_NVM_WEAR nvmWear;
+    int calleeRetVal;
+    uint32_t i;
+
+    calleeRetVal = uffs_seek(mk82FsDataFileHandle, offsetof(MK82_FS_DATA, fsWear), USEEK_SET);
+
+    if (calleeRetVal != offsetof(MK82_FS_DATA, fsWear))
     {
         mk82FsFatalError();
     }
 
-    calleeRetVal = uffs_write(fileHandle, buffer, length);
+    calleeRetVal = uffs_read(mk82FsDataFileHandle, &nvmWear, sizeof(nvmWear));
 
-    if (calleeRetVal < 0)
+    if (calleeRetVal != sizeof(nvmWear))
     {
         mk82FsFatalError();
     }
+
+    if (nvmWear.initialized != MK82_TRUE)
+    {
+        return;
+    }
+
+    /* Activity since power-up (mount) is already in RAM, add the saved totals on top of it. */
+    for (i = 0; i < MK82_FS_TOTAL_BLOCKS; i++)
+    {
+        mk82FsWearInfo.blockEraseCounters[i] += nvmWear.blockEraseCounters[i];
+    }
+
+    mk82FsWearInfo.pageWriteCounter += nvmWear.pageWriteCounter;
+
+    for (i = 0; i <= MK82_FS_NUMBER_OF_FILE_IDS; i++)
+    {
+        mk82FsWearInfo.fileCommitCounters[i] += nvmWear.fileCommitCounters[i];
+        mk82FsWearInfo.fileEraseCounters[i] += nvmWear.fileEraseCounters[i];
+    }
 }
 
-void mk82FsCommitWrite(uint8_t fileID)
+static void mk82FsSaveWearInfo(void)
 {
+    MK82_FS_NVM_WEAR nvmWear;
     int calleeRetVal;
-    int fileHandle;
-    uint32_t fileOffset;
 
-    mk82FsGetFileHandleAndOffset(fileID, &fileHandle, &fileOffset);
+    /* Erases caused by this save are counted and saved next time */
+    mk82FsUnsavedErases = 0;
+    mk82FsWearInfo.fileCommitCounters[MK82_FS_FILE_ID_NONE]++;
 
-    calleeRetVal = uffs_flush(fileHandle);
+    nvmWear.initialized = MK82_TRUE;
+    mk82SystemMemCpy((uint8_t *)nvmWear.blockEraseCounters, (uint8_t *)mk82FsWearInfo.blockEraseCounters,
+                     sizeof(nvmWear.blockEraseCounters));
+    nvmWear.pageWriteCounter = mk82FsWearInfo.pageWriteCounter;
+    mk82SystemMemCpy((uint8_t *)nvmWear.fileCommitCounters, (uint8_t *)mk82FsWearInfo.fileCommitCounters,
+                     sizeof(nvmWear.fileCommitCounters));
+    mk82SystemMemCpy((uint8_t *)nvmWear.fileEraseCounters, (uint8_t *)mk82FsWearInfo.fileEraseCounters,
+                     sizeof(nvmWear.fileEraseCounters));
+
+    calleeRetVal = uffs_seek(mk82FsDataFileHandle, offsetof(MK82_FS_DATA, fsWear), USEEK_SET);
+
+    if (calleeRetVal != offsetof(MK82_FS_DATA, fsWear))
+    {
+        mk82FsFatalError();
+    }
+
+    calleeRetVal = uffs_write(mk82FsDataFileHandle, &nvmWear, sizeof(nvmWear));
 
     if (calleeRetVal < 0)
     {
         mk82FsFatalError();
     }
+
+    calleeRetVal = uffs_flush(mk82FsDataFileHandle);
+
+    if (calleeRetVal < 0)
+    {
+        mk82FsFatalError();
+    }
+}
+
+void mk82FsGetWearInfo(MK82_FS_WEAR_INFO *wearInfo)
+{
+    if (wearInfo == NULL)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82SystemMemCpy((uint8_t *)wearInfo, (uint8_t *)&mk82FsWearInfo, sizeof(MK82_FS_WEAR_INFO));
 }
 
 #if 0
@@ -608,6 +1263,9 @@ void mk82FsInit(void)
 
     uffs_SetupDebugOutput();
 
+    mk82FsPendingErases = 0;
+    mk82SystemMemSet((uint8_t *)mk82FsCheckedPages, 0, sizeof(mk82FsCheckedPages));
+
     mk82SystemMemSet((uint8_t *)&mk82FsFlashStorage, 0, sizeof(struct uffs_StorageAttrSt));
 
     // setup NAND flash attributes.
@@ -643,4 +1301,54 @@ void mk82FsInit(void)
 #endif
 
     mk82FsOpenAndCheckAllFiles();
+
+    mk82FsLoadWearInfo();
+
+    mk82FsRecoverJournal();
 }
+
+/* Does one erase or one erased block check per call, so that the superloop gets back to USB in between */
+void mk82FsIdleTask(void)
+{
+    uffs_Device *dev = &mk82FsDevice;
+    TreeNode *node;
+
+    if (mk82FsTransactionActive == MK82_TRUE)
+    {
+        return;
+    }
+
+    if (mk82FsPendingErases != 0)
+    {
+        mk82FsCompletePendingErase(0);
+        return;
+    }
+
+    /*
+     * The wear counters live in the data file, which a command has often just rewritten. Saving them here, after the
+     * old block of that file has been erased, keeps the save from making the next command wait for that erase.
+     */
+    if (mk82FsUnsavedErases >= MK82_FS_WEAR_SAVE_THRESHOLD)
+    {
+        mk82FsSaveWearInfo();
+        return;
+    }
+
+    /* Blocks that looked erased at mount have only had their first page checked */
+    for (node = dev->tree.erased; node != NULL; node = node->u.list.next)
+    {
+        if (node->u.list.u.need_check != 0)
+        {
+            if (uffs_FlashCheckErasedBlock(dev, node->u.list.block) != U_SUCC)
+            {
+                uffs_TreeEraseNode(dev, node);
+            }
+
+            node->u.list.u.need_check = 0;
+
+            return;
+        }
+    }
+}
+
+#endif /* !USE_RECORD_STORE */
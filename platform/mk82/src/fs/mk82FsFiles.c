@@ -0,0 +1,96 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2017 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "mk82Global.h"
+#include "mk82GlobalInt.h"
+#include "mk82System.h"
+#include "mk82Fs.h"
+#include "mk82FsInt.h"
+
+#include "stddef.h"
+
+#define MK82_FS_FILE_DESCRIPTOR(id, file, type, field)                   \
+    {                                                                   \
+        (id), (file), offsetof(type, field), sizeof(((type *)0)->field) \
+    }
+
+/* Indexed by file ID. Each entry repeats its own ID so that a corrupted index is caught. */
+static const MK82_FS_FILE_DESCRIPTOR mk82FsFileDescriptors[MK82_FS_NUMBER_OF_FILE_IDS + 1] = {
+    {MK82_FS_FILE_ID_NONE, MK82_FS_NUMBER_OF_FILES, 0, 0},
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OPGP_COUNTERS, MK82_FS_FILE_COUNTERS, MK82_FS_COUNTERS, opgpCounters),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OPGP_CERTIFICATES, MK82_FS_FILE_CERTIFICATES,
+                            MK82_FS_CERTIFICATES, opgpCertificates),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OPGP_KEYS, MK82_FS_FILE_KEYS, MK82_FS_KEYS, opgpKeys),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OPGP_DATA, MK82_FS_FILE_DATA, MK82_FS_DATA, opgpData),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_SF_COUNTERS, MK82_FS_FILE_COUNTERS, MK82_FS_COUNTERS, sfCounters),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_KEYSAFE_DATA, MK82_FS_FILE_DATA, MK82_FS_DATA, keysafeData),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OTP_COUNTERS, MK82_FS_FILE_COUNTERS, MK82_FS_COUNTERS, otpCounters),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OTP_KEYS, MK82_FS_FILE_KEYS, MK82_FS_KEYS, otpKeys),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OTP_DATA, MK82_FS_FILE_DATA, MK82_FS_DATA, otpData),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_BTC_COUNTERS, MK82_FS_FILE_COUNTERS, MK82_FS_COUNTERS, btcCounters),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_BTC_KEYS, MK82_FS_FILE_KEYS, MK82_FS_KEYS, btcKeys),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_BTC_DATA, MK82_FS_FILE_DATA, MK82_FS_DATA, btcData),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_ETH_COUNTERS, MK82_FS_FILE_COUNTERS, MK82_FS_COUNTERS, ethCounters),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_ETH_KEYS, MK82_FS_FILE_KEYS, MK82_FS_KEYS, ethKeys),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_ETH_DATA, MK82_FS_FILE_DATA, MK82_FS_DATA, ethData),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_SSL_KEYS, MK82_FS_FILE_KEYS, MK82_FS_KEYS, sslKeys),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_XRP_COUNTERS, MK82_FS_FILE_COUNTERS, MK82_FS_COUNTERS, xrpCounters),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_XRP_KEYS, MK82_FS_FILE_KEYS, MK82_FS_KEYS, xrpKeys),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_XRP_DATA, MK82_FS_FILE_DATA, MK82_FS_DATA, xrpData),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OTP_TIME, MK82_FS_FILE_DATA, MK82_FS_DATA, otpTime),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OPGP_PRIME_POOL, MK82_FS_FILE_DATA, MK82_FS_DATA, opgpPrimePool),
+    MK82_FS_FILE_DESCRIPTOR(MK82_FS_FILE_ID_OTP_KEY_MIDSTATES, MK82_FS_FILE_DATA, MK82_FS_DATA, otpKeyMidstates)};
+
+const MK82_FS_FILE_DESCRIPTOR *mk82FsGetFileDescriptor(uint8_t fileID, uint32_t offset, uint32_t length)
+{
+    const MK82_FS_FILE_DESCRIPTOR *descriptor;
+    uint16_t inRange = MK82_FALSE;
+
+    if ((fileID > MK82_FS_FILE_ID_NONE) && (fileID <= MK82_FS_NUMBER_OF_FILE_IDS))
+    {
+        inRange = MK82_TRUE;
+    }
+
+    if (inRange != MK82_TRUE)
+    {
+        mk82SystemFatalError();
+    }
+
+    /* Checked a second time in case the first comparison was skipped */
+    if ((fileID == MK82_FS_FILE_ID_NONE) || (fileID > MK82_FS_NUMBER_OF_FILE_IDS))
+    {
+        mk82SystemFatalError();
+    }
+
+    descriptor = &mk82FsFileDescriptors[fileID];
+
+    if ((descriptor->fileID != fileID) || (descriptor->file >= MK82_FS_NUMBER_OF_FILES))
+    {
+        mk82SystemFatalError();
+    }
+
+    inRange = MK82_FALSE;
+
+    if ((offset <= descriptor->maxLength) && (length <= (descriptor->maxLength - offset)))
+    {
+        inRange = MK82_TRUE;
+    }
+
+    if (inRange != MK82_TRUE)
+    {
+        mk82SystemFatalError();
+    }
+
+    if ((offset > descriptor->maxLength) || (length > (descriptor->maxLength - offset)))
+    {
+        mk82SystemFatalError();
+    }
+
+    return descriptor;
+}
@@ -26,7 +26,7 @@
 #include "mk82KeySafe.h"
 #include "mk82Ssl.h"
 
-#define MK82_FS_TOTAL_BLOCKS (MK82_FLASH_FILE_SYSTEM_SIZE / MK82_FLASH_PAGE_SIZE)
+#define MK82_FS_TOTAL_BLOCKS (MK82_FS_NUMBER_OF_BLOCKS)
 #define MK82_FS_PAGE_DATA_SIZE (246)
 #define MK82_FS_PAGE_SPARE_SIZE (10)
 #define MK82_FS_PAGES_PER_BLOCK (16)
@@ -35,6 +35,78 @@
 
 #define MK82_FS_INTERNAL_INFO_PER_PAGE (4)
 
+/* Wear counters are written back once this many erases have accumulated, which costs one page program per that
+ * many block erases. */
+#define MK82_FS_WEAR_SAVE_THRESHOLD (8)
+/* With UFFS the idle task saves them, a commit only does once the idle task has not run for this many erases */
+#define MK82_FS_WEAR_SAVE_LIMIT (32)
+
+#define MK82_FS_FILE_ID_NONE (0)
+
+/*
+ * Blocks that may wait for their erase until the superloop is idle. The limit is not what makes a command wait: a
+ * second block of an object that already has one waiting, or a waiting block UFFS takes again, is erased right away.
+ */
+#define MK82_FS_MAX_PENDING_ERASES (4)
+#define MK82_FS_BLOCK_OWNER_NONE (0xFFFFFFFF)
+
+#define MK82_FS_FILE_PAGE_SIZE (MK82_FS_PAGE_DATA_SIZE - MK82_FS_INTERNAL_INFO_PER_PAGE)
+
+/* One bit per page of the file system, for pages mapped by mk82FsMapFile */
+#define MK82_FS_CHECKED_PAGE_WORDS (((MK82_FS_TOTAL_BLOCKS * MK82_FS_PAGES_PER_BLOCK) + 31) / 32)
+#define MK82_FS_IS_PAGE_CHECKED(pages, page) (((pages)[(page) / 32] & (1UL << ((page) % 32))) != 0)
+#define MK82_FS_SET_PAGE_CHECKED(pages, page) ((pages)[(page) / 32] |= (1UL << ((page) % 32)))
+#define MK82_FS_CLEAR_PAGE_CHECKED(pages, page) ((pages)[(page) / 32] &= ~(1UL << ((page) % 32)))
+
+/* The four files that hold every file ID, in the order of their UFFS names "/1" to "/4" */
+#define MK82_FS_FILE_COUNTERS (0)
+#define MK82_FS_FILE_CERTIFICATES (1)
+#define MK82_FS_FILE_KEYS (2)
+#define MK82_FS_FILE_DATA (3)
+#define MK82_FS_NUMBER_OF_FILES (4)
+
+/* Where each file ID lives: the file that holds it, its offset in that file and its size. */
+typedef struct
+{
+    uint8_t fileID;
+    uint8_t file;
+    uint16_t offset;
+    uint16_t maxLength;
+} MK82_FS_FILE_DESCRIPTOR;
+
+/* Writes made inside a transaction are staged in RAM as records of {fileID, offset, length, data}. A transaction
+ * that touches a single UFFS file is applied with one flush, which UFFS already performs atomically. One that
+ * touches several files is first written to the journal file, so that it can be replayed at mount. */
+#define MK82_FS_TRANSACTION_BUFFER_SIZE (1536)
+#define MK82_FS_TRANSACTION_RECORD_HEADER_SIZE (5)
+#define MK82_FS_JOURNAL_PAGES (2)
+#define MK82_FS_MAX_FILES_PER_TRANSACTION (5)
+
+typedef struct
+{
+    uint32_t block;
+    uint32_t owner;
+} MK82_FS_PENDING_ERASE;
+
+MK82_MAKE_PACKED(typedef struct)
+{
+    uint16_t committed; /* MK82_FALSE16 */
+    uint16_t dataLength;
+    uint16_t crc;
+    uint8_t data[MK82_FS_FILE_PAGE_SIZE * MK82_FS_JOURNAL_PAGES - 3 * sizeof(uint16_t)];
+}
+MK82_FS_JOURNAL;
+
+MK82_MAKE_PACKED(typedef struct)
+{
+    uint16_t initialized; /* MK82_FALSE16 */
+    uint32_t blockEraseCounters[MK82_FS_TOTAL_BLOCKS];
+    uint32_t pageWriteCounter;
+    uint32_t fileCommitCounters[MK82_FS_NUMBER_OF_FILE_IDS + 1];
+    uint32_t fileEraseCounters[MK82_FS_NUMBER_OF_FILE_IDS + 1];
+}
+MK82_FS_NVM_WEAR;
+
 MK82_MAKE_PACKED(typedef struct)
 {
     OPGP_HAL_NVM_COUNTERS opgpCounters;
@@ -83,12 +155,78 @@ MK82_MAKE_PACKED(typedef struct)
     BTC_HAL_NVM_DATA btcData;
     ETH_HAL_NVM_DATA ethData;
     XRP_HAL_NVM_DATA xrpData;
+    OTP_HAL_NVM_TIME otpTime;
+    MK82_FS_NVM_WEAR fsWear;
+    OPGP_HAL_NVM_PRIME_POOL opgpPrimePool;
+    /* Wrapped like the keys, the keys file has no room left. */
+    OTP_HAL_NVM_KEY_MIDSTATES otpKeyMidstates;
 
     uint8_t padding[MK82_FS_PAGE_DATA_SIZE * (MK82_FS_PAGES_PER_BLOCK - 1) - sizeof(OPGP_HAL_NVM_DATA) -
                     sizeof(KEYSAFE_NVM_DATA) - sizeof(OTP_HAL_NVM_DATA) - sizeof(BTC_HAL_NVM_DATA) -
-                    sizeof(ETH_HAL_NVM_DATA) - sizeof(XRP_HAL_NVM_DATA) -
+                    sizeof(ETH_HAL_NVM_DATA) - sizeof(XRP_HAL_NVM_DATA) - sizeof(OTP_HAL_NVM_TIME) -
+                    sizeof(MK82_FS_NVM_WEAR) - sizeof(OPGP_HAL_NVM_PRIME_POOL) - sizeof(OTP_HAL_NVM_KEY_MIDSTATES) -
                     MK82_FS_INTERNAL_INFO_PER_PAGE * (MK82_FS_PAGES_PER_BLOCK - 1)];
 }
 MK82_FS_DATA;
 
+/*
+ * Record store, used instead of UFFS when USE_RECORD_STORE is defined.
+ *
+ * The four files are laid out back to back in one logical space, which is cut into records of
+ * MK82_FS_RECORD_DATA_SIZE bytes. Writing a record appends a new copy of it to a log that runs through the flash
+ * sectors in turn, and a RAM index points at the newest copy of every record. Records written between two commits
+ * form a group that shares a group number, and the last record of a group is flagged. At mount a group only counts
+ * once its last record is found, so a commit torn by a power loss is dropped as a whole.
+ *
+ * Space is reclaimed one sector at a time: the live records of the oldest sector are copied to the head of the log
+ * and the sector is erased. One erased sector is always kept back as the target of that copy.
+ */
+#define MK82_FS_RECORD_SLOT_SIZE (32)
+#define MK82_FS_RECORD_HEADER_SIZE (8)
+#define MK82_FS_RECORD_DATA_SIZE (MK82_FS_RECORD_SLOT_SIZE - MK82_FS_RECORD_HEADER_SIZE)
+#define MK82_FS_RECORD_NUMBER_OF_SECTORS (MK82_FLASH_FILE_SYSTEM_SIZE / MK82_FLASH_PAGE_SIZE)
+#define MK82_FS_RECORD_SLOTS_PER_SECTOR (MK82_FLASH_PAGE_SIZE / MK82_FS_RECORD_SLOT_SIZE)
+/* Slot 0 of every sector holds its header */
+#define MK82_FS_RECORD_FIRST_SLOT (1)
+#define MK82_FS_RECORD_DATA_SLOTS_PER_SECTOR (MK82_FS_RECORD_SLOTS_PER_SECTOR - MK82_FS_RECORD_FIRST_SLOT)
+
+#define MK82_FS_RECORD_LOGICAL_SIZE \
+    (sizeof(MK82_FS_COUNTERS) + sizeof(MK82_FS_CERTIFICATES) + sizeof(MK82_FS_KEYS) + sizeof(MK82_FS_DATA))
+#define MK82_FS_RECORD_NUMBER_OF_RECORDS \
+    ((MK82_FS_RECORD_LOGICAL_SIZE + MK82_FS_RECORD_DATA_SIZE - 1) / MK82_FS_RECORD_DATA_SIZE)
+
+/* Enough for the largest commit the applications make, a wipeout of the OpenPGP keys */
+#define MK82_FS_RECORD_MAX_GROUP_SLOTS (192)
+/* Free slots mk82FsRecordCollectGarbage leaves before a group opens */
+#define MK82_FS_RECORD_GC_THRESHOLD_SLOTS (MK82_FS_RECORD_MAX_GROUP_SLOTS + MK82_FS_RECORD_DATA_SLOTS_PER_SECTOR)
+
+#define MK82_FS_RECORD_SLOT_NONE (0xFFFF)
+#define MK82_FS_RECORD_SECTOR_NONE (0xFFFFFFFF)
+#define MK82_FS_RECORD_SEQUENCE_NONE (0xFFFFFFFF)
+#define MK82_FS_RECORD_SECTOR_MAGIC (0x5AC3C35A)
+
+/*
+ * magic and eraseCounter are programmed right after the erase, sequence and sequenceCheck when the sector becomes the
+ * head of the log
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t eraseCounter;
+    uint32_t sequence;
+    uint32_t sequenceCheck; /* ~sequence */
+    uint8_t unused[MK82_FS_RECORD_SLOT_SIZE - 4 * sizeof(uint32_t)];
+} MK82_FS_RECORD_SECTOR_HEADER;
+
+typedef struct
+{
+    uint16_t recordNumber;
+    uint16_t group;
+    uint16_t last; /* MK82_TRUE for the last record of a group */
+    uint16_t crc;
+    uint8_t data[MK82_FS_RECORD_DATA_SIZE];
+} MK82_FS_RECORD;
+
+const MK82_FS_FILE_DESCRIPTOR *mk82FsGetFileDescriptor(uint8_t fileID, uint32_t offset, uint32_t length);
+
 #endif /* __MK82_FS_INT_H__ */
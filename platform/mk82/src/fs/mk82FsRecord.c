@@ -0,0 +1,924 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "mk82Global.h"
+#include "mk82GlobalInt.h"
+#include "mk82System.h"
+#include "mk82Fs.h"
+#include "mk82FsInt.h"
+
+#include "fsl_device_registers.h"
+#include "fsl_flash.h"
+
+#include "uffs_config.h"
+#include "uffs/uffs_crc.h"
+
+#include "stddef.h"
+
+#if defined(USE_RECORD_STORE)
+
+#define MK82_FS_RECORD_SECTOR_ADDRESS(sector) (MK82_FLASH_FILE_SYSTEM_START + (sector)*MK82_FLASH_PAGE_SIZE)
+#define MK82_FS_RECORD_SLOT_ADDRESS(slot) (MK82_FLASH_FILE_SYSTEM_START + (slot)*MK82_FS_RECORD_SLOT_SIZE)
+
+static void mk82FsFatalError(void);
+
+static void mk82FsRecordProgram(uint32_t address, uint8_t *data, uint32_t length);
+static uint16_t mk82FsRecordIsSectorErased(uint32_t sector);
+static void mk82FsRecordEraseSector(uint32_t sector);
+static void mk82FsRecordFormatSector(uint32_t sector);
+static void mk82FsRecordOpenSector(void);
+static uint32_t mk82FsRecordGetFreeSlots(void);
+static uint16_t mk82FsRecordComputeCrc(MK82_FS_RECORD *record);
+static uint16_t mk82FsRecordIsErased(uint8_t *data, uint32_t length);
+static void mk82FsRecordWriteRecord(MK82_FS_RECORD *record, uint16_t last);
+static void mk82FsRecordMoveSector(uint32_t sector);
+static uint32_t mk82FsRecordGetOldestSector(void);
+static void mk82FsRecordCollectGarbage(void);
+static void mk82FsRecordOpenGroup(void);
+static void mk82FsRecordCloseGroup(void);
+static void mk82FsRecordRead(uint32_t address, uint8_t *buffer, uint32_t length);
+static const uint8_t *mk82FsRecordMap(uint32_t recordNumber);
+static void mk82FsRecordWrite(uint32_t address, uint8_t *buffer, uint32_t length);
+static void mk82FsRecordMountSectors(void);
+static void mk82FsRecordMountRecords(void);
+
+static void mk82FsLoadWearInfo(void);
+static void mk82FsSaveWearInfo(void);
+
+/* Where each file starts in the logical space, indexed by MK82_FS_FILE_xxx */
+static const uint32_t mk82FsRecordFileStart[MK82_FS_NUMBER_OF_FILES] = {
+    0, sizeof(MK82_FS_COUNTERS), sizeof(MK82_FS_COUNTERS) + sizeof(MK82_FS_CERTIFICATES),
+    sizeof(MK82_FS_COUNTERS) + sizeof(MK82_FS_CERTIFICATES) + sizeof(MK82_FS_KEYS)};
+
+/* What a record that was never written reads as */
+static const uint8_t mk82FsRecordZeroData[MK82_FS_RECORD_DATA_SIZE] = {0};
+
+/* Slot of the newest copy of every record, MK82_FS_RECORD_SLOT_NONE for records never written, which read as zeros */
+static uint16_t mk82FsRecordIndex[MK82_FS_RECORD_NUMBER_OF_RECORDS];
+
+static uint32_t mk82FsRecordSectorSequences[MK82_FS_RECORD_NUMBER_OF_SECTORS];
+static uint16_t mk82FsRecordSectorLiveRecords[MK82_FS_RECORD_NUMBER_OF_SECTORS];
+static uint32_t mk82FsRecordHeadSector = MK82_FS_RECORD_SECTOR_NONE;
+static uint32_t mk82FsRecordHeadSlot;
+static uint32_t mk82FsRecordNextSequence;
+
+/* The record being written is kept here until a write moves on to another record or the group is committed */
+static MK82_FS_RECORD MK82_ALIGN(4) mk82FsRecordCache;
+static uint16_t mk82FsRecordCacheValid = MK82_FALSE;
+
+static uint16_t mk82FsRecordGroup;
+static uint16_t mk82FsRecordGroupOpen = MK82_FALSE;
+static uint32_t mk82FsRecordGroupSlots;
+static uint32_t mk82FsRecordGroupFileIDs;
+
+static uint16_t mk82FsTransactionActive = MK82_FALSE;
+
+static MK82_FS_WEAR_INFO mk82FsWearInfo;
+static uint8_t mk82FsCurrentFileID = MK82_FS_FILE_ID_NONE;
+static uint32_t mk82FsUnsavedErases;
+
+static void mk82FsFatalError(void) { mk82SystemFatalError(); }
+
+static void mk82FsRecordProgram(uint32_t address, uint8_t *data, uint32_t length)
+{
+    status_t result;
+    uint32_t failAddr, failDat;
+
+    mk82SystemFlashProgram(address, data, length);
+
+    mk82SystemFlashBeginOperation();
+
+    result = FLASH_VerifyProgram(&mk82FlashDriver, address, length, (uint32_t *)data, kFLASH_marginValueUser,
+                                 &failAddr, &failDat);
+
+    if (kStatus_FLASH_Success != result)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82SystemFlashEndOperation();
+
+    mk82FsWearInfo.pageWriteCounter++;
+}
+
+static uint16_t mk82FsRecordIsSectorErased(uint32_t sector)
+{
+    status_t result;
+
+    mk82SystemFlashBeginOperation();
+
+    result = FLASH_VerifyErase(&mk82FlashDriver, MK82_FS_RECORD_SECTOR_ADDRESS(sector), MK82_FLASH_PAGE_SIZE,
+                               kFLASH_marginValueUser);
+
+    mk82SystemFlashEndOperation();
+
+    if (kStatus_FLASH_Success != result)
+    {
+        return MK82_FALSE;
+    }
+
+    return MK82_TRUE;
+}
+
+static void mk82FsRecordEraseSector(uint32_t sector)
+{
+    status_t result;
+
+    if (sector >= MK82_FS_RECORD_NUMBER_OF_SECTORS)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82SystemFlashBeginOperation();
+
+    result = FLASH_Erase(&mk82FlashDriver, MK82_FS_RECORD_SECTOR_ADDRESS(sector), MK82_FLASH_PAGE_SIZE,
+                         kFLASH_apiEraseKey);
+
+    if (kStatus_FLASH_Success != result)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82SystemFlashEndOperation();
+
+    if (mk82FsRecordIsSectorErased(sector) != MK82_TRUE)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsWearInfo.blockEraseCounters[sector]++;
+    mk82FsWearInfo.fileEraseCounters[mk82FsCurrentFileID]++;
+    mk82FsUnsavedErases++;
+
+    mk82FsRecordFormatSector(sector);
+}
+
+/* Writes the first two longwords of the header of an erased sector, which makes it a free sector */
+static void mk82FsRecordFormatSector(uint32_t sector)
+{
+    MK82_FS_RECORD_SECTOR_HEADER MK82_ALIGN(4) header;
+
+    mk82SystemMemSet((uint8_t *)&header, 0xFF, sizeof(header));
+
+    header.magic = MK82_FS_RECORD_SECTOR_MAGIC;
+    header.eraseCounter = mk82FsWearInfo.blockEraseCounters[sector];
+
+    mk82FsRecordProgram(MK82_FS_RECORD_SECTOR_ADDRESS(sector), (uint8_t *)&header.magic,
+                        sizeof(header.magic) + sizeof(header.eraseCounter));
+
+    mk82FsRecordSectorSequences[sector] = MK82_FS_RECORD_SEQUENCE_NONE;
+    mk82FsRecordSectorLiveRecords[sector] = 0;
+}
+
+/* Makes the least worn free sector the head of the log */
+static void mk82FsRecordOpenSector(void)
+{
+    MK82_FS_RECORD_SECTOR_HEADER MK82_ALIGN(4) header;
+    uint32_t sector = MK82_FS_RECORD_SECTOR_NONE;
+    uint32_t i;
+
+    for (i = 0; i < MK82_FS_RECORD_NUMBER_OF_SECTORS; i++)
+    {
+        if (mk82FsRecordSectorSequences[i] != MK82_FS_RECORD_SEQUENCE_NONE)
+        {
+            continue;
+        }
+
+        if ((sector == MK82_FS_RECORD_SECTOR_NONE) ||
+            (mk82FsWearInfo.blockEraseCounters[i] < mk82FsWearInfo.blockEraseCounters[sector]))
+        {
+            sector = i;
+        }
+    }
+
+    if (sector == MK82_FS_RECORD_SECTOR_NONE)
+    {
+        mk82FsFatalError();
+    }
+
+    header.sequence = mk82FsRecordNextSequence;
+    header.sequenceCheck = ~mk82FsRecordNextSequence;
+
+    mk82FsRecordProgram(MK82_FS_RECORD_SECTOR_ADDRESS(sector) + offsetof(MK82_FS_RECORD_SECTOR_HEADER, sequence),
+                        (uint8_t *)&header.sequence, sizeof(header.sequence) + sizeof(header.sequenceCheck));
+
+    mk82FsRecordSectorSequences[sector] = mk82FsRecordNextSequence;
+    mk82FsRecordNextSequence++;
+
+    mk82FsRecordHeadSector = sector;
+    mk82FsRecordHeadSlot = MK82_FS_RECORD_FIRST_SLOT;
+}
+
+static uint32_t mk82FsRecordGetFreeSlots(void)
+{
+    uint32_t freeSlots = 0;
+    uint32_t i;
+
+    if (mk82FsRecordHeadSector != MK82_FS_RECORD_SECTOR_NONE)
+    {
+        freeSlots += MK82_FS_RECORD_SLOTS_PER_SECTOR - mk82FsRecordHeadSlot;
+    }
+
+    for (i = 0; i < MK82_FS_RECORD_NUMBER_OF_SECTORS; i++)
+    {
+        if (mk82FsRecordSectorSequences[i] == MK82_FS_RECORD_SEQUENCE_NONE)
+        {
+            freeSlots += MK82_FS_RECORD_DATA_SLOTS_PER_SECTOR;
+        }
+    }
+
+    return freeSlots;
+}
+
+static uint16_t mk82FsRecordComputeCrc(MK82_FS_RECORD *record)
+{
+    uint16_t crc;
+
+    crc = uffs_crc16sum(record, offsetof(MK82_FS_RECORD, crc));
+
+    return uffs_crc16update(record->data, sizeof(record->data), crc);
+}
+
+static uint16_t mk82FsRecordIsErased(uint8_t *data, uint32_t length)
+{
+    uint32_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        if (data[i] != 0xFF)
+        {
+            return MK82_FALSE;
+        }
+    }
+
+    return MK82_TRUE;
+}
+
+static void mk82FsRecordWriteRecord(MK82_FS_RECORD *record, uint16_t last)
+{
+    uint32_t slot;
+    uint32_t oldSlot;
+
+    if (record->recordNumber >= MK82_FS_RECORD_NUMBER_OF_RECORDS)
+    {
+        mk82FsFatalError();
+    }
+
+    if (mk82FsRecordGroupSlots >= MK82_FS_RECORD_MAX_GROUP_SLOTS)
+    {
+        mk82FsFatalError();
+    }
+
+    if ((mk82FsRecordHeadSector == MK82_FS_RECORD_SECTOR_NONE) ||
+        (mk82FsRecordHeadSlot >= MK82_FS_RECORD_SLOTS_PER_SECTOR))
+    {
+        mk82FsRecordOpenSector();
+    }
+
+    slot = mk82FsRecordHeadSector * MK82_FS_RECORD_SLOTS_PER_SECTOR + mk82FsRecordHeadSlot;
+    mk82FsRecordHeadSlot++;
+
+    record->group = mk82FsRecordGroup;
+    record->last = last;
+    record->crc = mk82FsRecordComputeCrc(record);
+
+    mk82FsRecordProgram(MK82_FS_RECORD_SLOT_ADDRESS(slot), (uint8_t *)record, MK82_FS_RECORD_SLOT_SIZE);
+
+    oldSlot = mk82FsRecordIndex[record->recordNumber];
+
+    if (oldSlot != MK82_FS_RECORD_SLOT_NONE)
+    {
+        mk82FsRecordSectorLiveRecords[oldSlot / MK82_FS_RECORD_SLOTS_PER_SECTOR]--;
+    }
+
+    mk82FsRecordIndex[record->recordNumber] = slot;
+    mk82FsRecordSectorLiveRecords[mk82FsRecordHeadSector]++;
+
+    mk82FsRecordGroupSlots++;
+}
+
+/* Copies the live records of a sector to the head of the log as one group, the sector can be erased afterwards */
+static void mk82FsRecordMoveSector(uint32_t sector)
+{
+    MK82_FS_RECORD MK82_ALIGN(4) record;
+    uint32_t remainingRecords = mk82FsRecordSectorLiveRecords[sector];
+    uint32_t i;
+
+    if (remainingRecords == 0)
+    {
+        return;
+    }
+
+    mk82FsRecordGroupSlots = 0;
+
+    for (i = 0; (i < MK82_FS_RECORD_NUMBER_OF_RECORDS) && (remainingRecords > 0); i++)
+    {
+        uint32_t slot = mk82FsRecordIndex[i];
+
+        if ((slot == MK82_FS_RECORD_SLOT_NONE) || ((slot / MK82_FS_RECORD_SLOTS_PER_SECTOR) != sector))
+        {
+            continue;
+        }
+
+        mk82SystemMemCpy((uint8_t *)&record, (uint8_t *)MK82_FS_RECORD_SLOT_ADDRESS(slot), sizeof(record));
+
+        remainingRecords--;
+
+        mk82FsRecordWriteRecord(&record, (remainingRecords == 0) ? MK82_TRUE : MK82_FALSE);
+    }
+
+    if (remainingRecords != 0)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82SystemMemSet((uint8_t *)&record, 0x00, sizeof(record));
+
+    mk82FsRecordGroup++;
+}
+
+/* The oldest sector in the log, other than the head */
+static uint32_t mk82FsRecordGetOldestSector(void)
+{
+    uint32_t victim = MK82_FS_RECORD_SECTOR_NONE;
+    uint32_t i;
+
+    for (i = 0; i < MK82_FS_RECORD_NUMBER_OF_SECTORS; i++)
+    {
+        if ((i == mk82FsRecordHeadSector) || (mk82FsRecordSectorSequences[i] == MK82_FS_RECORD_SEQUENCE_NONE))
+        {
+            continue;
+        }
+
+        if ((victim == MK82_FS_RECORD_SECTOR_NONE) ||
+            (mk82FsRecordSectorSequences[i] < mk82FsRecordSectorSequences[victim]))
+        {
+            victim = i;
+        }
+    }
+
+    return victim;
+}
+
+/* Runs before a group is opened, so that no group ever needs to reclaim space while it is being written */
+static void mk82FsRecordCollectGarbage(void)
+{
+    uint32_t collectedSectors = 0;
+
+    while (mk82FsRecordGetFreeSlots() < MK82_FS_RECORD_GC_THRESHOLD_SLOTS)
+    {
+        uint32_t victim = mk82FsRecordGetOldestSector();
+
+        if ((victim == MK82_FS_RECORD_SECTOR_NONE) || (collectedSectors >= MK82_FS_RECORD_NUMBER_OF_SECTORS))
+        {
+            mk82FsFatalError();
+        }
+
+        mk82FsRecordMoveSector(victim);
+        mk82FsRecordEraseSector(victim);
+
+        collectedSectors++;
+    }
+}
+
+static void mk82FsRecordOpenGroup(void)
+{
+    mk82FsRecordCollectGarbage();
+
+    mk82FsRecordGroupOpen = MK82_TRUE;
+    mk82FsRecordGroupSlots = 0;
+    mk82FsRecordGroupFileIDs = 0;
+}
+
+static void mk82FsRecordCloseGroup(void)
+{
+    uint32_t i;
+
+    if (mk82FsRecordGroupOpen != MK82_TRUE)
+    {
+        return;
+    }
+
+    /* The record written last is still cached, it closes the group */
+    if (mk82FsRecordCacheValid != MK82_TRUE)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsRecordWriteRecord(&mk82FsRecordCache, MK82_TRUE);
+
+    mk82SystemMemSet((uint8_t *)&mk82FsRecordCache, 0x00, sizeof(mk82FsRecordCache));
+    mk82FsRecordCacheValid = MK82_FALSE;
+
+    mk82FsRecordGroupOpen = MK82_FALSE;
+    mk82FsRecordGroup++;
+
+    for (i = 0; i <= MK82_FS_NUMBER_OF_FILE_IDS; i++)
+    {
+        if ((mk82FsRecordGroupFileIDs & (1UL << i)) != 0)
+        {
+            mk82FsWearInfo.fileCommitCounters[i]++;
+        }
+    }
+}
+
+static const uint8_t *mk82FsRecordMap(uint32_t recordNumber)
+{
+    uint32_t slot = mk82FsRecordIndex[recordNumber];
+
+    if ((mk82FsRecordCacheValid == MK82_TRUE) && (mk82FsRecordCache.recordNumber == recordNumber))
+    {
+        return mk82FsRecordCache.data;
+    }
+    else if (slot == MK82_FS_RECORD_SLOT_NONE)
+    {
+        return mk82FsRecordZeroData;
+    }
+    else
+    {
+        return (const uint8_t *)(MK82_FS_RECORD_SLOT_ADDRESS(slot) + offsetof(MK82_FS_RECORD, data));
+    }
+}
+
+static void mk82FsRecordRead(uint32_t address, uint8_t *buffer, uint32_t length)
+{
+    if ((address + length) > MK82_FS_RECORD_LOGICAL_SIZE)
+    {
+        mk82FsFatalError();
+    }
+
+    while (length > 0)
+    {
+        uint32_t recordNumber = address / MK82_FS_RECORD_DATA_SIZE;
+        uint32_t recordOffset = address % MK82_FS_RECORD_DATA_SIZE;
+        uint32_t chunkLength = MK82_FS_RECORD_DATA_SIZE - recordOffset;
+
+        if (chunkLength > length)
+        {
+            chunkLength = length;
+        }
+
+        mk82SystemMemCpy(buffer, (uint8_t *)&mk82FsRecordMap(recordNumber)[recordOffset], chunkLength);
+
+        address += chunkLength;
+        buffer += chunkLength;
+        length -= chunkLength;
+    }
+}
+
+static void mk82FsRecordWrite(uint32_t address, uint8_t *buffer, uint32_t length)
+{
+    if ((address + length) > MK82_FS_RECORD_LOGICAL_SIZE)
+    {
+        mk82FsFatalError();
+    }
+
+    if (mk82FsRecordGroupOpen != MK82_TRUE)
+    {
+        mk82FsRecordOpenGroup();
+    }
+
+    while (length > 0)
+    {
+        uint32_t recordNumber = address / MK82_FS_RECORD_DATA_SIZE;
+        uint32_t recordOffset = address % MK82_FS_RECORD_DATA_SIZE;
+        uint32_t chunkLength = MK82_FS_RECORD_DATA_SIZE - recordOffset;
+
+        if (chunkLength > length)
+        {
+            chunkLength = length;
+        }
+
+        if ((mk82FsRecordCacheValid == MK82_TRUE) && (mk82FsRecordCache.recordNumber != recordNumber))
+        {
+            mk82FsRecordWriteRecord(&mk82FsRecordCache, MK82_FALSE);
+            mk82FsRecordCacheValid = MK82_FALSE;
+        }
+
+        if (mk82FsRecordCacheValid != MK82_TRUE)
+        {
+            mk82FsRecordRead(recordNumber * MK82_FS_RECORD_DATA_SIZE, mk82FsRecordCache.data, MK82_FS_RECORD_DATA_SIZE);
+            mk82FsRecordCache.recordNumber = recordNumber;
+            mk82FsRecordCacheValid = MK82_TRUE;
+        }
+
+        mk82SystemMemCpy(&mk82FsRecordCache.data[recordOffset], buffer, chunkLength);
+
+        address += chunkLength;
+        buffer += chunkLength;
+        length -= chunkLength;
+    }
+}
+
+/*
+ * Reads the sector headers. A blank region is formatted. A region without a single valid header that is not blank
+ * holds something else, most likely a UFFS image that has not been migrated, and is left alone.
+ */
+static void mk82FsRecordMountSectors(void)
+{
+    uint16_t sectorValid[MK82_FS_RECORD_NUMBER_OF_SECTORS];
+    uint16_t formatted = MK82_FALSE;
+    uint32_t i;
+
+    for (i = 0; i < MK82_FS_RECORD_NUMBER_OF_SECTORS; i++)
+    {
+        MK82_FS_RECORD_SECTOR_HEADER *header = (MK82_FS_RECORD_SECTOR_HEADER *)MK82_FS_RECORD_SECTOR_ADDRESS(i);
+
+        mk82FsRecordSectorSequences[i] = MK82_FS_RECORD_SEQUENCE_NONE;
+        mk82FsRecordSectorLiveRecords[i] = 0;
+        mk82FsWearInfo.blockEraseCounters[i] = 0;
+        sectorValid[i] = MK82_FALSE;
+
+        if (header->magic != MK82_FS_RECORD_SECTOR_MAGIC)
+        {
+            continue;
+        }
+
+        formatted = MK82_TRUE;
+        mk82FsWearInfo.blockEraseCounters[i] = header->eraseCounter;
+
+        if ((header->sequence != MK82_FS_RECORD_SEQUENCE_NONE) && (header->sequence == ~header->sequenceCheck))
+        {
+            mk82FsRecordSectorSequences[i] = header->sequence;
+            sectorValid[i] = MK82_TRUE;
+        }
+        else if ((header->sequence == MK82_FS_RECORD_SEQUENCE_NONE) &&
+                 (header->sequenceCheck == MK82_FS_RECORD_SEQUENCE_NONE))
+        {
+            sectorValid[i] = MK82_TRUE;
+        }
+    }
+
+    if (formatted != MK82_TRUE)
+    {
+        for (i = 0; i < MK82_FS_RECORD_NUMBER_OF_SECTORS; i++)
+        {
+            if (mk82FsRecordIsSectorErased(i) != MK82_TRUE)
+            {
+                mk82FsFatalError();
+            }
+        }
+    }
+
+    /* Sectors whose erase or header program was cut short */
+    for (i = 0; i < MK82_FS_RECORD_NUMBER_OF_SECTORS; i++)
+    {
+        if (sectorValid[i] == MK82_TRUE)
+        {
+            continue;
+        }
+
+        if (mk82FsRecordIsSectorErased(i) == MK82_TRUE)
+        {
+            mk82FsRecordFormatSector(i);
+        }
+        else
+        {
+            mk82FsRecordEraseSector(i);
+        }
+    }
+}
+
+/* Replays the log oldest sector first. The records of a group are only indexed once its last record is found. */
+static void mk82FsRecordMountRecords(void)
+{
+    uint16_t pendingSlots[MK82_FS_RECORD_MAX_GROUP_SLOTS];
+    uint32_t numberOfPendingSlots = 0;
+    uint16_t pendingGroup = 0;
+    uint32_t previousSequence = 0;
+    uint16_t firstSector = MK82_TRUE;
+    uint32_t i;
+
+    mk82SystemMemSet((uint8_t *)mk82FsRecordIndex, 0xFF, sizeof(mk82FsRecordIndex));
+
+    mk82FsRecordHeadSector = MK82_FS_RECORD_SECTOR_NONE;
+    mk82FsRecordNextSequence = 0;
+
+    while (1)
+    {
+        uint32_t sector = MK82_FS_RECORD_SECTOR_NONE;
+        uint32_t slot;
+
+        for (i = 0; i < MK82_FS_RECORD_NUMBER_OF_SECTORS; i++)
+        {
+            uint32_t sequence = mk82FsRecordSectorSequences[i];
+
+            if ((sequence == MK82_FS_RECORD_SEQUENCE_NONE) ||
+                ((firstSector != MK82_TRUE) && (sequence <= previousSequence)))
+            {
+                continue;
+            }
+
+            if ((sector == MK82_FS_RECORD_SECTOR_NONE) || (sequence < mk82FsRecordSectorSequences[sector]))
+            {
+                sector = i;
+            }
+        }
+
+        if (sector == MK82_FS_RECORD_SECTOR_NONE)
+        {
+            break;
+        }
+
+        firstSector = MK82_FALSE;
+        previousSequence = mk82FsRecordSectorSequences[sector];
+
+        for (slot = MK82_FS_RECORD_FIRST_SLOT; slot < MK82_FS_RECORD_SLOTS_PER_SECTOR; slot++)
+        {
+            uint32_t slotNumber = sector * MK82_FS_RECORD_SLOTS_PER_SECTOR + slot;
+            MK82_FS_RECORD *record = (MK82_FS_RECORD *)MK82_FS_RECORD_SLOT_ADDRESS(slotNumber);
+
+            if (mk82FsRecordIsErased((uint8_t *)record, MK82_FS_RECORD_SLOT_SIZE) == MK82_TRUE)
+            {
+                break;
+            }
+
+            /* A record torn by a power loss, the group it belongs to never completed */
+            if ((record->recordNumber >= MK82_FS_RECORD_NUMBER_OF_RECORDS) ||
+                (record->crc != mk82FsRecordComputeCrc(record)))
+            {
+                numberOfPendingSlots = 0;
+                continue;
+            }
+
+            if ((numberOfPendingSlots != 0) && (record->group != pendingGroup))
+            {
+                numberOfPendingSlots = 0;
+            }
+
+            if (numberOfPendingSlots >= MK82_FS_RECORD_MAX_GROUP_SLOTS)
+            {
+                mk82FsFatalError();
+            }
+
+            pendingGroup = record->group;
+            pendingSlots[numberOfPendingSlots++] = slotNumber;
+
+            mk82FsRecordGroup = record->group + 1;
+
+            if (record->last == MK82_TRUE)
+            {
+                for (i = 0; i < numberOfPendingSlots; i++)
+                {
+                    MK82_FS_RECORD *pendingRecord = (MK82_FS_RECORD *)MK82_FS_RECORD_SLOT_ADDRESS(pendingSlots[i]);
+
+                    mk82FsRecordIndex[pendingRecord->recordNumber] = pendingSlots[i];
+                }
+
+                numberOfPendingSlots = 0;
+            }
+        }
+
+        mk82FsRecordHeadSector = sector;
+        mk82FsRecordHeadSlot = slot;
+        mk82FsRecordNextSequence = mk82FsRecordSectorSequences[sector] + 1;
+    }
+
+    for (i = 0; i < MK82_FS_RECORD_NUMBER_OF_RECORDS; i++)
+    {
+        if (mk82FsRecordIndex[i] != MK82_FS_RECORD_SLOT_NONE)
+        {
+            mk82FsRecordSectorLiveRecords[mk82FsRecordIndex[i] / MK82_FS_RECORD_SLOTS_PER_SECTOR]++;
+        }
+    }
+}
+
+void mk82FsInit(void)
+{
+    mk82SystemMemSet((uint8_t *)&mk82FsWearInfo, 0x00, sizeof(mk82FsWearInfo));
+    mk82SystemMemSet((uint8_t *)&mk82FsRecordCache, 0x00, sizeof(mk82FsRecordCache));
+    mk82FsRecordCacheValid = MK82_FALSE;
+    mk82FsRecordGroupOpen = MK82_FALSE;
+    mk82FsTransactionActive = MK82_FALSE;
+
+    mk82FsRecordMountSectors();
+    mk82FsRecordMountRecords();
+
+    mk82FsLoadWearInfo();
+}
+
+void mk82FsReadFile(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+{
+    const MK82_FS_FILE_DESCRIPTOR *descriptor;
+
+    if (buffer == NULL)
+    {
+        mk82FsFatalError();
+    }
+
+    descriptor = mk82FsGetFileDescriptor(fileID, offset, length);
+
+    mk82FsRecordRead(mk82FsRecordFileStart[descriptor->file] + descriptor->offset + offset, buffer, length);
+}
+
+/* One extent per record. Records were checked against their CRC at mount. */
+uint32_t mk82FsMapFile(uint8_t fileID, uint32_t offset, uint32_t length, MK82_FS_EXTENT *extents,
+                       uint32_t maxExtents, uint32_t *numberOfExtents)
+{
+    const MK82_FS_FILE_DESCRIPTOR *descriptor;
+    uint32_t address;
+    uint32_t mappedLength = 0;
+    uint32_t extentCount = 0;
+
+    if ((extents == NULL) || (numberOfExtents == NULL) || (maxExtents == 0))
+    {
+        mk82FsFatalError();
+    }
+
+    /* Kept the same as with UFFS, where staged writes are not in the pages yet */
+    if (mk82FsTransactionActive == MK82_TRUE)
+    {
+        mk82FsFatalError();
+    }
+
+    descriptor = mk82FsGetFileDescriptor(fileID, offset, length);
+
+    address = mk82FsRecordFileStart[descriptor->file] + descriptor->offset + offset;
+
+    if ((address + length) > MK82_FS_RECORD_LOGICAL_SIZE)
+    {
+        mk82FsFatalError();
+    }
+
+    while ((mappedLength < length) && (extentCount < maxExtents))
+    {
+        uint32_t recordOffset = address % MK82_FS_RECORD_DATA_SIZE;
+        uint32_t extentLength = MK82_FS_RECORD_DATA_SIZE - recordOffset;
+
+        if (extentLength > (length - mappedLength))
+        {
+            extentLength = length - mappedLength;
+        }
+
+        extents[extentCount].data = &mk82FsRecordMap(address / MK82_FS_RECORD_DATA_SIZE)[recordOffset];
+        extents[extentCount].length = extentLength;
+
+        address += extentLength;
+        mappedLength += extentLength;
+        extentCount++;
+    }
+
+    *numberOfExtents = extentCount;
+
+    return mappedLength;
+}
+
+void mk82FsWriteFile(uint8_t fileID, uint32_t offset, uint8_t *buffer, uint32_t length)
+{
+    const MK82_FS_FILE_DESCRIPTOR *descriptor;
+
+    if (buffer == NULL)
+    {
+        mk82FsFatalError();
+    }
+
+    descriptor = mk82FsGetFileDescriptor(fileID, offset, length);
+
+    mk82FsCurrentFileID = fileID;
+
+    mk82FsRecordWrite(mk82FsRecordFileStart[descriptor->file] + descriptor->offset + offset, buffer, length);
+
+    mk82FsCurrentFileID = MK82_FS_FILE_ID_NONE;
+
+    mk82FsRecordGroupFileIDs |= (1UL << fileID);
+}
+
+void mk82FsCommitWrite(uint8_t fileID)
+{
+    mk82FsGetFileDescriptor(fileID, 0, 0);
+
+    if (mk82FsTransactionActive == MK82_TRUE)
+    {
+        /* Applied by mk82FsCommitTransaction */
+        return;
+    }
+
+    mk82FsRecordCloseGroup();
+
+    if (mk82FsUnsavedErases >= MK82_FS_WEAR_SAVE_THRESHOLD)
+    {
+        mk82FsSaveWearInfo();
+    }
+}
+
+/* Every group is already atomic, so a transaction is just a group that spans several commits */
+void mk82FsBeginTransaction(void)
+{
+    if (mk82FsTransactionActive == MK82_TRUE)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsTransactionActive = MK82_TRUE;
+}
+
+void mk82FsCommitTransaction(void)
+{
+    if (mk82FsTransactionActive != MK82_TRUE)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82FsTransactionActive = MK82_FALSE;
+
+    mk82FsRecordCloseGroup();
+
+    if (mk82FsUnsavedErases >= MK82_FS_WEAR_SAVE_THRESHOLD)
+    {
+        mk82FsSaveWearInfo();
+    }
+}
+
+/* Sector erase counters are kept in the sector headers, only the other counters are saved in the data file */
+static void mk82FsLoadWearInfo(void)
+{
+    MK82_FS_NVM_WEAR nvmWear;
+    uint32_t i;
+
+    mk82FsRecordRead(mk82FsRecordFileStart[MK82_FS_FILE_DATA] + offsetof(MK82_FS_DATA, fsWear), (uint8_t *)&nvmWear,
+                     sizeof(nvmWear));
+
+    if (nvmWear.initialized != MK82_TRUE)
+    {
+        return;
+    }
+
+    mk82FsWearInfo.pageWriteCounter += nvmWear.pageWriteCounter;
+
+    for (i = 0; i <= MK82_FS_NUMBER_OF_FILE_IDS; i++)
+    {
+        mk82FsWearInfo.fileCommitCounters[i] += nvmWear.fileCommitCounters[i];
+        mk82FsWearInfo.fileEraseCounters[i] += nvmWear.fileEraseCounters[i];
+    }
+}
+
+static void mk82FsSaveWearInfo(void)
+{
+    MK82_FS_NVM_WEAR nvmWear;
+
+    /* Erases caused by this save are counted and saved next time */
+    mk82FsUnsavedErases = 0;
+    mk82FsWearInfo.fileCommitCounters[MK82_FS_FILE_ID_NONE]++;
+
+    nvmWear.initialized = MK82_TRUE;
+    mk82SystemMemCpy((uint8_t *)nvmWear.blockEraseCounters, (uint8_t *)mk82FsWearInfo.blockEraseCounters,
+                     sizeof(nvmWear.blockEraseCounters));
+    nvmWear.pageWriteCounter = mk82FsWearInfo.pageWriteCounter;
+    mk82SystemMemCpy((uint8_t *)nvmWear.fileCommitCounters, (uint8_t *)mk82FsWearInfo.fileCommitCounters,
+                     sizeof(nvmWear.fileCommitCounters));
+    mk82SystemMemCpy((uint8_t *)nvmWear.fileEraseCounters, (uint8_t *)mk82FsWearInfo.fileEraseCounters,
+                     sizeof(nvmWear.fileEraseCounters));
+
+    mk82FsRecordWrite(mk82FsRecordFileStart[MK82_FS_FILE_DATA] + offsetof(MK82_FS_DATA, fsWear), (uint8_t *)&nvmWear,
+                      sizeof(nvmWear));
+
+    mk82FsRecordCloseGroup();
+}
+
+void mk82FsGetWearInfo(MK82_FS_WEAR_INFO *wearInfo)
+{
+    if (wearInfo == NULL)
+    {
+        mk82FsFatalError();
+    }
+
+    mk82SystemMemCpy((uint8_t *)wearInfo, (uint8_t *)&mk82FsWearInfo, sizeof(MK82_FS_WEAR_INFO));
+}
+
+/*
+ * Keeps one sector more than mk82FsRecordCollectGarbage needs free, so that opening a group rarely has to move and
+ * erase anything. Collects at most one sector per call, and only one that frees at least half of its slots.
+ */
+void mk82FsIdleTask(void)
+{
+    uint32_t victim;
+
+    if ((mk82FsTransactionActive == MK82_TRUE) || (mk82FsRecordGroupOpen == MK82_TRUE))
+    {
+        return;
+    }
+
+    if (mk82FsRecordGetFreeSlots() >= (MK82_FS_RECORD_GC_THRESHOLD_SLOTS + MK82_FS_RECORD_DATA_SLOTS_PER_SECTOR))
+    {
+        return;
+    }
+
+    victim = mk82FsRecordGetOldestSector();
+
+    if ((victim == MK82_FS_RECORD_SECTOR_NONE) ||
+        (mk82FsRecordSectorLiveRecords[victim] > (MK82_FS_RECORD_DATA_SLOTS_PER_SECTOR / 2)))
+    {
+        return;
+    }
+
+    mk82FsRecordMoveSector(victim);
+    mk82FsRecordEraseSector(victim);
+}
+
+#endif /* USE_RECORD_STORE */
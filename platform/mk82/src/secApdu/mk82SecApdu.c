@@ -42,7 +42,7 @@ void mk82SecApduProcessCommandIfAvailable(uint32_t dataTypesToProcess, uint32_t
 
         if ((sslStatus == MK82_SSL_STATUS_UNWRAPPED) || (sslStatus == MK82_SSL_STATUS_NOT_SSL))
         {
-            mk82AsProcessAPDU(data, &dataLength, allowedCommands);
+            mk82AsProcessAPDU(data, &dataLength, allowedCommands, mk82UsbGetCcidSlot());
         }
         else
         {
@@ -30,7 +30,12 @@
 flash_config_t mk82FlashDriver;
 
 #ifdef FIRMWARE
-static uint32_t mk82SystemTickerPeriodsElapsed;
+/* Kept out of .bss so that the ticker keeps counting across warm resets. */
+static uint32_t mk82SystemTickerPeriodsElapsed MK82_PLACE_IN_SECTION(".noinit");
+static uint32_t mk82SystemTickerSessionID MK82_PLACE_IN_SECTION(".noinit");
+static uint32_t mk82SystemTickerCheck MK82_PLACE_IN_SECTION(".noinit");
+
+static MK82_SYSTEM_INIT_INFO mk82SystemInitInfo;
 #endif /* FIRMWARE */
 
 #ifdef FIRMWARE
@@ -105,7 +110,32 @@ void mk82SystemInit(void)
     PIT_Init(PIT0, &pitConfig);
 
 #ifdef FIRMWARE
-    mk82SystemTickerPeriodsElapsed = 0;
+    if (((RCM->SRS0 & (RCM_SRS0_POR_MASK | RCM_SRS0_LVD_MASK)) != 0) ||
+        (mk82SystemTickerCheck !=
+         (mk82SystemTickerPeriodsElapsed ^ mk82SystemTickerSessionID ^ MK82_SYSTEM_TICKER_CHECK_MAGIC)))
+    {
+        calleeRetVal = TRNG_GetRandomData(TRNG0, &mk82SystemTickerSessionID, sizeof(mk82SystemTickerSessionID));
+
+        if (calleeRetVal != kStatus_Success)
+        {
+            mk82SystemFatalError();
+        }
+
+        mk82SystemTickerPeriodsElapsed = 0;
+    }
+    else
+    {
+        /* The period interrupted by the reset is counted as a whole one to keep the ticker monotonic. The time
+         * from the reset to this point is not counted at all: the bootstrapper, the startup code, the clock setup
+         * and the TRNG and DRBG seeding above. After a warm reset the ticker is therefore up to one period ahead,
+         * or behind by that boot time, which has not been measured on the device. A TOTP code only changes every
+         * 30 seconds, so either error only shows up next to a step boundary, and the next time sync removes it. */
+        mk82SystemTickerPeriodsElapsed++;
+    }
+
+    mk82SystemTickerCheck =
+        mk82SystemTickerPeriodsElapsed ^ mk82SystemTickerSessionID ^ MK82_SYSTEM_TICKER_CHECK_MAGIC;
+
     PIT_SetTimerPeriod(PIT0, kPIT_Chnl_3,
                        MSEC_TO_COUNT(MK82_SYSTEM_TICKER_INTERRUPT_PERIOD_IN_MS, CLOCK_GetFreq(kCLOCK_BusClk)));
     PIT_EnableInterrupts(PIT0, kPIT_Chnl_3, kPIT_TimerInterruptEnable);
@@ -128,6 +158,8 @@ void PIT3_IRQHandler(void)
 {
     PIT_ClearStatusFlags(PIT0, kPIT_Chnl_3, PIT_TFLG_TIF_MASK);
     mk82SystemTickerPeriodsElapsed++;
+    mk82SystemTickerCheck =
+        mk82SystemTickerPeriodsElapsed ^ mk82SystemTickerSessionID ^ MK82_SYSTEM_TICKER_CHECK_MAGIC;
 }
 
 void mk82SystemTickerGetMsPassed(uint64_t* ms)
@@ -146,7 +178,7 @@ void mk82SystemTickerGetMsPassed(uint64_t* ms)
 
         currentTimerCount = PIT_GetCurrentTimerCount(PIT0, kPIT_Chnl_3);
 
-        *ms = tickerPeriodsElapsedBackup * MK82_SYSTEM_TICKER_INTERRUPT_PERIOD_IN_MS +
+        *ms = (uint64_t)tickerPeriodsElapsedBackup * MK82_SYSTEM_TICKER_INTERRUPT_PERIOD_IN_MS +
               MK82_SYSTEM_TICKER_INTERRUPT_PERIOD_IN_MS -
               COUNT_TO_MSEC(currentTimerCount, CLOCK_GetFreq(kCLOCK_BusClk));
 
@@ -157,6 +189,72 @@ void mk82SystemTickerGetMsPassed(uint64_t* ms)
     }
 }
 
+void mk82SystemTickerGetUsPassed(uint64_t* us)
+{
+    if (us == NULL)
+    {
+        mk82SystemFatalError();
+    }
+
+    while (1)
+    {
+        uint32_t currentTimerCount;
+        uint32_t tickerPeriodsElapsedBackup;
+
+        tickerPeriodsElapsedBackup = mk82SystemTickerPeriodsElapsed;
+
+        currentTimerCount = PIT_GetCurrentTimerCount(PIT0, kPIT_Chnl_3);
+
+        *us = ((uint64_t)tickerPeriodsElapsedBackup + 1) * MK82_SYSTEM_TICKER_INTERRUPT_PERIOD_IN_MS * 1000 -
+              COUNT_TO_USEC((uint64_t)currentTimerCount, CLOCK_GetFreq(kCLOCK_BusClk));
+
+        if (tickerPeriodsElapsedBackup == mk82SystemTickerPeriodsElapsed)
+        {
+            break;
+        }
+    }
+}
+
+void mk82SystemTickerGetSessionID(uint32_t* sessionID)
+{
+    if (sessionID == NULL)
+    {
+        mk82SystemFatalError();
+    }
+
+    *sessionID = mk82SystemTickerSessionID;
+}
+
+void mk82SystemInitStageCompleted(uint32_t stage, uint64_t startTimeInUs, uint64_t endTimeInUs)
+{
+    if ((stage >= MK82_SYSTEM_MAX_INIT_STAGES) || (stage != mk82SystemInitInfo.completedStages) ||
+        (endTimeInUs < startTimeInUs))
+    {
+        mk82SystemFatalError();
+    }
+
+    if (stage == 0)
+    {
+        mk82SystemInitInfo.firstStageStartTimeInMs = (uint32_t)(startTimeInUs / 1000);
+    }
+
+    mk82SystemInitInfo.stageTimeInUs[stage] = (uint32_t)(endTimeInUs - startTimeInUs);
+    mk82SystemInitInfo.lastStageEndTimeInMs = (uint32_t)(endTimeInUs / 1000);
+    mk82SystemInitInfo.completedStages = stage + 1;
+}
+
+void mk82SystemInitCommandDelayed(void) { mk82SystemInitInfo.delayedCommands++; }
+
+void mk82SystemGetInitInfo(MK82_SYSTEM_INIT_INFO* info)
+{
+    if (info == NULL)
+    {
+        mk82SystemFatalError();
+    }
+
+    mk82SystemMemCpy((uint8_t*)info, (uint8_t*)&mk82SystemInitInfo, sizeof(MK82_SYSTEM_INIT_INFO));
+}
+
 void mk82SystemGetRandom(uint8_t* buffer, uint32_t bufferLength)
 {
     int calleeRetVal;
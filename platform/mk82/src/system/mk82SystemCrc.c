@@ -0,0 +1,70 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "mk82Global.h"
+#include "mk82GlobalInt.h"
+#include "mk82System.h"
+#include "mk82SystemInt.h"
+
+#ifdef FIRMWARE
+
+#include "fsl_device_registers.h"
+#include "fsl_crc.h"
+
+/*
+ * CRC-16 with the polynomial 0x1021, reflected input and output and no final XOR, the one UFFS computes from a table.
+ * A running CRC is passed back in as the seed to continue it. CRC0 holds the checksum unreflected, so the seed is
+ * the running CRC with its bits reversed.
+ *
+ * CRC0 is left clocked and configured between calls, so continuing a CRC only writes a new seed. mk82BootInfo
+ * reconfigures CRC0 for its CRC-32 and gates its clock, which the check below notices.
+ */
+static uint32_t mk82SystemCrc16Control = 0;
+
+static void mk82SystemCrc16Configure(uint16_t seed)
+{
+    crc_config_t crcConfig;
+
+    CRC_GetDefaultConfig(&crcConfig);
+
+    crcConfig.polynomial = MK82_SYSTEM_CRC16_POLYNOMIAL;
+    crcConfig.seed = seed;
+    crcConfig.reflectIn = true;
+    crcConfig.reflectOut = true;
+    crcConfig.complementChecksum = false;
+    crcConfig.crcBits = kCrcBits16;
+    crcConfig.crcResult = kCrcFinalChecksum;
+
+    CRC_Init(CRC0, &crcConfig);
+
+    mk82SystemCrc16Control = CRC0->CTRL;
+}
+
+uint16_t mk82SystemCrc16Update(const uint8_t* data, uint32_t length, uint16_t crc)
+{
+    uint16_t seed = __RBIT(crc) >> 16;
+
+    if (((SIM->SCGC6 & SIM_SCGC6_CRC_MASK) == 0) || (mk82SystemCrc16Control == 0) ||
+        (CRC0->CTRL != mk82SystemCrc16Control) || (CRC0->GPOLY != MK82_SYSTEM_CRC16_POLYNOMIAL))
+    {
+        mk82SystemCrc16Configure(seed);
+    }
+    else
+    {
+        CRC0->CTRL = mk82SystemCrc16Control | CRC_CTRL_WAS_MASK;
+        CRC0->DATA = seed;
+        CRC0->CTRL = mk82SystemCrc16Control;
+    }
+
+    CRC_WriteData(CRC0, data, length);
+
+    return CRC_Get16bitResult(CRC0);
+}
+
+#endif /* FIRMWARE */
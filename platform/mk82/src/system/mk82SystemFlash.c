@@ -0,0 +1,119 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "mk82Global.h"
+#include "mk82GlobalInt.h"
+#include "mk82System.h"
+#include "mk82SystemInt.h"
+
+#ifndef BOOTSTRAPPER
+
+#include "fsl_device_registers.h"
+#include "fsl_flash.h"
+
+/*
+ * The FTFA of the K82 has neither FlexRAM nor a program section command, so data is programmed one longword per
+ * command. Longwords that already hold their data, which is mostly erased flash left erased, are skipped, and the
+ * rest is programmed in short runs so that interrupts are only held off for one run at a time.
+ *
+ * Nothing may be fetched from flash while a command runs, and the USB stack that the USB0 and PIT0 handlers run
+ * through lives in flash, so every flash command is bracketed by mk82SystemFlashBeginOperation() and
+ * mk82SystemFlashEndOperation(), which keep interrupts disabled in between.
+ */
+
+static uint32_t mk82SystemFlashSavedPrimask;
+static uint32_t mk82SystemFlashOperationDepth = 0;
+
+void mk82SystemFlashBeginOperation(void)
+{
+    uint32_t primask;
+
+    primask = DisableGlobalIRQ();
+
+    if (mk82SystemFlashOperationDepth == 0)
+    {
+        mk82SystemFlashSavedPrimask = primask;
+    }
+
+    mk82SystemFlashOperationDepth++;
+}
+
+void mk82SystemFlashEndOperation(void)
+{
+    if (mk82SystemFlashOperationDepth == 0)
+    {
+        mk82SystemFatalError();
+    }
+
+    mk82SystemFlashOperationDepth--;
+
+    if (mk82SystemFlashOperationDepth == 0)
+    {
+        EnableGlobalIRQ(mk82SystemFlashSavedPrimask);
+    }
+}
+
+static uint16_t mk82SystemFlashIsProgrammed(uint32_t address, uint8_t* data)
+{
+    return mk82SystemMemCmp((uint8_t*)address, data, MK82_SYSTEM_FLASH_WRITE_UNIT_SIZE);
+}
+
+void mk82SystemFlashProgram(uint32_t address, uint8_t* data, uint32_t length)
+{
+    uint32_t offset = 0;
+
+    if (data == NULL)
+    {
+        mk82SystemFatalError();
+    }
+
+    if (((address % MK82_SYSTEM_FLASH_WRITE_UNIT_SIZE) != 0) || ((length % MK82_SYSTEM_FLASH_WRITE_UNIT_SIZE) != 0))
+    {
+        mk82SystemFatalError();
+    }
+
+    while (offset < length)
+    {
+        uint32_t runStart;
+        uint32_t runLength = 0;
+
+        while ((offset < length) &&
+               (mk82SystemFlashIsProgrammed(address + offset, data + offset) == MK82_CMP_EQUAL))
+        {
+            offset += MK82_SYSTEM_FLASH_WRITE_UNIT_SIZE;
+        }
+
+        runStart = offset;
+
+        while ((offset < length) && (runLength < MK82_SYSTEM_FLASH_MAX_PROGRAM_RUN) &&
+               (mk82SystemFlashIsProgrammed(address + offset, data + offset) != MK82_CMP_EQUAL))
+        {
+            offset += MK82_SYSTEM_FLASH_WRITE_UNIT_SIZE;
+            runLength += MK82_SYSTEM_FLASH_WRITE_UNIT_SIZE;
+        }
+
+        if (runLength != 0)
+        {
+            status_t calleeRetVal;
+
+            mk82SystemFlashBeginOperation();
+
+            calleeRetVal = FLASH_Program(&mk82FlashDriver, address + runStart, (uint32_t*)(data + runStart), runLength);
+
+            mk82SystemFlashEndOperation();
+
+            if (calleeRetVal != kStatus_FLASH_Success)
+            {
+                mk82SystemFatalError();
+            }
+        }
+    }
+}
+
+#endif /* BOOTSTRAPPER */
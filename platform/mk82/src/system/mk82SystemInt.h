@@ -20,6 +20,15 @@
 #error Unsupported platform
 #endif
 
-#define MK82_SYSTEM_TICKER_INTERRUPT_PERIOD_IN_MS (10000)
+#define MK82_SYSTEM_TICKER_INTERRUPT_PERIOD_IN_MS (1000)
+#define MK82_SYSTEM_TICKER_CHECK_MAGIC (0xA5C3E10F)
+
+/* The K82 program flash is written one longword per command */
+#define MK82_SYSTEM_FLASH_WRITE_UNIT_SIZE (FSL_FEATURE_FLASH_PFLASH_BLOCK_WRITE_UNIT_SIZE)
+/* Longest run programmed with interrupts disabled, about 120 us */
+#define MK82_SYSTEM_FLASH_MAX_PROGRAM_RUN (16 * MK82_SYSTEM_FLASH_WRITE_UNIT_SIZE)
+
+/* CRC-16 of the UFFS page data and names, used reflected */
+#define MK82_SYSTEM_CRC16_POLYNOMIAL (0x1021)
 
 #endif /* __MK82_SYSTEM_INT_H__ */
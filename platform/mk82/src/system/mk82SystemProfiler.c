@@ -0,0 +1,138 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "mk82Global.h"
+#include "mk82GlobalInt.h"
+#include "mk82System.h"
+#include "mk82SystemProfilerInt.h"
+
+#include "fsl_device_registers.h"
+#include "fsl_common.h"
+
+#if defined(FIRMWARE) && defined(USE_PROFILER)
+
+/*
+ * All four PIT channels are taken (CCID WTX, U2F HID, U2F user presence and the system ticker),
+ * so the sampler runs from the core SysTick timer which is otherwise unused by the firmware.
+ */
+
+static uint16_t mk82SystemProfilerHistogram[MK82_SYSTEM_PROFILER_NUMBER_OF_BUCKETS];
+static volatile uint32_t mk82SystemProfilerTotalSamples;
+static volatile uint32_t mk82SystemProfilerOutOfRegionSamples;
+static uint32_t mk82SystemProfilerSamplingRate;
+static uint16_t mk82SystemProfilerRunning = MK82_FALSE;
+
+#ifdef __GNUC__
+__attribute__((naked)) void SysTick_Handler(void)
+{
+    __asm volatile(
+        "tst lr, #4                             \n"
+        "ite eq                                 \n"
+        "mrseq r0, msp                          \n"
+        "mrsne r0, psp                          \n"
+        "ldr r0, [r0, #24]                      \n"
+        "b mk82SystemProfilerRecordSample       \n");
+}
+#else
+#error Unsupported platform
+#endif
+
+void mk82SystemProfilerRecordSample(uint32_t programCounter)
+{
+    mk82SystemProfilerTotalSamples++;
+
+    if ((programCounter >= MK82_SYSTEM_PROFILER_REGION_START) &&
+        (programCounter < (MK82_SYSTEM_PROFILER_REGION_START + MK82_SYSTEM_PROFILER_REGION_SIZE)))
+    {
+        uint32_t bucket;
+
+        bucket = (programCounter - MK82_SYSTEM_PROFILER_REGION_START) >> MK82_SYSTEM_PROFILER_BUCKET_SIZE_SHIFT;
+
+        if (mk82SystemProfilerHistogram[bucket] != MK82_SYSTEM_PROFILER_MAX_BUCKET_VALUE)
+        {
+            mk82SystemProfilerHistogram[bucket]++;
+        }
+    }
+    else
+    {
+        mk82SystemProfilerOutOfRegionSamples++;
+    }
+}
+
+void mk82SystemProfilerStart(uint32_t samplingRate)
+{
+    if ((samplingRate < MK82_SYSTEM_PROFILER_MIN_SAMPLING_RATE) ||
+        (samplingRate > MK82_SYSTEM_PROFILER_MAX_SAMPLING_RATE))
+    {
+        mk82SystemFatalError();
+    }
+
+    mk82SystemProfilerStop();
+
+    mk82SystemMemSet((uint8_t*)mk82SystemProfilerHistogram, 0x00, sizeof(mk82SystemProfilerHistogram));
+    mk82SystemProfilerTotalSamples = 0;
+    mk82SystemProfilerOutOfRegionSamples = 0;
+    mk82SystemProfilerSamplingRate = samplingRate;
+
+    if (SysTick_Config(SystemCoreClock / samplingRate) != 0)
+    {
+        mk82SystemFatalError();
+    }
+
+    NVIC_SetPriority(SysTick_IRQn, MK82_SYSTEM_PROFILER_INTERRUPT_PRIORITY);
+
+    mk82SystemProfilerRunning = MK82_TRUE;
+}
+
+void mk82SystemProfilerStop(void)
+{
+    SysTick->CTRL &= ~(SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk);
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+
+    mk82SystemProfilerRunning = MK82_FALSE;
+}
+
+void mk82SystemProfilerGetInfo(MK82_SYSTEM_PROFILER_INFO* info)
+{
+    if (info == NULL)
+    {
+        mk82SystemFatalError();
+    }
+
+    info->samplingRate = mk82SystemProfilerSamplingRate;
+    info->regionStart = MK82_SYSTEM_PROFILER_REGION_START;
+    info->bucketSize = MK82_SYSTEM_PROFILER_BUCKET_SIZE;
+    info->numberOfBuckets = MK82_SYSTEM_PROFILER_NUMBER_OF_BUCKETS;
+    info->totalSamples = mk82SystemProfilerTotalSamples;
+    info->outOfRegionSamples = mk82SystemProfilerOutOfRegionSamples;
+    info->running = mk82SystemProfilerRunning;
+}
+
+void mk82SystemProfilerReadHistogram(uint32_t firstBucket, uint16_t* buckets, uint32_t numberOfBuckets)
+{
+    uint32_t i;
+
+    if (buckets == NULL)
+    {
+        mk82SystemFatalError();
+    }
+
+    if ((firstBucket >= MK82_SYSTEM_PROFILER_NUMBER_OF_BUCKETS) ||
+        (numberOfBuckets > (MK82_SYSTEM_PROFILER_NUMBER_OF_BUCKETS - firstBucket)))
+    {
+        mk82SystemFatalError();
+    }
+
+    for (i = 0; i < numberOfBuckets; i++)
+    {
+        buckets[i] = mk82SystemProfilerHistogram[firstBucket + i];
+    }
+}
+
+#endif /* FIRMWARE && USE_PROFILER */
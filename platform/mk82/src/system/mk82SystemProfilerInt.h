@@ -0,0 +1,27 @@
+/*
+ * Secalot firmware.
+ * Copyright (c) 2018 Matvey Mukha <matvey.mukha@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __MK82_SYSTEM_PROFILER_INT_H__
+#define __MK82_SYSTEM_PROFILER_INT_H__
+
+#define MK82_SYSTEM_PROFILER_REGION_START (MK82_FLASH_FIRMWARE_START)
+#define MK82_SYSTEM_PROFILER_REGION_SIZE (MK82_FLASH_FIRMWARE_SIZE)
+
+#define MK82_SYSTEM_PROFILER_BUCKET_SIZE_SHIFT (6)
+#define MK82_SYSTEM_PROFILER_BUCKET_SIZE (1UL << MK82_SYSTEM_PROFILER_BUCKET_SIZE_SHIFT)
+#define MK82_SYSTEM_PROFILER_NUMBER_OF_BUCKETS (MK82_SYSTEM_PROFILER_REGION_SIZE >> MK82_SYSTEM_PROFILER_BUCKET_SIZE_SHIFT)
+
+#define MK82_SYSTEM_PROFILER_MAX_BUCKET_VALUE (0xFFFF)
+
+#define MK82_SYSTEM_PROFILER_INTERRUPT_PRIORITY (0U)
+
+/* Called from the SysTick handler with the PC taken from the exception stack frame. */
+void mk82SystemProfilerRecordSample(uint32_t programCounter);
+
+#endif /* __MK82_SYSTEM_PROFILER_INT_H__ */
@@ -89,14 +89,26 @@ static usb_status_t USB_DeviceKeyboardInterruptIn(usb_device_handle handle,
 static usb_status_t USB_DeviceBtcInterruptOut(usb_device_handle handle,
                                               usb_device_endpoint_callback_message_struct_t *message,
                                               void *callbackParam);
+#ifdef USE_VENDOR_BULK
+static usb_status_t USB_DeviceVendorBulkIn(usb_device_handle handle,
+                                           usb_device_endpoint_callback_message_struct_t *message, void *callbackParam);
+static usb_status_t USB_DeviceVendorBulkOut(usb_device_handle handle,
+                                            usb_device_endpoint_callback_message_struct_t *message,
+                                            void *callbackParam);
+#endif /* USE_VENDOR_BULK */
 #endif /* FIRMWARE */
 
 static void mk82UsbFatalError(void);
 static void mk82UsbCcidSendDataBlocking(uint8_t *buffer, uint32_t bufferLength);
 #ifdef FIRMWARE
 static void mk82UsbU2fSendPacketBlocking(void);
-static void mk82UsbKeyboardSendPacketBlocking(void);
+static uint16_t mk82UsbKeyboardPrepareNextReport(void);
+static void mk82UsbKeyboardSendReport(void);
 static void mk82UsbBtcSendPacketBlocking(void);
+#ifdef USE_VENDOR_BULK
+static void mk82UsbVendorSendDataBlocking(uint32_t dataLength);
+static void mk82UsbVendorSendWrongLength(void);
+#endif /* USE_VENDOR_BULK */
 #endif /* FIRMWARE */
 static uint16_t mk82UsbCheckForAnEvent(uint32_t dataTypesToProcess);
 
@@ -118,7 +130,10 @@ static volatile uint16_t mk82UsbU2fPacketReceived = MK82_FALSE;
 static volatile uint16_t mk82UsbU2fTimerExpired = MK82_FALSE;
 
 static uint8_t mk82UsbKeyboardOutgoingPacketBuffer[MK82_USB_KBD_INTERRUPT_ENDPOINT_PACKET_SIZE];
-static volatile uint16_t mk82UsbKeyboardPacketSent = MK82_FALSE;
+static uint8_t mk82UsbKeyboardString[MK82_USB_KBD_MAX_STRING_LENGTH];
+static uint32_t mk82UsbKeyboardStringLength = 0;
+static uint32_t mk82UsbKeyboardStringPosition = 0;
+static volatile uint16_t mk82UsbKeyboardBusy = MK82_FALSE;
 
 static uint8_t mk82UsbBtcHidDataBuffer[BTC_HID_MAX_DATA_SIZE];
 static BTC_HID_HANDLE mk82UsbBtcHidHandle;
@@ -126,6 +141,17 @@ static uint8_t mk82UsbBtcIncomingPacketBuffer[MK82_USB_BTC_INTERRUPT_ENDPOINTS_P
 static uint8_t mk82UsbBtcOutgoingPacketBuffer[MK82_USB_BTC_INTERRUPT_ENDPOINTS_PACKET_SIZE];
 static volatile uint16_t mk82UsbBtcPacketSent = MK82_FALSE;
 static volatile uint16_t mk82UsbBtcPacketReceived = MK82_FALSE;
+
+#ifdef USE_VENDOR_BULK
+static uint8_t mk82UsbVendorDataBuffer[MK82_USB_VENDOR_DATA_BUFFER_SIZE] MK82_ALIGN(4);
+static volatile uint16_t mk82UsbVendorDataSent = MK82_FALSE;
+static volatile uint16_t mk82UsbVendorDataReceived = MK82_FALSE;
+static uint32_t mk82UsbVendorReceivedDataLength = 0;
+static uint16_t mk82UsbVendorDiscarding = MK82_FALSE;
+static uint16_t mk82UsbBtcMessageSource = MK82_USB_BTC_SOURCE_HID;
+#endif /* USE_VENDOR_BULK */
+
+static volatile uint16_t mk82UsbConfigured = MK82_FALSE;
 #endif /* FIRMWARE */
 
 static uint16_t mk82UsbCheckForNewCommandInternal(uint32_t dataTypesToProcess, uint8_t **data, uint32_t *dataLength,
@@ -284,7 +310,18 @@ static usb_status_t USB_DeviceKeyboardInterruptIn(usb_device_handle handle,
 {
     usb_status_t error = kStatus_USB_Error;
 
-    mk82UsbKeyboardPacketSent = MK82_TRUE;
+    if (mk82UsbKeyboardBusy == MK82_TRUE)
+    {
+        if (mk82UsbKeyboardPrepareNextReport() == MK82_TRUE)
+        {
+            mk82UsbKeyboardSendReport();
+        }
+        else
+        {
+            mk82UsbKeyboardBusy = MK82_FALSE;
+        }
+    }
+
     error = kStatus_USB_Success;
 
     return error;
@@ -344,6 +381,64 @@ static usb_status_t USB_DeviceBtcInterruptOut(usb_device_handle handle,
     return kStatus_USB_Success;
 }
 
+#ifdef USE_VENDOR_BULK
+/*!
+ * @brief Vendor bulk in pipe callback function.
+ *
+ * This function serves as the callback function for vendor bulk in pipe.
+ *
+ * @param handle The USB device handle.
+ * @param message The endpoint callback message
+ * @param callbackParam The parameter of the callback.
+ *
+ * @return A USB error code or kStatus_USB_Success.
+ */
+static usb_status_t USB_DeviceVendorBulkIn(usb_device_handle handle,
+                                           usb_device_endpoint_callback_message_struct_t *message, void *callbackParam)
+{
+    usb_status_t error = kStatus_USB_Error;
+
+    if ((message->length != 0) && (!(message->length % MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE)))
+    {
+        /* The host reads a whole response in one transfer, so end it with a zero length packet. */
+        USB_DeviceSendRequest(handle, MK82_USB_VENDOR_BULK_IN_ENDPOINT, NULL, 0);
+        error = kStatus_USB_Success;
+    }
+    else
+    {
+        mk82UsbVendorDataSent = MK82_TRUE;
+        error = kStatus_USB_Success;
+    }
+
+    return error;
+}
+
+/*!
+ * @brief Vendor bulk out pipe callback function.
+ *
+ * This function serves as the callback function for vendor bulk out pipe.
+ *
+ * @param handle The USB device handle.
+ * @param message The endpoint callback message
+ * @param callbackParam The parameter of the callback.
+ *
+ * @return A USB error code or kStatus_USB_Success.
+ */
+static usb_status_t USB_DeviceVendorBulkOut(usb_device_handle handle,
+                                            usb_device_endpoint_callback_message_struct_t *message,
+                                            void *callbackParam)
+{
+    if (message->length == USB_UNINITIALIZED_VAL_32)
+    {
+        return kStatus_USB_Error;
+    }
+
+    mk82UsbVendorReceivedDataLength = message->length;
+    mk82UsbVendorDataReceived = MK82_TRUE;
+    return kStatus_USB_Success;
+}
+#endif /* USE_VENDOR_BULK */
+
 #endif /* FIRMWARE */
 
 /*!
@@ -410,6 +505,10 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
     {
         case kUSB_DeviceEventBusReset:
         {
+#ifdef FIRMWARE
+            mk82UsbConfigured = MK82_FALSE;
+            mk82UsbKeyboardBusy = MK82_FALSE;
+#endif /* FIRMWARE */
             USB_DeviceControlPipeInit(mk82UsbDeviceHandle);
         }
         break;
@@ -506,6 +605,32 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
                     epInitStruct.maxPacketSize = MK82_USB_BTC_INTERRUPT_ENDPOINTS_PACKET_SIZE;
 
                     USB_DeviceInitEndpoint(mk82UsbDeviceHandle, &epInitStruct, &endpointCallback);
+
+#ifdef USE_VENDOR_BULK
+                    /* Vendor */
+
+                    endpointCallback.callbackFn = USB_DeviceVendorBulkIn;
+                    endpointCallback.callbackParam = handle;
+
+                    epInitStruct.zlt = 0;
+                    epInitStruct.transferType = USB_ENDPOINT_BULK;
+                    epInitStruct.endpointAddress = MK82_USB_VENDOR_BULK_IN_ENDPOINT |
+                                                   (USB_IN << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT);
+                    epInitStruct.maxPacketSize = MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE;
+
+                    USB_DeviceInitEndpoint(mk82UsbDeviceHandle, &epInitStruct, &endpointCallback);
+
+                    endpointCallback.callbackFn = USB_DeviceVendorBulkOut;
+                    endpointCallback.callbackParam = handle;
+
+                    epInitStruct.zlt = 0;
+                    epInitStruct.transferType = USB_ENDPOINT_BULK;
+                    epInitStruct.endpointAddress = MK82_USB_VENDOR_BULK_OUT_ENDPOINT |
+                                                   (USB_OUT << USB_DESCRIPTOR_ENDPOINT_ADDRESS_DIRECTION_SHIFT);
+                    epInitStruct.maxPacketSize = MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE;
+
+                    USB_DeviceInitEndpoint(mk82UsbDeviceHandle, &epInitStruct, &endpointCallback);
+#endif /* USE_VENDOR_BULK */
 #endif /* FIRMWARE */
 
                     USB_DeviceRecvRequest(handle, MK82_USB_CCID_BULK_OUT_ENDPOINT, mk82UsbCcidPacketBuffer,
@@ -515,6 +640,12 @@ usb_status_t USB_DeviceCallback(usb_device_handle handle, uint32_t event, void *
                                           MK82_USB_U2F_INTERRUPT_ENDPOINTS_PACKET_SIZE);
                     USB_DeviceRecvRequest(handle, MK82_USB_BTC_INTERRUPT_OUT_ENDPOINT, mk82UsbBtcIncomingPacketBuffer,
                                           MK82_USB_BTC_INTERRUPT_ENDPOINTS_PACKET_SIZE);
+#ifdef USE_VENDOR_BULK
+                    USB_DeviceRecvRequest(handle, MK82_USB_VENDOR_BULK_OUT_ENDPOINT, mk82UsbVendorDataBuffer,
+                                          sizeof(mk82UsbVendorDataBuffer));
+#endif /* USE_VENDOR_BULK */
+
+                    mk82UsbConfigured = MK82_TRUE;
 #endif /* FIRMWARE */
 
                     error = kStatus_USB_Success;
@@ -673,7 +804,7 @@ static void mk82UsbU2fSendPacketBlocking(void)
     mk82UsbU2fPacketSent = MK82_FALSE;
 }
 
-static void mk82UsbKeyboardSendPacketBlocking(void)
+static void mk82UsbKeyboardSendReport(void)
 {
     usb_status_t error = kStatus_USB_Error;
 
@@ -684,12 +815,89 @@ static void mk82UsbKeyboardSendPacketBlocking(void)
     {
         mk82UsbFatalError();
     }
+}
 
-    while (mk82UsbKeyboardPacketSent != MK82_TRUE)
+/*
+ * Every report presses exactly one new key and keeps up to five of the previous ones held, so the host sees the
+ * key downs in string order. A release report is only needed when the next key is still held or the shift state
+ * changes, and once at the end.
+ */
+static uint16_t mk82UsbKeyboardPrepareNextReport(void)
+{
+    MK82_USB_KEYBOARD_INPUT_REPORT *report = (MK82_USB_KEYBOARD_INPUT_REPORT *)mk82UsbKeyboardOutgoingPacketBuffer;
+    uint32_t numberOfPressedKeys = 0;
+    uint8_t character = 0;
+    uint8_t key;
+    uint8_t modifier;
+    uint32_t i;
+
+    while ((numberOfPressedKeys < sizeof(report->pressedKeys)) && (report->pressedKeys[numberOfPressedKeys] != 0x00))
     {
-    };
+        numberOfPressedKeys++;
+    }
+
+    while (mk82UsbKeyboardStringPosition < mk82UsbKeyboardStringLength)
+    {
+        character = mk82UsbKeyboardString[mk82UsbKeyboardStringPosition];
+
+        if ((character < sizeof(mk82UsbKeyboardKeyTable)) && (mk82UsbKeyboardKeyTable[character] != 0x00))
+        {
+            break;
+        }
+
+        mk82UsbKeyboardStringPosition++;
+    }
+
+    if (mk82UsbKeyboardStringPosition >= mk82UsbKeyboardStringLength)
+    {
+        if ((numberOfPressedKeys == 0) && (report->keyModifier == 0x00))
+        {
+            return MK82_FALSE;
+        }
+
+        mk82SystemMemSet((uint8_t *)report, 0x00, sizeof(MK82_USB_KEYBOARD_INPUT_REPORT));
+
+        return MK82_TRUE;
+    }
+
+    key = mk82UsbKeyboardKeyTable[character];
+    modifier = mk82UsbKeyboardShiftModifierTable[character];
+
+    if (numberOfPressedKeys != 0)
+    {
+        for (i = 0; i < numberOfPressedKeys; i++)
+        {
+            if (report->pressedKeys[i] == key)
+            {
+                break;
+            }
+        }
+
+        if ((i < numberOfPressedKeys) || (modifier != report->keyModifier))
+        {
+            mk82SystemMemSet((uint8_t *)report, 0x00, sizeof(MK82_USB_KEYBOARD_INPUT_REPORT));
+
+            return MK82_TRUE;
+        }
+    }
+
+    if (numberOfPressedKeys == sizeof(report->pressedKeys))
+    {
+        /* Let go of the oldest key to make room. */
+        for (i = 1; i < numberOfPressedKeys; i++)
+        {
+            report->pressedKeys[i - 1] = report->pressedKeys[i];
+        }
+
+        numberOfPressedKeys--;
+    }
+
+    report->keyModifier = modifier;
+    report->pressedKeys[numberOfPressedKeys] = key;
+
+    mk82UsbKeyboardStringPosition++;
 
-    mk82UsbKeyboardPacketSent = MK82_FALSE;
+    return MK82_TRUE;
 }
 
 static void mk82UsbBtcSendPacketBlocking(void)
@@ -710,6 +918,35 @@ static void mk82UsbBtcSendPacketBlocking(void)
 
     mk82UsbBtcPacketSent = MK82_FALSE;
 }
+
+#ifdef USE_VENDOR_BULK
+static void mk82UsbVendorSendDataBlocking(uint32_t dataLength)
+{
+    usb_status_t error = kStatus_USB_Error;
+
+    error = USB_DeviceSendRequest(mk82UsbDeviceHandle, MK82_USB_VENDOR_BULK_IN_ENDPOINT, mk82UsbVendorDataBuffer,
+                                  dataLength);
+
+    if (error != kStatus_USB_Success)
+    {
+        mk82UsbFatalError();
+    }
+
+    while (mk82UsbVendorDataSent != MK82_TRUE)
+    {
+    };
+
+    mk82UsbVendorDataSent = MK82_FALSE;
+}
+
+static void mk82UsbVendorSendWrongLength(void)
+{
+    mk82UsbVendorDataBuffer[0] = (uint8_t)(APDU_CORE_SW_WRONG_LENGTH >> 8);
+    mk82UsbVendorDataBuffer[1] = (uint8_t)APDU_CORE_SW_WRONG_LENGTH;
+
+    mk82UsbVendorSendDataBlocking(2);
+}
+#endif /* USE_VENDOR_BULK */
 #endif /* FIRMWARE */
 
 static uint16_t mk82UsbCheckForAnEvent(uint32_t dataTypesToProcess)
@@ -741,6 +978,14 @@ static uint16_t mk82UsbCheckForAnEvent(uint32_t dataTypesToProcess)
 
         retVal = MK82_USB_EVENT_BTC_PACKET_RECEIVED;
     }
+#ifdef USE_VENDOR_BULK
+    else if (((dataTypesToProcess & MK82_GLOBAL_PROCESS_BTC_MESSAGE) != 0) && (mk82UsbVendorDataReceived == MK82_TRUE))
+    {
+        mk82UsbVendorDataReceived = MK82_FALSE;
+
+        retVal = MK82_USB_EVENT_VENDOR_DATA_RECEIVED;
+    }
+#endif /* USE_VENDOR_BULK */
 #endif /* FIRMWARE */
     else
     {
@@ -795,6 +1040,19 @@ void mk82UsbInit(void)
 #endif /* FIRMWARE */
 }
 
+#ifdef FIRMWARE
+uint16_t mk82UsbIsConfigured(void) { return mk82UsbConfigured; }
+
+uint8_t mk82UsbGetCcidSlot(void)
+{
+    uint8_t slot;
+
+    ccidCoreGetSlot(&mk82UsbCcidHandle, &slot);
+
+    return slot;
+}
+#endif /* FIRMWARE */
+
 uint16_t mk82UsbCheckForNewCommand(uint32_t dataTypesToProcess, uint8_t **data, uint32_t *dataLength,
                                    uint16_t *dataType)
 {
@@ -968,6 +1226,9 @@ static uint16_t mk82UsbCheckForNewCommandInternal(uint32_t dataTypesToProcess, u
             *data = mk82UsbBtcHidDataBuffer;
             *dataLength = (uint16_t)incomingDataSize;
             *dataType = MK82_GLOBAL_DATATYPE_BTC_MESSAGE;
+#ifdef USE_VENDOR_BULK
+            mk82UsbBtcMessageSource = MK82_USB_BTC_SOURCE_HID;
+#endif /* USE_VENDOR_BULK */
 
             newCommandReceived = MK82_USB_COMMAND_RECEIVED;
         }
@@ -981,6 +1242,48 @@ static uint16_t mk82UsbCheckForNewCommandInternal(uint32_t dataTypesToProcess, u
             mk82UsbFatalError();
         }
     }
+#ifdef USE_VENDOR_BULK
+    else if (event == MK82_USB_EVENT_VENDOR_DATA_RECEIVED)
+    {
+        /*
+         * Every transfer is one APDU for the BTC dispatcher, the same as a reassembled btcHid message. A transfer
+         * that fills the buffer has not ended: the rest of it arrives as further transfers, which are dropped up to
+         * the short packet that ends it. The host then gets a wrong length status instead of having the tail run
+         * as a command.
+         */
+        if (mk82UsbVendorReceivedDataLength == sizeof(mk82UsbVendorDataBuffer))
+        {
+            mk82UsbVendorDiscarding = MK82_TRUE;
+
+            USB_DeviceRecvRequest(mk82UsbDeviceHandle, MK82_USB_VENDOR_BULK_OUT_ENDPOINT, mk82UsbVendorDataBuffer,
+                                  sizeof(mk82UsbVendorDataBuffer));
+        }
+        else if ((mk82UsbVendorDiscarding == MK82_TRUE) ||
+                 (mk82UsbVendorReceivedDataLength > BTC_HID_MAX_DATA_SIZE))
+        {
+            mk82UsbVendorDiscarding = MK82_FALSE;
+
+            mk82UsbVendorSendWrongLength();
+
+            USB_DeviceRecvRequest(mk82UsbDeviceHandle, MK82_USB_VENDOR_BULK_OUT_ENDPOINT, mk82UsbVendorDataBuffer,
+                                  sizeof(mk82UsbVendorDataBuffer));
+        }
+        else if (mk82UsbVendorReceivedDataLength != 0)
+        {
+            *data = mk82UsbVendorDataBuffer;
+            *dataLength = mk82UsbVendorReceivedDataLength;
+            *dataType = MK82_GLOBAL_DATATYPE_BTC_MESSAGE;
+            mk82UsbBtcMessageSource = MK82_USB_BTC_SOURCE_VENDOR;
+
+            newCommandReceived = MK82_USB_COMMAND_RECEIVED;
+        }
+        else
+        {
+            USB_DeviceRecvRequest(mk82UsbDeviceHandle, MK82_USB_VENDOR_BULK_OUT_ENDPOINT, mk82UsbVendorDataBuffer,
+                                  sizeof(mk82UsbVendorDataBuffer));
+        }
+    }
+#endif /* USE_VENDOR_BULK */
 #endif /* FIRMWARE */
     else if (event == MK82_USB_EVENT_NOTHING_HAPPENED)
     {
@@ -1029,6 +1332,15 @@ void mk82UsbSendResponse(uint32_t dataLength, uint16_t dataType)
         USB_DeviceRecvRequest(mk82UsbDeviceHandle, MK82_USB_U2F_INTERRUPT_OUT_ENDPOINT, mk82UsbU2fIncomingPacketBuffer,
                               MK82_USB_U2F_INTERRUPT_ENDPOINTS_PACKET_SIZE);
     }
+#ifdef USE_VENDOR_BULK
+    else if ((dataType == MK82_GLOBAL_DATATYPE_BTC_MESSAGE) && (mk82UsbBtcMessageSource == MK82_USB_BTC_SOURCE_VENDOR))
+    {
+        mk82UsbVendorSendDataBlocking(dataLength);
+
+        USB_DeviceRecvRequest(mk82UsbDeviceHandle, MK82_USB_VENDOR_BULK_OUT_ENDPOINT, mk82UsbVendorDataBuffer,
+                              sizeof(mk82UsbVendorDataBuffer));
+    }
+#endif /* USE_VENDOR_BULK */
     else if (dataType == MK82_GLOBAL_DATATYPE_BTC_MESSAGE)
     {
         uint16_t moreFramesAvailable;
@@ -1056,26 +1368,36 @@ void mk82UsbSendResponse(uint32_t dataLength, uint16_t dataType)
 #ifdef FIRMWARE
 void mk82UsbTypeStringWithAKeyboard(uint8_t *stringToType, uint32_t stringLength)
 {
-    MK82_USB_KEYBOARD_INPUT_REPORT *report = (MK82_USB_KEYBOARD_INPUT_REPORT *)mk82UsbKeyboardOutgoingPacketBuffer;
-    uint32_t i;
+    if (stringToType == NULL)
+    {
+        mk82UsbFatalError();
+    }
 
-    for (i = 0; i < stringLength; i++)
+    if (stringLength > sizeof(mk82UsbKeyboardString))
     {
-        if (stringToType[i] < sizeof(mk82UsbKeyboardKeyTable))
-        {
-            mk82SystemMemSet((uint8_t *)report, 0x00, sizeof(MK82_USB_KEYBOARD_INPUT_REPORT));
+        mk82UsbFatalError();
+    }
 
-            report->keyModifier = mk82UsbKeyboardShiftModifierTable[stringToType[i]];
-            report->pressedKeys[0] = mk82UsbKeyboardKeyTable[stringToType[i]];
+    if ((mk82UsbKeyboardBusy == MK82_TRUE) || (mk82UsbConfigured != MK82_TRUE))
+    {
+        return;
+    }
 
-            mk82UsbKeyboardSendPacketBlocking();
+    mk82SystemMemCpy(mk82UsbKeyboardString, stringToType, stringLength);
+    mk82UsbKeyboardStringLength = stringLength;
+    mk82UsbKeyboardStringPosition = 0;
 
-            mk82SystemMemSet((uint8_t *)report, 0x00, sizeof(MK82_USB_KEYBOARD_INPUT_REPORT));
+    mk82SystemMemSet(mk82UsbKeyboardOutgoingPacketBuffer, 0x00, sizeof(mk82UsbKeyboardOutgoingPacketBuffer));
 
-            mk82UsbKeyboardSendPacketBlocking();
-        }
+    if (mk82UsbKeyboardPrepareNextReport() == MK82_TRUE)
+    {
+        /* The rest of the string is typed from the interrupt in callback. */
+        mk82UsbKeyboardBusy = MK82_TRUE;
+        mk82UsbKeyboardSendReport();
     }
 }
+
+uint16_t mk82UsbKeyboardIsBusy(void) { return mk82UsbKeyboardBusy; }
 #endif /* FIRMWARE */
 
 #ifdef FIRMWARE
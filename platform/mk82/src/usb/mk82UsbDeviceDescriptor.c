@@ -275,9 +275,99 @@ static uint8_t mk82UsbDeviceConfigurationDescriptor[] = {
     USB_ENDPOINT_INTERRUPT, USB_SHORT_GET_LOW(MK82_USB_BTC_INTERRUPT_ENDPOINTS_PACKET_SIZE),
     USB_SHORT_GET_HIGH(MK82_USB_BTC_INTERRUPT_ENDPOINTS_PACKET_SIZE),
     MK82_USB_BTC_INTERRUPT_ENDPOINTS_POLLING_INTERVAL, /* The polling interval value is every 0 Frames */
+
+#ifdef USE_VENDOR_BULK
+    /* Vendor Interface Descriptor */
+    USB_DESCRIPTOR_LENGTH_INTERFACE, USB_DESCRIPTOR_TYPE_INTERFACE, MK82_USB_VENDOR_INTERFACE_NUMBER, 0x00,
+    MK82_USB_VENDOR_NUMBER_OF_ENDPOINTS, MK82_USB_VENDOR_CLASS, MK82_USB_VENDOR_SUBCLASS, MK82_USB_VENDOR_PROTOCOL,
+    0x00, /* Interface Description String Index*/
+
+    /*Vendor Bulk IN Endpoint descriptor */
+    USB_DESCRIPTOR_LENGTH_ENDPOINT, USB_DESCRIPTOR_TYPE_ENDPOINT, MK82_USB_VENDOR_BULK_IN_ENDPOINT | (USB_IN << 7U),
+    USB_ENDPOINT_BULK, USB_SHORT_GET_LOW(MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE),
+    USB_SHORT_GET_HIGH(MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE), 0x00, /* Ignored for bulk endpoints */
+
+    /*Vendor Bulk OUT Endpoint descriptor */
+    USB_DESCRIPTOR_LENGTH_ENDPOINT, USB_DESCRIPTOR_TYPE_ENDPOINT, MK82_USB_VENDOR_BULK_OUT_ENDPOINT | (USB_OUT << 7U),
+    USB_ENDPOINT_BULK, USB_SHORT_GET_LOW(MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE),
+    USB_SHORT_GET_HIGH(MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE), 0x00, /* Ignored for bulk endpoints */
+#endif                                                 /* USE_VENDOR_BULK */
 #endif                                                 /* FIRMWARE */
 };
 
+#if defined(FIRMWARE) && defined(USE_VENDOR_BULK)
+/*
+ * The BOS descriptor advertises the vendor interface through two platform capabilities: WebUSB, so browsers can
+ * claim it, and MS OS 2.0, so Windows binds WinUSB to it without an INF.
+ */
+static uint8_t mk82UsbBosDescriptor[MK82_USB_BOS_TOTAL_LENGTH] = {
+    MK82_USB_BOS_DESCRIPTOR_LENGTH, MK82_USB_DESCRIPTOR_TYPE_BOS, USB_SHORT_GET_LOW(MK82_USB_BOS_TOTAL_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_BOS_TOTAL_LENGTH), MK82_USB_BOS_NUMBER_OF_CAPABILITIES,
+
+    /* WebUSB platform capability, UUID 3408B638-09A9-47A0-8BFD-A0768815B665 */
+    MK82_USB_WEBUSB_CAPABILITY_LENGTH, MK82_USB_DESCRIPTOR_TYPE_DEVICE_CAPABILITY,
+    MK82_USB_DEVICE_CAPABILITY_TYPE_PLATFORM, 0x00, 0x38, 0xB6, 0x08, 0x34, 0xA9, 0x09, 0xA0, 0x47, 0x8B, 0xFD, 0xA0,
+    0x76, 0x88, 0x15, 0xB6, 0x65, USB_SHORT_GET_LOW(MK82_USB_WEBUSB_VERSION),
+    USB_SHORT_GET_HIGH(MK82_USB_WEBUSB_VERSION), MK82_USB_WEBUSB_VENDOR_CODE, 0x00, /* No landing page */
+
+    /* MS OS 2.0 platform capability, UUID D8DD60DF-4589-4CC7-9CD2-659D9E648A9F */
+    MK82_USB_MS_OS_20_CAPABILITY_LENGTH, MK82_USB_DESCRIPTOR_TYPE_DEVICE_CAPABILITY,
+    MK82_USB_DEVICE_CAPABILITY_TYPE_PLATFORM, 0x00, 0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C, 0x9C, 0xD2, 0x65,
+    0x9D, 0x9E, 0x64, 0x8A, 0x9F, USB_LONG_GET_BYTE0(MK82_USB_MS_OS_20_WINDOWS_VERSION),
+    USB_LONG_GET_BYTE1(MK82_USB_MS_OS_20_WINDOWS_VERSION), USB_LONG_GET_BYTE2(MK82_USB_MS_OS_20_WINDOWS_VERSION),
+    USB_LONG_GET_BYTE3(MK82_USB_MS_OS_20_WINDOWS_VERSION), USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_SET_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_SET_LENGTH), MK82_USB_MS_OS_20_VENDOR_CODE,
+    0x00, /* No alternate enumeration */
+};
+
+static uint8_t mk82UsbMsOs20DescriptorSet[MK82_USB_MS_OS_20_SET_LENGTH] = {
+    /* Descriptor set header */
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_SET_HEADER_LENGTH), USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_SET_HEADER_LENGTH),
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_SET_HEADER_DESCRIPTOR),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_SET_HEADER_DESCRIPTOR),
+    USB_LONG_GET_BYTE0(MK82_USB_MS_OS_20_WINDOWS_VERSION), USB_LONG_GET_BYTE1(MK82_USB_MS_OS_20_WINDOWS_VERSION),
+    USB_LONG_GET_BYTE2(MK82_USB_MS_OS_20_WINDOWS_VERSION), USB_LONG_GET_BYTE3(MK82_USB_MS_OS_20_WINDOWS_VERSION),
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_SET_LENGTH), USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_SET_LENGTH),
+
+    /* Configuration subset header */
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_SUBSET_HEADER_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_SUBSET_HEADER_LENGTH),
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_SUBSET_HEADER_CONFIGURATION),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_SUBSET_HEADER_CONFIGURATION), 0x00, 0x00,
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_CONFIGURATION_SUBSET_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_CONFIGURATION_SUBSET_LENGTH),
+
+    /* Function subset header */
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_SUBSET_HEADER_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_SUBSET_HEADER_LENGTH),
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_SUBSET_HEADER_FUNCTION),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_SUBSET_HEADER_FUNCTION),
+    MK82_USB_VENDOR_INTERFACE_NUMBER, 0x00, USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_FUNCTION_SUBSET_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_FUNCTION_SUBSET_LENGTH),
+
+    /* Compatible ID */
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_COMPATIBLE_ID_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_COMPATIBLE_ID_LENGTH),
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_FEATURE_COMPATIBLE_ID),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_FEATURE_COMPATIBLE_ID),
+    'W', 'I', 'N', 'U', 'S', 'B', 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+
+    /* Registry property */
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_REG_PROPERTY_LENGTH), USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_REG_PROPERTY_LENGTH),
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_FEATURE_REG_PROPERTY),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_FEATURE_REG_PROPERTY),
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_REG_MULTI_SZ), USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_REG_MULTI_SZ),
+    USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_PROPERTY_NAME_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_PROPERTY_NAME_LENGTH),
+    'D', 0, 'e', 0, 'v', 0, 'i', 0, 'c', 0, 'e', 0, 'I', 0, 'n', 0, 't', 0, 'e', 0, 'r', 0, 'f', 0, 'a', 0, 'c', 0, 'e',
+    0, 'G', 0, 'U', 0, 'I', 0, 'D', 0, 's', 0, 0, 0, USB_SHORT_GET_LOW(MK82_USB_MS_OS_20_PROPERTY_DATA_LENGTH),
+    USB_SHORT_GET_HIGH(MK82_USB_MS_OS_20_PROPERTY_DATA_LENGTH), '{', 0, 'B', 0, '2', 0, '5', 0, '0', 0, '9', 0, '7', 0,
+    '4', 0, 'D', 0, '-', 0, '5', 0, 'E', 0, '1', 0, '3', 0, '-', 0, '4', 0, 'E', 0, '3', 0, '3', 0, '-', 0, 'A', 0, '9',
+    0, '7', 0, '4', 0, '-', 0, '8', 0, 'F', 0, '8', 0, 'B', 0, 'C', 0, 'E', 0, 'F', 0, 'A', 0, 'E', 0, 'F', 0, '8', 0,
+    '3', 0, '}', 0, 0, 0, 0, 0,
+};
+#endif /* defined(FIRMWARE) && defined(USE_VENDOR_BULK) */
+
 /* Define string descriptor */
 static uint8_t mk82UsbDeviceString0[MK82_USB_DESCRIPTOR_LENGTH_STRING0] = {sizeof(mk82UsbDeviceString0),
                                                                            USB_DESCRIPTOR_TYPE_STRING, 0x09, 0x04};
@@ -432,6 +522,14 @@ usb_status_t USB_DeviceGetDescriptor(usb_device_handle handle, usb_setup_struct_
         }
 #endif /* FIRMWARE */
         break;
+#if defined(FIRMWARE) && defined(USE_VENDOR_BULK)
+        case MK82_USB_DESCRIPTOR_TYPE_BOS:
+        {
+            *buffer = mk82UsbBosDescriptor;
+            *length = sizeof(mk82UsbBosDescriptor);
+        }
+        break;
+#endif /* defined(FIRMWARE) && defined(USE_VENDOR_BULK) */
         case USB_DESCRIPTOR_TYPE_STRING:
         {
             if (descriptorIndex == 0)
@@ -484,6 +582,34 @@ usb_status_t USB_DeviceGetDescriptor(usb_device_handle handle, usb_setup_struct_
     return ret;
 }
 
+/*!
+ * @brief Get the vendor descriptor.
+ *
+ * The function is used to answer the vendor requests announced in the BOS descriptor. Only the MS OS 2.0
+ * descriptor set is served, WebUSB landing page requests are not supported.
+ *
+ * @param handle              The device handle.
+ * @param setup               The setup packet buffer address.
+ * @param length              It is an OUT parameter, return the data length need to be sent to host.
+ * @param buffer              It is an OUT parameter, return the data buffer address.
+ *
+ * @return A USB error code or kStatus_USB_Success.
+ */
+usb_status_t USB_DeviceProcessVendorRequest(usb_device_handle handle, usb_setup_struct_t *setup, uint32_t *length,
+                                            uint8_t **buffer)
+{
+#if defined(FIRMWARE) && defined(USE_VENDOR_BULK)
+    if (((setup->bmRequestType & USB_REQUSET_TYPE_DIR_MASK) == USB_REQUEST_TYPE_DIR_IN) &&
+        (MK82_USB_MS_OS_20_VENDOR_CODE == setup->bRequest) && (MK82_USB_MS_OS_20_DESCRIPTOR_INDEX == setup->wIndex))
+    {
+        *buffer = mk82UsbMsOs20DescriptorSet;
+        *length = sizeof(mk82UsbMsOs20DescriptorSet);
+        return kStatus_USB_Success;
+    }
+#endif /* defined(FIRMWARE) && defined(USE_VENDOR_BULK) */
+    return kStatus_USB_InvalidRequest;
+}
+
 /*!
  * @brief Set the device configuration.
  *
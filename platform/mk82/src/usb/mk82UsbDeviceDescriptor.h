@@ -23,7 +23,12 @@
 #define MK82_USB_DEVICE_STRING_COUNT (3)
 #define MK82_USB_DEVICE_LANGUAGE_COUNT (1)
 
+/* BOS descriptors, which the WinUSB and WebUSB capabilities of the vendor interface are in, need USB 2.1. */
+#if defined(FIRMWARE) && defined(USE_VENDOR_BULK)
+#define MK82_USB_DEVICE_SPECIFICATION_VERSION (0x0210)
+#else /* defined(FIRMWARE) && defined(USE_VENDOR_BULK) */
 #define MK82_USB_DEVICE_SPECIFICATION_VERSION (0x0200)
+#endif /* defined(FIRMWARE) && defined(USE_VENDOR_BULK) */
 #define MK82_USB_DEVICE_VERSION (0x0100U)
 #define MK82_USB_DEVICE_MAX_POWER (0x32)
 
@@ -37,7 +42,11 @@
 #endif /* FIRMWARE */
 
 #ifdef FIRMWARE
+#ifdef USE_VENDOR_BULK
+#define MK82_USB_INTERFACE_COUNT (0x05)
+#else /* USE_VENDOR_BULK */
 #define MK82_USB_INTERFACE_COUNT (0x04)
+#endif /* USE_VENDOR_BULK */
 #else /* FIRMWARE */
 #define MK82_USB_INTERFACE_COUNT (0x01)
 #endif /* FIRMWARE */
@@ -52,7 +61,7 @@
      (2 * USB_DESCRIPTOR_LENGTH_ENDPOINT) + (1 * USB_DESCRIPTOR_LENGTH_INTERFACE) +     \
      (1 * MK82_USB_KBD_HID_DECRIPTOR_LENGTH) + (1 * USB_DESCRIPTOR_LENGTH_ENDPOINT) +   \
      (1 * USB_DESCRIPTOR_LENGTH_INTERFACE) + (1 * MK82_USB_BTC_HID_DECRIPTOR_LENGTH) +  \
-     (2 * USB_DESCRIPTOR_LENGTH_ENDPOINT))
+     (2 * USB_DESCRIPTOR_LENGTH_ENDPOINT) + MK82_USB_VENDOR_DESCRIPTORS_LENGTH)
 #else /* FIRMWARE */
 #define MK82_USB_TOTAL_CONFIGURATION_DESCRIPTOR_LENGTH                               \
     ((1 * USB_DESCRIPTOR_LENGTH_CONFIGURE) + (1 * USB_DESCRIPTOR_LENGTH_INTERFACE) + \
@@ -126,6 +135,72 @@
 #define MK82_USB_BTC_INTERRUPT_ENDPOINTS_PACKET_SIZE (0x40)
 #define MK82_USB_BTC_INTERRUPT_ENDPOINTS_POLLING_INTERVAL (0x05)
 
+/* Vendor bulk */
+
+#ifdef USE_VENDOR_BULK
+
+#define MK82_USB_VENDOR_INTERFACE_NUMBER (0x04)
+#define MK82_USB_VENDOR_NUMBER_OF_ENDPOINTS (0x02)
+
+#define MK82_USB_VENDOR_CLASS (0xFF)
+#define MK82_USB_VENDOR_SUBCLASS (0x00)
+#define MK82_USB_VENDOR_PROTOCOL (0x00)
+
+#define MK82_USB_VENDOR_BULK_IN_ENDPOINT (5)
+#define MK82_USB_VENDOR_BULK_OUT_ENDPOINT (5)
+#define MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE (0x40)
+
+#define MK82_USB_VENDOR_DESCRIPTORS_LENGTH \
+    ((1 * USB_DESCRIPTOR_LENGTH_INTERFACE) + (2 * USB_DESCRIPTOR_LENGTH_ENDPOINT))
+
+#define MK82_USB_DESCRIPTOR_TYPE_BOS (0x0F)
+#define MK82_USB_DESCRIPTOR_TYPE_DEVICE_CAPABILITY (0x10)
+#define MK82_USB_DEVICE_CAPABILITY_TYPE_PLATFORM (0x05)
+
+#define MK82_USB_BOS_DESCRIPTOR_LENGTH (0x05)
+#define MK82_USB_WEBUSB_CAPABILITY_LENGTH (0x18)
+#define MK82_USB_MS_OS_20_CAPABILITY_LENGTH (0x1C)
+#define MK82_USB_BOS_NUMBER_OF_CAPABILITIES (0x02)
+#define MK82_USB_BOS_TOTAL_LENGTH \
+    (MK82_USB_BOS_DESCRIPTOR_LENGTH + MK82_USB_WEBUSB_CAPABILITY_LENGTH + MK82_USB_MS_OS_20_CAPABILITY_LENGTH)
+
+#define MK82_USB_WEBUSB_VERSION (0x0100)
+#define MK82_USB_WEBUSB_VENDOR_CODE (0x01)
+
+/* Windows 8.1 and later read MS OS 2.0 descriptors. */
+#define MK82_USB_MS_OS_20_WINDOWS_VERSION (0x06030000)
+#define MK82_USB_MS_OS_20_VENDOR_CODE (0x02)
+#define MK82_USB_MS_OS_20_DESCRIPTOR_INDEX (0x07)
+
+#define MK82_USB_MS_OS_20_SET_HEADER_DESCRIPTOR (0x00)
+#define MK82_USB_MS_OS_20_SUBSET_HEADER_CONFIGURATION (0x01)
+#define MK82_USB_MS_OS_20_SUBSET_HEADER_FUNCTION (0x02)
+#define MK82_USB_MS_OS_20_FEATURE_COMPATIBLE_ID (0x03)
+#define MK82_USB_MS_OS_20_FEATURE_REG_PROPERTY (0x04)
+
+#define MK82_USB_MS_OS_20_SET_HEADER_LENGTH (0x0A)
+#define MK82_USB_MS_OS_20_SUBSET_HEADER_LENGTH (0x08)
+#define MK82_USB_MS_OS_20_COMPATIBLE_ID_LENGTH (0x14)
+#define MK82_USB_MS_OS_20_PROPERTY_NAME_LENGTH (0x2A)
+#define MK82_USB_MS_OS_20_PROPERTY_DATA_LENGTH (0x50)
+#define MK82_USB_MS_OS_20_REG_PROPERTY_LENGTH \
+    (0x0A + MK82_USB_MS_OS_20_PROPERTY_NAME_LENGTH + MK82_USB_MS_OS_20_PROPERTY_DATA_LENGTH)
+#define MK82_USB_MS_OS_20_FUNCTION_SUBSET_LENGTH                                          \
+    (MK82_USB_MS_OS_20_SUBSET_HEADER_LENGTH + MK82_USB_MS_OS_20_COMPATIBLE_ID_LENGTH + \
+     MK82_USB_MS_OS_20_REG_PROPERTY_LENGTH)
+#define MK82_USB_MS_OS_20_CONFIGURATION_SUBSET_LENGTH \
+    (MK82_USB_MS_OS_20_SUBSET_HEADER_LENGTH + MK82_USB_MS_OS_20_FUNCTION_SUBSET_LENGTH)
+#define MK82_USB_MS_OS_20_SET_LENGTH \
+    (MK82_USB_MS_OS_20_SET_HEADER_LENGTH + MK82_USB_MS_OS_20_CONFIGURATION_SUBSET_LENGTH)
+
+#define MK82_USB_MS_OS_20_REG_MULTI_SZ (0x0007)
+
+#else /* USE_VENDOR_BULK */
+
+#define MK82_USB_VENDOR_DESCRIPTORS_LENGTH (0)
+
+#endif /* USE_VENDOR_BULK */
+
 #endif /* FIRMWARE */
 
 #endif /* __MK82_USB_DEVICE_DESCRIPTOR_H__ */
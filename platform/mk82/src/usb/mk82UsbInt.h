@@ -18,10 +18,21 @@
 
 #define MK82_USB_MAX_HISTCHARS_LENGTH (15)
 
+#define MK82_USB_KBD_MAX_STRING_LENGTH (16)
+
+/* One bulk transfer carries a whole APDU. Rounded up so that the longest one still ends in a short packet. */
+#define MK82_USB_VENDOR_DATA_BUFFER_SIZE                                       \
+    ((BTC_HID_MAX_DATA_SIZE / MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE + 1) * \
+     MK82_USB_VENDOR_BULK_ENDPOINTS_PACKET_SIZE)
+
+#define MK82_USB_BTC_SOURCE_HID (0x9999)
+#define MK82_USB_BTC_SOURCE_VENDOR (0x6666)
+
 #define MK82_USB_EVENT_CCID_PACKET_RECEIVED (0x9999)
 #define MK82_USB_EVENT_U2F_PACKET_RECEIVED (0x6666)
 #define MK82_USB_EVENT_U2F_TIMER_EXPIRED (0xCCCC)
 #define MK82_USB_EVENT_BTC_PACKET_RECEIVED (0x3333)
+#define MK82_USB_EVENT_VENDOR_DATA_RECEIVED (0xAAAA)
 #define MK82_USB_EVENT_NOTHING_HAPPENED (0x5555)
 
 MK82_MAKE_PACKED(typedef struct)
@@ -18,6 +18,7 @@ extern "C"
     void sfCoreInit(void);
     void sfCoreDeinit(void);
     void sfCoreProcessAPDU(uint8_t* apduBuffer, uint32_t* apduBufferLength);
+    void sfCoreIdleTask(void);
 
 #ifdef __cplusplus
 }
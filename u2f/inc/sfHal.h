@@ -34,6 +34,8 @@ extern "C"
 
     void sfHalGenerateKeyPair(uint8_t* publicKey, uint8_t* applicationId, uint8_t* keyHandle);
 
+    void sfHalFillSignaturePool(void);
+
     void sfhalCheckUserPresence(uint16_t* userPresent);
 
     void sfHalDiscardUserPresence(void);
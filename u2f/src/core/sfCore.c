@@ -36,6 +36,8 @@ void sfCoreInit()
 
 void sfCoreDeinit() { sfHalDeinit(); }
 
+void sfCoreIdleTask(void) { sfHalFillSignaturePool(); }
+
 void sfCoreProcessAPDU(uint8_t* apduBuffer, uint32_t* apduBufferLength)
 {
     uint16_t sw = SF_CORE_SW_GENERAL_ERROR;
@@ -35,14 +35,121 @@
 static uint16_t shHalUserPresent = SF_FALSE;
 
 static void shHalButtonPressed(void);
+static void sfHalPrecomputeSignature(mbedtls_ecp_group* group, SF_HAL_PRECOMPUTED_SIGNATURE* precomputedSignature);
 static void sfHalSignData(uint8_t* privateKey, uint8_t* arraysToHash[], uint32_t arrayLengths[], uint32_t listLength,
                           uint8_t* signature, uint16_t* signatureLength);
 
+/* Ephemeral (k^-1, r) pairs for P-256, each used for exactly one signature. Never written to flash. */
+static SF_HAL_PRECOMPUTED_SIGNATURE sfHalSignaturePool[SF_HAL_SIGNATURE_POOL_SIZE];
+
+static void sfHalPrecomputeSignature(mbedtls_ecp_group* group, SF_HAL_PRECOMPUTED_SIGNATURE* precomputedSignature)
+{
+    int tlsCalleeRetVal;
+    mbedtls_ecp_point R;
+    mbedtls_mpi k, r, t;
+    uint32_t tries = 0;
+
+    mbedtls_ecp_point_init(&R);
+    mbedtls_mpi_init(&k);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&t);
+
+    do
+    {
+        if (tries++ > 10)
+        {
+            sfHalFatalError();
+        }
+
+        tlsCalleeRetVal = mbedtls_ecp_gen_keypair(group, &k, &R, mk82SystemGetRandomForTLS, NULL);
+        tlsCalleeRetVal |= mbedtls_mpi_mod_mpi(&r, &R.X, &group->N);
+
+        if (tlsCalleeRetVal != 0)
+        {
+            sfHalFatalError();
+        }
+    } while (mbedtls_mpi_cmp_int(&r, 0) == 0);
+
+    /* Blind the inversion the same way mbedtls_ecdsa_sign does: k^-1 = t * (k * t)^-1. */
+    tries = 0;
+
+    do
+    {
+        if (tries++ > 30)
+        {
+            sfHalFatalError();
+        }
+
+        tlsCalleeRetVal = mbedtls_mpi_fill_random(&t, SF_GLOBAL_PRIVATE_KEY_LENGTH, mk82SystemGetRandomForTLS, NULL);
+
+        if (tlsCalleeRetVal != 0)
+        {
+            sfHalFatalError();
+        }
+    } while ((mbedtls_mpi_cmp_int(&t, 1) < 0) || (mbedtls_mpi_cmp_mpi(&t, &group->N) >= 0));
+
+    tlsCalleeRetVal = mbedtls_mpi_mul_mpi(&k, &k, &t);
+    tlsCalleeRetVal |= mbedtls_mpi_mod_mpi(&k, &k, &group->N);
+    tlsCalleeRetVal |= mbedtls_mpi_inv_mod(&k, &k, &group->N);
+    tlsCalleeRetVal |= mbedtls_mpi_mul_mpi(&k, &k, &t);
+    tlsCalleeRetVal |= mbedtls_mpi_mod_mpi(&k, &k, &group->N);
+    tlsCalleeRetVal |= mbedtls_mpi_write_binary(&k, precomputedSignature->kInverse, SF_GLOBAL_PRIVATE_KEY_LENGTH);
+    tlsCalleeRetVal |= mbedtls_mpi_write_binary(&r, precomputedSignature->r, SF_GLOBAL_PRIVATE_KEY_LENGTH);
+
+    if (tlsCalleeRetVal != 0)
+    {
+        sfHalFatalError();
+    }
+
+    precomputedSignature->valid = SF_TRUE;
+
+    mbedtls_ecp_point_free(&R);
+    mbedtls_mpi_free(&k);
+    mbedtls_mpi_free(&r);
+    mbedtls_mpi_free(&t);
+}
+
+/* Computes a single pair per call so that it can run between USB commands without delaying them noticeably. */
+void sfHalFillSignaturePool(void)
+{
+    int tlsCalleeRetVal;
+    mbedtls_ecp_group group;
+    uint32_t i;
+
+    for (i = 0; i < SF_HAL_SIGNATURE_POOL_SIZE; i++)
+    {
+        if (sfHalSignaturePool[i].valid != SF_TRUE)
+        {
+            break;
+        }
+    }
+
+    if (i == SF_HAL_SIGNATURE_POOL_SIZE)
+    {
+        return;
+    }
+
+    mbedtls_ecp_group_init(&group);
+
+    tlsCalleeRetVal = mbedtls_ecp_group_load(&group, MBEDTLS_ECP_DP_SECP256R1);
+
+    if (tlsCalleeRetVal != 0)
+    {
+        sfHalFatalError();
+    }
+
+    sfHalPrecomputeSignature(&group, &sfHalSignaturePool[i]);
+
+    mbedtls_ecp_group_free(&group);
+}
+
 static void sfHalSignData(uint8_t* privateKey, uint8_t* arraysToHash[], uint32_t arrayLengths[], uint32_t listLength,
                           uint8_t* signature, uint16_t* signatureLength)
 {
     int tlsCalleeRetVal;
     mbedtls_ecdsa_context ecsdaContext;
+    mbedtls_mpi kInverse, r, s, e;
+    SF_HAL_PRECOMPUTED_SIGNATURE precomputedSignature;
     uint8_t hash[SF_HAL_SHA256_LENGTH];
     mbedtls_sha256_context shaContext;
     uint8_t signatureInternal[MBEDTLS_ECDSA_MAX_LEN];
@@ -50,6 +157,10 @@ static void sfHalSignData(uint8_t* privateKey, uint8_t* arraysToHash[], uint32_t
     uint32_t i;
 
     mbedtls_ecdsa_init(&ecsdaContext);
+    mbedtls_mpi_init(&kInverse);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+    mbedtls_mpi_init(&e);
 
     tlsCalleeRetVal = mbedtls_ecp_group_load(&ecsdaContext.grp, MBEDTLS_ECP_DP_SECP256R1);
 
@@ -76,9 +187,62 @@ static void sfHalSignData(uint8_t* privateKey, uint8_t* arraysToHash[], uint32_t
     mbedtls_sha256_finish(&shaContext, hash);
     mbedtls_sha256_free(&shaContext);
 
-    tlsCalleeRetVal =
-        mbedtls_ecdsa_write_signature(&ecsdaContext, MBEDTLS_MD_SHA256, hash, sizeof(hash), signatureInternal,
-                                      (size_t*)&signatureLengthInternal, mk82SystemGetRandomForTLS, NULL, 0);
+    for (i = 0; i < SF_HAL_SIGNATURE_POOL_SIZE; i++)
+    {
+        if (sfHalSignaturePool[i].valid == SF_TRUE)
+        {
+            break;
+        }
+    }
+
+    if (i < SF_HAL_SIGNATURE_POOL_SIZE)
+    {
+        mk82SystemMemCpy((uint8_t*)&precomputedSignature, (uint8_t*)&sfHalSignaturePool[i],
+                         sizeof(SF_HAL_PRECOMPUTED_SIGNATURE));
+        mk82SystemMemSet((uint8_t*)&sfHalSignaturePool[i], 0x00, sizeof(SF_HAL_PRECOMPUTED_SIGNATURE));
+    }
+    else
+    {
+        sfHalPrecomputeSignature(&ecsdaContext.grp, &precomputedSignature);
+    }
+
+    /* s = k^-1 * (e + r * d) mod n. The hash is as long as n, so e only needs a conditional subtraction. */
+    tlsCalleeRetVal = mbedtls_mpi_read_binary(&kInverse, precomputedSignature.kInverse, SF_GLOBAL_PRIVATE_KEY_LENGTH);
+    tlsCalleeRetVal |= mbedtls_mpi_read_binary(&r, precomputedSignature.r, SF_GLOBAL_PRIVATE_KEY_LENGTH);
+    tlsCalleeRetVal |= mbedtls_mpi_read_binary(&e, hash, sizeof(hash));
+
+    if (tlsCalleeRetVal != 0)
+    {
+        sfHalFatalError();
+    }
+
+    if (mbedtls_mpi_cmp_mpi(&e, &ecsdaContext.grp.N) >= 0)
+    {
+        tlsCalleeRetVal = mbedtls_mpi_sub_mpi(&e, &e, &ecsdaContext.grp.N);
+
+        if (tlsCalleeRetVal != 0)
+        {
+            sfHalFatalError();
+        }
+    }
+
+    tlsCalleeRetVal = mbedtls_mpi_mul_mpi(&s, &r, &ecsdaContext.d);
+    tlsCalleeRetVal |= mbedtls_mpi_add_mpi(&s, &s, &e);
+    tlsCalleeRetVal |= mbedtls_mpi_mul_mpi(&s, &s, &kInverse);
+    tlsCalleeRetVal |= mbedtls_mpi_mod_mpi(&s, &s, &ecsdaContext.grp.N);
+
+    if (tlsCalleeRetVal != 0)
+    {
+        sfHalFatalError();
+    }
+
+    /* Only possible if e + r * d is a multiple of n, which has negligible probability. */
+    if (mbedtls_mpi_cmp_int(&s, 0) == 0)
+    {
+        sfHalFatalError();
+    }
+
+    tlsCalleeRetVal = ecdsa_signature_to_asn1(&r, &s, signatureInternal, (size_t*)&signatureLengthInternal);
 
     if (tlsCalleeRetVal != 0)
     {
@@ -93,6 +257,12 @@ static void sfHalSignData(uint8_t* privateKey, uint8_t* arraysToHash[], uint32_t
     *signatureLength = (uint16_t)signatureLengthInternal;
     mk82SystemMemCpy(signature, signatureInternal, signatureLengthInternal);
 
+    mk82SystemMemSet((uint8_t*)&precomputedSignature, 0x00, sizeof(SF_HAL_PRECOMPUTED_SIGNATURE));
+
+    mbedtls_mpi_free(&kInverse);
+    mbedtls_mpi_free(&r);
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&e);
     mbedtls_ecdsa_free(&ecsdaContext);
 }
 
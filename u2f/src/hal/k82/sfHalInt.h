@@ -14,4 +14,13 @@
 
 #define SF_HAL_SHA256_LENGTH (32)
 
+#define SF_HAL_SIGNATURE_POOL_SIZE (4)
+
+typedef struct
+{
+    uint16_t valid;
+    uint8_t kInverse[SF_GLOBAL_PRIVATE_KEY_LENGTH];
+    uint8_t r[SF_GLOBAL_PRIVATE_KEY_LENGTH];
+} SF_HAL_PRECOMPUTED_SIGNATURE;
+
 #endif /* __SF_HAL_WIN32_INT_H__ */
@@ -87,7 +87,8 @@ typedef struct
     uint8_t nonce[SF_HID_INIT_NONCE_SIZE];
 } SF_HID_INIT_REQEST;
 
-typedef struct
+/* Packed, it sits at an odd offset in the frame */
+SF_MAKE_PACKED(typedef struct)
 {
     uint8_t nonce[SF_HID_INIT_NONCE_SIZE];
     uint32_t channelID;
@@ -96,7 +97,8 @@ typedef struct
     uint8_t minorVersion;
     uint8_t buildVersion;
     uint8_t capabilitiesFlags;
-} SF_HID_INIT_RESP;
+}
+SF_HID_INIT_RESP;
 
 #define SF_HID_INIT_RESP_SIZE (17)
 